@@ -0,0 +1,136 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "corpus/header_corpus.h"
+
+#include <vector>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/hpack/header_type.h"
+
+namespace bench {
+
+const std::vector<mh2c::headers_t> request_header_corpus{
+    // Browser navigation
+    {
+        {":method", "GET"},
+        {":authority", "www.example.com"},
+        {":scheme", "https"},
+        {":path", "/"},
+        {"user-agent",
+         "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like "
+         "Gecko) Chrome/90.0.4430.93 Safari/537.36"},
+        {"accept",
+         "text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,"
+         "image/webp,image/apng,*/*;q=0.8"},
+        {"accept-encoding", "gzip, deflate, br"},
+        {"accept-language", "en-US,en;q=0.9,ja;q=0.8"},
+        {"cookie",
+         "_ga=GA1.2.1234567890.1612345678; _gid=GA1.2.987654321.1619876543; "
+         "session_id=3f2a9c1e7b6d4a5f8e0c2b1a9d8e7f6c"},
+        {"upgrade-insecure-requests", "1"},
+        {"sec-fetch-site", "none"},
+        {"sec-fetch-mode", "navigate"},
+        {"sec-fetch-dest", "document"},
+    },
+    // Browser sub-resource
+    {
+        {":method", "GET"},
+        {":authority", "static.example.com"},
+        {":scheme", "https"},
+        {":path", "/assets/js/app.3f9c2e1d.js"},
+        {"user-agent",
+         "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like "
+         "Gecko) Chrome/90.0.4430.93 Safari/537.36"},
+        {"accept", "*/*"},
+        {"accept-encoding", "gzip, deflate, br"},
+        {"accept-language", "en-US,en;q=0.9,ja;q=0.8"},
+        {"referer", "https://www.example.com/"},
+        {"sec-fetch-site", "same-site"},
+        {"sec-fetch-mode", "no-cors"},
+        {"sec-fetch-dest", "script"},
+    },
+    // JSON API call with a bearer token
+    {
+        {":method", "POST"},
+        {":authority", "api.example.com"},
+        {":scheme", "https"},
+        {":path", "/v1/orders?limit=50&cursor=eyJpZCI6MTIzNDU2fQ"},
+        {"content-type", "application/json"},
+        {"content-length", "348"},
+        {"accept", "application/json"},
+        {"authorization",
+         "Bearer eyJhbGciOiJSUzI1NiIsInR5cCI6IkpXVCJ9.eyJzdWIiOiIxMjM0NTY3OD"
+         "kwIiwibmFtZSI6IkpvaG4gRG9lIiwiaWF0IjoxNTE2MjM5MDIyfQ.POstGetfAytaZS8"
+         "2wHcjoTyoqhMyxXiWdR7Nhvwfw"},
+        {"user-agent", "example-client/2.4.1"},
+        {"x-request-id", "0a1b2c3d-4e5f-6789-abcd-ef0123456789"},
+    },
+    // gRPC call
+    {
+        {":method", "POST"},
+        {":scheme", "https"},
+        {":path", "/example.inventory.v1.InventoryService/GetItem"},
+        {":authority", "inventory.internal.example.com:443"},
+        {"content-type", "application/grpc"},
+        {"te", "trailers"},
+        {"grpc-accept-encoding", "identity,deflate,gzip"},
+        {"grpc-timeout", "1S"},
+        {"user-agent", "grpc-c++/1.37.0 grpc-c/16.0.0 (linux; chttp2)"},
+    },
+};
+
+const std::vector<mh2c::headers_t> response_header_corpus{
+    // HTML document
+    {
+        {":status", "200"},
+        {"content-type", "text/html; charset=utf-8"},
+        {"content-encoding", "br"},
+        {"date", "Mon, 03 May 2021 12:34:56 GMT"},
+        {"cache-control", "private, max-age=0, must-revalidate"},
+        {"set-cookie",
+         "session_id=3f2a9c1e7b6d4a5f8e0c2b1a9d8e7f6c; Path=/; Secure; "
+         "HttpOnly; SameSite=Lax"},
+        {"strict-transport-security", "max-age=63072000; includeSubDomains"},
+        {"vary", "Accept-Encoding"},
+        {"server", "nginx"},
+    },
+    // Static asset
+    {
+        {":status", "200"},
+        {"content-type", "application/javascript"},
+        {"content-length", "183742"},
+        {"cache-control", "public, max-age=31536000, immutable"},
+        {"etag", "\"5f8e0c2b-2cdbe\""},
+        {"last-modified", "Tue, 27 Apr 2021 08:15:30 GMT"},
+        {"accept-ranges", "bytes"},
+        {"date", "Mon, 03 May 2021 12:34:57 GMT"},
+        {"age", "3600"},
+        {"via", "1.1 varnish"},
+    },
+    // JSON API response
+    {
+        {":status", "201"},
+        {"content-type", "application/json"},
+        {"content-length", "512"},
+        {"location", "/v1/orders/7b6d4a5f"},
+        {"date", "Mon, 03 May 2021 12:34:58 GMT"},
+        {"x-request-id", "0a1b2c3d-4e5f-6789-abcd-ef0123456789"},
+        {"x-ratelimit-remaining", "4987"},
+    },
+};
+
+std::vector<mh2c::byte_array_t> collect_header_strings() {
+  std::vector<mh2c::byte_array_t> strings{};
+  for (const auto* corpus : {&request_header_corpus, &response_header_corpus}) {
+    for (const auto& headers : *corpus) {
+      for (const auto& header : headers) {
+        strings.emplace_back(header.first.begin(), header.first.end());
+        strings.emplace_back(header.second.begin(), header.second.end());
+      }
+    }
+  }
+  return strings;
+}
+
+}  // namespace bench
@@ -0,0 +1,23 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#ifndef BENCH_CORPUS_HEADER_CORPUS_H_
+#define BENCH_CORPUS_HEADER_CORPUS_H_
+
+#include <vector>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/hpack/header_type.h"
+
+namespace bench {
+
+// Header lists modeled on real browser and API traffic.
+extern const std::vector<mh2c::headers_t> request_header_corpus;
+extern const std::vector<mh2c::headers_t> response_header_corpus;
+
+// Every header name and value of both corpora as raw bytes.
+std::vector<mh2c::byte_array_t> collect_header_strings();
+
+}  // namespace bench
+
+#endif  // BENCH_CORPUS_HEADER_CORPUS_H_
@@ -0,0 +1,127 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include <benchmark/benchmark.h>
+
+#include <utility>
+
+#include "corpus/header_corpus.h"
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/continuation_frame.h"
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/error_codes.h"
+#include "mh2c/frame/frame_builder.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/goaway_frame.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/i_frame.h"
+#include "mh2c/frame/ping_frame.h"
+#include "mh2c/frame/priority_frame.h"
+#include "mh2c/frame/push_promise_frame.h"
+#include "mh2c/frame/rst_stream_frame.h"
+#include "mh2c/frame/settings_frame.h"
+#include "mh2c/frame/window_update_frame.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+#include "support/allocation_report.h"
+
+namespace {
+
+using raw_frame_t = std::pair<mh2c::frame_header, mh2c::byte_array_t>;
+
+raw_frame_t split_frame(const mh2c::i_frame<mh2c::frame_header>& frame) {
+  const auto serialized_frame = frame.serialize();
+  return {frame.get_header(),
+          {serialized_frame.begin() + mh2c::FRAME_HEADER_BYTES,
+           serialized_frame.end()}};
+}
+
+mh2c::header_block_t make_response_header_block() {
+  return mh2c::make_header_block(mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+                                 bench::response_header_corpus.front());
+}
+
+raw_frame_t make_data_frame() {
+  return split_frame(
+      mh2c::data_frame{0u, 1u, mh2c::byte_array_t(16384u, 'x')});
+}
+
+raw_frame_t make_headers_frame() {
+  return split_frame(mh2c::headers_frame{
+      0x4, 1u, make_response_header_block(), mh2c::header_encode_mode::HUFFMAN,
+      mh2c::dynamic_table{}});
+}
+
+raw_frame_t make_priority_frame() {
+  return split_frame(mh2c::priority_frame{3u, {0u, 1u, 15u}});
+}
+
+raw_frame_t make_rst_stream_frame() {
+  return split_frame(mh2c::rst_stream_frame{1u, mh2c::error_codes::CANCEL});
+}
+
+raw_frame_t make_settings_frame() {
+  return split_frame(mh2c::settings_frame{
+      0u, 0u,
+      mh2c::make_sf_payload(
+          {{mh2c::sf_parameter::SETTINGS_HEADER_TABLE_SIZE, 4096u},
+           {mh2c::sf_parameter::SETTINGS_MAX_CONCURRENT_STREAM, 100u},
+           {mh2c::sf_parameter::SETTINGS_INITIAL_WINDOW_SIZE, 65535u},
+           {mh2c::sf_parameter::SETTINGS_MAX_FRAME_SIZE, 16384u}})});
+}
+
+raw_frame_t make_push_promise_frame() {
+  const mh2c::push_promise_payload payload{
+      0u, 2u,
+      mh2c::make_header_block(mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+                              bench::request_header_corpus[1]),
+      {}};
+  return split_frame(mh2c::push_promise_frame{
+      0x4, 1u, payload, mh2c::header_encode_mode::HUFFMAN,
+      mh2c::dynamic_table{}});
+}
+
+raw_frame_t make_ping_frame() {
+  return split_frame(mh2c::ping_frame{0u, {1, 2, 3, 4, 5, 6, 7, 8}});
+}
+
+raw_frame_t make_goaway_frame() {
+  return split_frame(mh2c::goaway_frame{
+      mh2c::goaway_payload{0u, 7u, mh2c::error_codes::NO_ERROR, {}}});
+}
+
+raw_frame_t make_window_update_frame() {
+  return split_frame(mh2c::window_update_frame{1u, 65535u});
+}
+
+raw_frame_t make_continuation_frame() {
+  return split_frame(mh2c::continuation_frame{
+      0x4, 1u, make_response_header_block(),
+      mh2c::header_encode_mode::HUFFMAN, mh2c::dynamic_table{}});
+}
+
+void build_frame(benchmark::State& state, const raw_frame_t& raw_frame) {
+  const mh2c::dynamic_table dynamic_table{};
+
+  test_support::allocation_counter allocations{};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        mh2c::build_frame(raw_frame.first, raw_frame.second, dynamic_table));
+  }
+  bench::report_allocations(state, allocations);
+
+  state.SetBytesProcessed(state.iterations() *
+                          (mh2c::FRAME_HEADER_BYTES + raw_frame.second.size()));
+}
+BENCHMARK_CAPTURE(build_frame, data, make_data_frame());
+BENCHMARK_CAPTURE(build_frame, headers, make_headers_frame());
+BENCHMARK_CAPTURE(build_frame, priority, make_priority_frame());
+BENCHMARK_CAPTURE(build_frame, rst_stream, make_rst_stream_frame());
+BENCHMARK_CAPTURE(build_frame, settings, make_settings_frame());
+BENCHMARK_CAPTURE(build_frame, push_promise, make_push_promise_frame());
+BENCHMARK_CAPTURE(build_frame, ping, make_ping_frame());
+BENCHMARK_CAPTURE(build_frame, goaway, make_goaway_frame());
+BENCHMARK_CAPTURE(build_frame, window_update, make_window_update_frame());
+BENCHMARK_CAPTURE(build_frame, continuation, make_continuation_frame());
+
+}  // namespace
@@ -0,0 +1,39 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include <benchmark/benchmark.h>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/frame_header.h"
+#include "support/allocation_report.h"
+
+namespace {
+
+void build_frame_header(benchmark::State& state) {
+  const mh2c::byte_array_t raw_fh{0x00, 0x40, 0x00, 0x00, 0x01,
+                                  0x00, 0x00, 0x00, 0x0b};
+
+  test_support::allocation_counter allocations{};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mh2c::build_frame_header(raw_fh));
+  }
+  bench::report_allocations(state, allocations);
+
+  state.SetBytesProcessed(state.iterations() * raw_fh.size());
+}
+BENCHMARK(build_frame_header);
+
+void serialize_frame_header(benchmark::State& state) {
+  const mh2c::frame_header fh{16384u, 0x0, 0x1, 0x0, 11u};
+
+  test_support::allocation_counter allocations{};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mh2c::serialize(fh));
+  }
+  bench::report_allocations(state, allocations);
+
+  state.SetBytesProcessed(state.iterations() * mh2c::FRAME_HEADER_BYTES);
+}
+BENCHMARK(serialize_frame_header);
+
+}  // namespace
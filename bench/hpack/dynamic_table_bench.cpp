@@ -0,0 +1,39 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "corpus/header_corpus.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+#include "support/allocation_report.h"
+
+namespace {
+
+// Range(0) is the maximum table size; small tables evict on most pushes.
+void dynamic_table_push(benchmark::State& state) {
+  std::vector<mh2c::header_t> headers{};
+  for (const auto* corpus :
+       {&bench::request_header_corpus, &bench::response_header_corpus}) {
+    for (const auto& header_list : *corpus) {
+      headers.insert(headers.end(), header_list.begin(), header_list.end());
+    }
+  }
+
+  mh2c::dynamic_table dynamic_table{
+      static_cast<mh2c::dynamic_table::size_type>(state.range(0))};
+  test_support::allocation_counter allocations{};
+  for (auto _ : state) {
+    for (const auto& header : headers) {
+      dynamic_table.push(header);
+    }
+  }
+  bench::report_allocations(state, allocations);
+
+  state.SetItemsProcessed(state.iterations() * headers.size());
+}
+BENCHMARK(dynamic_table_push)->Arg(256)->Arg(4096)->Arg(65536);
+
+}  // namespace
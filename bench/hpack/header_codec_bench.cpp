@@ -0,0 +1,108 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "corpus/header_corpus.h"
+#include "mh2c/common/byte_array.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_decoder.h"
+#include "mh2c/hpack/header_encoder.h"
+#include "mh2c/hpack/header_type.h"
+#include "support/allocation_report.h"
+
+namespace {
+
+mh2c::header_block_t make_corpus_header_block(
+    const mh2c::header_prefix_pattern prefix) {
+  mh2c::header_block_t header_block{};
+  for (const auto* corpus :
+       {&bench::request_header_corpus, &bench::response_header_corpus}) {
+    for (const auto& headers : *corpus) {
+      const auto block = mh2c::make_header_block(prefix, headers);
+      header_block.insert(header_block.end(), block.begin(), block.end());
+    }
+  }
+  return header_block;
+}
+
+void encode_header(benchmark::State& state,
+                   const mh2c::header_prefix_pattern prefix,
+                   const mh2c::header_encode_mode mode) {
+  const auto header_block = make_corpus_header_block(prefix);
+  const mh2c::dynamic_table dynamic_table{};
+
+  test_support::allocation_counter allocations{};
+  for (auto _ : state) {
+    for (const auto& header_entry : header_block) {
+      benchmark::DoNotOptimize(
+          mh2c::encode_header(header_entry, mode, dynamic_table));
+    }
+  }
+  bench::report_allocations(state, allocations);
+
+  state.SetItemsProcessed(state.iterations() * header_block.size());
+}
+BENCHMARK_CAPTURE(encode_header, without_indexing_raw,
+                  mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+                  mh2c::header_encode_mode::NONE);
+BENCHMARK_CAPTURE(encode_header, without_indexing_huffman,
+                  mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+                  mh2c::header_encode_mode::HUFFMAN);
+BENCHMARK_CAPTURE(encode_header, incremental_indexing_huffman,
+                  mh2c::header_prefix_pattern::INCREMENTAL_INDEXING,
+                  mh2c::header_encode_mode::HUFFMAN);
+
+// Dynamic table references are looked up in a full table.
+void encode_header_dynamic_indexed(benchmark::State& state) {
+  const auto header_block =
+      make_corpus_header_block(mh2c::header_prefix_pattern::NEVER_INDEXED);
+  mh2c::dynamic_table dynamic_table{1u << 16};
+  for (const auto& header_entry : header_block) {
+    dynamic_table.push(header_entry.get_header());
+  }
+
+  test_support::allocation_counter allocations{};
+  for (auto _ : state) {
+    for (const auto& header_entry : header_block) {
+      benchmark::DoNotOptimize(mh2c::encode_header(
+          header_entry, mh2c::header_encode_mode::HUFFMAN, dynamic_table));
+    }
+  }
+  bench::report_allocations(state, allocations);
+
+  state.SetItemsProcessed(state.iterations() * header_block.size());
+}
+BENCHMARK(encode_header_dynamic_indexed);
+
+void decode_header(benchmark::State& state,
+                   const mh2c::header_encode_mode mode) {
+  const auto header_block =
+      make_corpus_header_block(mh2c::header_prefix_pattern::WITHOUT_INDEXING);
+  const mh2c::dynamic_table dynamic_table{};
+  std::vector<mh2c::byte_array_t> encoded_headers{};
+  size_t encoded_size{};
+  for (const auto& header_entry : header_block) {
+    encoded_headers.push_back(
+        mh2c::encode_header(header_entry, mode, dynamic_table));
+    encoded_size += encoded_headers.back().size();
+  }
+
+  test_support::allocation_counter allocations{};
+  for (auto _ : state) {
+    for (const auto& encoded_header : encoded_headers) {
+      benchmark::DoNotOptimize(
+          mh2c::decode_header(encoded_header, dynamic_table));
+    }
+  }
+  bench::report_allocations(state, allocations);
+
+  state.SetBytesProcessed(state.iterations() * encoded_size);
+  state.SetItemsProcessed(state.iterations() * encoded_headers.size());
+}
+BENCHMARK_CAPTURE(decode_header, raw, mh2c::header_encode_mode::NONE);
+BENCHMARK_CAPTURE(decode_header, huffman, mh2c::header_encode_mode::HUFFMAN);
+
+}  // namespace
@@ -0,0 +1,59 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "corpus/header_corpus.h"
+#include "mh2c/common/byte_array.h"
+#include "mh2c/hpack/huffman_decoder.h"
+#include "mh2c/hpack/huffman_encoder.h"
+#include "support/allocation_report.h"
+
+namespace {
+
+size_t total_size(const std::vector<mh2c::byte_array_t>& strings) {
+  size_t size{};
+  for (const auto& str : strings) {
+    size += str.size();
+  }
+  return size;
+}
+
+void huffman_encode(benchmark::State& state) {
+  const auto strings = bench::collect_header_strings();
+
+  test_support::allocation_counter allocations{};
+  for (auto _ : state) {
+    for (const auto& str : strings) {
+      benchmark::DoNotOptimize(mh2c::huffman::encode(str));
+    }
+  }
+  bench::report_allocations(state, allocations);
+
+  state.SetBytesProcessed(state.iterations() * total_size(strings));
+  state.SetItemsProcessed(state.iterations() * strings.size());
+}
+BENCHMARK(huffman_encode);
+
+void huffman_decode(benchmark::State& state) {
+  std::vector<mh2c::byte_array_t> encoded_strings{};
+  for (const auto& str : bench::collect_header_strings()) {
+    encoded_strings.push_back(mh2c::huffman::encode(str));
+  }
+
+  test_support::allocation_counter allocations{};
+  for (auto _ : state) {
+    for (const auto& str : encoded_strings) {
+      benchmark::DoNotOptimize(mh2c::huffman::decode(str));
+    }
+  }
+  bench::report_allocations(state, allocations);
+
+  state.SetBytesProcessed(state.iterations() * total_size(encoded_strings));
+  state.SetItemsProcessed(state.iterations() * encoded_strings.size());
+}
+BENCHMARK(huffman_decode);
+
+}  // namespace
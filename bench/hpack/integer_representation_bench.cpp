@@ -0,0 +1,56 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/hpack/integer_representation.h"
+#include "support/allocation_report.h"
+
+namespace {
+
+// Typical indexes, string lengths and table sizes
+const std::vector<size_t> values{2u, 10u, 30u, 62u, 127u, 1337u, 4096u, 65535u};
+
+template <mh2c::header_index_t N>
+void encode_integer_value(benchmark::State& state) {
+  test_support::allocation_counter allocations{};
+  for (auto _ : state) {
+    for (const auto value : values) {
+      benchmark::DoNotOptimize(mh2c::encode_integer_value<N>(value));
+    }
+  }
+  bench::report_allocations(state, allocations);
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK_TEMPLATE(encode_integer_value, 4);
+BENCHMARK_TEMPLATE(encode_integer_value, 5);
+BENCHMARK_TEMPLATE(encode_integer_value, 6);
+BENCHMARK_TEMPLATE(encode_integer_value, 7);
+
+template <mh2c::header_index_t N>
+void decode_integer_value(benchmark::State& state) {
+  std::vector<mh2c::byte_array_t> encoded_values{};
+  for (const auto value : values) {
+    encoded_values.push_back(mh2c::encode_integer_value<N>(value));
+  }
+
+  test_support::allocation_counter allocations{};
+  for (auto _ : state) {
+    for (const auto& encoded_value : encoded_values) {
+      benchmark::DoNotOptimize(mh2c::decode_integer_value<N>(encoded_value));
+    }
+  }
+  bench::report_allocations(state, allocations);
+
+  state.SetItemsProcessed(state.iterations() * encoded_values.size());
+}
+BENCHMARK_TEMPLATE(decode_integer_value, 4);
+BENCHMARK_TEMPLATE(decode_integer_value, 5);
+BENCHMARK_TEMPLATE(decode_integer_value, 6);
+BENCHMARK_TEMPLATE(decode_integer_value, 7);
+
+}  // namespace
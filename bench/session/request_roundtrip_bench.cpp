@@ -0,0 +1,107 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/settings_frame.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/http2_client.h"
+#include "mh2c/server/http2_server.h"
+#include "mh2c/server/server_options.h"
+#include "mh2c/server/server_session.h"
+#include "mh2c/transport/i_transport.h"
+#include "mh2c/transport/memory_transport.h"
+#include "mh2c/transport/tcp_transport.h"
+#include "mh2c/util/bit_operation.h"
+#include "mh2c/util/cast.h"
+#include "support/allocation_report.h"
+
+namespace {
+
+mh2c::server::server_options make_server_options(const size_t body_size) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {200u, {{"server", "mh2c"}}, body_size};
+  return options;
+}
+
+// Sends GET requests one at a time and waits for each response to finish.
+void run_requests(benchmark::State& state, mh2c::http2_client* client) {
+  client->exchange_settings({});
+  client->enable_window_autotuning();
+
+  const auto header_block = mh2c::make_header_block(
+      mh2c::header_prefix_pattern::INCREMENTAL_INDEXING,
+      mh2c::headers_t{{":method", "GET"},
+                      {":scheme", "http"},
+                      {":authority", "localhost"},
+                      {":path", "/"}});
+  mh2c::fh_stream_id_t stream_id{1u};
+  size_t body_bytes{};
+
+  test_support::allocation_counter allocations{};
+  for (auto _ : state) {
+    const mh2c::headers_frame hf{
+        mh2c::make_frame_header_flags(mh2c::hf_flag::END_STREAM,
+                                      mh2c::hf_flag::END_HEADERS),
+        stream_id, header_block, mh2c::header_encode_mode::HUFFMAN,
+        client->get_request_dynamic_table()};
+    client->send_frame(hf);
+    client->update_request_dynamic_table(hf.get_payload());
+
+    while (true) {
+      const auto fh = client->receive_frame()->get_header();
+      if (mh2c::cast_to_frame_type_registry(fh.m_type) ==
+          mh2c::frame_type_registry::DATA) {
+        body_bytes += fh.m_length;
+      }
+      if (fh.m_stream_id == stream_id &&
+          mh2c::is_flag_set(fh.m_flags, mh2c::hf_flag::END_STREAM)) {
+        break;
+      }
+    }
+    stream_id += 2u;
+  }
+  bench::report_allocations(state, allocations);
+
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(body_bytes);
+}
+
+// Range(0) is the response body size.
+void request_roundtrip_memory(benchmark::State& state) {
+  auto [client_transport, server_transport] =
+      mh2c::transport::make_memory_transport_pair();
+  std::thread server_thread{[options = make_server_options(state.range(0)),
+                             transport =
+                                 std::move(server_transport)]() mutable {
+    mh2c::server::server_session{std::move(transport), options}.run();
+  }};
+
+  {
+    mh2c::http2_client client{std::move(client_transport)};
+    run_requests(state, &client);
+  }
+  server_thread.join();
+}
+BENCHMARK(request_roundtrip_memory)->Arg(0)->Arg(16384)->Arg(1 << 20);
+
+void request_roundtrip_h2c(benchmark::State& state) {
+  mh2c::server::http2_server server{make_server_options(state.range(0))};
+  const auto port = server.listen("127.0.0.1", 0u,
+                                  mh2c::server::server_transport::CLEARTEXT);
+
+  mh2c::http2_client client{
+      mh2c::transport::connect_cleartext("127.0.0.1", port)};
+  run_requests(state, &client);
+}
+BENCHMARK(request_roundtrip_h2c)->Arg(0)->Arg(16384)->Arg(1 << 20);
+
+}  // namespace
@@ -0,0 +1,28 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#ifndef BENCH_SUPPORT_ALLOCATION_REPORT_H_
+#define BENCH_SUPPORT_ALLOCATION_REPORT_H_
+
+#include <benchmark/benchmark.h>
+
+#include "support/allocation_counter.h"
+
+namespace bench {
+
+// Reports the operator new calls counted by `allocations` as the "allocs/op"
+// counter. Construct the counter just before the benchmark loop and call this
+// right after it, so that neither the setup nor the other counters are
+// counted.
+inline void report_allocations(
+    benchmark::State& state,
+    const test_support::allocation_counter& allocations) {
+  const auto count = static_cast<double>(allocations.get_count());
+  state.counters["allocs/op"] =
+      benchmark::Counter(count, benchmark::Counter::kAvgIterations);
+  return;
+}
+
+}  // namespace bench
+
+#endif  // BENCH_SUPPORT_ALLOCATION_REPORT_H_
@@ -0,0 +1,169 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/body/body_source.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "mh2c/common/byte_array.h"
+
+namespace mh2c {
+
+namespace body {
+
+/*
+ * definitions of buffer_body_source
+ */
+buffer_body_source::buffer_body_source(const uint8_t* data,
+                                       const size_t length)
+    : m_storage{}, m_data{data}, m_length{length}, m_offset{} {}
+
+buffer_body_source::buffer_body_source(byte_array_t buffer)
+    : m_storage{std::move(buffer)},
+      m_data{m_storage.data()},
+      m_length{m_storage.size()},
+      m_offset{} {}
+
+body_chunk buffer_body_source::next(const size_t max_length) {
+  const auto length = std::min(max_length, m_length - m_offset);
+  const body_chunk chunk{m_data + m_offset, length,
+                         m_offset + length == m_length};
+  m_offset += length;
+  return chunk;
+}
+
+/*
+ * definitions of producer_body_source
+ */
+producer_body_source::producer_body_source(body_producer producer)
+    : m_producer{std::move(producer)}, m_buffer{}, m_finished{false} {}
+
+body_chunk producer_body_source::next(const size_t max_length) {
+  if (m_finished || max_length == 0) {
+    return {nullptr, 0u, m_finished};
+  }
+
+  if (m_buffer.size() < max_length) {
+    m_buffer.resize(max_length);
+  }
+  const auto length = m_producer(m_buffer.data(), max_length);
+  if (length > max_length) {
+    throw std::out_of_range("body producer overran the buffer: length=" +
+                            std::to_string(length));
+  }
+  m_finished = length == 0;
+
+  return {m_buffer.data(), length, m_finished};
+}
+
+/*
+ * definitions of file_body_source
+ */
+file_body_source::file_body_source(const std::string& path,
+                                   const size_t map_window,
+                                   const file_transfer_mode mode)
+    : m_fd{-1},
+      m_length{},
+      m_offset{},
+      m_mode{mode},
+      m_map_window{map_window},
+      m_map{nullptr},
+      m_map_offset{},
+      m_map_length{} {
+  const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  if (map_window == 0 || map_window % page_size != 0) {
+    throw std::invalid_argument("map window is not a multiple of the page "
+                                "size: map_window=" +
+                                std::to_string(map_window));
+  }
+
+  m_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (m_fd < 0) {
+    const int err_code = errno;
+    throw std::runtime_error("cannot open " + path +
+                             ": err_code=" + std::to_string(err_code));
+  }
+
+  struct stat file_stat {};
+  if (fstat(m_fd, &file_stat) != 0) {
+    const int err_code = errno;
+    close(m_fd);
+    throw std::runtime_error("cannot stat " + path +
+                             ": err_code=" + std::to_string(err_code));
+  }
+  m_length = file_stat.st_size;
+}
+
+file_body_source::file_body_source(const std::string& path,
+                                   const file_transfer_mode mode)
+    : file_body_source{path, DEFAULT_MAP_WINDOW, mode} {}
+
+file_body_source::~file_body_source() {
+  unmap();
+  close(m_fd);
+}
+
+body_chunk file_body_source::next(const size_t max_length) {
+  if (m_offset == m_length || max_length == 0) {
+    return {nullptr, 0u, m_offset == m_length};
+  }
+
+  if (m_mode == file_transfer_mode::SENDFILE) {
+    const auto length = std::min<uint64_t>(max_length, m_length - m_offset);
+    const body_chunk chunk{nullptr, static_cast<size_t>(length),
+                           m_offset + length == m_length, m_fd, m_offset};
+    m_offset += length;
+    return chunk;
+  }
+
+  // Chunks never straddle two windows, so the next window starts where the
+  // current one ends.
+  if (m_offset == m_map_offset + m_map_length) {
+    unmap();
+    m_map_offset = m_offset;
+    m_map_length = std::min<uint64_t>(m_map_window, m_length - m_offset);
+    void* map = mmap(nullptr, m_map_length, PROT_READ, MAP_PRIVATE, m_fd,
+                     static_cast<off_t>(m_map_offset));
+    if (map == MAP_FAILED) {
+      const int err_code = errno;
+      m_map_length = 0;
+      throw std::runtime_error("mmap failed: err_code=" +
+                               std::to_string(err_code));
+    }
+    m_map = static_cast<uint8_t*>(map);
+    madvise(m_map, m_map_length, MADV_SEQUENTIAL);
+  }
+
+  const auto length = std::min<uint64_t>(
+      max_length, m_map_offset + m_map_length - m_offset);
+  const body_chunk chunk{m_map + (m_offset - m_map_offset),
+                         static_cast<size_t>(length),
+                         m_offset + length == m_length};
+  m_offset += length;
+  return chunk;
+}
+
+uint64_t file_body_source::get_length() const { return m_length; }
+
+void file_body_source::unmap() {
+  if (m_map != nullptr) {
+    munmap(m_map, m_map_length);
+    m_map = nullptr;
+  }
+  return;
+}
+
+}  // namespace body
+
+}  // namespace mh2c
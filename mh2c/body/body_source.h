@@ -0,0 +1,129 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_BODY_BODY_SOURCE_H_
+#define MH2C_BODY_BODY_SOURCE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "mh2c/common/byte_array.h"
+
+namespace mh2c {
+
+namespace body {
+
+// Part of a body, valid until the next call to i_body_source::next().
+struct body_chunk {
+  const uint8_t* m_data;
+  size_t m_length;
+  // Nothing follows this chunk, which may be empty.
+  bool m_last;
+  // Set instead of m_data for the range of the file at m_file_offset, which
+  // the client hands to i_transport::sendfile().
+  int m_fd{-1};
+  uint64_t m_file_offset{0};
+};
+
+// Where the bytes of a request body come from. The client asks for chunks
+// no larger than the DATA frame it can send and writes them straight from
+// the memory the source points to.
+class i_body_source {
+ public:
+  virtual ~i_body_source() = default;
+
+  // Returns up to max_length bytes. An empty chunk that is not the last one
+  // means that nothing fits, i.e. max_length is 0.
+  virtual body_chunk next(const size_t max_length) = 0;
+};
+
+// Body in memory. The view constructor does not copy the buffer, which the
+// caller keeps alive until the body has been sent.
+class buffer_body_source : public i_body_source {
+ public:
+  buffer_body_source(const uint8_t* data, const size_t length);
+  explicit buffer_body_source(byte_array_t buffer);
+
+  buffer_body_source(const buffer_body_source&) = delete;
+  buffer_body_source& operator=(const buffer_body_source&) = delete;
+
+  body_chunk next(const size_t max_length) override;
+
+ private:
+  byte_array_t m_storage;
+  const uint8_t* m_data;
+  size_t m_length;
+  size_t m_offset;
+};
+
+// Fills the buffer with up to max_length bytes and returns how many it
+// wrote, 0 at the end of the body.
+using body_producer =
+    std::function<size_t(uint8_t* buffer, const size_t max_length)>;
+
+// Body generated on demand, e.g. from a pipe or a compressor. Only one chunk
+// is buffered at a time.
+class producer_body_source : public i_body_source {
+ public:
+  explicit producer_body_source(body_producer producer);
+
+  body_chunk next(const size_t max_length) override;
+
+ private:
+  body_producer m_producer;
+  byte_array_t m_buffer;
+  bool m_finished;
+};
+
+enum class file_transfer_mode : uint8_t {
+  // Mapped a window at a time and written from the page cache
+  MAP,
+  // Passed as file ranges to i_transport::sendfile(), i.e. sendfile(2) over
+  // TCP, and SSL_sendfile once kTLS offloads the send direction, so that the
+  // payload never enters user space. Without kTLS, TLS copies it through user
+  // space anyway.
+  SENDFILE,
+};
+
+// Maps a window of the file at a time, so that a file of any size is sent
+// from the page cache with bounded address space and without read() copies.
+class file_body_source : public i_body_source {
+ public:
+  static constexpr size_t DEFAULT_MAP_WINDOW{64u * 1024u * 1024u};
+
+  // Throw std::runtime_error when the file cannot be opened, and
+  // std::invalid_argument unless map_window is a multiple of the page size.
+  explicit file_body_source(
+      const std::string& path, const size_t map_window = DEFAULT_MAP_WINDOW,
+      const file_transfer_mode mode = file_transfer_mode::MAP);
+  file_body_source(const std::string& path, const file_transfer_mode mode);
+  ~file_body_source() override;
+
+  file_body_source(const file_body_source&) = delete;
+  file_body_source& operator=(const file_body_source&) = delete;
+
+  // Throw std::runtime_error when the file cannot be mapped
+  body_chunk next(const size_t max_length) override;
+
+  uint64_t get_length() const;
+
+ private:
+  void unmap();
+
+  int m_fd;
+  uint64_t m_length;
+  uint64_t m_offset;
+  file_transfer_mode m_mode;
+  size_t m_map_window;
+  uint8_t* m_map;
+  uint64_t m_map_offset;
+  size_t m_map_length;
+};
+
+}  // namespace body
+
+}  // namespace mh2c
+
+#endif  // MH2C_BODY_BODY_SOURCE_H_
@@ -0,0 +1,279 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/body/content_decoder.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "mh2c/common/byte_array.h"
+
+namespace mh2c {
+
+namespace body {
+
+namespace {
+
+// Adding 32 to the window bits makes zlib detect the gzip or zlib header
+// cf. https://www.zlib.net/manual.html#Advanced
+constexpr int GZIP_WINDOW_BITS{MAX_WBITS + 32};
+constexpr size_t ZLIB_HEADER_BYTES{2u};
+
+// cf. https://tools.ietf.org/html/rfc1950#section-2.2
+bool is_zlib_header(const uint8_t cmf, const uint8_t flg) {
+  return (cmf & 0x0fu) == Z_DEFLATED && ((cmf << 8u) | flg) % 31u == 0;
+}
+
+std::string normalize(const std::string& value) {
+  const auto begin = value.find_first_not_of(" \t");
+  if (begin == std::string::npos) {
+    return {};
+  }
+  auto normalized =
+      value.substr(begin, value.find_last_not_of(" \t") - begin + 1);
+  std::transform(normalized.begin(), normalized.end(), normalized.begin(),
+                 [](const unsigned char c) { return std::tolower(c); });
+  return normalized;
+}
+
+}  // namespace
+
+/*
+ * definitions of buffer_body_sink
+ */
+buffer_body_sink::buffer_body_sink()
+    : m_buffer{}, m_complete{false}, m_error{} {}
+
+void buffer_body_sink::on_data(const uint8_t* data, const size_t length) {
+  m_buffer.insert(m_buffer.end(), data, data + length);
+  return;
+}
+
+void buffer_body_sink::on_end() {
+  m_complete = true;
+  return;
+}
+
+void buffer_body_sink::on_error(const std::string& what) {
+  m_error = what;
+  return;
+}
+
+const byte_array_t& buffer_body_sink::get_buffer() const { return m_buffer; }
+
+bool buffer_body_sink::is_complete() const { return m_complete; }
+
+const std::string& buffer_body_sink::get_error() const { return m_error; }
+
+content_coding parse_content_coding(const std::string& value) {
+  const auto coding = normalize(value);
+  if (coding.empty() || coding == "identity") {
+    return content_coding::IDENTITY;
+  }
+  // x-gzip is an alias of gzip
+  // cf. https://tools.ietf.org/html/rfc7230#section-4.2.3
+  if (coding == "gzip" || coding == "x-gzip") {
+    return content_coding::GZIP;
+  }
+  if (coding == "deflate") {
+    return content_coding::DEFLATE;
+  }
+
+  throw std::invalid_argument("unsupported content-encoding: " + value);
+}
+
+/*
+ * definitions of content_decoder
+ */
+class content_decoder::impl {
+ public:
+  impl(const content_coding coding, std::shared_ptr<i_body_sink> sink,
+       const size_t output_buffer);
+  ~impl();
+
+  void decode(const uint8_t* data, const size_t length);
+  void finish();
+  uint64_t get_decoded_length() const;
+
+ private:
+  void start(const int window_bits);
+  void inflate_input(const uint8_t* data, const size_t length);
+  void emit(const uint8_t* data, const size_t length);
+
+  content_coding m_coding;
+  std::shared_ptr<i_body_sink> m_sink;
+  byte_array_t m_output;
+  z_stream m_stream;
+  bool m_started;
+  bool m_stream_end;
+  // First bytes of a deflate body, which tell the zlib format from raw
+  // deflate
+  byte_array_t m_header;
+  uint64_t m_decoded_length;
+};
+
+content_decoder::impl::impl(const content_coding coding,
+                            std::shared_ptr<i_body_sink> sink,
+                            const size_t output_buffer)
+    : m_coding{coding},
+      m_sink{std::move(sink)},
+      m_output(output_buffer),
+      m_stream{},
+      m_started{false},
+      m_stream_end{false},
+      m_header{},
+      m_decoded_length{0} {
+  if (output_buffer == 0) {
+    throw std::invalid_argument("output buffer of content_decoder is empty");
+  }
+}
+
+content_decoder::impl::~impl() {
+  if (m_started) {
+    inflateEnd(&m_stream);
+  }
+}
+
+void content_decoder::impl::decode(const uint8_t* data, const size_t length) {
+  if (length == 0) {
+    return;
+  }
+
+  switch (m_coding) {
+    case content_coding::IDENTITY:
+      emit(data, length);
+      return;
+    case content_coding::GZIP:
+      if (m_started == false) {
+        start(GZIP_WINDOW_BITS);
+      }
+      inflate_input(data, length);
+      return;
+    case content_coding::DEFLATE:
+      break;
+  }
+
+  if (m_started) {
+    inflate_input(data, length);
+    return;
+  }
+
+  // The header may be split across DATA frames.
+  const auto header_length =
+      std::min(ZLIB_HEADER_BYTES - m_header.size(), length);
+  m_header.insert(m_header.end(), data, data + header_length);
+  if (m_header.size() < ZLIB_HEADER_BYTES) {
+    return;
+  }
+  start(is_zlib_header(m_header[0], m_header[1]) ? MAX_WBITS : -MAX_WBITS);
+  inflate_input(m_header.data(), m_header.size());
+  inflate_input(data + header_length, length - header_length);
+  return;
+}
+
+void content_decoder::impl::finish() {
+  const auto is_empty = m_started == false && m_header.empty();
+  if (m_coding != content_coding::IDENTITY && is_empty == false &&
+      m_stream_end == false) {
+    throw std::runtime_error("body ends in the middle of the coded data");
+  }
+
+  m_sink->on_end();
+  return;
+}
+
+uint64_t content_decoder::impl::get_decoded_length() const {
+  return m_decoded_length;
+}
+
+void content_decoder::impl::start(const int window_bits) {
+  if (inflateInit2(&m_stream, window_bits) != Z_OK) {
+    throw std::runtime_error("inflateInit2 failed");
+  }
+  m_started = true;
+  return;
+}
+
+void content_decoder::impl::inflate_input(const uint8_t* data,
+                                          const size_t length) {
+  // zlib does not write to the input.
+  m_stream.next_in = const_cast<uint8_t*>(data);
+  m_stream.avail_in = static_cast<uInt>(length);
+
+  bool is_output_full{false};
+  while (m_stream.avail_in > 0 || is_output_full) {
+    if (m_stream_end) {
+      if (m_stream.avail_in == 0) {
+        break;
+      }
+      // cf. https://tools.ietf.org/html/rfc1952#section-2.2
+      if (m_coding != content_coding::GZIP) {
+        throw std::runtime_error("data after the end of the deflate stream");
+      }
+      inflateReset(&m_stream);
+      m_stream_end = false;
+    }
+
+    m_stream.next_out = m_output.data();
+    m_stream.avail_out = static_cast<uInt>(m_output.size());
+    const auto result = inflate(&m_stream, Z_NO_FLUSH);
+    if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+      throw std::runtime_error(
+          "cannot inflate the body: " +
+          (m_stream.msg != nullptr ? std::string{m_stream.msg}
+                                   : std::to_string(result)));
+    }
+
+    m_stream_end = result == Z_STREAM_END;
+    is_output_full = m_stream.avail_out == 0;
+    emit(m_output.data(), m_output.size() - m_stream.avail_out);
+    // No progress is possible without more input.
+    if (result == Z_BUF_ERROR) {
+      break;
+    }
+  }
+
+  return;
+}
+
+void content_decoder::impl::emit(const uint8_t* data, const size_t length) {
+  if (length > 0) {
+    m_sink->on_data(data, length);
+    m_decoded_length += length;
+  }
+  return;
+}
+
+content_decoder::content_decoder(const content_coding coding,
+                                 std::shared_ptr<i_body_sink> sink,
+                                 const size_t output_buffer)
+    : m_pimpl(std::make_unique<content_decoder::impl>(coding, std::move(sink),
+                                                      output_buffer)) {}
+
+content_decoder::~content_decoder() = default;
+
+void content_decoder::decode(const uint8_t* data, const size_t length) {
+  m_pimpl->decode(data, length);
+  return;
+}
+
+void content_decoder::finish() {
+  m_pimpl->finish();
+  return;
+}
+
+uint64_t content_decoder::get_decoded_length() const {
+  return m_pimpl->get_decoded_length();
+}
+
+}  // namespace body
+
+}  // namespace mh2c
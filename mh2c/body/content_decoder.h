@@ -0,0 +1,99 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_BODY_CONTENT_DECODER_H_
+#define MH2C_BODY_CONTENT_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "mh2c/common/byte_array.h"
+
+namespace mh2c {
+
+namespace body {
+
+// Where the bytes of a response body go as they arrive.
+class i_body_sink {
+ public:
+  virtual ~i_body_sink() = default;
+
+  // data is valid only during the call
+  virtual void on_data(const uint8_t* data, const size_t length) = 0;
+  // The whole body has been passed to on_data()
+  virtual void on_end() = 0;
+  // The body cannot be decoded; nothing more is passed.
+  virtual void on_error(const std::string& what) = 0;
+};
+
+// Collects the body in memory.
+class buffer_body_sink : public i_body_sink {
+ public:
+  buffer_body_sink();
+
+  void on_data(const uint8_t* data, const size_t length) override;
+  void on_end() override;
+  void on_error(const std::string& what) override;
+
+  const byte_array_t& get_buffer() const;
+  bool is_complete() const;
+  // Empty unless on_error() has been called
+  const std::string& get_error() const;
+
+ private:
+  byte_array_t m_buffer;
+  bool m_complete;
+  std::string m_error;
+};
+
+// cf. https://tools.ietf.org/html/rfc7231#section-3.1.2.1
+enum class content_coding {
+  IDENTITY,
+  GZIP,
+  DEFLATE,
+};
+
+// accept-encoding value listing the codings content_decoder supports
+constexpr char ACCEPT_ENCODING[]{"gzip, deflate"};
+
+// Parses a content-encoding value; an empty one means IDENTITY. Throw
+// std::invalid_argument for any other coding, or for several of them.
+content_coding parse_content_coding(const std::string& value);
+
+// Inflates a body arriving in pieces, e.g. DATA payloads, and passes the
+// result to the sink through a fixed output buffer, so that memory stays
+// bounded whatever the compression ratio. deflate accepts the zlib format
+// as well as the raw one some servers send; gzip accepts concatenated
+// members.
+class content_decoder {
+ public:
+  static constexpr size_t DEFAULT_OUTPUT_BUFFER{16384u};
+
+  content_decoder(const content_coding coding,
+                  std::shared_ptr<i_body_sink> sink,
+                  const size_t output_buffer = DEFAULT_OUTPUT_BUFFER);
+  ~content_decoder();
+
+  content_decoder(const content_decoder&) = delete;
+  content_decoder& operator=(const content_decoder&) = delete;
+
+  // Throw std::runtime_error for data that is not of the coding
+  void decode(const uint8_t* data, const size_t length);
+  // Throw std::runtime_error when the body stops in the middle of the coded
+  // data. An empty body is complete.
+  void finish();
+
+  uint64_t get_decoded_length() const;
+
+ private:
+  class impl;
+  std::unique_ptr<impl> m_pimpl;
+};
+
+}  // namespace body
+
+}  // namespace mh2c
+
+#endif  // MH2C_BODY_CONTENT_DECODER_H_
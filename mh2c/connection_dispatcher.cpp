@@ -0,0 +1,660 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/connection_dispatcher.h"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mh2c/body/body_source.h"
+#include "mh2c/frame/common_type.h"
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/settings_frame.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/http2_client.h"
+#include "mh2c/net/socket_fd.h"
+#include "mh2c/util/bit_operation.h"
+#include "mh2c/util/mpsc_queue.h"
+#include "mh2c/util/spsc_queue.h"
+
+namespace mh2c {
+
+namespace {
+
+// The reader thread waits this long for a frame before it checks whether it
+// is being stopped; a posted task wakes it up right away.
+constexpr std::chrono::milliseconds IDLE_WAIT_INTERVAL{1000};
+// While frames are set aside for full stream queues, how often the reader
+// thread retries them
+constexpr std::chrono::milliseconds OVERFLOW_RETRY_INTERVAL{1};
+
+net::socket_fd make_eventfd() {
+  net::socket_fd fd{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)};
+  if (fd.get() < 0) {
+    int err_code = errno;
+    throw std::runtime_error("eventfd failed: err_code=" +
+                             std::to_string(err_code));
+  }
+  return fd;
+}
+
+}  // namespace
+
+/* definitions of dispatched_stream */
+
+class dispatched_stream::impl {
+ public:
+  explicit impl(const size_t capacity);
+
+  // Reader thread
+  void set_stream_id(const fh_stream_id_t stream_id);
+  // Returns false when the frame was set aside for the full queue.
+  bool push(h2_frame_ptr frame);
+  // Returns true once no frame is set aside any more.
+  bool flush_overflow();
+  void end(std::exception_ptr error);
+
+  fh_stream_id_t get_stream_id() const;
+  h2_frame_ptr pop(const std::chrono::milliseconds timeout);
+  bool is_finished() const;
+
+ private:
+  void publish_end();
+  void notify();
+
+  spsc_queue<h2_frame_ptr> m_queue;
+  // Frames the full queue did not take yet, and whether the stream ends
+  // after them. Reader thread only.
+  std::deque<h2_frame_ptr> m_overflow;
+  bool m_end_pending;
+  // Written before m_ended
+  std::exception_ptr m_error;
+  std::atomic<fh_stream_id_t> m_stream_id;
+  std::atomic<bool> m_ended;
+  // The consumer sleeps, or is about to, on m_readable.
+  std::atomic<bool> m_waiting;
+  std::mutex m_mutex;
+  std::condition_variable m_readable;
+};
+
+dispatched_stream::impl::impl(const size_t capacity)
+    : m_queue{capacity},
+      m_overflow{},
+      m_end_pending{false},
+      m_error{},
+      m_stream_id{0},
+      m_ended{false},
+      m_waiting{false},
+      m_mutex{},
+      m_readable{} {}
+
+void dispatched_stream::impl::set_stream_id(const fh_stream_id_t stream_id) {
+  m_stream_id.store(stream_id, std::memory_order_release);
+  return;
+}
+
+bool dispatched_stream::impl::push(h2_frame_ptr frame) {
+  // Behind the frames set aside already
+  if (m_overflow.empty() && m_queue.try_push(std::move(frame))) {
+    notify();
+    return true;
+  }
+  m_overflow.push_back(std::move(frame));
+  return false;
+}
+
+bool dispatched_stream::impl::flush_overflow() {
+  auto pushed = false;
+  while (m_overflow.empty() == false &&
+         m_queue.try_push(std::move(m_overflow.front()))) {
+    m_overflow.pop_front();
+    pushed = true;
+  }
+  if (m_overflow.empty() && m_end_pending) {
+    publish_end();
+  } else if (pushed) {
+    notify();
+  }
+  return m_overflow.empty();
+}
+
+void dispatched_stream::impl::end(std::exception_ptr error) {
+  m_error = std::move(error);
+  m_end_pending = true;
+  if (m_overflow.empty()) {
+    publish_end();
+  }
+  return;
+}
+
+fh_stream_id_t dispatched_stream::impl::get_stream_id() const {
+  return m_stream_id.load(std::memory_order_acquire);
+}
+
+h2_frame_ptr dispatched_stream::impl::pop(
+    const std::chrono::milliseconds timeout) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  h2_frame_ptr frame{};
+
+  while (true) {
+    if (m_queue.try_pop(&frame)) {
+      return frame;
+    }
+    if (m_ended.load(std::memory_order_acquire)) {
+      // A frame pushed right before the end
+      if (m_queue.try_pop(&frame)) {
+        return frame;
+      }
+      if (m_error) {
+        std::rethrow_exception(m_error);
+      }
+      return nullptr;
+    }
+    if (std::chrono::steady_clock::now() >= deadline) {
+      return nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_waiting.store(true, std::memory_order_relaxed);
+    // Pairs with the fence in notify(): either the reader thread sees
+    // m_waiting, or this thread sees what it pushed.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_queue.is_empty() &&
+        m_ended.load(std::memory_order_relaxed) == false) {
+      m_readable.wait_until(lock, deadline);
+    }
+    m_waiting.store(false, std::memory_order_relaxed);
+  }
+}
+
+bool dispatched_stream::impl::is_finished() const {
+  return m_ended.load(std::memory_order_acquire) && m_queue.is_empty();
+}
+
+void dispatched_stream::impl::publish_end() {
+  m_end_pending = false;
+  m_ended.store(true, std::memory_order_release);
+  notify();
+  return;
+}
+
+void dispatched_stream::impl::notify() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_waiting.load(std::memory_order_relaxed)) {
+    // Once the consumer holding the lock has started waiting
+    { std::lock_guard<std::mutex> lock{m_mutex}; }
+    m_readable.notify_one();
+  }
+  return;
+}
+
+dispatched_stream::dispatched_stream(std::shared_ptr<impl> pimpl)
+    : m_pimpl{std::move(pimpl)} {}
+
+dispatched_stream::~dispatched_stream() = default;
+
+fh_stream_id_t dispatched_stream::get_stream_id() const {
+  return m_pimpl->get_stream_id();
+}
+
+h2_frame_ptr dispatched_stream::pop(const std::chrono::milliseconds timeout) {
+  return m_pimpl->pop(timeout);
+}
+
+bool dispatched_stream::is_finished() const { return m_pimpl->is_finished(); }
+
+/* definitions of connection_dispatcher */
+
+class connection_dispatcher::impl {
+ public:
+  impl(std::unique_ptr<http2_client> client,
+       const dispatcher_options& options);
+  ~impl();
+
+  std::shared_ptr<dispatched_stream> submit(
+      const header_block_t& header_block, const header_encode_mode mode,
+      std::unique_ptr<body::i_body_source> body);
+  void submit(const header_block_t& header_block,
+              const header_encode_mode mode, stream_callback callback,
+              std::unique_ptr<body::i_body_source> body);
+  void post(std::function<void(http2_client* client)> task);
+
+  std::exception_ptr get_error() const;
+
+ private:
+  // Where the frames of a stream go, either of the two
+  struct route {
+    std::shared_ptr<dispatched_stream::impl> m_stream;
+    stream_callback m_callback;
+    // END_STREAM arrived, and its header block goes on in CONTINUATION.
+    bool m_end_stream;
+  };
+  struct request {
+    header_block_t m_header_block;
+    header_encode_mode m_mode;
+    std::unique_ptr<body::i_body_source> m_body;
+    route m_route;
+  };
+  // A request to send, or a task to run
+  struct task {
+    std::unique_ptr<request> m_request;
+    std::function<void(http2_client* client)> m_run;
+  };
+
+  void enqueue(task posted);
+  void wake();
+  void run();
+  // Waits for a frame, or for the wake-up of a posted task.
+  bool wait_readable(const std::chrono::milliseconds timeout);
+  void run_tasks();
+  // Opens a stream for the request, or has it wait for one.
+  void send(std::unique_ptr<request> posted);
+  // Sends the requests waiting, as far as the streams the peer allows go.
+  void send_waiting_requests();
+  bool is_stream_available() const;
+  // Ends the request unless the connection can still open a stream for it.
+  bool fail_unless_sendable(request* posted);
+  void open_stream(request* posted);
+  void dispatch(h2_frame_ptr frame);
+  void deliver(route* target, h2_frame_ptr frame);
+  void end(route* target, std::exception_ptr error);
+  void flush_overflows();
+  void fail(std::exception_ptr error);
+
+  std::unique_ptr<http2_client> m_client;
+  dispatcher_options m_options;
+  mpsc_queue<task> m_tasks;
+  // Written to by enqueue() to interrupt the wait of the reader thread
+  net::socket_fd m_wake_fd;
+  // The reader thread is about to wait on m_wake_fd.
+  std::atomic<bool> m_sleeping;
+  std::atomic<bool> m_stopping;
+  // Written before m_failed
+  std::exception_ptr m_error;
+  std::atomic<bool> m_failed;
+  // Reader thread only
+  std::unordered_map<fh_stream_id_t, route> m_routes;
+  std::vector<std::shared_ptr<dispatched_stream::impl>> m_overflowing;
+  // Requests waiting for SETTINGS_MAX_CONCURRENT_STREAMS, in the order
+  // submitted
+  std::deque<std::unique_ptr<request>> m_waiting_requests;
+  fh_stream_id_t m_next_stream_id;
+  // Started last, once every other member is ready
+  std::thread m_reader;
+};
+
+connection_dispatcher::impl::impl(std::unique_ptr<http2_client> client,
+                                  const dispatcher_options& options)
+    : m_client{std::move(client)},
+      m_options{options},
+      m_tasks{},
+      m_wake_fd{make_eventfd()},
+      m_sleeping{false},
+      m_stopping{false},
+      m_error{},
+      m_failed{false},
+      m_routes{},
+      m_overflowing{},
+      m_waiting_requests{},
+      m_next_stream_id{1u},
+      m_reader{} {
+  m_reader = std::thread{[this]() { run(); }};
+}
+
+connection_dispatcher::impl::~impl() {
+  m_stopping.store(true);
+  wake();
+  m_reader.join();
+}
+
+std::shared_ptr<dispatched_stream> connection_dispatcher::impl::submit(
+    const header_block_t& header_block, const header_encode_mode mode,
+    std::unique_ptr<body::i_body_source> body) {
+  auto stream = std::make_shared<dispatched_stream::impl>(
+      m_options.m_stream_queue_capacity);
+  enqueue({std::make_unique<request>(request{
+               header_block, mode, std::move(body), {stream, {}, false}}),
+           {}});
+  return std::shared_ptr<dispatched_stream>{
+      new dispatched_stream{std::move(stream)}};
+}
+
+void connection_dispatcher::impl::submit(
+    const header_block_t& header_block, const header_encode_mode mode,
+    stream_callback callback, std::unique_ptr<body::i_body_source> body) {
+  enqueue({std::make_unique<request>(request{header_block,
+                                             mode,
+                                             std::move(body),
+                                             {nullptr, std::move(callback),
+                                              false}}),
+           {}});
+  return;
+}
+
+void connection_dispatcher::impl::post(
+    std::function<void(http2_client* client)> task) {
+  enqueue({nullptr, std::move(task)});
+  return;
+}
+
+std::exception_ptr connection_dispatcher::impl::get_error() const {
+  return m_failed.load(std::memory_order_acquire) ? m_error : nullptr;
+}
+
+void connection_dispatcher::impl::enqueue(task posted) {
+  m_tasks.push(std::move(posted));
+  // Pairs with the fence in wait_readable(): either the reader thread sees
+  // the task, or this thread sees it going to sleep.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_sleeping.load(std::memory_order_relaxed) &&
+      m_sleeping.exchange(false)) {
+    wake();
+  }
+  return;
+}
+
+void connection_dispatcher::impl::wake() {
+  const uint64_t count{1u};
+  // Fails only with EAGAIN, when the counter is already far from zero
+  [[maybe_unused]] const auto result =
+      ::write(m_wake_fd.get(), &count, sizeof(count));
+  return;
+}
+
+void connection_dispatcher::impl::run() {
+  try {
+    while (m_stopping.load() == false) {
+      run_tasks();
+      // The last frame may have closed a stream, or raised the limit.
+      send_waiting_requests();
+      flush_overflows();
+      if (wait_readable(m_overflowing.empty() ? IDLE_WAIT_INTERVAL
+                                              : OVERFLOW_RETRY_INTERVAL)) {
+        dispatch(m_client->receive_frame());
+      }
+    }
+    fail(std::make_exception_ptr(
+        std::runtime_error("connection dispatcher stopped")));
+    return;
+  } catch (...) {
+    fail(std::current_exception());
+  }
+
+  // The requests posted from now on fail right away.
+  while (m_stopping.load() == false) {
+    flush_overflows();
+    m_sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_tasks.is_empty()) {
+      net::wait_for_events(m_wake_fd.get(), POLLIN,
+                           m_overflowing.empty() ? IDLE_WAIT_INTERVAL
+                                                 : OVERFLOW_RETRY_INTERVAL);
+    }
+    m_sleeping.store(false, std::memory_order_relaxed);
+    uint64_t count{};
+    [[maybe_unused]] const auto result =
+        ::read(m_wake_fd.get(), &count, sizeof(count));
+    run_tasks();
+  }
+  return;
+}
+
+bool connection_dispatcher::impl::wait_readable(
+    const std::chrono::milliseconds timeout) {
+  m_sleeping.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_tasks.is_empty() == false) {
+    m_sleeping.store(false, std::memory_order_relaxed);
+    return false;
+  }
+
+  const auto readable = m_client->wait_readable(timeout, m_wake_fd.get());
+  m_sleeping.store(false, std::memory_order_relaxed);
+  uint64_t count{};
+  [[maybe_unused]] const auto result =
+      ::read(m_wake_fd.get(), &count, sizeof(count));
+  return readable;
+}
+
+void connection_dispatcher::impl::run_tasks() {
+  task posted{};
+  while (m_tasks.try_pop(&posted)) {
+    if (m_failed.load(std::memory_order_relaxed)) {
+      if (posted.m_request) {
+        end(&posted.m_request->m_route, m_error);
+      }
+      continue;
+    }
+    if (posted.m_request) {
+      send(std::move(posted.m_request));
+    } else {
+      posted.m_run(m_client.get());
+    }
+  }
+  return;
+}
+
+void connection_dispatcher::impl::send(std::unique_ptr<request> posted) {
+  if (fail_unless_sendable(posted.get())) {
+    return;
+  }
+  // cf. https://tools.ietf.org/html/rfc7540#section-5.1.2
+  if (m_waiting_requests.empty() == false || is_stream_available() == false) {
+    m_waiting_requests.push_back(std::move(posted));
+    return;
+  }
+  open_stream(posted.get());
+  return;
+}
+
+void connection_dispatcher::impl::send_waiting_requests() {
+  while (m_waiting_requests.empty() == false) {
+    if (fail_unless_sendable(m_waiting_requests.front().get()) == false) {
+      if (is_stream_available() == false) {
+        return;
+      }
+      open_stream(m_waiting_requests.front().get());
+    }
+    m_waiting_requests.pop_front();
+  }
+  return;
+}
+
+bool connection_dispatcher::impl::is_stream_available() const {
+  return m_client->get_active_stream_count() <
+         m_client->get_settings().get_remote().get(
+             sf_parameter::SETTINGS_MAX_CONCURRENT_STREAM);
+}
+
+bool connection_dispatcher::impl::fail_unless_sendable(request* posted) {
+  if (m_client->is_draining() == false && m_next_stream_id <= MAX_STREAM_ID) {
+    return false;
+  }
+  end(&posted->m_route, std::make_exception_ptr(stream_unprocessed(
+                            m_client->is_draining()
+                                ? "connection is draining"
+                                : "stream identifiers are exhausted")));
+  return true;
+}
+
+void connection_dispatcher::impl::open_stream(request* posted) {
+  const auto stream_id = m_next_stream_id;
+  try {
+    m_client->send_headers(
+        posted->m_body ? fh_flags_t{0u}
+                       : make_frame_header_flags(hf_flag::END_STREAM),
+        stream_id, posted->m_header_block, posted->m_mode);
+  } catch (const std::invalid_argument&) {
+    // Nothing was sent; the stream identifier is still unused.
+    end(&posted->m_route, std::current_exception());
+    return;
+  }
+  m_next_stream_id += 2u;
+
+  if (posted->m_route.m_stream) {
+    posted->m_route.m_stream->set_stream_id(stream_id);
+  }
+  m_routes.emplace(stream_id, std::move(posted->m_route));
+  if (posted->m_body) {
+    m_client->send_body(stream_id, std::move(posted->m_body));
+  }
+  return;
+}
+
+void connection_dispatcher::impl::dispatch(h2_frame_ptr frame) {
+  const auto fh = frame->get_header();
+  const auto ite = m_routes.find(fh.m_stream_id);
+  if (ite == m_routes.end()) {
+    if (m_options.m_on_connection_frame) {
+      m_options.m_on_connection_frame(frame);
+    }
+  } else {
+    auto& target = ite->second;
+    auto ended = false;
+    switch (cast_to_frame_type_registry(fh.m_type)) {
+      case frame_type_registry::HEADERS:
+        target.m_end_stream = is_flag_set(fh.m_flags, hf_flag::END_STREAM);
+        ended = target.m_end_stream &&
+                is_flag_set(fh.m_flags, hf_flag::END_HEADERS);
+        break;
+      case frame_type_registry::CONTINUATION:
+        ended = target.m_end_stream &&
+                is_flag_set(fh.m_flags, hf_flag::END_HEADERS);
+        break;
+      case frame_type_registry::DATA:
+        ended = is_flag_set(fh.m_flags, df_flag::END_STREAM);
+        break;
+      case frame_type_registry::RST_STREAM:
+        ended = true;
+        break;
+      default:
+        break;
+    }
+
+    deliver(&target, std::move(frame));
+    if (ended) {
+      end(&target, nullptr);
+      m_routes.erase(ite);
+    }
+  }
+
+  // cf. https://tools.ietf.org/html/rfc7540#section-6.8
+  if (m_client->is_draining()) {
+    for (const auto stream_id : m_client->take_unprocessed_streams()) {
+      const auto unprocessed = m_routes.find(stream_id);
+      if (unprocessed != m_routes.end()) {
+        end(&unprocessed->second,
+            std::make_exception_ptr(stream_unprocessed(
+                "stream " + std::to_string(stream_id) +
+                " was not processed before GOAWAY")));
+        m_routes.erase(unprocessed);
+      }
+    }
+  }
+  return;
+}
+
+void connection_dispatcher::impl::deliver(route* target, h2_frame_ptr frame) {
+  if (target->m_callback) {
+    target->m_callback(std::move(frame), nullptr);
+    return;
+  }
+
+  const auto& stream = target->m_stream;
+  if (stream->push(std::move(frame)) == false &&
+      std::find(m_overflowing.begin(), m_overflowing.end(), stream) ==
+          m_overflowing.end()) {
+    m_overflowing.push_back(stream);
+  }
+  return;
+}
+
+void connection_dispatcher::impl::end(route* target,
+                                      std::exception_ptr error) {
+  if (target->m_callback) {
+    if (error) {
+      target->m_callback(nullptr, std::move(error));
+    }
+    return;
+  }
+  target->m_stream->end(std::move(error));
+  return;
+}
+
+void connection_dispatcher::impl::flush_overflows() {
+  m_overflowing.erase(
+      std::remove_if(m_overflowing.begin(), m_overflowing.end(),
+                     [](const std::shared_ptr<dispatched_stream::impl>&
+                            stream) { return stream->flush_overflow(); }),
+      m_overflowing.end());
+  return;
+}
+
+void connection_dispatcher::impl::fail(std::exception_ptr error) {
+  m_error = std::move(error);
+  m_failed.store(true, std::memory_order_release);
+  for (auto& [stream_id, target] : m_routes) {
+    end(&target, m_error);
+  }
+  m_routes.clear();
+  for (const auto& waiting : m_waiting_requests) {
+    end(&waiting->m_route, m_error);
+  }
+  m_waiting_requests.clear();
+  run_tasks();
+  return;
+}
+
+connection_dispatcher::connection_dispatcher(
+    std::unique_ptr<http2_client> client, const dispatcher_options& options)
+    : m_pimpl{std::make_unique<impl>(std::move(client), options)} {}
+
+connection_dispatcher::~connection_dispatcher() = default;
+
+std::shared_ptr<dispatched_stream> connection_dispatcher::submit(
+    const header_block_t& header_block, const header_encode_mode mode,
+    std::unique_ptr<body::i_body_source> body) {
+  return m_pimpl->submit(header_block, mode, std::move(body));
+}
+
+void connection_dispatcher::submit(const header_block_t& header_block,
+                                   const header_encode_mode mode,
+                                   stream_callback callback,
+                                   std::unique_ptr<body::i_body_source> body) {
+  m_pimpl->submit(header_block, mode, std::move(callback), std::move(body));
+  return;
+}
+
+void connection_dispatcher::post(
+    std::function<void(http2_client* client)> task) {
+  m_pimpl->post(std::move(task));
+  return;
+}
+
+std::exception_ptr connection_dispatcher::get_error() const {
+  return m_pimpl->get_error();
+}
+
+}  // namespace mh2c
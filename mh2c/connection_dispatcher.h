@@ -0,0 +1,128 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_CONNECTION_DISPATCHER_H_
+#define MH2C_CONNECTION_DISPATCHER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+#include "mh2c/body/body_source.h"
+#include "mh2c/frame/common_type.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/http2_client.h"
+
+namespace mh2c {
+
+// Ends a stream the server never processed because of GOAWAY; the request is
+// safe to retry on another connection.
+// cf. https://tools.ietf.org/html/rfc7540#section-8.1.4
+class stream_unprocessed : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Takes the frames of a stream on the reader thread, which it must not
+// block; an exception it throws ends the connection. error is set, with a
+// nullptr frame, when the stream or the connection fails before END_STREAM
+// or RST_STREAM arrived.
+using stream_callback =
+    std::function<void(h2_frame_ptr frame, std::exception_ptr error)>;
+
+struct dispatcher_options {
+  // Frames a stream queue holds. The reader thread sets the next ones aside,
+  // rather than stalling the other streams, until they are popped.
+  size_t m_stream_queue_capacity{64u};
+  // Called on the reader thread with the frames of stream 0, e.g. SETTINGS,
+  // PING and GOAWAY, and of the streams not submitted, e.g. pushed ones. The
+  // client has already applied them.
+  std::function<void(const h2_frame_ptr& frame)> m_on_connection_frame{};
+};
+
+// Response frames of a stream submitted with a queue, in the order they
+// arrived. One thread at a time may pop them.
+class dispatched_stream {
+ public:
+  ~dispatched_stream();
+
+  dispatched_stream(const dispatched_stream&) = delete;
+  dispatched_stream& operator=(const dispatched_stream&) = delete;
+
+  // 0 until the reader thread has sent the HEADERS
+  fh_stream_id_t get_stream_id() const;
+  // Next frame, or nullptr when none arrived before the timeout or, right
+  // away, when the stream has ended and every frame has been popped. Throws
+  // the error that ended the stream before END_STREAM or RST_STREAM, e.g.
+  // stream_unprocessed or transport::transport_closed, once drained.
+  h2_frame_ptr pop(const std::chrono::milliseconds timeout);
+  // The stream has ended and every frame has been popped.
+  bool is_finished() const;
+
+ private:
+  friend class connection_dispatcher;
+  class impl;
+
+  explicit dispatched_stream(std::shared_ptr<impl> pimpl);
+
+  std::shared_ptr<impl> m_pimpl;
+};
+
+// Shares one connection among many application threads. A reader thread
+// takes over the client: it receives and decodes every frame, in order, and
+// hands each to the queue or the callback of its stream. The threads post
+// requests and frames to a lock-free send queue that the reader thread
+// drains between frames, so that stream identifiers and the request HPACK
+// table follow the order the frames are written in. Neither side takes a
+// lock on the way; a thread waiting in dispatched_stream::pop() sleeps on a
+// condition variable of its own stream.
+class connection_dispatcher {
+ public:
+  // Takes a client that has exchanged SETTINGS and opened no stream yet.
+  // Nothing may use it but the tasks posted from now on.
+  explicit connection_dispatcher(std::unique_ptr<http2_client> client,
+                                 const dispatcher_options& options = {});
+  // Stops the reader thread; the streams not ended yet fail with
+  // std::runtime_error.
+  ~connection_dispatcher();
+
+  connection_dispatcher(const connection_dispatcher&) = delete;
+  connection_dispatcher& operator=(const connection_dispatcher&) = delete;
+
+  // Sends the request on the next stream, see http2_client::send_headers()
+  // and http2_client::send_body(); without a body its HEADERS carry
+  // END_STREAM. Past SETTINGS_MAX_CONCURRENT_STREAMS of the server, the
+  // requests wait in the order submitted until streams close. They fail with
+  // stream_unprocessed once the connection drains or runs out of stream
+  // identifiers. Thread-safe.
+  std::shared_ptr<dispatched_stream> submit(
+      const header_block_t& header_block, const header_encode_mode mode,
+      std::unique_ptr<body::i_body_source> body = nullptr);
+  void submit(const header_block_t& header_block,
+              const header_encode_mode mode, stream_callback callback,
+              std::unique_ptr<body::i_body_source> body = nullptr);
+  // Sends the frame from the reader thread. Thread-safe.
+  template <typename Frame>
+  void post_frame(const Frame& frame);
+  // Runs the task on the reader thread between two frames, the only place
+  // the client may be used. An exception it throws ends the connection.
+  // Thread-safe.
+  void post(std::function<void(http2_client* client)> task);
+
+  // The error that ended the connection, nullptr while it is up
+  std::exception_ptr get_error() const;
+
+ private:
+  class impl;
+  std::unique_ptr<impl> m_pimpl;
+};
+
+}  // namespace mh2c
+
+#include "mh2c/connection_dispatcher.ipp"
+
+#endif  // MH2C_CONNECTION_DISPATCHER_H_
@@ -0,0 +1,17 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_CONNECTION_DISPATCHER_IPP_
+#define MH2C_CONNECTION_DISPATCHER_IPP_
+
+namespace mh2c {
+
+template <typename Frame>
+void connection_dispatcher::post_frame(const Frame& frame) {
+  post([frame](http2_client* client) { client->send_frame(frame); });
+  return;
+}
+
+}  // namespace mh2c
+
+#endif  // MH2C_CONNECTION_DISPATCHER_IPP_
@@ -0,0 +1,473 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/coro/async_client.h"
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <list>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "mh2c/body/body_source.h"
+#include "mh2c/common/byte_array.h"
+#include "mh2c/connection_dispatcher.h"
+#include "mh2c/coro/task.h"
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/frame_builder.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/rst_stream_frame.h"
+#include "mh2c/frame/settings_frame.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/http2_client.h"
+#include "mh2c/util/bit_operation.h"
+#include "mh2c/util/cast.h"
+
+namespace mh2c {
+
+namespace coro {
+
+namespace {
+
+// run() waits this long for a frame at a time.
+constexpr std::chrono::milliseconds IDLE_WAIT_INTERVAL{1000};
+
+bool is_informational(const headers_t& headers) {
+  for (const auto& header : headers) {
+    if (header.first == ":status") {
+      return header.second.size() == 3u && header.second.front() == '1';
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+/* definitions of response_state */
+
+class response_state {
+ public:
+  explicit response_state(const fh_stream_id_t stream_id)
+      : m_stream_id{stream_id},
+        m_headers{},
+        m_header_block{},
+        m_in_header_block{false},
+        m_end_stream{false},
+        m_chunks{},
+        m_ended{false},
+        m_error{},
+        m_waiter{} {}
+
+  void throw_if_failed() const {
+    if (m_error) {
+      std::rethrow_exception(m_error);
+    }
+    return;
+  }
+
+  fh_stream_id_t m_stream_id;
+  // Final response
+  std::optional<headers_t> m_headers;
+  // Header block going on in CONTINUATION, and the END_STREAM of its HEADERS
+  headers_t m_header_block;
+  bool m_in_header_block;
+  bool m_end_stream;
+  std::deque<byte_array_t> m_chunks;
+  bool m_ended;
+  std::exception_ptr m_error;
+  // Coroutine reading the stream
+  std::coroutine_handle<> m_waiter;
+};
+
+/* definitions of response_stream */
+
+response_stream::headers_awaiter::headers_awaiter(
+    std::shared_ptr<response_state> state)
+    : m_state{std::move(state)} {}
+
+bool response_stream::headers_awaiter::await_ready() const {
+  return m_state->m_headers || m_state->m_ended;
+}
+
+void response_stream::headers_awaiter::await_suspend(
+    std::coroutine_handle<> awaiter) {
+  m_state->m_waiter = awaiter;
+  return;
+}
+
+headers_t response_stream::headers_awaiter::await_resume() {
+  if (m_state->m_headers) {
+    return *m_state->m_headers;
+  }
+  m_state->throw_if_failed();
+  throw std::runtime_error("stream " + std::to_string(m_state->m_stream_id) +
+                           " ended without a response");
+}
+
+response_stream::body_chunk_awaiter::body_chunk_awaiter(
+    std::shared_ptr<response_state> state)
+    : m_state{std::move(state)} {}
+
+bool response_stream::body_chunk_awaiter::await_ready() const {
+  return m_state->m_chunks.empty() == false || m_state->m_ended;
+}
+
+void response_stream::body_chunk_awaiter::await_suspend(
+    std::coroutine_handle<> awaiter) {
+  m_state->m_waiter = awaiter;
+  return;
+}
+
+byte_array_t response_stream::body_chunk_awaiter::await_resume() {
+  if (m_state->m_chunks.empty() == false) {
+    auto chunk = std::move(m_state->m_chunks.front());
+    m_state->m_chunks.pop_front();
+    return chunk;
+  }
+  m_state->throw_if_failed();
+  return {};
+}
+
+response_stream::response_stream(std::shared_ptr<response_state> state)
+    : m_state{std::move(state)} {}
+
+fh_stream_id_t response_stream::get_stream_id() const {
+  return m_state->m_stream_id;
+}
+
+response_stream::headers_awaiter response_stream::read_headers() {
+  return headers_awaiter{m_state};
+}
+
+response_stream::body_chunk_awaiter response_stream::read_body_chunk() {
+  return body_chunk_awaiter{m_state};
+}
+
+/* definitions of async_client */
+
+class async_client::impl {
+ public:
+  explicit impl(std::unique_ptr<http2_client> client);
+
+  // Reserves a stream for a request, false when it has to wait for one.
+  bool reserve_stream();
+  void wait_for_stream(std::coroutine_handle<> awaiter);
+  response_stream send(const header_block_t& header_block,
+                       const header_encode_mode mode,
+                       std::unique_ptr<body::i_body_source> body);
+
+  void spawn(task<> coroutine);
+  void run();
+
+  const http2_client& get_client() const;
+
+ private:
+  void dispatch(const h2_frame_ptr& frame);
+  void on_header_block(response_state* state, const headers_t& headers);
+  void end(const fh_stream_id_t stream_id, std::exception_ptr error);
+  void release_stream();
+  void wake(response_state* state);
+  void fail(std::exception_ptr error);
+
+  std::unique_ptr<http2_client> m_client;
+  std::unordered_map<fh_stream_id_t, std::shared_ptr<response_state>>
+      m_streams;
+  // Streams sent or reserved, not ended yet
+  size_t m_reserved_count;
+  // Requests waiting for SETTINGS_MAX_CONCURRENT_STREAMS
+  std::deque<std::coroutine_handle<>> m_stream_waiters;
+  std::deque<std::coroutine_handle<>> m_ready;
+  std::list<task<>> m_tasks;
+  fh_stream_id_t m_next_stream_id;
+  // The error that ended the connection
+  std::exception_ptr m_error;
+};
+
+async_client::impl::impl(std::unique_ptr<http2_client> client)
+    : m_client{std::move(client)},
+      m_streams{},
+      m_reserved_count{0},
+      m_stream_waiters{},
+      m_ready{},
+      m_tasks{},
+      m_next_stream_id{1u},
+      m_error{} {
+  m_client->enable_window_autotuning();
+}
+
+bool async_client::impl::reserve_stream() {
+  const auto max_concurrent_streams = m_client->get_settings().get_remote().get(
+      sf_parameter::SETTINGS_MAX_CONCURRENT_STREAM);
+  if (m_error == nullptr && m_stream_waiters.empty() == false) {
+    return false;
+  }
+  if (m_error == nullptr && m_reserved_count >= max_concurrent_streams) {
+    return false;
+  }
+  ++m_reserved_count;
+  return true;
+}
+
+void async_client::impl::wait_for_stream(std::coroutine_handle<> awaiter) {
+  m_stream_waiters.push_back(awaiter);
+  return;
+}
+
+response_stream async_client::impl::send(
+    const header_block_t& header_block, const header_encode_mode mode,
+    std::unique_ptr<body::i_body_source> body) {
+  if (m_error) {
+    release_stream();
+    std::rethrow_exception(m_error);
+  }
+  if (m_client->is_draining()) {
+    release_stream();
+    throw stream_unprocessed("connection is draining");
+  }
+
+  const auto stream_id = m_next_stream_id;
+  try {
+    m_client->send_headers(
+        body ? fh_flags_t{0u} : make_frame_header_flags(hf_flag::END_STREAM),
+        stream_id, header_block, mode);
+  } catch (...) {
+    release_stream();
+    throw;
+  }
+  m_next_stream_id += 2u;
+
+  auto state = std::make_shared<response_state>(stream_id);
+  m_streams.emplace(stream_id, state);
+  if (body) {
+    m_client->send_body(stream_id, std::move(body));
+  }
+  return response_stream{std::move(state)};
+}
+
+void async_client::impl::spawn(task<> coroutine) {
+  m_ready.push_back(coroutine.get_handle());
+  m_tasks.push_back(std::move(coroutine));
+  return;
+}
+
+void async_client::impl::run() {
+  while (m_tasks.empty() == false) {
+    while (m_ready.empty() == false) {
+      const auto handle = m_ready.front();
+      m_ready.pop_front();
+      handle.resume();
+    }
+
+    for (auto ite = m_tasks.begin(); ite != m_tasks.end();) {
+      if (ite->is_done() == false) {
+        ++ite;
+        continue;
+      }
+      const auto completed = std::move(*ite);
+      ite = m_tasks.erase(ite);
+      completed.get_handle().promise().rethrow_if_failed();
+    }
+    if (m_tasks.empty() || m_ready.empty() == false) {
+      continue;
+    }
+    // fail() has resumed every coroutine waiting for the connection; those
+    // still suspended wait for something no frame will bring.
+    if (m_error) {
+      m_tasks.clear();
+      std::rethrow_exception(m_error);
+    }
+
+    try {
+      if (m_client->wait_readable(IDLE_WAIT_INTERVAL)) {
+        dispatch(m_client->receive_frame());
+      }
+    } catch (...) {
+      fail(std::current_exception());
+    }
+  }
+  return;
+}
+
+const http2_client& async_client::impl::get_client() const {
+  return *m_client;
+}
+
+void async_client::impl::dispatch(const h2_frame_ptr& frame) {
+  const auto fh = frame->get_header();
+  const auto ite = m_streams.find(fh.m_stream_id);
+  if (ite != m_streams.end()) {
+    const auto state = ite->second;
+    switch (cast_to_frame_type_registry(fh.m_type)) {
+      case frame_type_registry::HEADERS:
+        state->m_header_block.clear();
+        state->m_end_stream = is_flag_set(fh.m_flags, hf_flag::END_STREAM);
+        [[fallthrough]];
+      case frame_type_registry::CONTINUATION:
+        for (const auto& entry : get_header_block(*frame)) {
+          if (entry.get_prefix() != header_prefix_pattern::SIZE_UPDATE) {
+            state->m_header_block.push_back(entry.get_header());
+          }
+        }
+        if (is_flag_set(fh.m_flags, hf_flag::END_HEADERS)) {
+          on_header_block(state.get(), state->m_header_block);
+          if (state->m_end_stream) {
+            end(fh.m_stream_id, nullptr);
+          }
+        }
+        break;
+      case frame_type_registry::DATA: {
+        auto payload = dynamic_cast<const data_frame&>(*frame).get_payload();
+        if (is_flag_set(fh.m_flags, df_flag::PADDED)) {
+          const auto pad_length = get_pad_length(payload);
+          payload.erase(payload.end() - pad_length, payload.end());
+          payload.erase(payload.begin());
+        }
+        if (payload.empty() == false) {
+          state->m_chunks.push_back(std::move(payload));
+          wake(state.get());
+        }
+        if (is_flag_set(fh.m_flags, df_flag::END_STREAM)) {
+          end(fh.m_stream_id, nullptr);
+        }
+        break;
+      }
+      case frame_type_registry::RST_STREAM:
+        end(fh.m_stream_id,
+            std::make_exception_ptr(std::runtime_error(
+                "stream " + std::to_string(fh.m_stream_id) +
+                " reset: error_code=" +
+                std::to_string(underlying_cast(
+                    dynamic_cast<const rst_stream_frame&>(*frame)
+                        .get_payload())))));
+        break;
+      default:
+        break;
+    }
+  }
+
+  // cf. https://tools.ietf.org/html/rfc7540#section-6.8
+  if (m_client->is_draining()) {
+    for (const auto stream_id : m_client->take_unprocessed_streams()) {
+      end(stream_id, std::make_exception_ptr(stream_unprocessed(
+                         "stream " + std::to_string(stream_id) +
+                         " was not processed before GOAWAY")));
+    }
+  }
+  return;
+}
+
+void async_client::impl::on_header_block(response_state* state,
+                                         const headers_t& headers) {
+  // Trailers are not kept.
+  if (state->m_headers || is_informational(headers)) {
+    return;
+  }
+  state->m_headers = headers;
+  wake(state);
+  return;
+}
+
+void async_client::impl::end(const fh_stream_id_t stream_id,
+                             std::exception_ptr error) {
+  const auto ite = m_streams.find(stream_id);
+  if (ite == m_streams.end()) {
+    return;
+  }
+  const auto state = ite->second;
+  m_streams.erase(ite);
+  state->m_ended = true;
+  state->m_error = std::move(error);
+  wake(state.get());
+  release_stream();
+  return;
+}
+
+void async_client::impl::release_stream() {
+  // Handed over to the request waiting for it
+  if (m_stream_waiters.empty() == false) {
+    m_ready.push_back(m_stream_waiters.front());
+    m_stream_waiters.pop_front();
+    return;
+  }
+  --m_reserved_count;
+  return;
+}
+
+void async_client::impl::wake(response_state* state) {
+  if (state->m_waiter) {
+    m_ready.push_back(std::exchange(state->m_waiter, nullptr));
+  }
+  return;
+}
+
+void async_client::impl::fail(std::exception_ptr error) {
+  m_error = error;
+  while (m_streams.empty() == false) {
+    end(m_streams.begin()->first, error);
+  }
+  // They fail once resumed.
+  while (m_stream_waiters.empty() == false) {
+    release_stream();
+  }
+  return;
+}
+
+async_client::request_awaiter::request_awaiter(
+    async_client* client, const header_block_t& header_block,
+    const header_encode_mode mode, std::unique_ptr<body::i_body_source> body)
+    : m_client{client},
+      m_header_block{header_block},
+      m_mode{mode},
+      m_body{std::move(body)} {}
+
+bool async_client::request_awaiter::await_ready() {
+  return m_client->m_pimpl->reserve_stream();
+}
+
+void async_client::request_awaiter::await_suspend(
+    std::coroutine_handle<> awaiter) {
+  m_client->m_pimpl->wait_for_stream(awaiter);
+  return;
+}
+
+response_stream async_client::request_awaiter::await_resume() {
+  return m_client->m_pimpl->send(m_header_block, m_mode, std::move(m_body));
+}
+
+async_client::async_client(std::unique_ptr<http2_client> client)
+    : m_pimpl{std::make_unique<impl>(std::move(client))} {}
+
+async_client::~async_client() = default;
+
+async_client::request_awaiter async_client::request(
+    const header_block_t& header_block, const header_encode_mode mode,
+    std::unique_ptr<body::i_body_source> body) {
+  return request_awaiter{this, header_block, mode, std::move(body)};
+}
+
+void async_client::spawn(task<> coroutine) {
+  m_pimpl->spawn(std::move(coroutine));
+  return;
+}
+
+void async_client::run() {
+  m_pimpl->run();
+  return;
+}
+
+const http2_client& async_client::get_client() const {
+  return m_pimpl->get_client();
+}
+
+}  // namespace coro
+
+}  // namespace mh2c
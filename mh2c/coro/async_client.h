@@ -0,0 +1,136 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_CORO_ASYNC_CLIENT_H_
+#define MH2C_CORO_ASYNC_CLIENT_H_
+
+#include <coroutine>
+#include <memory>
+
+#include "mh2c/body/body_source.h"
+#include "mh2c/common/byte_array.h"
+#include "mh2c/coro/task.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/http2_client.h"
+
+namespace mh2c {
+
+namespace coro {
+
+// What has arrived on a stream, kept by async_client
+class response_state;
+
+// Response of a request sent by async_client, read from one coroutine at a
+// time. Copies refer to the same stream.
+class response_stream {
+ public:
+  class headers_awaiter {
+   public:
+    bool await_ready() const;
+    void await_suspend(std::coroutine_handle<> awaiter);
+    headers_t await_resume();
+
+   private:
+    friend class response_stream;
+
+    explicit headers_awaiter(std::shared_ptr<response_state> state);
+
+    std::shared_ptr<response_state> m_state;
+  };
+
+  class body_chunk_awaiter {
+   public:
+    bool await_ready() const;
+    void await_suspend(std::coroutine_handle<> awaiter);
+    byte_array_t await_resume();
+
+   private:
+    friend class response_stream;
+
+    explicit body_chunk_awaiter(std::shared_ptr<response_state> state);
+
+    std::shared_ptr<response_state> m_state;
+  };
+
+  fh_stream_id_t get_stream_id() const;
+  // Resumes with the header list of the final response; 1xx responses are
+  // skipped. Throws the error that ended the stream or the connection, e.g.
+  // stream_unprocessed, and std::runtime_error for a stream reset or ended
+  // without a response.
+  headers_awaiter read_headers();
+  // Resumes with the payload of the next DATA frame, padding removed, and
+  // with an empty one once the body has ended. Throws like read_headers()
+  // once the payloads received are read.
+  body_chunk_awaiter read_body_chunk();
+
+ private:
+  friend class async_client;
+
+  explicit response_stream(std::shared_ptr<response_state> state);
+
+  std::shared_ptr<response_state> m_state;
+};
+
+// Runs coroutines that send requests and read responses on one connection,
+// all on the thread calling run(). The loop resumes a coroutine once a frame
+// it waits for has arrived, so each request in flight costs a coroutine
+// frame rather than a thread. Built with MH2C_ENABLE_COROUTINES only.
+class async_client {
+ public:
+  class request_awaiter {
+   public:
+    bool await_ready();
+    void await_suspend(std::coroutine_handle<> awaiter);
+    response_stream await_resume();
+
+   private:
+    friend class async_client;
+
+    request_awaiter(async_client* client, const header_block_t& header_block,
+                    const header_encode_mode mode,
+                    std::unique_ptr<body::i_body_source> body);
+
+    async_client* m_client;
+    header_block_t m_header_block;
+    header_encode_mode m_mode;
+    std::unique_ptr<body::i_body_source> m_body;
+  };
+
+  // Takes a client that has exchanged SETTINGS and opened no stream yet,
+  // and enables its window autotuning so that the bodies keep flowing.
+  explicit async_client(std::unique_ptr<http2_client> client);
+  ~async_client();
+
+  async_client(const async_client&) = delete;
+  async_client& operator=(const async_client&) = delete;
+
+  // Sends the request on the next stream, see http2_client::send_headers()
+  // and http2_client::send_body(), once SETTINGS_MAX_CONCURRENT_STREAMS of
+  // the server allows another stream. Without a body its HEADERS carry
+  // END_STREAM.
+  request_awaiter request(const header_block_t& header_block,
+                          const header_encode_mode mode,
+                          std::unique_ptr<body::i_body_source> body = nullptr);
+  // Has run() start the coroutine.
+  void spawn(task<> coroutine);
+  // Resumes the coroutines until every one spawned has completed. Rethrows
+  // the first exception one of them lets escape. Once the connection has
+  // failed, the coroutines waiting on it resume with its error, and those
+  // still suspended afterwards are destroyed and the error rethrown.
+  void run();
+
+  // For the metrics and the settings; sending or receiving with it breaks
+  // the loop.
+  const http2_client& get_client() const;
+
+ private:
+  class impl;
+  std::unique_ptr<impl> m_pimpl;
+};
+
+}  // namespace coro
+
+}  // namespace mh2c
+
+#endif  // MH2C_CORO_ASYNC_CLIENT_H_
@@ -0,0 +1,99 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_CORO_TASK_H_
+#define MH2C_CORO_TASK_H_
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+
+namespace mh2c {
+
+namespace coro {
+
+template <typename T>
+class task;
+
+// State shared by the promises of task<T> and task<void>
+class task_promise_base {
+ public:
+  // Resumes the coroutine awaiting the task, if any, once it has completed.
+  class final_awaiter {
+   public:
+    bool await_ready() const noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> handle) noexcept;
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  final_awaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() { m_exception = std::current_exception(); }
+
+  void set_continuation(std::coroutine_handle<> continuation);
+  void rethrow_if_failed() const;
+
+ private:
+  std::coroutine_handle<> m_continuation{};
+  std::exception_ptr m_exception{};
+};
+
+template <typename T>
+class task_promise : public task_promise_base {
+ public:
+  task<T> get_return_object();
+  void return_value(T value) { m_value.emplace(std::move(value)); }
+  T take_value();
+
+ private:
+  std::optional<T> m_value{};
+};
+
+template <>
+class task_promise<void> : public task_promise_base {
+ public:
+  task<void> get_return_object();
+  void return_void() const {}
+};
+
+// Coroutine that starts when it is awaited, or when async_client::spawn()
+// takes it, and resumes its awaiter with the value it returns or the
+// exception it throws. Destroying the task destroys its coroutine frame.
+template <typename T = void>
+class task {
+ public:
+  using promise_type = task_promise<T>;
+
+  task(task&& other) noexcept;
+  task& operator=(task&& other) noexcept;
+  ~task();
+
+  task(const task&) = delete;
+  task& operator=(const task&) = delete;
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter);
+  T await_resume();
+
+  // For async_client::spawn(): the coroutine, started by resuming it, and
+  // whether it has completed
+  std::coroutine_handle<promise_type> get_handle() const;
+  bool is_done() const;
+
+ private:
+  friend class task_promise<T>;
+
+  explicit task(std::coroutine_handle<promise_type> handle);
+
+  std::coroutine_handle<promise_type> m_handle;
+};
+
+}  // namespace coro
+
+}  // namespace mh2c
+
+#include "mh2c/coro/task.ipp"
+
+#endif  // MH2C_CORO_TASK_H_
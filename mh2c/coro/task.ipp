@@ -0,0 +1,115 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_CORO_TASK_IPP_
+#define MH2C_CORO_TASK_IPP_
+
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+namespace mh2c {
+
+namespace coro {
+
+/* definitions of task_promise_base */
+
+template <typename Promise>
+std::coroutine_handle<> task_promise_base::final_awaiter::await_suspend(
+    std::coroutine_handle<Promise> handle) noexcept {
+  // Symmetric transfer, so that a chain of completions never grows the stack
+  const auto continuation = handle.promise().m_continuation;
+  return continuation ? continuation : std::noop_coroutine();
+}
+
+inline void task_promise_base::set_continuation(
+    std::coroutine_handle<> continuation) {
+  m_continuation = continuation;
+  return;
+}
+
+inline void task_promise_base::rethrow_if_failed() const {
+  if (m_exception) {
+    std::rethrow_exception(m_exception);
+  }
+  return;
+}
+
+/* definitions of task_promise */
+
+template <typename T>
+task<T> task_promise<T>::get_return_object() {
+  return task<T>{std::coroutine_handle<task_promise<T>>::from_promise(*this)};
+}
+
+template <typename T>
+T task_promise<T>::take_value() {
+  rethrow_if_failed();
+  return std::move(*m_value);
+}
+
+inline task<void> task_promise<void>::get_return_object() {
+  return task<void>{
+      std::coroutine_handle<task_promise<void>>::from_promise(*this)};
+}
+
+/* definitions of task */
+
+template <typename T>
+task<T>::task(std::coroutine_handle<promise_type> handle) : m_handle{handle} {}
+
+template <typename T>
+task<T>::task(task&& other) noexcept
+    : m_handle{std::exchange(other.m_handle, nullptr)} {}
+
+template <typename T>
+task<T>& task<T>::operator=(task&& other) noexcept {
+  if (this != &other) {
+    if (m_handle) {
+      m_handle.destroy();
+    }
+    m_handle = std::exchange(other.m_handle, nullptr);
+  }
+  return *this;
+}
+
+template <typename T>
+task<T>::~task() {
+  if (m_handle) {
+    m_handle.destroy();
+  }
+}
+
+template <typename T>
+std::coroutine_handle<> task<T>::await_suspend(
+    std::coroutine_handle<> awaiter) {
+  m_handle.promise().set_continuation(awaiter);
+  return m_handle;
+}
+
+template <typename T>
+T task<T>::await_resume() {
+  if constexpr (std::is_void_v<T>) {
+    m_handle.promise().rethrow_if_failed();
+  } else {
+    return m_handle.promise().take_value();
+  }
+}
+
+template <typename T>
+std::coroutine_handle<typename task<T>::promise_type> task<T>::get_handle()
+    const {
+  return m_handle;
+}
+
+template <typename T>
+bool task<T>::is_done() const {
+  return m_handle.done();
+}
+
+}  // namespace coro
+
+}  // namespace mh2c
+
+#endif  // MH2C_CORO_TASK_IPP_
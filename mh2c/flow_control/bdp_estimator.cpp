@@ -0,0 +1,98 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/flow_control/bdp_estimator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+#include "mh2c/frame/window_update_frame.h"
+
+namespace mh2c {
+
+namespace flow_control {
+
+namespace {
+
+// cf. https://tools.ietf.org/html/rfc6298#section-2
+constexpr int RTT_SMOOTHING_DIVISOR{8};
+
+}  // namespace
+
+bdp_estimator::bdp_estimator(const window_size_t initial_window,
+                             const window_size_t max_window,
+                             const std::chrono::milliseconds sample_interval)
+    : m_window{initial_window},
+      m_max_window{std::max(initial_window, max_window)},
+      m_sample_interval{sample_interval},
+      m_ping_in_flight{false},
+      m_ping_sent_time{},
+      m_next_sample_time{},
+      m_sample_bytes{0u},
+      m_smoothed_rtt{0},
+      m_bdp{0u},
+      m_bandwidth{0.0},
+      m_max_bandwidth{0.0} {}
+
+bool bdp_estimator::on_data_received(const size_t length,
+                                     const clock_type::time_point now) {
+  m_sample_bytes += length;
+  return m_ping_in_flight == false && now >= m_next_sample_time;
+}
+
+void bdp_estimator::on_ping_sent(const clock_type::time_point now) {
+  m_ping_in_flight = true;
+  m_ping_sent_time = now;
+  m_sample_bytes = 0u;
+  return;
+}
+
+bool bdp_estimator::on_ping_ack(const clock_type::time_point now) {
+  if (m_ping_in_flight == false) {
+    return false;
+  }
+  m_ping_in_flight = false;
+  m_next_sample_time = now + m_sample_interval;
+
+  const auto rtt = std::max(now - m_ping_sent_time,
+                            clock_type::duration{std::chrono::microseconds{1}});
+  m_smoothed_rtt =
+      m_smoothed_rtt.count() == 0
+          ? std::chrono::duration_cast<std::chrono::nanoseconds>(rtt)
+          : (m_smoothed_rtt * (RTT_SMOOTHING_DIVISOR - 1) + rtt) /
+                RTT_SMOOTHING_DIVISOR;
+
+  m_bdp = m_sample_bytes;
+  m_bandwidth = m_bdp / std::chrono::duration<double>(rtt).count();
+
+  // Only a sample that is limited by the window says the window is too small.
+  auto grown = false;
+  if (m_bandwidth > m_max_bandwidth) {
+    m_max_bandwidth = m_bandwidth;
+    if (m_bdp * 3u >= static_cast<size_t>(m_window) * 2u &&
+        m_window < m_max_window) {
+      m_window = static_cast<window_size_t>(
+          std::min<size_t>(m_bdp * 2u, m_max_window));
+      grown = true;
+    }
+  }
+
+  return grown;
+}
+
+bool bdp_estimator::is_ping_in_flight() const { return m_ping_in_flight; }
+
+window_size_t bdp_estimator::get_window() const { return m_window; }
+
+std::chrono::nanoseconds bdp_estimator::get_smoothed_rtt() const {
+  return m_smoothed_rtt;
+}
+
+size_t bdp_estimator::get_bdp() const { return m_bdp; }
+
+double bdp_estimator::get_bandwidth() const { return m_bandwidth; }
+
+}  // namespace flow_control
+
+}  // namespace mh2c
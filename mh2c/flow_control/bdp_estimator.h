@@ -0,0 +1,60 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_FLOW_CONTROL_BDP_ESTIMATOR_H_
+#define MH2C_FLOW_CONTROL_BDP_ESTIMATOR_H_
+
+#include <chrono>
+#include <cstddef>
+
+#include "mh2c/frame/window_update_frame.h"
+
+namespace mh2c {
+
+namespace flow_control {
+
+// Estimates the bandwidth-delay product by counting the DATA bytes that
+// arrive between a PING and its ACK. The window doubles the sample whenever
+// the sample fills most of the current window at a new peak bandwidth.
+class bdp_estimator {
+ public:
+  using clock_type = std::chrono::steady_clock;
+
+  bdp_estimator(const window_size_t initial_window,
+                const window_size_t max_window,
+                const std::chrono::milliseconds sample_interval);
+
+  // Returns true when a PING should be sent to start a new sample.
+  bool on_data_received(const size_t length,
+                        const clock_type::time_point now);
+  void on_ping_sent(const clock_type::time_point now);
+  // Returns true when the window has grown.
+  bool on_ping_ack(const clock_type::time_point now);
+
+  bool is_ping_in_flight() const;
+  window_size_t get_window() const;
+  std::chrono::nanoseconds get_smoothed_rtt() const;
+  size_t get_bdp() const;
+  double get_bandwidth() const;
+
+ private:
+  window_size_t m_window;
+  window_size_t m_max_window;
+  std::chrono::milliseconds m_sample_interval;
+
+  bool m_ping_in_flight;
+  clock_type::time_point m_ping_sent_time;
+  clock_type::time_point m_next_sample_time;
+  size_t m_sample_bytes;
+
+  std::chrono::nanoseconds m_smoothed_rtt;
+  size_t m_bdp;
+  double m_bandwidth;
+  double m_max_bandwidth;
+};
+
+}  // namespace flow_control
+
+}  // namespace mh2c
+
+#endif  // MH2C_FLOW_CONTROL_BDP_ESTIMATOR_H_
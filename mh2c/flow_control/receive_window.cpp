@@ -0,0 +1,110 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/flow_control/receive_window.h"
+
+#include <cstddef>
+
+#include "mh2c/flow_control/window_autotuning.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/window_update_frame.h"
+
+namespace mh2c {
+
+namespace flow_control {
+
+namespace {
+
+// Replenish a window once half of it has been consumed.
+bool should_replenish(const size_t consumed, const window_size_t window) {
+  return consumed * 2u >= window;
+}
+
+}  // namespace
+
+receive_window::receive_window(const window_size_t initial_stream_window)
+    : m_connection_window{DEFAULT_WINDOW_SIZE},
+      m_stream_window{initial_stream_window},
+      m_connection_consumed{0u},
+      m_stream_consumed{},
+      m_stall_count{0u} {}
+
+window_updates_t receive_window::consume(const fh_stream_id_t stream_id,
+                                         const size_t length,
+                                         const bool end_stream) {
+  window_updates_t updates{};
+
+  // The peer has to wait for WINDOW_UPDATE if a window has been used up.
+  const auto stream_ite = m_stream_consumed.find(stream_id);
+  const auto stream_consumed_total =
+      (stream_ite != m_stream_consumed.end() ? stream_ite->second : 0u) +
+      length;
+  if (m_connection_consumed + length >= m_connection_window ||
+      stream_consumed_total >= m_stream_window) {
+    ++m_stall_count;
+  }
+
+  m_connection_consumed += length;
+  if (should_replenish(m_connection_consumed, m_connection_window)) {
+    updates.emplace_back(0u, m_connection_consumed);
+    m_connection_consumed = 0u;
+  }
+
+  // The stream window of a finished stream is never needed again.
+  if (end_stream) {
+    close_stream(stream_id);
+    return updates;
+  }
+
+  auto& stream_consumed = m_stream_consumed[stream_id];
+  stream_consumed += length;
+  if (should_replenish(stream_consumed, m_stream_window)) {
+    updates.emplace_back(stream_id, stream_consumed);
+    stream_consumed = 0u;
+  }
+
+  return updates;
+}
+
+void receive_window::close_stream(const fh_stream_id_t stream_id) {
+  m_stream_consumed.erase(stream_id);
+  return;
+}
+
+window_size_t receive_window::resize_connection_window(
+    const window_size_t new_size) {
+  if (new_size <= m_connection_window) {
+    return 0u;
+  }
+
+  const auto increment = new_size - m_connection_window;
+  m_connection_window = new_size;
+  return increment;
+}
+
+window_size_t receive_window::resize_stream_window(
+    const window_size_t new_size) {
+  if (new_size <= m_stream_window) {
+    return 0u;
+  }
+
+  // SETTINGS_INITIAL_WINDOW_SIZE also adjusts the windows of open streams.
+  // cf. https://tools.ietf.org/html/rfc7540#section-6.9.2
+  const auto increment = new_size - m_stream_window;
+  m_stream_window = new_size;
+  return increment;
+}
+
+window_size_t receive_window::get_connection_window() const {
+  return m_connection_window;
+}
+
+window_size_t receive_window::get_stream_window() const {
+  return m_stream_window;
+}
+
+size_t receive_window::get_stall_count() const { return m_stall_count; }
+
+}  // namespace flow_control
+
+}  // namespace mh2c
@@ -0,0 +1,53 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_FLOW_CONTROL_RECEIVE_WINDOW_H_
+#define MH2C_FLOW_CONTROL_RECEIVE_WINDOW_H_
+
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/window_update_frame.h"
+
+namespace mh2c {
+
+namespace flow_control {
+
+// Pairs of stream id (0 for the connection) and window size increment.
+using window_updates_t = std::vector<std::pair<fh_stream_id_t, window_size_t>>;
+
+// Accounts flow-controlled bytes received on the connection and its streams
+// and decides when to replenish the windows with WINDOW_UPDATE.
+class receive_window {
+ public:
+  explicit receive_window(const window_size_t initial_stream_window);
+
+  window_updates_t consume(const fh_stream_id_t stream_id, const size_t length,
+                           const bool end_stream);
+  void close_stream(const fh_stream_id_t stream_id);
+
+  // Return the increment that has to be announced to the peer.
+  window_size_t resize_connection_window(const window_size_t new_size);
+  window_size_t resize_stream_window(const window_size_t new_size);
+
+  window_size_t get_connection_window() const;
+  window_size_t get_stream_window() const;
+  // Number of DATA frames that used up the connection or the stream window
+  size_t get_stall_count() const;
+
+ private:
+  window_size_t m_connection_window;
+  window_size_t m_stream_window;
+  size_t m_connection_consumed;
+  std::unordered_map<fh_stream_id_t, size_t> m_stream_consumed;
+  size_t m_stall_count;
+};
+
+}  // namespace flow_control
+
+}  // namespace mh2c
+
+#endif  // MH2C_FLOW_CONTROL_RECEIVE_WINDOW_H_
@@ -0,0 +1,76 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/flow_control/send_window.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "mh2c/flow_control/window_autotuning.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/window_update_frame.h"
+
+namespace mh2c {
+
+namespace flow_control {
+
+send_window::send_window()
+    : m_connection_window{DEFAULT_WINDOW_SIZE},
+      m_initial_stream_window{DEFAULT_WINDOW_SIZE},
+      m_stream_windows{} {}
+
+void send_window::consume(const fh_stream_id_t stream_id,
+                          const size_t length) {
+  m_connection_window -= static_cast<int64_t>(length);
+  m_stream_windows.emplace(stream_id, m_initial_stream_window)
+      .first->second -= static_cast<int64_t>(length);
+  return;
+}
+
+void send_window::on_window_update(const fh_stream_id_t stream_id,
+                                   const window_size_t increment) {
+  if (stream_id == 0) {
+    m_connection_window += increment;
+    return;
+  }
+
+  m_stream_windows.emplace(stream_id, m_initial_stream_window)
+      .first->second += increment;
+  return;
+}
+
+void send_window::set_initial_stream_window(
+    const window_size_t initial_stream_window) {
+  const auto delta =
+      static_cast<int64_t>(initial_stream_window) - m_initial_stream_window;
+  for (auto& [stream_id, window] : m_stream_windows) {
+    window += delta;
+  }
+  m_initial_stream_window = initial_stream_window;
+  return;
+}
+
+void send_window::close_stream(const fh_stream_id_t stream_id) {
+  m_stream_windows.erase(stream_id);
+  return;
+}
+
+size_t send_window::get_available(const fh_stream_id_t stream_id) const {
+  const auto available =
+      std::min(m_connection_window, get_stream_window(stream_id));
+  return available > 0 ? static_cast<size_t>(available) : 0u;
+}
+
+int64_t send_window::get_connection_window() const {
+  return m_connection_window;
+}
+
+int64_t send_window::get_stream_window(const fh_stream_id_t stream_id) const {
+  const auto ite = m_stream_windows.find(stream_id);
+  return ite != m_stream_windows.end() ? ite->second : m_initial_stream_window;
+}
+
+}  // namespace flow_control
+
+}  // namespace mh2c
@@ -0,0 +1,49 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_FLOW_CONTROL_SEND_WINDOW_H_
+#define MH2C_FLOW_CONTROL_SEND_WINDOW_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/window_update_frame.h"
+
+namespace mh2c {
+
+namespace flow_control {
+
+// Accounts flow-controlled bytes sent on the connection and its streams
+// against the windows granted by the peer. The windows are signed because
+// SETTINGS_INITIAL_WINDOW_SIZE can shrink them below zero.
+// cf. https://tools.ietf.org/html/rfc7540#section-6.9.2
+class send_window {
+ public:
+  send_window();
+
+  void consume(const fh_stream_id_t stream_id, const size_t length);
+  // stream_id 0 for the connection
+  void on_window_update(const fh_stream_id_t stream_id,
+                        const window_size_t increment);
+  void set_initial_stream_window(const window_size_t initial_stream_window);
+  void close_stream(const fh_stream_id_t stream_id);
+
+  // Bytes of DATA the stream may send now, 0 when a window is exhausted
+  size_t get_available(const fh_stream_id_t stream_id) const;
+  int64_t get_connection_window() const;
+  int64_t get_stream_window(const fh_stream_id_t stream_id) const;
+
+ private:
+  int64_t m_connection_window;
+  int64_t m_initial_stream_window;
+  // Streams whose window differs from m_initial_stream_window
+  std::unordered_map<fh_stream_id_t, int64_t> m_stream_windows;
+};
+
+}  // namespace flow_control
+
+}  // namespace mh2c
+
+#endif  // MH2C_FLOW_CONTROL_SEND_WINDOW_H_
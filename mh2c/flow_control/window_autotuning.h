@@ -0,0 +1,40 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_FLOW_CONTROL_WINDOW_AUTOTUNING_H_
+#define MH2C_FLOW_CONTROL_WINDOW_AUTOTUNING_H_
+
+#include <chrono>
+#include <cstddef>
+
+#include "mh2c/frame/window_update_frame.h"
+
+namespace mh2c {
+
+namespace flow_control {
+
+// cf. https://tools.ietf.org/html/rfc7540#section-6.9.2
+constexpr window_size_t DEFAULT_WINDOW_SIZE{65535u};
+constexpr window_size_t MAX_WINDOW_SIZE{0x7fffffff};
+
+struct autotuning_options {
+  // SETTINGS_INITIAL_WINDOW_SIZE the caller has advertised.
+  window_size_t m_initial_stream_window{DEFAULT_WINDOW_SIZE};
+  window_size_t m_max_window{16u * 1024u * 1024u};
+  // Minimum time between the end of one RTT sample and the next PING.
+  std::chrono::milliseconds m_sample_interval{std::chrono::milliseconds{100}};
+};
+
+struct autotuning_status {
+  std::chrono::nanoseconds m_smoothed_rtt;
+  size_t m_bdp;        // bytes received during the last sample
+  double m_bandwidth;  // bytes per second of the last sample
+  window_size_t m_connection_window;
+  window_size_t m_stream_window;
+};
+
+}  // namespace flow_control
+
+}  // namespace mh2c
+
+#endif  // MH2C_FLOW_CONTROL_WINDOW_AUTOTUNING_H_
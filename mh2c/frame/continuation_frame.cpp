@@ -23,46 +23,14 @@ namespace mh2c {
  */
 namespace {
 
-byte_array_t construct_encoded_payload(const header_block_t& header_block,
-                                       const header_encode_mode mode,
-                                       const dynamic_table& dynamic_table) {
-  byte_array_t encoded_payload{};
-
-  // Header Block
-  std::for_each(
-      header_block.begin(), header_block.end(),
-      [&encoded_payload, mode, &dynamic_table](const auto& header_entry) {
-        const auto encoded_header =
-            encode_header(header_entry, mode, dynamic_table);
-        std::copy(encoded_header.begin(), encoded_header.end(),
-                  std::back_inserter(encoded_payload));
-      });
-
-  return encoded_payload;
-}
-
-frame_header construct_frame_header(fh_flags_t flags, fh_stream_id_t stream_id,
-                                    byte_array_t encoded_payload) {
+frame_header construct_frame_header(const fh_flags_t flags,
+                                    const fh_stream_id_t stream_id,
+                                    const byte_array_t& encoded_payload) {
   return {cast_to_fh_length(encoded_payload.size()),
           underlying_cast(frame_type_registry::CONTINUATION), flags, 0,
           stream_id};
 }
 
-header_block_t decode_payload(const byte_array_t& raw_payload,
-                              const dynamic_table& dynamic_table) {
-  auto raw_data{raw_payload};
-  header_block_t header_block{};
-
-  // Header Block
-  while (raw_data.size() > 0) {
-    const auto decoded_header = decode_header(raw_data, dynamic_table);
-    header_block.push_back(decoded_header.first);
-    raw_data.erase(raw_data.begin(), raw_data.begin() + decoded_header.second);
-  }
-
-  return header_block;
-}
-
 }  // namespace
 
 /*
@@ -73,17 +41,25 @@ continuation_frame::continuation_frame(const fh_flags_t flags,
                                        const header_block_t& header_block,
                                        const header_encode_mode mode,
                                        const dynamic_table& dynamic_table)
-    : m_encoded_payload{construct_encoded_payload(header_block, mode,
-                                                  dynamic_table)},
+    : m_encoded_payload{}, m_header{}, m_header_block{} {
+  m_encoded_payload =
+      encode_header_block(header_block, mode, dynamic_table, &m_header_block);
+  m_header = construct_frame_header(flags, stream_id, m_encoded_payload);
+}
+
+continuation_frame::continuation_frame(
+    const fh_flags_t flags, const fh_stream_id_t stream_id,
+    const byte_array_t& header_block_fragment)
+    : m_encoded_payload{header_block_fragment},
       m_header{construct_frame_header(flags, stream_id, m_encoded_payload)},
-      m_header_block{header_block} {}
+      m_header_block{} {}
 
 continuation_frame::continuation_frame(const frame_header& fh,
                                        const byte_array_t& raw_payload,
                                        const dynamic_table& dynamic_table)
     : m_encoded_payload{raw_payload},
       m_header{fh},
-      m_header_block{decode_payload(raw_payload, dynamic_table)} {}
+      m_header_block{decode_header_block(raw_payload, dynamic_table)} {}
 
 frame_header continuation_frame::get_header() const { return m_header; }
 
@@ -21,10 +21,16 @@ enum class cf_flag : fh_flags_t {
 
 class continuation_frame : public i_frame<frame_header> {
  public:
+  // Encodes the header block with encode_header_block(); get_payload()
+  // returns the entries as they are encoded.
   continuation_frame(const fh_flags_t flags, const fh_stream_id_t stream_id,
                      const header_block_t& header_block,
                      const header_encode_mode mode,
                      const dynamic_table& dynamic_table);
+  // Carries a slice of a header block encoded beforehand, which need not end
+  // on a header field boundary; get_payload() is empty.
+  continuation_frame(const fh_flags_t flags, const fh_stream_id_t stream_id,
+                     const byte_array_t& header_block_fragment);
   continuation_frame(const frame_header& fh, const byte_array_t& raw_payload,
                      const dynamic_table& dynamic_table);
 
@@ -5,6 +5,7 @@
 #define MH2C_FRAME_ERROR_CODES_H_
 
 #include <cstdint>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 
@@ -50,6 +51,21 @@ const std::unordered_map<error_codes, std::string> error_codes_str_map{
 template <typename T>
 inline error_codes cast_to_error_codes(T error_code);
 
+// Thrown when the peer breaks the protocol in a way that fails the whole
+// connection. The error code is the one to send in GOAWAY.
+// cf. https://tools.ietf.org/html/rfc7540#section-5.4.1
+class connection_error : public std::runtime_error {
+ public:
+  connection_error(const error_codes error_code, const std::string& what)
+      : std::runtime_error{error_codes_str_map.at(error_code) + ": " + what},
+        m_error_code{error_code} {}
+
+  error_codes get_error_code() const { return m_error_code; }
+
+ private:
+  error_codes m_error_code;
+};
+
 }  // namespace mh2c
 
 #include "mh2c/frame/error_codes.ipp"
@@ -9,12 +9,14 @@
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <unordered_map>
 
 #include "mh2c/common/byte_array.h"
 #include "mh2c/frame/common_type.h"
 #include "mh2c/frame/continuation_frame.h"
 #include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/error_codes.h"
 #include "mh2c/frame/frame_header.h"
 #include "mh2c/frame/frame_type_registry.h"
 #include "mh2c/frame/goaway_frame.h"
@@ -30,6 +32,7 @@
 #include "mh2c/hpack/dynamic_table.h"
 #include "mh2c/hpack/header_type.h"
 #include "mh2c/util/byte_order.h"
+#include "mh2c/util/cast.h"
 
 namespace mh2c {
 
@@ -142,4 +145,70 @@ h2_frame_ptr build_frame(const frame_header& fh, const byte_array_t& payload,
   return builder_func(fh, payload, dynamic_table);
 }
 
+size_t get_pad_length(const byte_array_t& raw_payload) {
+  if (raw_payload.empty() || raw_payload.front() >= raw_payload.size()) {
+    throw connection_error(
+        error_codes::PROTOCOL_ERROR,
+        "padding does not fit in a payload of " +
+            std::to_string(raw_payload.size()) + " bytes");
+  }
+  return raw_payload.front();
+}
+
+header_block_t get_header_block(const i_frame<frame_header>& frame) {
+  switch (cast_to_frame_type_registry(frame.get_header().m_type)) {
+    case frame_type_registry::HEADERS:
+      return dynamic_cast<const headers_frame&>(frame).get_payload();
+    case frame_type_registry::PUSH_PROMISE:
+      return dynamic_cast<const push_promise_frame&>(frame)
+          .get_payload()
+          .m_header_block;
+    case frame_type_registry::CONTINUATION:
+      return dynamic_cast<const continuation_frame&>(frame).get_payload();
+    default:
+      return {};
+  }
+}
+
+size_t update_dynamic_table(const header_block_t& header_block,
+                            dynamic_table* dynamic_table) {
+  const auto entry_count = dynamic_table->get_entries().size();
+  size_t pushed_count{};
+
+  std::for_each(
+      header_block.begin(), header_block.end(),
+      [dynamic_table, &pushed_count](const auto& header_entry) {
+        if (header_entry.get_prefix() ==
+            header_prefix_pattern::INCREMENTAL_INDEXING) {
+          dynamic_table->push(header_entry.get_header());
+          ++pushed_count;
+        } else if (header_entry.get_prefix() ==
+                   header_prefix_pattern::SIZE_UPDATE) {
+          dynamic_table->update_table_size(header_entry.get_max_size());
+        }
+      });
+
+  return entry_count + pushed_count - dynamic_table->get_entries().size();
+}
+
+size_t update_dynamic_table(const h2_frame_ptr& frame_ptr,
+                            dynamic_table* dynamic_table) {
+  if (cast_to_frame_type_registry(frame_ptr->get_header().m_type) ==
+      frame_type_registry::SETTINGS) {
+    const auto sf_payload =
+        dynamic_cast<const settings_frame*>(frame_ptr.get())->get_payload();
+    const auto table_size_key =
+        underlying_cast(sf_parameter::SETTINGS_HEADER_TABLE_SIZE);
+    if (sf_payload.find(table_size_key) == sf_payload.end()) {
+      return 0u;
+    }
+
+    const auto entry_count = dynamic_table->get_entries().size();
+    dynamic_table->update_table_size(sf_payload.at(table_size_key));
+    return entry_count - dynamic_table->get_entries().size();
+  }
+
+  return update_dynamic_table(get_header_block(*frame_ptr), dynamic_table);
+}
+
 }  // namespace mh2c
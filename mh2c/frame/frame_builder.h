@@ -4,9 +4,12 @@
 #ifndef MH2C_FRAME_FRAME_BUILDER_H_
 #define MH2C_FRAME_FRAME_BUILDER_H_
 
+#include <cstddef>
+
 #include "mh2c/common/byte_array.h"
 #include "mh2c/frame/common_type.h"
 #include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/i_frame.h"
 #include "mh2c/hpack/dynamic_table.h"
 #include "mh2c/hpack/header_type.h"
 
@@ -16,6 +19,23 @@ h2_frame_ptr build_frame(const frame_header& fh,
                          const byte_array_t& raw_payload,
                          const dynamic_table& dynamic_table);
 
+// Header block of HEADERS, PUSH_PROMISE and CONTINUATION, empty otherwise
+header_block_t get_header_block(const i_frame<frame_header>& frame);
+
+// Pad Length of a DATA, HEADERS or PUSH_PROMISE payload with PADDED set.
+// Throw connection_error with PROTOCOL_ERROR unless the padding is shorter
+// than the payload, which carries the Pad Length field as well.
+// cf. https://tools.ietf.org/html/rfc7540#section-6.1
+size_t get_pad_length(const byte_array_t& raw_payload);
+
+// Apply the INCREMENTAL_INDEXING and SIZE_UPDATE entries of a header block,
+// or the SETTINGS_HEADER_TABLE_SIZE of a SETTINGS frame, to the table.
+// Return the number of evicted entries.
+size_t update_dynamic_table(const header_block_t& header_block,
+                            dynamic_table* dynamic_table);
+size_t update_dynamic_table(const h2_frame_ptr& frame_ptr,
+                            dynamic_table* dynamic_table);
+
 }  // namespace mh2c
 
 #endif  // MH2C_FRAME_FRAME_BUILDER_H_
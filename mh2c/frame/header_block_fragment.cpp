@@ -0,0 +1,93 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/frame/header_block_fragment.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/common_type.h"
+#include "mh2c/frame/continuation_frame.h"
+#include "mh2c/frame/error_codes.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/util/bit_operation.h"
+#include "mh2c/util/cast.h"
+
+namespace mh2c {
+
+std::vector<h2_frame_ptr> fragment_header_block(
+    const fh_flags_t flags, const fh_stream_id_t stream_id,
+    const byte_array_t& encoded_block, const header_block_t& header_block,
+    const size_t max_frame_size, const hf_priority_option& priority_option) {
+  if (is_flag_set(flags, hf_flag::PADDED)) {
+    throw std::invalid_argument(
+        "PADDED is not supported for fragmented header blocks");
+  }
+
+  const fh_flags_t end_headers = make_frame_header_flags(hf_flag::END_HEADERS);
+  std::vector<h2_frame_ptr> frames{};
+  auto begin = encoded_block.begin();
+  do {
+    const auto capacity =
+        frames.empty() && is_flag_set(flags, hf_flag::PRIORITY)
+            ? max_frame_size - PRIORITY_FIELDS_BYTES
+            : max_frame_size;
+    const auto length =
+        std::min<size_t>(capacity, encoded_block.end() - begin);
+    const byte_array_t fragment(begin, begin + length);
+    begin += length;
+    const fh_flags_t last_flags =
+        begin == encoded_block.end() ? end_headers : 0u;
+
+    if (frames.empty()) {
+      frames.push_back(std::make_unique<headers_frame>(
+          (flags & ~end_headers) | last_flags, stream_id, fragment,
+          header_block, priority_option));
+    } else {
+      frames.push_back(std::make_unique<continuation_frame>(
+          last_flags, stream_id, fragment));
+    }
+  } while (begin != encoded_block.end());
+
+  return frames;
+}
+
+void append_header_block_fragment(const frame_header& continuation_fh,
+                                  const byte_array_t& continuation_payload,
+                                  frame_header* fh, byte_array_t* raw_payload) {
+  // cf. https://tools.ietf.org/html/rfc7540#section-6.10
+  if (cast_to_frame_type_registry(continuation_fh.m_type) !=
+          frame_type_registry::CONTINUATION ||
+      continuation_fh.m_stream_id != fh->m_stream_id) {
+    throw connection_error(
+        error_codes::PROTOCOL_ERROR,
+        "header block of stream " + std::to_string(fh->m_stream_id) +
+            " interrupted by frame type " +
+            std::to_string(continuation_fh.m_type));
+  }
+
+  // HEADERS and PUSH_PROMISE share the PADDED flag.
+  if (is_flag_set(fh->m_flags, hf_flag::PADDED)) {
+    const auto pad_length = raw_payload->front();
+    raw_payload->erase(raw_payload->end() - pad_length, raw_payload->end());
+    raw_payload->erase(raw_payload->begin());
+    fh->m_flags &= ~underlying_cast(hf_flag::PADDED);
+  }
+
+  raw_payload->insert(raw_payload->end(), continuation_payload.begin(),
+                      continuation_payload.end());
+  fh->m_length = cast_to_fh_length(raw_payload->size());
+  fh->m_flags |=
+      continuation_fh.m_flags & underlying_cast(cf_flag::END_HEADERS);
+  return;
+}
+
+}  // namespace mh2c
@@ -0,0 +1,40 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#ifndef MH2C_FRAME_HEADER_BLOCK_FRAGMENT_H_
+#define MH2C_FRAME_HEADER_BLOCK_FRAGMENT_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/common_type.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/hpack/header_type.h"
+
+namespace mh2c {
+
+// Slice an encoded header block into a HEADERS frame followed by as many
+// CONTINUATION frames as max_frame_size requires, without encoding it again.
+// END_HEADERS is set on the last frame whatever flags says. priority_option
+// is used with PRIORITY, whose fields take room in the HEADERS frame; throw
+// std::invalid_argument for PADDED.
+// cf. https://tools.ietf.org/html/rfc7540#section-4.3
+std::vector<h2_frame_ptr> fragment_header_block(
+    const fh_flags_t flags, const fh_stream_id_t stream_id,
+    const byte_array_t& encoded_block, const header_block_t& header_block,
+    const size_t max_frame_size,
+    const hf_priority_option& priority_option = {});
+
+// Append the fragment of a CONTINUATION frame to the raw payload of the
+// HEADERS or PUSH_PROMISE frame it continues, so that the block is decoded
+// once it is complete. The padding of the first frame is removed. Throw
+// connection_error when the frame is not a CONTINUATION of the same stream.
+void append_header_block_fragment(const frame_header& continuation_fh,
+                                  const byte_array_t& continuation_payload,
+                                  frame_header* fh, byte_array_t* raw_payload);
+
+}  // namespace mh2c
+
+#endif  // MH2C_FRAME_HEADER_BLOCK_FRAGMENT_H_
@@ -31,10 +31,39 @@ namespace {
 
 constexpr uint8_t EXCLUSIVE_BITS{1u};
 
+void append_priority_fields(const hf_priority_option& priority_option,
+                            byte_array_t* encoded_payload) {
+  const uint32_t exclusive_and_stream_dependency =
+      (priority_option.m_exclusive << STREAM_ID_BITS) |
+      extract_low_bit<STREAM_ID_BITS>(priority_option.m_stream_dependency);
+  const auto bytes =
+      integral2bytes<byte_array_t>(exclusive_and_stream_dependency);
+  std::copy(bytes.begin(), bytes.end(), std::back_inserter(*encoded_payload));
+  encoded_payload->push_back(priority_option.m_weight);
+  return;
+}
+
+byte_array_t construct_fragment_payload(
+    const fh_flags_t flags, const byte_array_t& header_block_fragment,
+    const hf_priority_option& priority_option) {
+  if (is_flag_set(flags, mh2c::hf_flag::PRIORITY) == false) {
+    return header_block_fragment;
+  }
+
+  byte_array_t encoded_payload{};
+  encoded_payload.reserve(PRIORITY_FIELDS_BYTES +
+                          header_block_fragment.size());
+  append_priority_fields(priority_option, &encoded_payload);
+  encoded_payload.insert(encoded_payload.end(), header_block_fragment.begin(),
+                         header_block_fragment.end());
+  return encoded_payload;
+}
+
 byte_array_t construct_encoded_payload(
     const fh_flags_t flags, const header_block_t& header_block,
     const header_encode_mode mode, const dynamic_table& dynamic_table,
-    const byte_array_t& padding, const hf_priority_option& priority_option) {
+    const byte_array_t& padding, const hf_priority_option& priority_option,
+    header_block_t* emitted_block) {
   byte_array_t encoded_payload{};
 
   // Pad Length
@@ -46,24 +75,14 @@ byte_array_t construct_encoded_payload(
   // Priority Settings
   const auto is_priority_set = is_flag_set(flags, mh2c::hf_flag::PRIORITY);
   if (is_priority_set) {
-    const uint32_t exclusive_and_stream_dependency =
-        (priority_option.m_exclusive << STREAM_ID_BITS) |
-        extract_low_bit<STREAM_ID_BITS>(priority_option.m_stream_dependency);
-    const auto bytes =
-        integral2bytes<byte_array_t>(exclusive_and_stream_dependency);
-    std::copy(bytes.begin(), bytes.end(), std::back_inserter(encoded_payload));
-    encoded_payload.push_back(priority_option.m_weight);
+    append_priority_fields(priority_option, &encoded_payload);
   }
 
   // Header Block
-  std::for_each(
-      header_block.begin(), header_block.end(),
-      [&encoded_payload, mode, &dynamic_table](const auto& header_entry) {
-        const auto encoded_header =
-            encode_header(header_entry, mode, dynamic_table);
-        std::copy(encoded_header.begin(), encoded_header.end(),
-                  std::back_inserter(encoded_payload));
-      });
+  const auto encoded_block =
+      encode_header_block(header_block, mode, dynamic_table, emitted_block);
+  encoded_payload.insert(encoded_payload.end(), encoded_block.begin(),
+                         encoded_block.end());
 
   // Padding
   if (is_padded_set) {
@@ -91,7 +110,6 @@ decoded_payload_t decode_payload(const frame_header& fh,
                                  const byte_array_t& raw_payload,
                                  const dynamic_table& dynamic_table) {
   auto raw_data{raw_payload};
-  header_block_t header_block{};
 
   // Extract padding if needed
   byte_array_t padding{};
@@ -128,14 +146,8 @@ decoded_payload_t decode_payload(const frame_header& fh,
     raw_data.erase(raw_data.begin());
   }
 
-  // Header Block
-  while (raw_data.size() > 0) {
-    const auto decoded_header = decode_header(raw_data, dynamic_table);
-    header_block.push_back(decoded_header.first);
-    raw_data.erase(raw_data.begin(), raw_data.begin() + decoded_header.second);
-  }
-
-  return {padding, priority_option, header_block};
+  return {padding, priority_option,
+          decode_header_block(raw_data, dynamic_table)};
 }
 
 }  // namespace
@@ -150,11 +162,27 @@ headers_frame::headers_frame(const fh_flags_t flags,
                              const dynamic_table& dynamic_table,
                              const byte_array_t& padding,
                              const hf_priority_option& priority_option)
-    : m_encoded_payload{construct_encoded_payload(
-          flags, header_block, mode, dynamic_table, padding, priority_option)},
-      m_header{construct_frame_header(flags, stream_id, m_encoded_payload)},
+    : m_encoded_payload{},
+      m_header{},
       m_padding{padding},
       m_priority_option{priority_option},
+      m_header_block{} {
+  m_encoded_payload =
+      construct_encoded_payload(flags, header_block, mode, dynamic_table,
+                                padding, priority_option, &m_header_block);
+  m_header = construct_frame_header(flags, stream_id, m_encoded_payload);
+}
+
+headers_frame::headers_frame(const fh_flags_t flags,
+                             const fh_stream_id_t stream_id,
+                             const byte_array_t& header_block_fragment,
+                             const header_block_t& header_block,
+                             const hf_priority_option& priority_option)
+    : m_encoded_payload{construct_fragment_payload(
+          flags, header_block_fragment, priority_option)},
+      m_header{construct_frame_header(flags, stream_id, m_encoded_payload)},
+      m_padding{},
+      m_priority_option{priority_option},
       m_header_block{header_block} {}
 
 headers_frame::headers_frame(const frame_header& fh,
@@ -171,6 +199,10 @@ frame_header headers_frame::get_header() const { return m_header; }
 
 header_block_t headers_frame::get_payload() const { return m_header_block; }
 
+hf_priority_option headers_frame::get_priority_option() const {
+  return m_priority_option;
+}
+
 byte_array_t headers_frame::serialize() const {
   byte_array_t serialized_hf = mh2c::serialize(m_header);
   std::copy(m_encoded_payload.begin(), m_encoded_payload.end(),
@@ -4,6 +4,7 @@
 #ifndef MH2C_FRAME_HEADERS_FRAME_H_
 #define MH2C_FRAME_HEADERS_FRAME_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <ostream>
 
@@ -26,6 +27,8 @@ enum class hf_flag : fh_flags_t {
 using hf_exclusive_t = uint8_t;
 using hf_weight_t = uint8_t;
 
+constexpr size_t PRIORITY_FIELDS_BYTES{5u};
+
 struct hf_priority_option {
   hf_exclusive_t m_exclusive;
   fh_stream_id_t m_stream_dependency;
@@ -34,17 +37,27 @@ struct hf_priority_option {
 
 class headers_frame : public i_frame<frame_header> {
  public:
+  // Encodes the header block with encode_header_block(); get_payload()
+  // returns the entries as they are encoded.
   headers_frame(const fh_flags_t flags, const fh_stream_id_t stream_id,
                 const header_block_t& header_block,
                 const header_encode_mode mode,
                 const dynamic_table& dynamic_table,
                 const byte_array_t& padding = {},
                 const hf_priority_option& priority_option = {});
+  // Carries the first slice of a header block encoded beforehand, which is
+  // not padded. header_block is the whole decoded block, which get_payload()
+  // returns.
+  headers_frame(const fh_flags_t flags, const fh_stream_id_t stream_id,
+                const byte_array_t& header_block_fragment,
+                const header_block_t& header_block,
+                const hf_priority_option& priority_option = {});
   headers_frame(const frame_header& fh, const byte_array_t& raw_payload,
                 const dynamic_table& dynamic_table);
 
   frame_header get_header() const override;
   header_block_t get_payload() const;
+  hf_priority_option get_priority_option() const;
 
   byte_array_t serialize() const override;
   void dump(std::ostream& out_stream) const override;
@@ -28,7 +28,8 @@ namespace {
 byte_array_t construct_encoded_payload(const fh_flags_t flags,
                                        const push_promise_payload& payload,
                                        const header_encode_mode mode,
-                                       const dynamic_table& dynamic_table) {
+                                       const dynamic_table& dynamic_table,
+                                       header_block_t* emitted_block) {
   byte_array_t encoded_payload{};
 
   // Pad Length
@@ -48,13 +49,10 @@ byte_array_t construct_encoded_payload(const fh_flags_t flags,
             std::back_inserter(encoded_payload));
 
   // Header Block
-  std::for_each(payload.m_header_block.begin(), payload.m_header_block.end(),
-                [&encoded_payload, mode, &dynamic_table](const auto& header) {
-                  const auto encoded_header =
-                      encode_header(header, mode, dynamic_table);
-                  std::copy(encoded_header.begin(), encoded_header.end(),
-                            std::back_inserter(encoded_payload));
-                });
+  const auto encoded_block = encode_header_block(
+      payload.m_header_block, mode, dynamic_table, emitted_block);
+  encoded_payload.insert(encoded_payload.end(), encoded_block.begin(),
+                         encoded_block.end());
 
   // Padding
   if (is_padded_set) {
@@ -96,15 +94,8 @@ push_promise_payload decode_payload(const frame_header& fh,
       bytes2integral<fh_stream_id_t>(raw_data.begin()));
   raw_data.erase(raw_data.begin(), raw_data.begin() + sizeof(fh_stream_id_t));
 
-  // Header Block
-  header_block_t header_block{};
-  while (raw_data.size() > 0) {
-    const auto decoded_header = decode_header(raw_data, dynamic_table);
-    header_block.push_back(decoded_header.first);
-    raw_data.erase(raw_data.begin(), raw_data.begin() + decoded_header.second);
-  }
-
-  return {reserved, promised_stream_id, header_block, padding};
+  return {reserved, promised_stream_id,
+          decode_header_block(raw_data, dynamic_table), padding};
 }  // namespace
 
 }  // namespace
@@ -127,11 +118,14 @@ push_promise_frame::push_promise_frame(const fh_flags_t flags,
                                        const push_promise_payload& payload,
                                        const header_encode_mode mode,
                                        const dynamic_table& dynamic_table)
-    : m_encoded_payload{construct_encoded_payload(flags, payload, mode,
-                                                  dynamic_table)},
-      m_header{
-          construct_frame_header(flags, stream_id, m_encoded_payload.size())},
-      m_payload{payload} {}
+    : m_encoded_payload{},
+      m_header{},
+      m_payload{payload.m_reserved, payload.m_promised_stream_id, {},
+                payload.m_padding} {
+  m_encoded_payload = construct_encoded_payload(
+      flags, payload, mode, dynamic_table, &m_payload.m_header_block);
+  m_header = construct_frame_header(flags, stream_id, m_encoded_payload.size());
+}
 
 push_promise_frame::push_promise_frame(const frame_header& fh,
                                        const byte_array_t& raw_payload,
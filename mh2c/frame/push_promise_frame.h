@@ -35,6 +35,8 @@ bool operator!=(const push_promise_payload& lhs,
 
 class push_promise_frame : public i_frame<frame_header> {
  public:
+  // Encodes the header block with encode_header_block(); get_payload()
+  // returns the entries as they are encoded.
   push_promise_frame(const fh_flags_t flags, const fh_stream_id_t stream_id,
                      const push_promise_payload& payload,
                      const header_encode_mode mode,
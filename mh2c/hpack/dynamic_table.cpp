@@ -4,6 +4,7 @@
 #include "mh2c/hpack/dynamic_table.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <ostream>
 #include <string>
 
@@ -32,11 +33,23 @@ dynamic_table::size_type resize_table(
 dynamic_table::dynamic_table() : dynamic_table{DEFAULT_TABLE_SIZE} {}
 
 dynamic_table::dynamic_table(const size_type initial_size)
-    : m_entries{}, m_table_size{0}, m_max_table_size{initial_size} {}
+    : m_entries{},
+      m_table_size{0},
+      m_max_table_size{initial_size},
+      m_revision{0} {}
 
 void dynamic_table::push(const_reference header) {
   const auto header_size =
       header.first.length() + header.second.length() + ENTRY_OVERHEAD_SIZE;
+  ++m_revision;
+
+  // cf. https://tools.ietf.org/html/rfc7541#section-4.4
+  if (header_size > m_max_table_size) {
+    m_entries.clear();
+    m_table_size = 0;
+    return;
+  }
+
   m_table_size =
       resize_table(&m_entries, m_table_size + header_size, m_max_table_size);
   m_entries.insert(m_entries.begin(), header);
@@ -50,6 +63,7 @@ dynamic_table::const_reference dynamic_table::at(const size_t position) const {
 void dynamic_table::update_table_size(const size_type new_size) {
   m_table_size = resize_table(&m_entries, m_table_size, new_size);
   m_max_table_size = new_size;
+  ++m_revision;
 }
 
 const dynamic_table::container_type& dynamic_table::get_entries() const {
@@ -64,6 +78,8 @@ dynamic_table::size_type dynamic_table::get_max_table_size() const {
   return m_max_table_size;
 }
 
+uint64_t dynamic_table::get_revision() const { return m_revision; }
+
 dynamic_table::iterator dynamic_table::begin() { return m_entries.begin(); }
 
 dynamic_table::const_iterator dynamic_table::begin() const {
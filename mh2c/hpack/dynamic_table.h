@@ -4,6 +4,7 @@
 #ifndef MH2C_HPACK_DYNAMIC_TABLE_H_
 #define MH2C_HPACK_DYNAMIC_TABLE_H_
 
+#include <cstdint>
 #include <ostream>
 #include <vector>
 
@@ -38,6 +39,9 @@ class dynamic_table {
   const container_type& get_entries() const;
   size_type get_table_size() const;
   size_type get_max_table_size() const;
+  // Bumped by every push() and update_table_size(), so that observers can
+  // tell whether the table changed without comparing entries.
+  uint64_t get_revision() const;
 
   iterator begin();
   const_iterator begin() const;
@@ -48,6 +52,7 @@ class dynamic_table {
   container_type m_entries;
   size_type m_table_size;
   size_type m_max_table_size;
+  uint64_t m_revision;
 };
 
 std::ostream& operator<<(std::ostream& out_stream, const dynamic_table& table);
@@ -0,0 +1,102 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/hpack/dynamic_table_view.h"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+
+namespace mh2c {
+
+namespace {
+
+dynamic_table::size_type get_entry_size(const header_t& header) {
+  // cf. https://tools.ietf.org/html/rfc7541#section-4.1
+  return header.first.length() + header.second.length() +
+         dynamic_table::ENTRY_OVERHEAD_SIZE;
+}
+
+}  // namespace
+
+dynamic_table_view::dynamic_table_view(const dynamic_table& table,
+                                       const header_block_t* header_block)
+    : m_table{table},
+      m_header_block{header_block},
+      m_added{},
+      m_evicted{0},
+      m_table_count{table.get_entries().size()},
+      m_table_size{table.get_table_size()},
+      m_max_table_size{table.get_max_table_size()} {}
+
+void dynamic_table_view::push(const size_t block_position) {
+  const auto& header = m_header_block->at(block_position).get_header();
+  const auto header_size = get_entry_size(header);
+
+  // cf. https://tools.ietf.org/html/rfc7541#section-4.4
+  if (header_size > m_max_table_size) {
+    m_table_count = 0;
+    m_evicted = m_added.size();
+    m_table_size = 0;
+    return;
+  }
+
+  m_table_size += header_size;
+  evict(m_max_table_size);
+  m_added.push_back(block_position);
+  return;
+}
+
+void dynamic_table_view::update_table_size(const size_type new_size) {
+  evict(new_size);
+  m_max_table_size = new_size;
+  return;
+}
+
+const header_t& dynamic_table_view::at(const size_t position) const {
+  const auto added_count = get_added_count();
+  if (position < added_count) {
+    return (*m_header_block)[m_added[m_added.size() - 1u - position]]
+        .get_header();
+  }
+  if (position - added_count >= m_table_count) {
+    throw std::out_of_range("no dynamic table entry at " +
+                            std::to_string(position));
+  }
+  return m_table.at(position - added_count);
+}
+
+size_t dynamic_table_view::find(const header_t& header) const {
+  for (size_t position = 0; position < size(); ++position) {
+    if (at(position) == header) {
+      return position;
+    }
+  }
+  return size();
+}
+
+size_t dynamic_table_view::size() const {
+  return get_added_count() + m_table_count;
+}
+
+size_t dynamic_table_view::get_added_count() const {
+  return m_added.size() - m_evicted;
+}
+
+void dynamic_table_view::evict(const size_type max_table_size) {
+  // The oldest entries are those of the table, then those the block added.
+  while (m_table_size > max_table_size) {
+    if (m_table_count > 0) {
+      m_table_size -= get_entry_size(m_table.at(--m_table_count));
+    } else {
+      m_table_size -= get_entry_size(at(get_added_count() - 1u));
+      ++m_evicted;
+    }
+  }
+  return;
+}
+
+}  // namespace mh2c
@@ -0,0 +1,62 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#ifndef MH2C_HPACK_DYNAMIC_TABLE_VIEW_H_
+#define MH2C_HPACK_DYNAMIC_TABLE_VIEW_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+
+namespace mh2c {
+
+// The dynamic table as the entries of a header block coded so far leave it,
+// without copying the table: the entries the block adds are referred to by
+// their position in the block, and the evictions only shorten the part of
+// the table that is still visible. Nothing is allocated until an entry is
+// added.
+// cf. https://tools.ietf.org/html/rfc7541#section-4.4
+class dynamic_table_view {
+ public:
+  using size_type = dynamic_table::size_type;
+
+  // header_block holds the entries push() adds. It may grow while the view
+  // is in use, but both have to outlive the view.
+  explicit dynamic_table_view(const dynamic_table& table,
+                              const header_block_t* header_block = nullptr);
+
+  dynamic_table_view(const dynamic_table_view&) = delete;
+  dynamic_table_view& operator=(const dynamic_table_view&) = delete;
+
+  // Adds the header of (*header_block)[block_position].
+  void push(const size_t block_position);
+  void update_table_size(const size_type new_size);
+
+  // Entry at the position, 0 being the newest; throws std::out_of_range
+  // past the end like dynamic_table::at().
+  const header_t& at(const size_t position) const;
+  // Position of the newest entry equal to header, size() when there is none
+  size_t find(const header_t& header) const;
+  size_t size() const;
+
+ private:
+  size_t get_added_count() const;
+  void evict(const size_type max_table_size);
+
+  const dynamic_table& m_table;
+  const header_block_t* m_header_block;
+  // Positions in m_header_block of the entries added, oldest first; the
+  // first m_evicted of them have been evicted again.
+  std::vector<size_t> m_added;
+  size_t m_evicted;
+  // Entries of m_table still visible, the newest ones
+  size_t m_table_count;
+  size_type m_table_size;
+  size_type m_max_table_size;
+};
+
+}  // namespace mh2c
+
+#endif  // MH2C_HPACK_DYNAMIC_TABLE_VIEW_H_
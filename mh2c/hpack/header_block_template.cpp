@@ -0,0 +1,179 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/hpack/header_block_template.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_encoder.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/util/cast.h"
+
+namespace mh2c {
+
+header_block_template::header_block_template(
+    const header_block_t& header_block,
+    const std::vector<header_name_t>& variable_names,
+    const header_encode_mode mode)
+    : m_header_block{header_block},
+      m_variable_positions{},
+      m_mode{mode},
+      m_constant_segments{},
+      m_emitted_block{},
+      m_table{nullptr},
+      m_table_revision{} {
+  for (size_t position = 0; position < m_header_block.size(); ++position) {
+    const auto& entry = m_header_block[position];
+    if (entry.get_prefix() == header_prefix_pattern::SIZE_UPDATE ||
+        std::find(variable_names.begin(), variable_names.end(),
+                  entry.get_header().first) == variable_names.end()) {
+      continue;
+    }
+    if (entry.get_prefix() == header_prefix_pattern::INCREMENTAL_INDEXING) {
+      throw std::invalid_argument("variable field is indexed: " +
+                                  entry.get_header().first);
+    }
+    m_variable_positions.push_back(position);
+  }
+}
+
+byte_array_t header_block_template::encode(
+    const std::vector<header_value_t>& values,
+    const dynamic_table& dynamic_table, header_block_t* emitted_block) {
+  if (m_table != &dynamic_table ||
+      m_table_revision != dynamic_table.get_revision() ||
+      m_constant_segments.empty()) {
+    header_block_t full_emitted_block{};
+    std::vector<size_t> entry_ends{};
+    const auto encoded_block =
+        encode_header_block(make_header_block(values), m_mode, dynamic_table,
+                            &full_emitted_block, &entry_ends);
+    cache_constant_segments(encoded_block, entry_ends, full_emitted_block,
+                            dynamic_table);
+    if (emitted_block != nullptr) {
+      emitted_block->insert(emitted_block->end(), full_emitted_block.begin(),
+                            full_emitted_block.end());
+    }
+    return encoded_block;
+  }
+
+  if (values.size() != m_variable_positions.size()) {
+    const auto msg = "number of values is invalid: " +
+                     std::to_string(values.size());
+    throw std::invalid_argument(msg);
+  }
+
+  size_t length = 0u;
+  for (const auto& segment : m_constant_segments) {
+    length += segment.size();
+  }
+  for (size_t i = 0; i < m_variable_positions.size(); ++i) {
+    const auto& entry = m_header_block[m_variable_positions[i]];
+    // Name and value as literals, with their length prefixes
+    length += entry.get_header().first.size() + values[i].size() + 8u;
+  }
+
+  byte_array_t encoded_block{};
+  encoded_block.reserve(length);
+  const auto first_emitted = emitted_block != nullptr ? emitted_block->size()
+                                                      : size_t{0u};
+  if (emitted_block != nullptr) {
+    emitted_block->insert(emitted_block->end(), m_emitted_block.begin(),
+                          m_emitted_block.end());
+  }
+  for (size_t i = 0; i < m_variable_positions.size(); ++i) {
+    const auto& segment = m_constant_segments[i];
+    encoded_block.insert(encoded_block.end(), segment.begin(), segment.end());
+
+    const auto position = m_variable_positions[i];
+    auto entry = m_header_block[position];
+    entry.set_header({entry.get_header().first, values[i]});
+    const auto encoded_header = encode_header(entry, m_mode, dynamic_table);
+    encoded_block.insert(encoded_block.end(), encoded_header.begin(),
+                         encoded_header.end());
+    if (emitted_block != nullptr) {
+      const auto is_indexed =
+          encoded_header[0] & underlying_cast(header_prefix_pattern::INDEXED);
+      (*emitted_block)[first_emitted + position] =
+          is_indexed ? header_block_entry{header_prefix_pattern::INDEXED,
+                                          entry.get_header()}
+                     : entry;
+    }
+  }
+  const auto& last_segment = m_constant_segments.back();
+  encoded_block.insert(encoded_block.end(), last_segment.begin(),
+                       last_segment.end());
+  return encoded_block;
+}
+
+header_block_t header_block_template::make_header_block(
+    const std::vector<header_value_t>& values) const {
+  if (values.size() != m_variable_positions.size()) {
+    const auto msg = "number of values is invalid: " +
+                     std::to_string(values.size());
+    throw std::invalid_argument(msg);
+  }
+
+  auto header_block = m_header_block;
+  for (size_t i = 0; i < m_variable_positions.size(); ++i) {
+    auto& entry = header_block[m_variable_positions[i]];
+    entry.set_header({entry.get_header().first, values[i]});
+  }
+  return header_block;
+}
+
+const header_block_t& header_block_template::get_header_block() const {
+  return m_header_block;
+}
+
+header_encode_mode header_block_template::get_mode() const { return m_mode; }
+
+void header_block_template::cache_constant_segments(
+    const byte_array_t& encoded_block, const std::vector<size_t>& entry_ends,
+    const header_block_t& emitted_block, const dynamic_table& dynamic_table) {
+  m_constant_segments.clear();
+  m_table = nullptr;
+
+  // A block that adds entries or resizes the table is encoded again once the
+  // table has changed; the segments would not outlive it.
+  const auto changes_table =
+      std::any_of(emitted_block.begin(), emitted_block.end(),
+                  [](const header_block_entry& entry) {
+                    const auto prefix = entry.get_prefix();
+                    return prefix == header_prefix_pattern::SIZE_UPDATE ||
+                           prefix ==
+                               header_prefix_pattern::INCREMENTAL_INDEXING;
+                  });
+  if (changes_table) {
+    return;
+  }
+
+  // Every field is encoded against the same table, so the encodings of the
+  // fields are those they have in the block.
+  m_constant_segments.emplace_back();
+  auto variable_iter = m_variable_positions.begin();
+  size_t begin = 0u;
+  for (size_t position = 0; position < m_header_block.size(); ++position) {
+    const auto end = entry_ends[position];
+    if (variable_iter != m_variable_positions.end() &&
+        *variable_iter == position) {
+      m_constant_segments.emplace_back();
+      ++variable_iter;
+    } else {
+      m_constant_segments.back().insert(m_constant_segments.back().end(),
+                                        encoded_block.begin() + begin,
+                                        encoded_block.begin() + end);
+    }
+    begin = end;
+  }
+  m_emitted_block = emitted_block;
+  m_table = &dynamic_table;
+  m_table_revision = dynamic_table.get_revision();
+  return;
+}
+
+}  // namespace mh2c
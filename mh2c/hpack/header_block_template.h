@@ -0,0 +1,66 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#ifndef MH2C_HPACK_HEADER_BLOCK_TEMPLATE_H_
+#define MH2C_HPACK_HEADER_BLOCK_TEMPLATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+
+namespace mh2c {
+
+// Header block of requests that differ in a few values only, e.g. :path. The
+// constant fields are encoded once per state of the dynamic table and then
+// copied as they are, indexed references included, so that a block costs the
+// encoding of its variable values only. Once the table changes, evictions
+// included, the next encode() encodes the whole block again. The table is
+// told apart by its address and revision only: encoding against a table that
+// replaced a destroyed one takes a new template.
+class header_block_template {
+ public:
+  // The fields of header_block named in variable_names take their values from
+  // encode(), in the order they appear in header_block. Throws
+  // std::invalid_argument when a variable field is INCREMENTAL_INDEXING,
+  // which would add an entry to the table with every new value.
+  header_block_template(const header_block_t& header_block,
+                        const std::vector<header_name_t>& variable_names,
+                        const header_encode_mode mode);
+
+  // Equivalent to encode_header_block() of make_header_block(values), which
+  // throws std::invalid_argument unless there is a value per variable field.
+  byte_array_t encode(const std::vector<header_value_t>& values,
+                      const dynamic_table& dynamic_table,
+                      header_block_t* emitted_block = nullptr);
+  header_block_t make_header_block(
+      const std::vector<header_value_t>& values) const;
+
+  const header_block_t& get_header_block() const;
+  header_encode_mode get_mode() const;
+
+ private:
+  // Slices the encodings of the constant fields out of a whole block
+  void cache_constant_segments(const byte_array_t& encoded_block,
+                               const std::vector<size_t>& entry_ends,
+                               const header_block_t& emitted_block,
+                               const dynamic_table& dynamic_table);
+
+  header_block_t m_header_block;
+  std::vector<size_t> m_variable_positions;
+  header_encode_mode m_mode;
+
+  // Encodings of the constant fields before each variable field and after
+  // the last one, valid while m_table is at m_table_revision
+  std::vector<byte_array_t> m_constant_segments;
+  header_block_t m_emitted_block;
+  const dynamic_table* m_table;
+  uint64_t m_table_revision;
+};
+
+}  // namespace mh2c
+
+#endif  // MH2C_HPACK_HEADER_BLOCK_TEMPLATE_H_
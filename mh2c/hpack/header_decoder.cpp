@@ -11,6 +11,7 @@
 
 #include "mh2c/common/byte_array.h"
 #include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/dynamic_table_view.h"
 #include "mh2c/hpack/header_type.h"
 #include "mh2c/hpack/huffman_decoder.h"
 #include "mh2c/hpack/integer_representation.h"
@@ -154,8 +155,10 @@ decoded_string_t decode_header_value(const byte_array_t& encoded_header_value) {
   return {header_value, decoded_byte_length};
 }
 
+namespace {
+
 header_t make_indexed_header(const size_t index,
-                             const dynamic_table& dynamic_table) {
+                             const dynamic_table_view& dynamic_table) {
   const auto static_table_end_index = static_table_entries.size();
   const auto header =
       (index > static_table_end_index)
@@ -165,7 +168,7 @@ header_t make_indexed_header(const size_t index,
 }
 
 decoded_header_t decode_header(const byte_array_t& encoded_header,
-                               const dynamic_table& dynamic_table) {
+                               const dynamic_table_view& dynamic_table) {
   byte_array_t encoded_data{encoded_header};
   const auto prefix = check_prefix(encoded_data[0]);
 
@@ -215,4 +218,39 @@ decoded_header_t decode_header(const byte_array_t& encoded_header,
   return {header_entry, decoded_byte_length};
 }
 
+}  // namespace
+
+decoded_header_t decode_header(const byte_array_t& encoded_header,
+                               const dynamic_table& dynamic_table) {
+  return decode_header(encoded_header, dynamic_table_view{dynamic_table});
+}
+
+header_block_t decode_header_block(const byte_array_t& encoded_block,
+                                   const dynamic_table& dynamic_table) {
+  auto encoded_data{encoded_block};
+  header_block_t header_block{};
+  // Follows the entries that change the table
+  dynamic_table_view table{dynamic_table, &header_block};
+
+  while (encoded_data.size() > 0) {
+    const auto [header_entry, decoded_length] =
+        decode_header(encoded_data, table);
+    header_block.push_back(header_entry);
+    encoded_data.erase(encoded_data.begin(),
+                       encoded_data.begin() + decoded_length);
+
+    const auto prefix = header_entry.get_prefix();
+    if (encoded_data.empty()) {
+      continue;
+    }
+    if (prefix == header_prefix_pattern::SIZE_UPDATE) {
+      table.update_table_size(header_entry.get_max_size());
+    } else if (prefix == header_prefix_pattern::INCREMENTAL_INDEXING) {
+      table.push(header_block.size() - 1u);
+    }
+  }
+
+  return header_block;
+}
+
 }  // namespace mh2c
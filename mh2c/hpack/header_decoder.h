@@ -16,6 +16,12 @@ using decoded_header_t = std::pair<header_block_entry, size_t>;
 
 decoded_header_t decode_header(const byte_array_t& encoded_header,
                                const dynamic_table& dynamic_table);
+// Decode every entry of a complete block, each against the table as the
+// entries before it have left it, without changing dynamic_table; apply the
+// block with update_dynamic_table() afterwards.
+// cf. https://tools.ietf.org/html/rfc7541#section-3.2
+header_block_t decode_header_block(const byte_array_t& encoded_block,
+                                   const dynamic_table& dynamic_table);
 
 }  // namespace mh2c
 
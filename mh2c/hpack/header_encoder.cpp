@@ -10,6 +10,7 @@
 
 #include "mh2c/common/byte_array.h"
 #include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/dynamic_table_view.h"
 #include "mh2c/hpack/header_type.h"
 #include "mh2c/hpack/huffman_encoder.h"
 #include "mh2c/hpack/integer_representation.h"
@@ -106,9 +107,11 @@ byte_array_t encode_header_name(const header_name_t& header_name,
   return encoded_header_name;
 }
 
+namespace {
+
 byte_array_t encode_header(const header_block_entry& header_entry,
                            const header_encode_mode encode_mode,
-                           const dynamic_table& dynamic_table) {
+                           const dynamic_table_view& dynamic_table) {
   const auto prefix = header_entry.get_prefix();
 
   // max size update
@@ -116,7 +119,7 @@ byte_array_t encode_header(const header_block_entry& header_entry,
     return encode_max_size(header_entry.get_max_size(), prefix);
   }
 
-  const auto header = header_entry.get_header();
+  const auto& header = header_entry.get_header();
 
   // header name/value match in reverse static table
   // cf. https://tools.ietf.org/html/rfc7541#section-6.1
@@ -127,10 +130,8 @@ byte_array_t encode_header(const header_block_entry& header_entry,
   }
 
   // header name/value match in dynamic table
-  const auto header_iter =
-      std::find(dynamic_table.begin(), dynamic_table.end(), header);
-  if (header_iter != dynamic_table.end()) {
-    const auto index = header_iter - dynamic_table.begin();
+  const auto index = dynamic_table.find(header);
+  if (index != dynamic_table.size()) {
     return encode_index(static_table_entries.size() + 1 + index,
                         header_prefix_pattern::INDEXED);
   }
@@ -164,4 +165,56 @@ byte_array_t encode_header(const header_block_entry& header_entry,
   return encoded_header;
 }
 
+}  // namespace
+
+byte_array_t encode_header(const header_block_entry& header_entry,
+                           const header_encode_mode encode_mode,
+                           const dynamic_table& dynamic_table) {
+  return encode_header(header_entry, encode_mode,
+                       dynamic_table_view{dynamic_table});
+}
+
+byte_array_t encode_header_block(const header_block_t& header_block,
+                                 const header_encode_mode mode,
+                                 const dynamic_table& dynamic_table,
+                                 header_block_t* emitted_block,
+                                 std::vector<size_t>* entry_ends) {
+  byte_array_t encoded_block{};
+  // Follows the entries that change the table, which only blocks bringing
+  // new headers have
+  dynamic_table_view table{dynamic_table, &header_block};
+  for (size_t position = 0; position < header_block.size(); ++position) {
+    const auto& header_entry = header_block[position];
+    const auto encoded_header = encode_header(header_entry, mode, table);
+    encoded_block.insert(encoded_block.end(), encoded_header.begin(),
+                         encoded_header.end());
+    if (entry_ends != nullptr) {
+      entry_ends->push_back(encoded_block.size());
+    }
+
+    const auto prefix = header_entry.get_prefix();
+    const auto is_indexed =
+        prefix != header_prefix_pattern::SIZE_UPDATE &&
+        (encoded_header[0] & underlying_cast(header_prefix_pattern::INDEXED));
+    if (emitted_block != nullptr) {
+      emitted_block->push_back(
+          is_indexed ? header_block_entry{header_prefix_pattern::INDEXED,
+                                          header_entry.get_header()}
+                     : header_entry);
+    }
+
+    // The last entry leaves the table to the caller.
+    if (position + 1u == header_block.size()) {
+      break;
+    }
+    if (prefix == header_prefix_pattern::SIZE_UPDATE) {
+      table.update_table_size(header_entry.get_max_size());
+    } else if (prefix == header_prefix_pattern::INCREMENTAL_INDEXING &&
+               is_indexed == false) {
+      table.push(position);
+    }
+  }
+  return encoded_block;
+}
+
 }  // namespace mh2c
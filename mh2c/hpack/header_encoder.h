@@ -4,6 +4,9 @@
 #ifndef MH2C_HPACK_HEADER_ENCODER_H_
 #define MH2C_HPACK_HEADER_ENCODER_H_
 
+#include <cstddef>
+#include <vector>
+
 #include "mh2c/common/byte_array.h"
 #include "mh2c/hpack/dynamic_table.h"
 #include "mh2c/hpack/header_type.h"
@@ -13,6 +16,19 @@ namespace mh2c {
 byte_array_t encode_header(const header_block_entry& header,
                            const header_encode_mode mode,
                            const dynamic_table& dynamic_table);
+// Encode the entries in order into one contiguous block, each against the
+// table as the entries before it leave it on the peer. emitted_block, when
+// given, receives the entries as they are represented: an entry found in the
+// static or dynamic table is INDEXED whatever its prefix, so that
+// update_dynamic_table() applies the block the way the peer does.
+// entry_ends, when given, receives the offset in the block at which the
+// encoding of each entry ends.
+// cf. https://tools.ietf.org/html/rfc7541#section-3.2
+byte_array_t encode_header_block(const header_block_t& header_block,
+                                 const header_encode_mode mode,
+                                 const dynamic_table& dynamic_table,
+                                 header_block_t* emitted_block = nullptr,
+                                 std::vector<size_t>* entry_ends = nullptr);
 
 }  // namespace mh2c
 
@@ -40,7 +40,7 @@ header_prefix_pattern header_block_entry::get_prefix() const {
   return m_prefix;
 }
 
-header_t header_block_entry::get_header() const {
+const header_t& header_block_entry::get_header() const {
   if (std::holds_alternative<header_t>(m_entry)) {
     return std::get<header_t>(m_entry);
   } else {
@@ -50,7 +50,7 @@ class header_block_entry {
   header_block_entry(const header_prefix_pattern prefix, const size_t max_size);
 
   header_prefix_pattern get_prefix() const;
-  header_t get_header() const;
+  const header_t& get_header() const;
   size_t get_max_size() const;
   std::variant<header_t, size_t> get_entry() const;
 
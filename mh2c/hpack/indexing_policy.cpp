@@ -0,0 +1,80 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/hpack/indexing_policy.h"
+
+#include <algorithm>
+
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+
+namespace mh2c {
+
+indexing_policy::indexing_policy(const indexing_policy_options& options)
+    : m_options{options}, m_names{}, m_values{}, m_status{} {}
+
+indexing_decision indexing_policy::decide(const header_t& header,
+                                          const dynamic_table& dynamic_table) {
+  if (is_sensitive(header.first)) {
+    ++m_status.m_sensitive;
+    return {header_prefix_pattern::NEVER_INDEXED, indexing_reason::SENSITIVE};
+  }
+
+  // cf. https://tools.ietf.org/html/rfc7541#section-4.1
+  const auto entry_size = header.first.length() + header.second.length() +
+                          dynamic_table::ENTRY_OVERHEAD_SIZE;
+  if (entry_size >
+      dynamic_table.get_max_table_size() * m_options.m_max_entry_share) {
+    ++m_status.m_too_large;
+    return {header_prefix_pattern::WITHOUT_INDEXING,
+            indexing_reason::TOO_LARGE};
+  }
+
+  if (m_values.size() >= m_options.m_max_tracked_values &&
+      m_values.count(header) == 0) {
+    m_values.clear();
+    m_names.clear();
+  }
+  auto& stats = m_names[header.first];
+  const auto previous_fields = stats.m_fields++;
+  if (m_values[header]++ > 0) {
+    ++m_status.m_recurring_values;
+    return {header_prefix_pattern::INCREMENTAL_INDEXING,
+            indexing_reason::RECURRING_VALUE};
+  }
+
+  // A name most of whose fields so far brought a new value is expected to
+  // bring yet another one.
+  const auto previous_values = stats.m_distinct_values++;
+  if (previous_fields < m_options.m_min_name_samples ||
+      previous_values * 2u <= previous_fields) {
+    ++m_status.m_recurring_names;
+    return {header_prefix_pattern::INCREMENTAL_INDEXING,
+            indexing_reason::RECURRING_NAME};
+  }
+  ++m_status.m_unique_values;
+  return {header_prefix_pattern::WITHOUT_INDEXING,
+          indexing_reason::UNIQUE_VALUES};
+}
+
+header_block_t indexing_policy::make_header_block(
+    const headers_t& headers, const dynamic_table& dynamic_table) {
+  header_block_t header_block{};
+  header_block.reserve(headers.size());
+  for (const auto& header : headers) {
+    header_block.emplace_back(decide(header, dynamic_table).m_prefix, header);
+  }
+  return header_block;
+}
+
+indexing_policy_status indexing_policy::get_status() const {
+  return m_status;
+}
+
+bool indexing_policy::is_sensitive(const header_name_t& name) const {
+  return std::find(m_options.m_sensitive_names.begin(),
+                   m_options.m_sensitive_names.end(),
+                   name) != m_options.m_sensitive_names.end();
+}
+
+}  // namespace mh2c
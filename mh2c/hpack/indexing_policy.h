@@ -0,0 +1,100 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#ifndef MH2C_HPACK_INDEXING_POLICY_H_
+#define MH2C_HPACK_INDEXING_POLICY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+
+namespace mh2c {
+
+struct indexing_policy_options {
+  // Names whose values are credentials: sent NEVER_INDEXED, so that neither
+  // the peer nor an intermediary indexes them.
+  // cf. https://tools.ietf.org/html/rfc7541#section-7.1.3
+  std::vector<header_name_t> m_sensitive_names{
+      "authorization", "proxy-authorization", "cookie", "set-cookie"};
+  // An entry larger than this share of the table, 32 bytes of overhead
+  // included, is sent WITHOUT_INDEXING: it would evict most of the table for
+  // one value.
+  double m_max_entry_share{0.25};
+  // Once a name has been seen this many times with mostly new values, only
+  // the values that have already been sent are indexed.
+  uint32_t m_min_name_samples{2u};
+  // Name/value pairs counted; past it the counts start over, so that memory
+  // stays bounded whatever the values.
+  size_t m_max_tracked_values{4096u};
+};
+
+enum class indexing_reason : uint8_t {
+  SENSITIVE,
+  TOO_LARGE,
+  // The name and value have been sent before.
+  RECURRING_VALUE,
+  // New value of a name whose values tend to repeat, or have not been seen
+  // enough to tell.
+  RECURRING_NAME,
+  // New value of a name whose values seldom repeat
+  UNIQUE_VALUES,
+};
+
+struct indexing_decision {
+  header_prefix_pattern m_prefix;
+  indexing_reason m_reason;
+};
+
+// Decisions made so far, by reason
+struct indexing_policy_status {
+  uint64_t m_sensitive{0};
+  uint64_t m_too_large{0};
+  uint64_t m_recurring_values{0};
+  uint64_t m_recurring_names{0};
+  uint64_t m_unique_values{0};
+};
+
+// Chooses the literal representation of each field by how often its name and
+// value recur, in place of one prefix for a whole block: values likely to be
+// sent again are added to the dynamic table, while high-entropy ones, e.g.
+// :path of distinct resources or request identifiers, stay out of it rather
+// than evicting the entries that do repeat. One policy follows the fields of
+// one connection.
+// cf. https://tools.ietf.org/html/rfc7541#section-6.2
+class indexing_policy {
+ public:
+  explicit indexing_policy(const indexing_policy_options& options = {});
+
+  // Representation for the field, to be encoded against dynamic_table, whose
+  // maximum size is the SETTINGS_HEADER_TABLE_SIZE in effect. Counts the
+  // field as sent.
+  indexing_decision decide(const header_t& header,
+                           const dynamic_table& dynamic_table);
+  // Block of the fields with the prefix decide() chooses for each
+  header_block_t make_header_block(const headers_t& headers,
+                                   const dynamic_table& dynamic_table);
+
+  indexing_policy_status get_status() const;
+
+ private:
+  struct name_stats {
+    uint64_t m_fields;
+    uint64_t m_distinct_values;
+  };
+
+  bool is_sensitive(const header_name_t& name) const;
+
+  indexing_policy_options m_options;
+  std::unordered_map<header_name_t, name_stats> m_names;
+  std::map<header_t, uint32_t> m_values;
+  indexing_policy_status m_status;
+};
+
+}  // namespace mh2c
+
+#endif  // MH2C_HPACK_INDEXING_POLICY_H_
@@ -3,24 +3,74 @@
 // See accompanying file LICENSE.
 #include "mh2c/http2_client.h"
 
+#include <sys/types.h>
+#include <sys/uio.h>
+
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <ostream>
 #include <queue>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "mh2c/body/body_source.h"
+#include "mh2c/body/content_decoder.h"
 #include "mh2c/common/byte_array.h"
+#include "mh2c/flow_control/bdp_estimator.h"
+#include "mh2c/flow_control/receive_window.h"
+#include "mh2c/flow_control/send_window.h"
+#include "mh2c/flow_control/window_autotuning.h"
 #include "mh2c/frame/common_type.h"
 #include "mh2c/frame/continuation_frame.h"
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/error_codes.h"
 #include "mh2c/frame/frame_builder.h"
 #include "mh2c/frame/frame_header.h"
 #include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/goaway_frame.h"
+#include "mh2c/frame/header_block_fragment.h"
 #include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/i_frame.h"
+#include "mh2c/frame/ping_frame.h"
+#include "mh2c/frame/priority_frame.h"
 #include "mh2c/frame/push_promise_frame.h"
+#include "mh2c/frame/rst_stream_frame.h"
 #include "mh2c/frame/settings_frame.h"
+#include "mh2c/frame/window_update_frame.h"
 #include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_block_template.h"
+#include "mh2c/hpack/header_encoder.h"
 #include "mh2c/hpack/header_type.h"
+#include "mh2c/metrics/connection_metrics.h"
+#include "mh2c/metrics/header_block_inspector.h"
+#include "mh2c/net/connect_options.h"
+#include "mh2c/settings/connection_settings.h"
 #include "mh2c/ssl/ssl_connection.h"
+#include "mh2c/ssl/ssl_ktls_mode.h"
+#include "mh2c/ssl/ssl_session_cache.h"
+#include "mh2c/stream/latency_breakdown.h"
+#include "mh2c/stream/priority_scheduler.h"
+#include "mh2c/stream/push_cache.h"
+#include "mh2c/stream/stream_latency_tracker.h"
+#include "mh2c/stream/stream_state.h"
+#include "mh2c/stream/stream_tracker.h"
+#include "mh2c/trace/frame_capture.h"
+#include "mh2c/trace/trace_hook.h"
+#include "mh2c/trace/trace_observer.h"
+#include "mh2c/transport/file_copy.h"
+#include "mh2c/transport/i_transport.h"
+#include "mh2c/util/bit_operation.h"
 #include "mh2c/util/byte_order.h"
 #include "mh2c/util/cast.h"
 
@@ -28,58 +78,116 @@ namespace mh2c {
 
 namespace {
 
-void update_dynamic_table(const header_block_t& header_block,
-                          dynamic_table* dynamic_table) {
-  std::for_each(
-      header_block.begin(), header_block.end(),
-      [dynamic_table](const auto& header_entry) {
-        if (header_entry.get_prefix() ==
-            header_prefix_pattern::INCREMENTAL_INDEXING) {
-          dynamic_table->push(header_entry.get_header());
-        } else if (header_entry.get_prefix() ==
-                   header_prefix_pattern::SIZE_UPDATE) {
-          dynamic_table->update_table_size(header_entry.get_max_size());
-        }
-      });
+// Opaque data of the PING frames sent to measure RTT
+const byte_array_t BDP_PING_OPAQUE_DATA{'m', 'h', '2', 'c', 'b', 'd', 'p', 0};
+
+// Bounds on the control frames held back while the peer keeps sending
+constexpr size_t MAX_HELD_CONTROL_BYTES{1024u};
+constexpr std::chrono::milliseconds MAX_CONTROL_FRAME_HOLD{5};
+
+// DATA frame whose payload stays in the body source, so that sending a chunk
+// never copies it into a frame object
+class data_chunk_frame : public i_frame<frame_header> {
+ public:
+  data_chunk_frame(const frame_header& fh, const uint8_t* payload)
+      : m_header{fh}, m_payload{payload} {}
+
+  frame_header get_header() const override { return m_header; }
+
+  byte_array_t serialize() const override {
+    auto serialized_df = mh2c::serialize(m_header);
+    serialized_df.insert(serialized_df.end(), m_payload,
+                         m_payload + m_header.m_length);
+    return serialized_df;
+  }
+
+  void dump(std::ostream& out_stream) const override {
+    data_frame{m_header.m_flags, m_header.m_stream_id,
+               byte_array_t(m_payload, m_payload + m_header.m_length)}
+        .dump(out_stream);
+    return;
+  }
+
+ private:
+  frame_header m_header;
+  const uint8_t* m_payload;
+};
 
+struct pending_body {
+  fh_stream_id_t m_stream_id;
+  std::unique_ptr<body::i_body_source> m_source;
+};
+
+struct response_decoding {
+  std::shared_ptr<body::i_body_sink> m_sink;
+  // Created once the response header block, CONTINUATION frames included,
+  // tells the content-encoding
+  std::unique_ptr<body::content_decoder> m_decoder;
+  // Fields of the header block so far, and whether it goes on in
+  // CONTINUATION frames
+  headers_t m_headers;
+  bool m_headers_continued;
+  bool m_end_stream;
+};
+
+// Response whose body a frame could not decode
+struct decoding_failure {
+  std::shared_ptr<body::i_body_sink> m_sink;
+  std::string m_what;
+};
+
+void append_headers(const header_block_t& header_block, headers_t* headers) {
+  for (const auto& entry : header_block) {
+    if (entry.get_prefix() != header_prefix_pattern::SIZE_UPDATE) {
+      headers->push_back(entry.get_header());
+    }
+  }
   return;
 }
 
-void update_dynamic_table(const h2_frame_ptr& frame_ptr,
-                          dynamic_table* dynamic_table) {
-  header_block_t header_block{};
+header_value_t find_value(const headers_t& headers, const header_name_t& name) {
+  for (const auto& header : headers) {
+    if (header.first == name) {
+      return header.second;
+    }
+  }
+  return {};
+}
 
-  switch (cast_to_frame_type_registry(frame_ptr->get_header().m_type)) {
+bool has_header(const header_block_t& header_block,
+                const header_name_t& name) {
+  return std::any_of(header_block.begin(), header_block.end(),
+                     [&name](const header_block_entry& entry) {
+                       return entry.get_prefix() !=
+                                  header_prefix_pattern::SIZE_UPDATE &&
+                              entry.get_header().first == name;
+                     });
+}
+
+// Frames that may go out as TLS 1.3 early data, which the server may process
+// twice: requests of a safe method without a body. A CONTINUATION frame
+// follows a HEADERS frame that was.
+// cf. https://tools.ietf.org/html/rfc8470#section-2.1
+bool is_replayable(const i_frame<frame_header>& frame) {
+  const auto fh = frame.get_header();
+  switch (cast_to_frame_type_registry(fh.m_type)) {
+    case frame_type_registry::DATA:
+      return false;
     case frame_type_registry::HEADERS:
-      header_block =
-          dynamic_cast<const headers_frame*>(frame_ptr.get())->get_payload();
-      break;
-    case frame_type_registry::PUSH_PROMISE:
-      header_block = dynamic_cast<const push_promise_frame*>(frame_ptr.get())
-                         ->get_payload()
-                         .m_header_block;
-      break;
-    case frame_type_registry::CONTINUATION:
-      header_block = dynamic_cast<const continuation_frame*>(frame_ptr.get())
-                         ->get_payload();
-      break;
-    case frame_type_registry::SETTINGS: {
-      const auto sf_payload =
-          dynamic_cast<const settings_frame*>(frame_ptr.get())->get_payload();
-      const auto table_size_key =
-          underlying_cast(sf_parameter::SETTINGS_HEADER_TABLE_SIZE);
-      if (sf_payload.find(table_size_key) != sf_payload.end()) {
-        const auto table_size = sf_payload.at(table_size_key);
-        dynamic_table->update_table_size(table_size);
+      if (is_flag_set(fh.m_flags, hf_flag::END_STREAM) == false) {
+        return false;
       }
-      return;
-    }
+      for (const auto& entry : get_header_block(frame)) {
+        if (entry.get_prefix() != header_prefix_pattern::SIZE_UPDATE &&
+            entry.get_header().first == ":method") {
+          const auto& method = entry.get_header().second;
+          return method == "GET" || method == "HEAD";
+        }
+      }
+      return false;
     default:
-      return;
+      return true;
   }
-
-  update_dynamic_table(header_block, dynamic_table);
-  return;
 }
 
 }  // namespace
@@ -87,36 +195,197 @@ void update_dynamic_table(const h2_frame_ptr& frame_ptr,
 class http2_client::impl {
  public:
   impl(const std::string& hostname, const uint16_t port,
-       const ssl::verify_mode mode);
+       const ssl::verify_mode mode, const ssl::ktls_mode ktls,
+       const net::connect_options& options);
+  impl(std::unique_ptr<transport::i_transport> transport,
+       const net::connect_options& options);
 
   void send_raw_data(const uint8_t* data, const size_t length);
+  void send_raw_file(const int fd, const off_t offset, const size_t length);
   void receive_raw_data(uint8_t* data, const size_t length);
 
   void send_connection_preface();
+  h2_frame_ptr exchange_settings(const sf_payload_t& settings);
   h2_frame_ptr receive_frame();
+  bool wait_readable(const std::chrono::milliseconds timeout,
+                     const int wake_fd);
+  void flush_control_frames();
+  bool is_draining() const;
+  std::vector<fh_stream_id_t> take_unprocessed_streams();
 
+  void send_headers(const fh_flags_t flags, const fh_stream_id_t stream_id,
+                    const header_block_t& header_block,
+                    const header_encode_mode mode,
+                    const hf_priority_option& priority_option);
+  void send_headers(const fh_flags_t flags, const fh_stream_id_t stream_id,
+                    header_block_template* header_template,
+                    const std::vector<header_value_t>& values,
+                    const hf_priority_option& priority_option);
+  void send_body(const fh_stream_id_t stream_id,
+                 std::unique_ptr<body::i_body_source> source);
+  size_t get_pending_body_count() const;
+  size_t get_active_stream_count() const;
+  void decode_response_body(const fh_stream_id_t stream_id,
+                            std::shared_ptr<body::i_body_sink> sink);
+  void enable_push_cache(const stream::push_cache_options& options);
+  const stream::pushed_response* find_pushed_response(
+      const headers_t& request);
+  fh_stream_id_t get_promised_stream(const headers_t& request) const;
+  stream::push_cache_status get_push_cache_status() const;
   void update_request_dynamic_table(const header_block_t& header_block);
   void update_request_dynamic_table(const size_t max_size);
   const dynamic_table& get_request_dynamic_table();
 
+  ssl::ktls_status get_ktls_status() const;
+  ssl::early_data_status get_early_data_status() const;
+
+  void enable_window_autotuning(
+      const flow_control::autotuning_options& options);
+  flow_control::autotuning_status get_window_autotuning_status() const;
+
+  void check_frame(const i_frame<frame_header>& frame) const;
+  void end_early_data_unless_replayable(const i_frame<frame_header>& frame);
+  void on_frame_sent(const i_frame<frame_header>& frame,
+                     const uint8_t* raw_header, const uint8_t* raw_payload);
+  const metrics::connection_metrics& get_metrics() const;
+
+  const settings::connection_settings& get_settings() const;
+  size_t get_send_window(const fh_stream_id_t stream_id) const;
+
+  void set_trace_observer(std::shared_ptr<trace::i_trace_observer> observer);
+  stream::stream_state get_stream_state(const fh_stream_id_t stream_id) const;
+  void mark_stream_queued(const fh_stream_id_t stream_id);
+  const stream::latency_breakdown& get_latency_breakdown() const;
+
+  void start_capture(const std::string& path);
+  void stop_capture();
+
  private:
-  ssl::ssl_connection m_ssl_connection;
+  void send_encoded_headers(const fh_flags_t flags,
+                            const fh_stream_id_t stream_id,
+                            const byte_array_t& encoded_block,
+                            const header_block_t& emitted_block,
+                            const hf_priority_option& priority_option);
+  void send_control_frame(const i_frame<frame_header>& frame);
+  void queue_control_frame(const i_frame<frame_header>& frame);
+  // Writes the control frames queued first, in the same write.
+  void write_after_control_frames(const iovec* vectors, const size_t count);
+  // Once they have been written
+  void record_control_frames();
+  // Whether the control frames held back go out even though more frames are
+  // waiting to be read
+  bool must_flush_control_frames() const;
+  // Effects of a frame on the state of the connection, applied as soon as
+  // it is sent or queued
+  void apply_sent_frame(const i_frame<frame_header>& frame);
+  // Metrics, capture and trace of a frame written to the transport
+  void record_sent_frame(const frame_header& fh, const uint8_t* raw_header,
+                         const uint8_t* raw_payload);
+  void apply_peer_frame(const h2_frame_ptr& frame_ptr);
+  void flush_bodies();
+  void send_body_chunk(const fh_stream_id_t stream_id,
+                       const body::body_chunk& chunk);
+  std::optional<decoding_failure> decode_response_frame(
+      const i_frame<frame_header>& frame, const byte_array_t& raw_payload);
+  void fail_response_decoding(const fh_stream_id_t stream_id,
+                              const decoding_failure& failure);
+  void autotune_windows(const h2_frame_ptr& frame_ptr);
+  void record_header_block(const i_frame<frame_header>& frame,
+                           const uint8_t* raw_payload);
+  void on_stream_transitions(
+      const std::vector<stream::stream_transition>& transitions);
+  void on_table_updated(const trace::table_kind kind,
+                        const dynamic_table& table, uint64_t* last_revision);
+
+  net::connect_options m_connect_options;
+  std::unique_ptr<transport::i_transport> m_transport;
+  // m_transport when it is TLS
+  ssl::ssl_connection* m_ssl_connection;
   dynamic_table m_request_dynamic_table;
   dynamic_table m_response_dynamic_table;
+  settings::connection_settings m_settings;
+  flow_control::send_window m_send_window;
+  std::deque<pending_body> m_pending_bodies;
+  stream::priority_scheduler m_scheduler;
+  std::unordered_map<fh_stream_id_t, response_decoding> m_response_decodings;
+  std::optional<stream::push_cache> m_push_cache;
+  // Last GOAWAY of the peer
+  std::optional<goaway_payload> m_goaway;
+  std::vector<fh_stream_id_t> m_unprocessed_streams;
+  std::optional<flow_control::bdp_estimator> m_bdp_estimator;
+  std::optional<flow_control::receive_window> m_receive_window;
+  metrics::connection_metrics m_metrics;
+  stream::stream_tracker m_stream_tracker;
+  stream::stream_latency_tracker m_latency_tracker;
+  std::shared_ptr<trace::i_trace_observer> m_trace_observer;
+  std::unique_ptr<trace::frame_capture_writer> m_capture_writer;
+  // Serialized control frames answering the peer, see queue_control_frame()
+  byte_array_t m_control_frames;
+  // When the first of m_control_frames was queued
+  std::chrono::steady_clock::time_point m_control_frames_since;
+  // The peer may be waiting for it to send more.
+  bool m_window_update_held;
+  // The RTT sample starts once the PING is written, see
+  // record_control_frames().
+  bool m_bdp_ping_held;
+  // Revisions of the dynamic tables last reported to m_trace_observer
+  uint64_t m_request_table_revision;
+  uint64_t m_response_table_revision;
 };
 
 http2_client::impl::impl(const std::string& hostname, uint16_t port,
-                         const ssl::verify_mode mode)
-    : m_ssl_connection{hostname, port, mode} {}
+                         const ssl::verify_mode mode,
+                         const ssl::ktls_mode ktls,
+                         const net::connect_options& options)
+    : m_connect_options{options},
+      m_transport{},
+      m_ssl_connection{},
+      m_window_update_held{false},
+      m_bdp_ping_held{false},
+      m_request_table_revision{0},
+      m_response_table_revision{0} {
+  auto ssl_connection = std::make_unique<ssl::ssl_connection>(
+      hostname, port, mode, ktls, options);
+  m_ssl_connection = ssl_connection.get();
+  m_transport = std::move(ssl_connection);
+}
+
+http2_client::impl::impl(std::unique_ptr<transport::i_transport> transport,
+                         const net::connect_options& options)
+    : m_connect_options{options},
+      m_transport{std::move(transport)},
+      m_ssl_connection{},
+      m_window_update_held{false},
+      m_bdp_ping_held{false},
+      m_request_table_revision{0},
+      m_response_table_revision{0} {}
 
 void http2_client::impl::send_raw_data(const uint8_t* data,
                                        const size_t length) {
-  m_ssl_connection.write(data, length);
+  if (m_control_frames.empty()) {
+    m_transport->write(data, length);
+    return;
+  }
+  const iovec vectors[]{{const_cast<uint8_t*>(data), length}};
+  write_after_control_frames(vectors, sizeof(vectors) / sizeof(vectors[0]));
+  return;
+}
+
+void http2_client::impl::send_raw_file(const int fd, const off_t offset,
+                                       const size_t length) {
+  flush_control_frames();
+  m_transport->sendfile(fd, offset, length);
   return;
 }
 
 void http2_client::impl::receive_raw_data(uint8_t* data, const size_t length) {
-  m_ssl_connection.read(data, length);
+  // The peer may be waiting for them, e.g. for WINDOW_UPDATE.
+  if (m_control_frames.empty() == false &&
+      (must_flush_control_frames() ||
+       m_transport->wait_readable(std::chrono::milliseconds{0}) == false)) {
+    flush_control_frames();
+  }
+  m_transport->read(data, length);
   return;
 }
 
@@ -129,30 +398,245 @@ void http2_client::impl::send_connection_preface() {
   return;
 }
 
+h2_frame_ptr http2_client::impl::exchange_settings(
+    const sf_payload_t& settings) {
+  send_connection_preface();
+  send_control_frame(settings_frame{0u, 0u, settings});
+
+  // cf. https://tools.ietf.org/html/rfc7540#section-3.5
+  if (m_transport->wait_readable(m_connect_options.m_settings_timeout) ==
+      false) {
+    throw std::runtime_error("SETTINGS exchange timed out");
+  }
+
+  auto frame = receive_frame();
+  const auto type = frame->get_header().m_type;
+  if (cast_to_frame_type_registry(type) != frame_type_registry::SETTINGS) {
+    throw std::runtime_error("unexpected first frame: type=" +
+                             std::to_string(type));
+  }
+
+  return frame;
+}
+
 h2_frame_ptr http2_client::impl::receive_frame() {
   byte_array_t raw_fh(FRAME_HEADER_BYTES);
   receive_raw_data(&raw_fh[0], raw_fh.size());
   const auto fh = build_frame_header(raw_fh);
+  // Checked before the payload buffer is allocated
+  // cf. https://tools.ietf.org/html/rfc7540#section-4.2
+  const auto max_frame_size =
+      m_settings.get_local().get(sf_parameter::SETTINGS_MAX_FRAME_SIZE);
+  if (fh.m_length > max_frame_size) {
+    throw connection_error(error_codes::FRAME_SIZE_ERROR,
+                           "frame of " + std::to_string(fh.m_length) +
+                               " bytes, SETTINGS_MAX_FRAME_SIZE=" +
+                               std::to_string(max_frame_size));
+  }
 
   byte_array_t raw_payload(fh.m_length);
   if (fh.m_length > 0) {
     receive_raw_data(&raw_payload[0], raw_payload.size());
   }
 
+  if (m_capture_writer) {
+    m_capture_writer->write(trace::now(), trace::capture_direction::RECEIVED,
+                            raw_fh.data(), raw_payload.data(),
+                            raw_payload.size());
+  }
+
+  const auto decode_begin = std::chrono::steady_clock::now();
   auto frame_ptr = build_frame(fh, raw_payload, m_response_dynamic_table);
-  update_dynamic_table(frame_ptr, &m_response_dynamic_table);
+  const auto evicted_count =
+      update_dynamic_table(frame_ptr, &m_response_dynamic_table);
+  m_metrics.on_frame_decoded(std::chrono::steady_clock::now() - decode_begin);
+  m_metrics.on_frame_received(fh);
+  m_metrics.on_hpack_evictions(evicted_count);
+  record_header_block(*frame_ptr, raw_payload.data());
+
+  MH2C_TRACE(m_trace_observer, on_frame_received(trace::now(), fh));
+  on_table_updated(trace::table_kind::RESPONSE, m_response_dynamic_table,
+                   &m_response_table_revision);
+  // Before END_STREAM closes the stream
+  std::optional<decoding_failure> failure{};
+  if (m_response_decodings.empty() == false) {
+    failure = decode_response_frame(*frame_ptr, raw_payload);
+  }
+  const auto cancelled_stream_id =
+      m_push_cache ? m_push_cache->on_frame(*frame_ptr, raw_payload) : 0u;
+  on_stream_transitions(
+      m_stream_tracker.on_frame(*frame_ptr, stream::frame_origin::REMOTE));
+  m_latency_tracker.on_frame(fh, stream::frame_origin::REMOTE, decode_begin);
+  apply_peer_frame(frame_ptr);
+  // cf. https://tools.ietf.org/html/rfc7540#section-8.2.2
+  if (cancelled_stream_id != 0) {
+    queue_control_frame(
+        rst_stream_frame{cancelled_stream_id, error_codes::CANCEL});
+  }
+
+  if (m_receive_window) {
+    autotune_windows(frame_ptr);
+  }
+  if (m_pending_bodies.empty() == false) {
+    flush_bodies();
+  }
+  // Once the frame has been accounted for, as any other
+  if (failure.has_value()) {
+    fail_response_decoding(fh.m_stream_id, *failure);
+  }
 
   return frame_ptr;
 }
 
+bool http2_client::impl::wait_readable(
+    const std::chrono::milliseconds timeout, const int wake_fd) {
+  if (m_control_frames.empty() == false) {
+    if (m_transport->wait_readable(std::chrono::milliseconds{0}, wake_fd)) {
+      return true;
+    }
+    flush_control_frames();
+  }
+  return m_transport->wait_readable(timeout, wake_fd);
+}
+
+void http2_client::impl::flush_control_frames() {
+  if (m_control_frames.empty()) {
+    return;
+  }
+  m_transport->write(m_control_frames.data(), m_control_frames.size());
+  record_control_frames();
+  m_control_frames.clear();
+  m_window_update_held = false;
+  return;
+}
+
+bool http2_client::impl::is_draining() const { return m_goaway.has_value(); }
+
+std::vector<fh_stream_id_t> http2_client::impl::take_unprocessed_streams() {
+  return std::exchange(m_unprocessed_streams, {});
+}
+
+void http2_client::impl::send_headers(
+    const fh_flags_t flags, const fh_stream_id_t stream_id,
+    const header_block_t& header_block, const header_encode_mode mode,
+    const hf_priority_option& priority_option) {
+  if (m_response_decodings.count(stream_id) > 0 &&
+      has_header(header_block, "accept-encoding") == false) {
+    // The value is an entry of the static table; sending it without
+    // indexing keeps it out of the dynamic tables of both endpoints.
+    auto advertised_block = header_block;
+    advertised_block.emplace_back(
+        header_prefix_pattern::WITHOUT_INDEXING,
+        header_t{"accept-encoding", body::ACCEPT_ENCODING});
+    send_headers(flags, stream_id, advertised_block, mode, priority_option);
+    return;
+  }
+
+  header_block_t emitted_block{};
+  const auto encoded_block = encode_header_block(
+      header_block, mode, m_request_dynamic_table, &emitted_block);
+  send_encoded_headers(flags, stream_id, encoded_block, emitted_block,
+                       priority_option);
+  return;
+}
+
+void http2_client::impl::send_headers(
+    const fh_flags_t flags, const fh_stream_id_t stream_id,
+    header_block_template* header_template,
+    const std::vector<header_value_t>& values,
+    const hf_priority_option& priority_option) {
+  if (m_response_decodings.count(stream_id) > 0 &&
+      has_header(header_template->get_header_block(), "accept-encoding") ==
+          false) {
+    send_headers(flags, stream_id, header_template->make_header_block(values),
+                 header_template->get_mode(), priority_option);
+    return;
+  }
+
+  header_block_t emitted_block{};
+  const auto encoded_block =
+      header_template->encode(values, m_request_dynamic_table, &emitted_block);
+  send_encoded_headers(flags, stream_id, encoded_block, emitted_block,
+                       priority_option);
+  return;
+}
+
+void http2_client::impl::send_encoded_headers(
+    const fh_flags_t flags, const fh_stream_id_t stream_id,
+    const byte_array_t& encoded_block, const header_block_t& emitted_block,
+    const hf_priority_option& priority_option) {
+  const auto frames = fragment_header_block(
+      flags, stream_id, encoded_block, emitted_block,
+      m_settings.get_remote().get(sf_parameter::SETTINGS_MAX_FRAME_SIZE),
+      priority_option);
+
+  // Only the HEADERS frame can be refused; the CONTINUATION frames follow it
+  // without any frame in between.
+  // cf. https://tools.ietf.org/html/rfc7540#section-6.10
+  for (const auto& frame_ptr : frames) {
+    send_control_frame(*frame_ptr);
+  }
+  update_request_dynamic_table(emitted_block);
+  return;
+}
+
+void http2_client::impl::send_body(
+    const fh_stream_id_t stream_id,
+    std::unique_ptr<body::i_body_source> source) {
+  m_pending_bodies.push_back({stream_id, std::move(source)});
+  flush_bodies();
+  return;
+}
+
+size_t http2_client::impl::get_pending_body_count() const {
+  return m_pending_bodies.size();
+}
+
+size_t http2_client::impl::get_active_stream_count() const {
+  return m_stream_tracker.get_active_stream_count();
+}
+
+void http2_client::impl::decode_response_body(
+    const fh_stream_id_t stream_id, std::shared_ptr<body::i_body_sink> sink) {
+  m_response_decodings[stream_id] = {std::move(sink), nullptr, {}, false,
+                                     false};
+  return;
+}
+
+void http2_client::impl::enable_push_cache(
+    const stream::push_cache_options& options) {
+  m_push_cache.emplace(options);
+  return;
+}
+
+const stream::pushed_response* http2_client::impl::find_pushed_response(
+    const headers_t& request) {
+  return m_push_cache ? m_push_cache->find(request) : nullptr;
+}
+
+fh_stream_id_t http2_client::impl::get_promised_stream(
+    const headers_t& request) const {
+  return m_push_cache ? m_push_cache->get_promised_stream(request) : 0u;
+}
+
+stream::push_cache_status http2_client::impl::get_push_cache_status() const {
+  return m_push_cache ? m_push_cache->get_status()
+                      : stream::push_cache_status{};
+}
+
 void http2_client::impl::update_request_dynamic_table(
     const header_block_t& header_block) {
-  update_dynamic_table(header_block, &m_request_dynamic_table);
+  m_metrics.on_hpack_evictions(
+      update_dynamic_table(header_block, &m_request_dynamic_table));
+  on_table_updated(trace::table_kind::REQUEST, m_request_dynamic_table,
+                   &m_request_table_revision);
   return;
 }
 
 void http2_client::impl::update_request_dynamic_table(const size_t max_size) {
   m_request_dynamic_table.update_table_size(max_size);
+  on_table_updated(trace::table_kind::REQUEST, m_request_dynamic_table,
+                   &m_request_table_revision);
   return;
 }
 
@@ -160,17 +644,697 @@ const dynamic_table& http2_client::impl::get_request_dynamic_table() {
   return m_request_dynamic_table;
 }
 
+ssl::ktls_status http2_client::impl::get_ktls_status() const {
+  return m_ssl_connection != nullptr ? m_ssl_connection->get_ktls_status()
+                                     : ssl::ktls_status{};
+}
+
+ssl::early_data_status http2_client::impl::get_early_data_status() const {
+  return m_ssl_connection != nullptr
+             ? m_ssl_connection->get_early_data_status()
+             : ssl::early_data_status::NOT_SENT;
+}
+
+void http2_client::impl::enable_window_autotuning(
+    const flow_control::autotuning_options& options) {
+  m_bdp_estimator.emplace(options.m_initial_stream_window, options.m_max_window,
+                          options.m_sample_interval);
+  m_receive_window.emplace(options.m_initial_stream_window);
+  return;
+}
+
+flow_control::autotuning_status
+http2_client::impl::get_window_autotuning_status() const {
+  if (m_receive_window.has_value() == false) {
+    return {};
+  }
+
+  return {m_bdp_estimator->get_smoothed_rtt(), m_bdp_estimator->get_bdp(),
+          m_bdp_estimator->get_bandwidth(),
+          m_receive_window->get_connection_window(),
+          m_receive_window->get_stream_window()};
+}
+
+void http2_client::impl::check_frame(
+    const i_frame<frame_header>& frame) const {
+  const auto fh = frame.get_header();
+  const auto& remote = m_settings.get_remote();
+  if (fh.m_length > remote.get(sf_parameter::SETTINGS_MAX_FRAME_SIZE)) {
+    throw std::invalid_argument(
+        "frame larger than SETTINGS_MAX_FRAME_SIZE of the peer: length=" +
+        std::to_string(fh.m_length));
+  }
+
+  switch (cast_to_frame_type_registry(fh.m_type)) {
+    case frame_type_registry::DATA:
+      // cf. https://tools.ietf.org/html/rfc7540#section-6.9.1
+      if (fh.m_length > m_send_window.get_available(fh.m_stream_id)) {
+        throw std::invalid_argument(
+            "DATA exceeds the flow-control window: stream=" +
+            std::to_string(fh.m_stream_id));
+      }
+      break;
+    case frame_type_registry::HEADERS: {
+      const auto is_new_stream = m_stream_tracker.get_state(fh.m_stream_id) ==
+                                 stream::stream_state::IDLE;
+      // cf. https://tools.ietf.org/html/rfc7540#section-6.8
+      if (is_new_stream && m_goaway.has_value()) {
+        throw std::invalid_argument(
+            "connection is draining after GOAWAY: stream=" +
+            std::to_string(fh.m_stream_id));
+      }
+      // cf. https://tools.ietf.org/html/rfc7540#section-5.1.2
+      if (is_new_stream &&
+          m_stream_tracker.get_active_stream_count() >=
+              remote.get(sf_parameter::SETTINGS_MAX_CONCURRENT_STREAM)) {
+        throw std::invalid_argument(
+            "SETTINGS_MAX_CONCURRENT_STREAMS of the peer reached: stream=" +
+            std::to_string(fh.m_stream_id));
+      }
+
+      // cf. https://tools.ietf.org/html/rfc7540#section-6.5.2
+      const auto max_header_list_size =
+          remote.get(sf_parameter::SETTINGS_MAX_HEADER_LIST_SIZE);
+      if (max_header_list_size == settings::UNLIMITED) {
+        break;
+      }
+      uint64_t header_list_size{};
+      for (const auto& entry : get_header_block(frame)) {
+        if (entry.get_prefix() != header_prefix_pattern::SIZE_UPDATE) {
+          header_list_size += entry.get_header().first.length() +
+                              entry.get_header().second.length() + 32u;
+        }
+      }
+      if (header_list_size > max_header_list_size) {
+        throw std::invalid_argument(
+            "header list larger than SETTINGS_MAX_HEADER_LIST_SIZE of the "
+            "peer: size=" +
+            std::to_string(header_list_size));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+
+  return;
+}
+
+void http2_client::impl::end_early_data_unless_replayable(
+    const i_frame<frame_header>& frame) {
+  if (m_ssl_connection != nullptr &&
+      m_ssl_connection->get_early_data_status() ==
+          ssl::early_data_status::PENDING &&
+      is_replayable(frame) == false) {
+    m_ssl_connection->complete_handshake();
+  }
+  return;
+}
+
+void http2_client::impl::on_frame_sent(const i_frame<frame_header>& frame,
+                                       const uint8_t* raw_header,
+                                       const uint8_t* raw_payload) {
+  record_header_block(frame, raw_payload);
+  record_sent_frame(frame.get_header(), raw_header, raw_payload);
+  apply_sent_frame(frame);
+  return;
+}
+
+void http2_client::impl::apply_sent_frame(const i_frame<frame_header>& frame) {
+  const auto fh = frame.get_header();
+  switch (cast_to_frame_type_registry(fh.m_type)) {
+    case frame_type_registry::DATA:
+      m_send_window.consume(fh.m_stream_id, fh.m_length);
+      break;
+    case frame_type_registry::SETTINGS:
+      if (is_flag_set(fh.m_flags, sf_flag::ACK) == false) {
+        m_settings.on_local_settings(
+            dynamic_cast<const settings_frame&>(frame).get_payload());
+      }
+      break;
+    case frame_type_registry::HEADERS:
+      if (is_flag_set(fh.m_flags, hf_flag::PRIORITY)) {
+        const auto option =
+            dynamic_cast<const headers_frame&>(frame).get_priority_option();
+        m_scheduler.set_priority(fh.m_stream_id,
+                                 {option.m_exclusive,
+                                  option.m_stream_dependency,
+                                  option.m_weight});
+      }
+      break;
+    case frame_type_registry::PRIORITY:
+      m_scheduler.set_priority(
+          fh.m_stream_id,
+          dynamic_cast<const priority_frame&>(frame).get_payload());
+      break;
+    default:
+      break;
+  }
+
+  on_stream_transitions(
+      m_stream_tracker.on_frame(frame, stream::frame_origin::LOCAL));
+  m_latency_tracker.on_frame(fh, stream::frame_origin::LOCAL,
+                             std::chrono::steady_clock::now());
+  return;
+}
+
+void http2_client::impl::record_sent_frame(const frame_header& fh,
+                                           const uint8_t* raw_header,
+                                           const uint8_t* raw_payload) {
+  m_metrics.on_frame_sent(fh);
+  if (m_capture_writer) {
+    m_capture_writer->write(trace::now(), trace::capture_direction::SENT,
+                            raw_header, raw_payload, fh.m_length);
+  }
+
+  MH2C_TRACE(m_trace_observer, on_frame_sent(trace::now(), fh));
+  return;
+}
+
+const metrics::connection_metrics& http2_client::impl::get_metrics() const {
+  return m_metrics;
+}
+
+const settings::connection_settings& http2_client::impl::get_settings() const {
+  return m_settings;
+}
+
+size_t http2_client::impl::get_send_window(
+    const fh_stream_id_t stream_id) const {
+  return m_send_window.get_available(stream_id);
+}
+
+void http2_client::impl::set_trace_observer(
+    std::shared_ptr<trace::i_trace_observer> observer) {
+  m_trace_observer = std::move(observer);
+  return;
+}
+
+stream::stream_state http2_client::impl::get_stream_state(
+    const fh_stream_id_t stream_id) const {
+  return m_stream_tracker.get_state(stream_id);
+}
+
+void http2_client::impl::mark_stream_queued(const fh_stream_id_t stream_id) {
+  m_latency_tracker.on_queued(stream_id, std::chrono::steady_clock::now());
+  return;
+}
+
+const stream::latency_breakdown& http2_client::impl::get_latency_breakdown()
+    const {
+  return m_latency_tracker.get_breakdown();
+}
+
+void http2_client::impl::start_capture(const std::string& path) {
+  m_capture_writer = std::make_unique<trace::frame_capture_writer>(path);
+  return;
+}
+
+void http2_client::impl::stop_capture() {
+  m_capture_writer.reset();
+  return;
+}
+
+void http2_client::impl::send_control_frame(
+    const i_frame<frame_header>& frame) {
+  check_frame(frame);
+  end_early_data_unless_replayable(frame);
+  const auto raw_frame = frame.serialize();
+  send_raw_data(raw_frame.data(), raw_frame.size());
+  on_frame_sent(frame, raw_frame.data(),
+                raw_frame.data() + FRAME_HEADER_BYTES);
+  return;
+}
+
+// The answers to the peer, e.g. SETTINGS ACK and WINDOW_UPDATE, are held back
+// rather than written one small record each: they go out with the next frame
+// sent, or once receive_frame() or wait_readable() finds nothing more to read,
+// and before receive_frame() reads on past the bounds of
+// must_flush_control_frames().
+void http2_client::impl::queue_control_frame(
+    const i_frame<frame_header>& frame) {
+  check_frame(frame);
+  end_early_data_unless_replayable(frame);
+  const auto raw_frame = frame.serialize();
+  if (m_control_frames.empty()) {
+    m_control_frames_since = std::chrono::steady_clock::now();
+  }
+  if (cast_to_frame_type_registry(frame.get_header().m_type) ==
+      frame_type_registry::WINDOW_UPDATE) {
+    m_window_update_held = true;
+  }
+  m_control_frames.insert(m_control_frames.end(), raw_frame.begin(),
+                          raw_frame.end());
+  // Recorded once written, see record_control_frames()
+  apply_sent_frame(frame);
+  return;
+}
+
+void http2_client::impl::write_after_control_frames(const iovec* vectors,
+                                                    const size_t count) {
+  if (m_control_frames.empty()) {
+    m_transport->writev(vectors, count);
+    return;
+  }
+  // The callers write a frame of at most two buffers.
+  std::array<iovec, 3u> joined_vectors{};
+  joined_vectors[0] = {m_control_frames.data(), m_control_frames.size()};
+  std::copy(vectors, vectors + count, joined_vectors.begin() + 1);
+  m_transport->writev(joined_vectors.data(), count + 1u);
+  record_control_frames();
+  m_control_frames.clear();
+  m_window_update_held = false;
+  return;
+}
+
+void http2_client::impl::record_control_frames() {
+  const auto now = flow_control::bdp_estimator::clock_type::now();
+  for (size_t offset = 0; offset < m_control_frames.size();) {
+    const auto raw_header = m_control_frames.data() + offset;
+    const auto raw_payload = raw_header + FRAME_HEADER_BYTES;
+    const auto fh = build_frame_header(
+        byte_array_t(raw_header, raw_header + FRAME_HEADER_BYTES));
+    record_sent_frame(fh, raw_header, raw_payload);
+    // Holding it back would otherwise count in the RTT.
+    if (m_bdp_ping_held &&
+        cast_to_frame_type_registry(fh.m_type) == frame_type_registry::PING &&
+        is_flag_set(fh.m_flags, pf_flag::ACK) == false &&
+        std::equal(BDP_PING_OPAQUE_DATA.begin(), BDP_PING_OPAQUE_DATA.end(),
+                   raw_payload, raw_payload + fh.m_length)) {
+      m_bdp_estimator->on_ping_sent(now);
+      m_bdp_ping_held = false;
+    }
+    offset += FRAME_HEADER_BYTES + fh.m_length;
+  }
+  return;
+}
+
+// A peer that sends DATA without a pause would otherwise drain its send
+// window before seeing WINDOW_UPDATE.
+bool http2_client::impl::must_flush_control_frames() const {
+  return m_window_update_held ||
+         m_control_frames.size() >= MAX_HELD_CONTROL_BYTES ||
+         std::chrono::steady_clock::now() - m_control_frames_since >=
+             MAX_CONTROL_FRAME_HOLD;
+}
+
+void http2_client::impl::apply_peer_frame(const h2_frame_ptr& frame_ptr) {
+  const auto fh = frame_ptr->get_header();
+  switch (cast_to_frame_type_registry(fh.m_type)) {
+    case frame_type_registry::SETTINGS:
+      // cf. https://tools.ietf.org/html/rfc7540#section-6.5.3
+      if (is_flag_set(fh.m_flags, sf_flag::ACK)) {
+        m_settings.on_local_ack();
+        break;
+      }
+      m_settings.on_remote_settings(
+          dynamic_cast<const settings_frame*>(frame_ptr.get())->get_payload());
+      m_send_window.set_initial_stream_window(m_settings.get_remote().get(
+          sf_parameter::SETTINGS_INITIAL_WINDOW_SIZE));
+      queue_control_frame(
+          settings_frame{make_frame_header_flags(sf_flag::ACK), 0u, {}});
+      break;
+    case frame_type_registry::PING:
+      // cf. https://tools.ietf.org/html/rfc7540#section-6.7
+      if (is_flag_set(fh.m_flags, pf_flag::ACK) == false) {
+        queue_control_frame(ping_frame{
+            make_frame_header_flags(pf_flag::ACK),
+            dynamic_cast<const ping_frame*>(frame_ptr.get())->get_payload()});
+      }
+      break;
+    case frame_type_registry::WINDOW_UPDATE:
+      m_send_window.on_window_update(
+          fh.m_stream_id,
+          dynamic_cast<const window_update_frame*>(frame_ptr.get())
+              ->get_payload());
+      break;
+    case frame_type_registry::GOAWAY: {
+      m_goaway =
+          dynamic_cast<const goaway_frame*>(frame_ptr.get())->get_payload();
+      const auto transitions =
+          m_stream_tracker.on_goaway(m_goaway->m_last_stream_id, true);
+      for (const auto& transition : transitions) {
+        m_unprocessed_streams.push_back(transition.m_stream_id);
+        m_latency_tracker.drop_stream(transition.m_stream_id);
+      }
+      on_stream_transitions(transitions);
+      break;
+    }
+    default:
+      break;
+  }
+
+  return;
+}
+
+void http2_client::impl::flush_bodies() {
+  const size_t max_frame_size{
+      m_settings.get_remote().get(sf_parameter::SETTINGS_MAX_FRAME_SIZE)};
+  auto ite = m_pending_bodies.begin();
+  while (ite != m_pending_bodies.end()) {
+    const auto stream_id = ite->m_stream_id;
+    // Reset by either side
+    if (m_stream_tracker.get_state(stream_id) == stream::stream_state::CLOSED) {
+      ite = m_pending_bodies.erase(ite);
+      continue;
+    }
+
+    const auto available = m_send_window.get_available(stream_id);
+    // What is left may be empty, which needs no window.
+    if (available == 0) {
+      const auto chunk = ite->m_source->next(0u);
+      if (chunk.m_last) {
+        m_scheduler.set_ready(stream_id, false);
+        send_body_chunk(stream_id, chunk);
+        ite = m_pending_bodies.erase(ite);
+        continue;
+      }
+    }
+    m_scheduler.set_ready(stream_id, available > 0);
+    ++ite;
+  }
+
+  // One frame at a time, so that concurrent bodies interleave by priority
+  for (auto stream_id = m_scheduler.select(); stream_id != 0;
+       stream_id = m_scheduler.select()) {
+    const auto body = std::find_if(
+        m_pending_bodies.begin(), m_pending_bodies.end(),
+        [stream_id](const pending_body& pending) {
+          return pending.m_stream_id == stream_id;
+        });
+    const auto chunk = body->m_source->next(
+        std::min(max_frame_size, m_send_window.get_available(stream_id)));
+    // The last frame may close the stream, which leaves the tree.
+    m_scheduler.on_sent(stream_id, chunk.m_length);
+    if (chunk.m_last) {
+      m_scheduler.set_ready(stream_id, false);
+    }
+    if (chunk.m_length > 0 || chunk.m_last) {
+      send_body_chunk(stream_id, chunk);
+    }
+
+    if (chunk.m_last) {
+      m_pending_bodies.erase(body);
+    } else if (chunk.m_length == 0 ||
+               m_send_window.get_available(stream_id) == 0) {
+      m_scheduler.set_ready(stream_id, false);
+    }
+  }
+
+  return;
+}
+
+void http2_client::impl::send_body_chunk(const fh_stream_id_t stream_id,
+                                         const body::body_chunk& chunk) {
+  const fh_flags_t flags =
+      chunk.m_last ? make_frame_header_flags(df_flag::END_STREAM) : 0u;
+  const frame_header fh{cast_to_fh_length(chunk.m_length),
+                        underlying_cast(frame_type_registry::DATA), flags, 0,
+                        stream_id};
+  const data_chunk_frame frame{fh, chunk.m_data};
+  check_frame(frame);
+  end_early_data_unless_replayable(frame);
+
+  const auto raw_header = serialize(fh);
+  if (chunk.m_data == nullptr && chunk.m_length > 0) {
+    const iovec vectors[]{
+        {const_cast<uint8_t*>(raw_header.data()), raw_header.size()},
+    };
+    write_after_control_frames(vectors, sizeof(vectors) / sizeof(vectors[0]));
+    const auto offset = static_cast<off_t>(chunk.m_file_offset);
+    m_transport->sendfile(chunk.m_fd, offset, chunk.m_length);
+    // Only a capture needs the payload in memory.
+    const auto payload =
+        m_capture_writer
+            ? transport::read_file(chunk.m_fd, offset, chunk.m_length)
+            : byte_array_t{};
+    on_frame_sent(data_chunk_frame{fh, payload.data()}, raw_header.data(),
+                  payload.data());
+    return;
+  }
+
+  const iovec vectors[]{
+      {const_cast<uint8_t*>(raw_header.data()), raw_header.size()},
+      {const_cast<uint8_t*>(chunk.m_data), chunk.m_length},
+  };
+  write_after_control_frames(vectors, sizeof(vectors) / sizeof(vectors[0]));
+  on_frame_sent(frame, raw_header.data(), chunk.m_data);
+  return;
+}
+
+std::optional<decoding_failure> http2_client::impl::decode_response_frame(
+    const i_frame<frame_header>& frame, const byte_array_t& raw_payload) {
+  const auto fh = frame.get_header();
+  const auto ite = m_response_decodings.find(fh.m_stream_id);
+  if (ite == m_response_decodings.end()) {
+    return std::nullopt;
+  }
+
+  auto& decoding = ite->second;
+  const auto type = cast_to_frame_type_registry(fh.m_type);
+  try {
+    switch (type) {
+      case frame_type_registry::HEADERS:
+        decoding.m_end_stream = is_flag_set(fh.m_flags, hf_flag::END_STREAM);
+        // Trailers follow the body.
+        if (decoding.m_decoder) {
+          break;
+        }
+        decoding.m_headers.clear();
+        append_headers(get_header_block(frame), &decoding.m_headers);
+        decoding.m_headers_continued =
+            is_flag_set(fh.m_flags, hf_flag::END_HEADERS) == false;
+        break;
+      // cf. https://tools.ietf.org/html/rfc7540#section-6.10
+      case frame_type_registry::CONTINUATION:
+        if (decoding.m_headers_continued == false) {
+          return std::nullopt;
+        }
+        append_headers(get_header_block(frame), &decoding.m_headers);
+        decoding.m_headers_continued =
+            is_flag_set(fh.m_flags, cf_flag::END_HEADERS) == false;
+        break;
+      case frame_type_registry::DATA:
+        if (decoding.m_decoder) {
+          size_t offset{0};
+          size_t length{raw_payload.size()};
+          if (is_flag_set(fh.m_flags, df_flag::PADDED)) {
+            offset = 1u;
+            length -= 1u + get_pad_length(raw_payload);
+          }
+          decoding.m_decoder->decode(raw_payload.data() + offset, length);
+        }
+        break;
+      default:
+        return std::nullopt;
+    }
+
+    if (decoding.m_headers_continued) {
+      return std::nullopt;
+    }
+    if (type != frame_type_registry::DATA && decoding.m_decoder == nullptr) {
+      const auto status = find_value(decoding.m_headers, ":status");
+      // An informational response precedes the final one.
+      // cf. https://tools.ietf.org/html/rfc7540#section-8.1
+      if (status.empty() == false && status.front() == '1') {
+        return std::nullopt;
+      }
+      decoding.m_decoder = std::make_unique<body::content_decoder>(
+          body::parse_content_coding(
+              find_value(decoding.m_headers, "content-encoding")),
+          decoding.m_sink);
+      decoding.m_headers.clear();
+    }
+
+    // The END_STREAM of HEADERS applies once its CONTINUATION frames end.
+    const auto end_stream = type == frame_type_registry::DATA
+                                ? is_flag_set(fh.m_flags, df_flag::END_STREAM)
+                                : decoding.m_end_stream;
+    if (end_stream && decoding.m_decoder) {
+      decoding.m_decoder->finish();
+      m_response_decodings.erase(ite);
+    }
+  } catch (const connection_error&) {
+    throw;
+  } catch (const std::exception& e) {
+    decoding_failure failure{std::move(ite->second.m_sink),
+                             "cannot decode the body of stream " +
+                                 std::to_string(fh.m_stream_id) + ": " +
+                                 e.what()};
+    m_response_decodings.erase(ite);
+    return failure;
+  }
+
+  return std::nullopt;
+}
+
+void http2_client::impl::fail_response_decoding(
+    const fh_stream_id_t stream_id, const decoding_failure& failure) {
+  // The rest of the body is of no use; a response that has ended leaves
+  // nothing to cancel.
+  // cf. https://tools.ietf.org/html/rfc7540#section-8.1
+  if (m_stream_tracker.get_state(stream_id) != stream::stream_state::CLOSED) {
+    queue_control_frame(rst_stream_frame{stream_id, error_codes::CANCEL});
+  }
+  failure.m_sink->on_error(failure.m_what);
+  return;
+}
+
+void http2_client::impl::record_header_block(
+    const i_frame<frame_header>& frame, const uint8_t* raw_payload) {
+  const auto fh = frame.get_header();
+  switch (cast_to_frame_type_registry(fh.m_type)) {
+    case frame_type_registry::HEADERS:
+    case frame_type_registry::PUSH_PROMISE:
+    case frame_type_registry::CONTINUATION: {
+      const auto stats = metrics::inspect_header_block(
+          fh, raw_payload, get_header_block(frame));
+      m_metrics.on_hpack_block(stats.m_static_hits, stats.m_dynamic_hits,
+                               stats.m_literals, stats.m_huffman_bytes_saved);
+      break;
+    }
+    default:
+      break;
+  }
+
+  return;
+}
+
+void http2_client::impl::on_stream_transitions(
+    const std::vector<stream::stream_transition>& transitions) {
+  for (const auto& transition : transitions) {
+    if (transition.m_to == stream::stream_state::CLOSED) {
+      m_send_window.close_stream(transition.m_stream_id);
+      m_scheduler.remove_stream(transition.m_stream_id);
+      m_response_decodings.erase(transition.m_stream_id);
+    }
+    MH2C_TRACE(m_trace_observer,
+               on_stream_state_changed(trace::now(), transition));
+  }
+  return;
+}
+
+void http2_client::impl::on_table_updated(const trace::table_kind kind,
+                                          const dynamic_table& table,
+                                          uint64_t* last_revision) {
+  if (table.get_revision() == *last_revision) {
+    return;
+  }
+
+  *last_revision = table.get_revision();
+  MH2C_TRACE(m_trace_observer, on_table_changed(trace::now(), kind, table));
+  return;
+}
+
+void http2_client::impl::autotune_windows(const h2_frame_ptr& frame_ptr) {
+  const auto fh = frame_ptr->get_header();
+  const auto now = flow_control::bdp_estimator::clock_type::now();
+
+  switch (cast_to_frame_type_registry(fh.m_type)) {
+    case frame_type_registry::DATA: {
+      // Padding counts against the windows as well.
+      const auto end_stream = is_flag_set(fh.m_flags, df_flag::END_STREAM);
+      const auto stall_count = m_receive_window->get_stall_count();
+      const auto updates =
+          m_receive_window->consume(fh.m_stream_id, fh.m_length, end_stream);
+      m_metrics.on_flow_control_stalls(m_receive_window->get_stall_count() -
+                                       stall_count);
+      for (const auto& [stream_id, increment] : updates) {
+        queue_control_frame(window_update_frame{stream_id, increment});
+      }
+
+      if (m_bdp_estimator->on_data_received(fh.m_length, now) &&
+          m_bdp_ping_held == false) {
+        queue_control_frame(ping_frame{0u, BDP_PING_OPAQUE_DATA});
+        m_bdp_ping_held = true;
+      }
+      break;
+    }
+    case frame_type_registry::HEADERS:
+      if (is_flag_set(fh.m_flags, hf_flag::END_STREAM)) {
+        m_receive_window->close_stream(fh.m_stream_id);
+      }
+      break;
+    case frame_type_registry::RST_STREAM:
+      m_receive_window->close_stream(fh.m_stream_id);
+      break;
+    case frame_type_registry::PING: {
+      const auto opaque_data =
+          dynamic_cast<const ping_frame*>(frame_ptr.get())->get_payload();
+      if (is_flag_set(fh.m_flags, pf_flag::ACK) == false ||
+          opaque_data != BDP_PING_OPAQUE_DATA ||
+          m_bdp_estimator->on_ping_ack(now) == false) {
+        break;
+      }
+
+      const auto new_window = m_bdp_estimator->get_window();
+      const auto connection_increment =
+          m_receive_window->resize_connection_window(new_window);
+      if (connection_increment > 0) {
+        queue_control_frame(window_update_frame{0u, connection_increment});
+      }
+      if (m_receive_window->resize_stream_window(new_window) > 0) {
+        queue_control_frame(settings_frame{
+            0u, 0u,
+            make_sf_payload(
+                {{sf_parameter::SETTINGS_INITIAL_WINDOW_SIZE, new_window}})});
+      }
+      break;
+    }
+    default:
+      break;
+  }
+
+  return;
+}
+
 http2_client::http2_client(const std::string& hostname, const uint16_t port,
-                           const ssl::verify_mode mode)
-    : m_pimpl(std::make_unique<http2_client::impl>(hostname, port, mode)) {}
+                           const ssl::verify_mode mode,
+                           const ssl::ktls_mode ktls,
+                           const net::connect_options& options)
+    : m_pimpl(std::make_unique<http2_client::impl>(hostname, port, mode, ktls,
+                                                   options)) {}
+
+http2_client::http2_client(std::unique_ptr<transport::i_transport> transport,
+                           const net::connect_options& options)
+    : m_pimpl(std::make_unique<http2_client::impl>(std::move(transport),
+                                                   options)) {}
 
 http2_client::~http2_client() = default;
 
+std::future<std::unique_ptr<http2_client>> http2_client::async_connect(
+    const std::string& hostname, const uint16_t port,
+    const ssl::verify_mode mode, const sf_payload_t& settings,
+    const ssl::ktls_mode ktls, const net::connect_options& options) {
+  // Unlike that of std::async, a future of a promise does not wait for the
+  // worker when destroyed, so a caller may drop it.
+  using client_promise = std::promise<std::unique_ptr<http2_client>>;
+  auto promise = std::make_shared<client_promise>();
+  auto future = promise->get_future();
+  std::thread{[=]() {
+    try {
+      auto client =
+          std::make_unique<http2_client>(hostname, port, mode, ktls, options);
+      client->exchange_settings(settings);
+      promise->set_value(std::move(client));
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+    }
+  }}.detach();
+  return future;
+}
+
 void http2_client::send_raw_data(const uint8_t* data, const size_t length) {
   m_pimpl->send_raw_data(data, length);
   return;
 }
 
+void http2_client::send_raw_file(const int fd, const off_t offset,
+                                 const size_t length) {
+  m_pimpl->send_raw_file(fd, offset, length);
+  return;
+}
+
 void http2_client::receive_raw_data(uint8_t* data, const size_t length) {
   m_pimpl->receive_raw_data(data, length);
   return;
@@ -181,8 +1345,88 @@ void http2_client::send_connection_preface() {
   return;
 }
 
+h2_frame_ptr http2_client::exchange_settings(const sf_payload_t& settings) {
+  return m_pimpl->exchange_settings(settings);
+}
+
 h2_frame_ptr http2_client::receive_frame() { return m_pimpl->receive_frame(); }
 
+bool http2_client::wait_readable(const std::chrono::milliseconds timeout,
+                                 const int wake_fd) {
+  return m_pimpl->wait_readable(timeout, wake_fd);
+}
+
+void http2_client::flush_control_frames() {
+  m_pimpl->flush_control_frames();
+  return;
+}
+
+bool http2_client::is_draining() const { return m_pimpl->is_draining(); }
+
+std::vector<fh_stream_id_t> http2_client::take_unprocessed_streams() {
+  return m_pimpl->take_unprocessed_streams();
+}
+
+void http2_client::send_headers(const fh_flags_t flags,
+                                const fh_stream_id_t stream_id,
+                                const header_block_t& header_block,
+                                const header_encode_mode mode,
+                                const hf_priority_option& priority_option) {
+  m_pimpl->send_headers(flags, stream_id, header_block, mode,
+                        priority_option);
+  return;
+}
+
+void http2_client::send_headers(const fh_flags_t flags,
+                                const fh_stream_id_t stream_id,
+                                header_block_template* header_template,
+                                const std::vector<header_value_t>& values,
+                                const hf_priority_option& priority_option) {
+  m_pimpl->send_headers(flags, stream_id, header_template, values,
+                        priority_option);
+  return;
+}
+
+void http2_client::send_body(const fh_stream_id_t stream_id,
+                             std::unique_ptr<body::i_body_source> source) {
+  m_pimpl->send_body(stream_id, std::move(source));
+  return;
+}
+
+size_t http2_client::get_pending_body_count() const {
+  return m_pimpl->get_pending_body_count();
+}
+
+size_t http2_client::get_active_stream_count() const {
+  return m_pimpl->get_active_stream_count();
+}
+
+void http2_client::decode_response_body(
+    const fh_stream_id_t stream_id, std::shared_ptr<body::i_body_sink> sink) {
+  m_pimpl->decode_response_body(stream_id, std::move(sink));
+  return;
+}
+
+void http2_client::enable_push_cache(
+    const stream::push_cache_options& options) {
+  m_pimpl->enable_push_cache(options);
+  return;
+}
+
+const stream::pushed_response* http2_client::find_pushed_response(
+    const headers_t& request) {
+  return m_pimpl->find_pushed_response(request);
+}
+
+fh_stream_id_t http2_client::get_promised_stream(
+    const headers_t& request) const {
+  return m_pimpl->get_promised_stream(request);
+}
+
+stream::push_cache_status http2_client::get_push_cache_status() const {
+  return m_pimpl->get_push_cache_status();
+}
+
 void http2_client::update_request_dynamic_table(
     const header_block_t& header_block) {
   m_pimpl->update_request_dynamic_table(header_block);
@@ -198,6 +1442,85 @@ const dynamic_table& http2_client::get_request_dynamic_table() {
   return m_pimpl->get_request_dynamic_table();
 }
 
+ssl::ktls_status http2_client::get_ktls_status() const {
+  return m_pimpl->get_ktls_status();
+}
+
+ssl::early_data_status http2_client::get_early_data_status() const {
+  return m_pimpl->get_early_data_status();
+}
+
+void http2_client::enable_window_autotuning(
+    const flow_control::autotuning_options& options) {
+  m_pimpl->enable_window_autotuning(options);
+  return;
+}
+
+flow_control::autotuning_status http2_client::get_window_autotuning_status()
+    const {
+  return m_pimpl->get_window_autotuning_status();
+}
+
+const metrics::connection_metrics& http2_client::get_metrics() const {
+  return m_pimpl->get_metrics();
+}
+
+void http2_client::set_trace_observer(
+    std::shared_ptr<trace::i_trace_observer> observer) {
+  m_pimpl->set_trace_observer(std::move(observer));
+  return;
+}
+
+stream::stream_state http2_client::get_stream_state(
+    const fh_stream_id_t stream_id) const {
+  return m_pimpl->get_stream_state(stream_id);
+}
+
+void http2_client::mark_stream_queued(const fh_stream_id_t stream_id) {
+  m_pimpl->mark_stream_queued(stream_id);
+  return;
+}
+
+const stream::latency_breakdown& http2_client::get_latency_breakdown() const {
+  return m_pimpl->get_latency_breakdown();
+}
+
+void http2_client::start_capture(const std::string& path) {
+  m_pimpl->start_capture(path);
+  return;
+}
+
+void http2_client::stop_capture() {
+  m_pimpl->stop_capture();
+  return;
+}
+
+const settings::connection_settings& http2_client::get_settings() const {
+  return m_pimpl->get_settings();
+}
+
+size_t http2_client::get_send_window(const fh_stream_id_t stream_id) const {
+  return m_pimpl->get_send_window(stream_id);
+}
+
+void http2_client::check_frame(const i_frame<frame_header>& frame) const {
+  m_pimpl->check_frame(frame);
+  return;
+}
+
+void http2_client::end_early_data_unless_replayable(
+    const i_frame<frame_header>& frame) {
+  m_pimpl->end_early_data_unless_replayable(frame);
+  return;
+}
+
+void http2_client::on_frame_sent(const i_frame<frame_header>& frame,
+                                 const uint8_t* raw_header,
+                                 const uint8_t* raw_payload) {
+  m_pimpl->on_frame_sent(frame, raw_header, raw_payload);
+  return;
+}
+
 std::ostream& operator<<(std::ostream& out_stream, const h2_frame_ptr& frame) {
   frame->dump(out_stream);
   return out_stream;
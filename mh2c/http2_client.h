@@ -4,38 +4,209 @@
 #ifndef MH2C_HTTP2_CLIENT_H_
 #define MH2C_HTTP2_CLIENT_H_
 
+#include <sys/types.h>
+
+#include <chrono>
 #include <cstdint>
+#include <future>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <vector>
 
+#include "mh2c/body/body_source.h"
+#include "mh2c/body/content_decoder.h"
 #include "mh2c/common/byte_array.h"
+#include "mh2c/flow_control/window_autotuning.h"
 #include "mh2c/frame/common_type.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/i_frame.h"
+#include "mh2c/frame/settings_frame.h"
 #include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_block_template.h"
 #include "mh2c/hpack/header_type.h"
+#include "mh2c/metrics/connection_metrics.h"
+#include "mh2c/net/connect_options.h"
+#include "mh2c/settings/connection_settings.h"
+#include "mh2c/ssl/ssl_ktls_mode.h"
+#include "mh2c/ssl/ssl_session_cache.h"
 #include "mh2c/ssl/ssl_verify_mode.h"
+#include "mh2c/stream/latency_breakdown.h"
+#include "mh2c/stream/push_cache.h"
+#include "mh2c/stream/stream_state.h"
+#include "mh2c/trace/trace_observer.h"
+#include "mh2c/transport/i_transport.h"
 
 namespace mh2c {
 
 class http2_client {
  public:
   http2_client(const std::string& hostname, const uint16_t port,
-               const ssl::verify_mode mode);
+               const ssl::verify_mode mode,
+               const ssl::ktls_mode ktls = ssl::ktls_mode::DISABLED,
+               const net::connect_options& options = {});
+  // Speaks HTTP/2 over an already established transport, e.g. h2c or an
+  // in-process pipe.
+  explicit http2_client(std::unique_ptr<transport::i_transport> transport,
+                        const net::connect_options& options = {});
   ~http2_client();
 
+  // Connects, sends the connection preface and exchanges SETTINGS on a
+  // detached thread so that a slow peer never blocks the caller. Dropping the
+  // future does not wait for the thread, which ends within the deadlines of
+  // options and then closes the connection.
+  static std::future<std::unique_ptr<http2_client>> async_connect(
+      const std::string& hostname, const uint16_t port,
+      const ssl::verify_mode mode, const sf_payload_t& settings,
+      const ssl::ktls_mode ktls = ssl::ktls_mode::DISABLED,
+      const net::connect_options& options = {});
+
   void send_raw_data(const uint8_t* data, const size_t length);
+  void send_raw_file(const int fd, const off_t offset, const size_t length);
   void receive_raw_data(uint8_t* data, const size_t length);
 
   void send_connection_preface();
+  h2_frame_ptr exchange_settings(const sf_payload_t& settings);
+  // Throw std::invalid_argument, without sending anything, for a frame the
+  // SETTINGS or the flow-control windows of the peer do not allow.
   template <typename Frame>
   void send_frame(const Frame& frame);
+  // Encodes the header block once against the request dynamic table, sends
+  // it as HEADERS and as many CONTINUATION frames as SETTINGS_MAX_FRAME_SIZE
+  // of the peer requires, and then applies it to the table. Of flags, only
+  // END_STREAM and PRIORITY, which carries priority_option, are meaningful.
+  void send_headers(const fh_flags_t flags, const fh_stream_id_t stream_id,
+                    const header_block_t& header_block,
+                    const header_encode_mode mode,
+                    const hf_priority_option& priority_option = {});
+  // Same with the block of the template and the values of its variable
+  // fields; the constant fields are copied as the template last encoded them
+  // while the request dynamic table is unchanged.
+  void send_headers(const fh_flags_t flags, const fh_stream_id_t stream_id,
+                    header_block_template* header_template,
+                    const std::vector<header_value_t>& values,
+                    const hf_priority_option& priority_option = {});
+  // Sends the body of a stream whose HEADERS went out without END_STREAM as
+  // DATA frames of at most SETTINGS_MAX_FRAME_SIZE of the peer, written
+  // straight from the memory of the source. What the flow-control windows
+  // do not allow yet is sent by receive_frame() as WINDOW_UPDATE opens them.
+  // The last DATA frame carries END_STREAM. Concurrent bodies are interleaved
+  // frame by frame following the priorities sent in HEADERS and PRIORITY
+  // frames.
+  // cf. https://tools.ietf.org/html/rfc7540#section-5.3
+  void send_body(const fh_stream_id_t stream_id,
+                 std::unique_ptr<body::i_body_source> source);
+  // Bodies not completely sent yet
+  size_t get_pending_body_count() const;
+  // Streams open or half-closed, which count against
+  // SETTINGS_MAX_CONCURRENT_STREAMS of the peer
+  // cf. https://tools.ietf.org/html/rfc7540#section-5.1.2
+  size_t get_active_stream_count() const;
+  // Opts the response of the stream in to content decoding: send_headers()
+  // adds accept-encoding unless the request carries one, and receive_frame()
+  // inflates the DATA payloads into sink by the content-encoding of the
+  // response, which may come in a CONTINUATION frame, as they arrive, calling
+  // on_end() at END_STREAM. The frames are still returned. When the body
+  // cannot be decoded, receive_frame() resets the stream with CANCEL, unless
+  // it has ended, and calls on_error() of the sink instead; the connection
+  // goes on.
+  void decode_response_body(const fh_stream_id_t stream_id,
+                            std::shared_ptr<body::i_body_sink> sink);
+  // Keeps the responses the server pushes, see stream::push_cache, and has
+  // receive_frame() cancel the pushes it does not want with RST_STREAM.
+  // SETTINGS_ENABLE_PUSH must be left at 1 for the server to push.
+  void enable_push_cache(const stream::push_cache_options& options = {});
+  // Response pushed for the request, nullptr when there is none or the cache
+  // is not enabled. Valid until the next receive_frame().
+  const stream::pushed_response* find_pushed_response(
+      const headers_t& request);
+  // Promised stream still bringing the response for the request, 0 for none.
+  // Rather than sending the request, call receive_frame() until it closes.
+  fh_stream_id_t get_promised_stream(const headers_t& request) const;
+  stream::push_cache_status get_push_cache_status() const;
+  // Applies SETTINGS and WINDOW_UPDATE of the peer, and answers its SETTINGS
+  // with ACK and its PING with PING ACK. Throw connection_error when the peer
+  // breaks them. On GOAWAY, closes the streams the peer will not process, see
+  // take_unprocessed_streams().
+  // The answers, and the WINDOW_UPDATE and RST_STREAM frames sent from here,
+  // are held back and written together: ahead of the next frame sent, in the
+  // same write, or before the next receive_frame() or wait_readable() would
+  // wait for the peer. While frames keep arriving, receive_frame() writes
+  // them before reading on once WINDOW_UPDATE is among them, they reach 1 KiB
+  // or the first has waited 5 ms.
   h2_frame_ptr receive_frame();
+  // Returns false if nothing arrived for receive_frame() before the timeout,
+  // or as soon as wake_fd, when not -1, becomes readable.
+  bool wait_readable(const std::chrono::milliseconds timeout,
+                     const int wake_fd = -1);
+  // Writes the frames receive_frame() holds back now. They count in the
+  // metrics, the capture and the trace once written; destroying the client
+  // drops those still held back.
+  void flush_control_frames();
+  // The peer has sent GOAWAY: the streams it processes still complete, but
+  // send_headers() throws std::invalid_argument for a new stream.
+  bool is_draining() const;
+  // Streams above the last stream identifier of GOAWAY, already closed and
+  // safe to retry on another connection. Each is returned once.
+  // cf. https://tools.ietf.org/html/rfc7540#section-8.1.4
+  std::vector<fh_stream_id_t> take_unprocessed_streams();
 
   void update_request_dynamic_table(const header_block_t& header_block);
   void update_request_dynamic_table(const size_t max_size);
   const dynamic_table& get_request_dynamic_table();
 
+  ssl::ktls_status get_ktls_status() const;
+  // With net::connect_options::m_early_data on a resumed session, the frames
+  // sent before the first receive go out as TLS 1.3 early data as long as
+  // they are safe to replay: the preface, SETTINGS, and GET or HEAD requests
+  // without a body. Anything else, send_raw_file() or a receive completes
+  // the handshake first; frames the server rejected are sent again then.
+  // send_raw_data() is not checked.
+  ssl::early_data_status get_early_data_status() const;
+
+  // Replenishes the receive windows automatically and grows them, together
+  // with SETTINGS_INITIAL_WINDOW_SIZE, to the bandwidth-delay product measured
+  // with PING.
+  void enable_window_autotuning(
+      const flow_control::autotuning_options& options = {});
+  flow_control::autotuning_status get_window_autotuning_status() const;
+
+  // Counters of this connection, updated by send_frame() and receive_frame()
+  const metrics::connection_metrics& get_metrics() const;
+
+  // SETTINGS sent and received so far
+  const settings::connection_settings& get_settings() const;
+  // Bytes of DATA the stream may send before the peer opens the windows
+  size_t get_send_window(const fh_stream_id_t stream_id) const;
+
+  // Reports frames, HPACK table changes and stream state changes as they
+  // happen. Only effective when built with MH2C_ENABLE_TRACING, see
+  // trace::TRACING_ENABLED; pass nullptr to detach.
+  void set_trace_observer(std::shared_ptr<trace::i_trace_observer> observer);
+  // cf. https://tools.ietf.org/html/rfc7540#section-5.1
+  stream::stream_state get_stream_state(const fh_stream_id_t stream_id) const;
+
+  // Starts the queued phase of a request about to be sent. Without it the
+  // request is timed from its HEADERS being written.
+  void mark_stream_queued(const fh_stream_id_t stream_id);
+  // Phase histograms of the requests completed so far. Read it on the thread
+  // driving the connection; copies from several connections merge with +=.
+  const stream::latency_breakdown& get_latency_breakdown() const;
+
+  // Records every frame sent and received from now on to a capture file, see
+  // trace::frame_capture_writer. Start it before exchange_settings() to
+  // capture the whole connection; the file is complete once stop_capture()
+  // returns or the client is destroyed.
+  void start_capture(const std::string& path);
+  void stop_capture();
+
  private:
+  void check_frame(const i_frame<frame_header>& frame) const;
+  void end_early_data_unless_replayable(const i_frame<frame_header>& frame);
+  void on_frame_sent(const i_frame<frame_header>& frame,
+                     const uint8_t* raw_header, const uint8_t* raw_payload);
+
   class impl;
   std::unique_ptr<impl> m_pimpl;
 };
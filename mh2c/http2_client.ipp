@@ -8,8 +8,12 @@ namespace mh2c {
 
 template <typename Frame>
 void http2_client::send_frame(const Frame& frame) {
+  check_frame(frame);
+  end_early_data_unless_replayable(frame);
   const auto raw_frame = frame.serialize();
   send_raw_data(raw_frame.data(), raw_frame.size());
+  on_frame_sent(frame, raw_frame.data(),
+                raw_frame.data() + FRAME_HEADER_BYTES);
   return;
 }
 
@@ -0,0 +1,170 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/metrics/connection_metrics.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/metrics/latency_histogram.h"
+
+namespace mh2c {
+
+namespace metrics {
+
+namespace {
+
+constexpr auto RELAXED = std::memory_order_relaxed;
+
+size_t to_frame_type_slot(const fh_type_t type) {
+  return std::min<size_t>(type, FRAME_TYPE_SLOTS - 1u);
+}
+
+void store_min(std::atomic<uint64_t>* counter, const uint64_t value) {
+  auto current = counter->load(RELAXED);
+  while (value < current &&
+         !counter->compare_exchange_weak(current, value, RELAXED)) {
+  }
+  return;
+}
+
+void store_max(std::atomic<uint64_t>* counter, const uint64_t value) {
+  auto current = counter->load(RELAXED);
+  while (value > current &&
+         !counter->compare_exchange_weak(current, value, RELAXED)) {
+  }
+  return;
+}
+
+template <size_t N>
+std::array<uint64_t, N> load_all(
+    const std::array<std::atomic<uint64_t>, N>& counters) {
+  std::array<uint64_t, N> values{};
+  for (size_t i = 0; i < N; ++i) {
+    values[i] = counters[i].load(RELAXED);
+  }
+  return values;
+}
+
+template <size_t N>
+void add_all(std::array<uint64_t, N>* lhs, const std::array<uint64_t, N>& rhs) {
+  for (size_t i = 0; i < N; ++i) {
+    (*lhs)[i] += rhs[i];
+  }
+  return;
+}
+
+}  // namespace
+
+double metrics_snapshot::get_hpack_hit_rate() const {
+  const auto hits = m_hpack_static_hits + m_hpack_dynamic_hits;
+  const auto total = hits + m_hpack_literals;
+  return total == 0 ? 0.0 : static_cast<double>(hits) / total;
+}
+
+metrics_snapshot& metrics_snapshot::operator+=(const metrics_snapshot& other) {
+  add_all(&m_frames_sent, other.m_frames_sent);
+  add_all(&m_bytes_sent, other.m_bytes_sent);
+  add_all(&m_frames_received, other.m_frames_received);
+  add_all(&m_bytes_received, other.m_bytes_received);
+  m_hpack_static_hits += other.m_hpack_static_hits;
+  m_hpack_dynamic_hits += other.m_hpack_dynamic_hits;
+  m_hpack_literals += other.m_hpack_literals;
+  m_hpack_evictions += other.m_hpack_evictions;
+  m_huffman_bytes_saved += other.m_huffman_bytes_saved;
+  m_flow_control_stalls += other.m_flow_control_stalls;
+  m_decode_time += other.m_decode_time;
+  return *this;
+}
+
+connection_metrics::connection_metrics()
+    : m_frames_sent{},
+      m_bytes_sent{},
+      m_frames_received{},
+      m_bytes_received{},
+      m_hpack_static_hits{0u},
+      m_hpack_dynamic_hits{0u},
+      m_hpack_literals{0u},
+      m_hpack_evictions{0u},
+      m_huffman_bytes_saved{0u},
+      m_flow_control_stalls{0u},
+      m_decode_time_buckets{},
+      m_decode_time_sum_ns{0u},
+      m_decode_time_min_ns{std::numeric_limits<uint64_t>::max()},
+      m_decode_time_max_ns{0u} {}
+
+void connection_metrics::on_frame_sent(const frame_header& fh) {
+  const auto slot = to_frame_type_slot(fh.m_type);
+  m_frames_sent[slot].fetch_add(1u, RELAXED);
+  m_bytes_sent[slot].fetch_add(FRAME_HEADER_BYTES + fh.m_length, RELAXED);
+  return;
+}
+
+void connection_metrics::on_frame_received(const frame_header& fh) {
+  const auto slot = to_frame_type_slot(fh.m_type);
+  m_frames_received[slot].fetch_add(1u, RELAXED);
+  m_bytes_received[slot].fetch_add(FRAME_HEADER_BYTES + fh.m_length, RELAXED);
+  return;
+}
+
+void connection_metrics::on_hpack_block(const uint64_t static_hits,
+                                        const uint64_t dynamic_hits,
+                                        const uint64_t literals,
+                                        const uint64_t huffman_bytes_saved) {
+  m_hpack_static_hits.fetch_add(static_hits, RELAXED);
+  m_hpack_dynamic_hits.fetch_add(dynamic_hits, RELAXED);
+  m_hpack_literals.fetch_add(literals, RELAXED);
+  m_huffman_bytes_saved.fetch_add(huffman_bytes_saved, RELAXED);
+  return;
+}
+
+void connection_metrics::on_hpack_evictions(const uint64_t count) {
+  m_hpack_evictions.fetch_add(count, RELAXED);
+  return;
+}
+
+void connection_metrics::on_flow_control_stalls(const uint64_t count) {
+  m_flow_control_stalls.fetch_add(count, RELAXED);
+  return;
+}
+
+void connection_metrics::on_frame_decoded(
+    const std::chrono::nanoseconds elapsed) {
+  const auto elapsed_ns = latency_histogram::to_value_ns(elapsed);
+  m_decode_time_buckets[latency_histogram::get_bucket_index(elapsed_ns)]
+      .fetch_add(1u, RELAXED);
+  m_decode_time_sum_ns.fetch_add(elapsed_ns, RELAXED);
+  store_min(&m_decode_time_min_ns, elapsed_ns);
+  store_max(&m_decode_time_max_ns, elapsed_ns);
+  return;
+}
+
+metrics_snapshot connection_metrics::snapshot() const {
+  metrics_snapshot snapshot{};
+
+  snapshot.m_frames_sent = load_all(m_frames_sent);
+  snapshot.m_bytes_sent = load_all(m_bytes_sent);
+  snapshot.m_frames_received = load_all(m_frames_received);
+  snapshot.m_bytes_received = load_all(m_bytes_received);
+  snapshot.m_hpack_static_hits = m_hpack_static_hits.load(RELAXED);
+  snapshot.m_hpack_dynamic_hits = m_hpack_dynamic_hits.load(RELAXED);
+  snapshot.m_hpack_literals = m_hpack_literals.load(RELAXED);
+  snapshot.m_hpack_evictions = m_hpack_evictions.load(RELAXED);
+  snapshot.m_huffman_bytes_saved = m_huffman_bytes_saved.load(RELAXED);
+  snapshot.m_flow_control_stalls = m_flow_control_stalls.load(RELAXED);
+  snapshot.m_decode_time = latency_histogram{
+      load_all(m_decode_time_buckets), m_decode_time_sum_ns.load(RELAXED),
+      m_decode_time_min_ns.load(RELAXED), m_decode_time_max_ns.load(RELAXED)};
+
+  return snapshot;
+}
+
+}  // namespace metrics
+
+}  // namespace mh2c
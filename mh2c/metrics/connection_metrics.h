@@ -0,0 +1,96 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_METRICS_CONNECTION_METRICS_H_
+#define MH2C_METRICS_CONNECTION_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/metrics/latency_histogram.h"
+
+namespace mh2c {
+
+namespace metrics {
+
+// One slot per frame type of RFC 7540 plus one for unknown types
+constexpr size_t FRAME_TYPE_SLOTS{
+    static_cast<size_t>(frame_type_registry::CONTINUATION) + 2u};
+using frame_counts_t = std::array<uint64_t, FRAME_TYPE_SLOTS>;
+
+// Plain copy of the counters. Snapshots of several connections can be summed.
+struct metrics_snapshot {
+  frame_counts_t m_frames_sent{};
+  frame_counts_t m_bytes_sent{};
+  frame_counts_t m_frames_received{};
+  frame_counts_t m_bytes_received{};
+
+  // Header field representations of the sent and received header blocks
+  uint64_t m_hpack_static_hits{};
+  uint64_t m_hpack_dynamic_hits{};
+  uint64_t m_hpack_literals{};
+  // Entries evicted from both dynamic tables
+  uint64_t m_hpack_evictions{};
+  uint64_t m_huffman_bytes_saved{};
+
+  // DATA frames that used up a receive window, see enable_window_autotuning()
+  uint64_t m_flow_control_stalls{};
+
+  // Time spent parsing and HPACK decoding each received frame
+  latency_histogram m_decode_time{};
+
+  // Ratio of indexed representations among all of them
+  double get_hpack_hit_rate() const;
+  metrics_snapshot& operator+=(const metrics_snapshot& other);
+};
+
+// Live counters of one connection. Every update is a relaxed atomic
+// increment, so they are cheap enough to stay enabled and snapshot() may be
+// called from any thread.
+class connection_metrics {
+ public:
+  connection_metrics();
+
+  connection_metrics(const connection_metrics&) = delete;
+  connection_metrics& operator=(const connection_metrics&) = delete;
+
+  void on_frame_sent(const frame_header& fh);
+  void on_frame_received(const frame_header& fh);
+  void on_hpack_block(const uint64_t static_hits, const uint64_t dynamic_hits,
+                      const uint64_t literals,
+                      const uint64_t huffman_bytes_saved);
+  void on_hpack_evictions(const uint64_t count);
+  void on_flow_control_stalls(const uint64_t count);
+  void on_frame_decoded(const std::chrono::nanoseconds elapsed);
+
+  metrics_snapshot snapshot() const;
+
+ private:
+  using counter_t = std::atomic<uint64_t>;
+
+  std::array<counter_t, FRAME_TYPE_SLOTS> m_frames_sent;
+  std::array<counter_t, FRAME_TYPE_SLOTS> m_bytes_sent;
+  std::array<counter_t, FRAME_TYPE_SLOTS> m_frames_received;
+  std::array<counter_t, FRAME_TYPE_SLOTS> m_bytes_received;
+  counter_t m_hpack_static_hits;
+  counter_t m_hpack_dynamic_hits;
+  counter_t m_hpack_literals;
+  counter_t m_hpack_evictions;
+  counter_t m_huffman_bytes_saved;
+  counter_t m_flow_control_stalls;
+  std::array<counter_t, latency_histogram::BUCKETS> m_decode_time_buckets;
+  counter_t m_decode_time_sum_ns;
+  counter_t m_decode_time_min_ns;
+  counter_t m_decode_time_max_ns;
+};
+
+}  // namespace metrics
+
+}  // namespace mh2c
+
+#endif  // MH2C_METRICS_CONNECTION_METRICS_H_
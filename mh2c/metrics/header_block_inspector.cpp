@@ -0,0 +1,140 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/metrics/header_block_inspector.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/util/bit_operation.h"
+
+namespace mh2c {
+
+namespace metrics {
+
+namespace {
+
+constexpr uint8_t HUFFMAN_FLAG{0x80u};
+constexpr size_t PRIORITY_FIELDS_BYTES{5u};
+constexpr size_t PROMISED_STREAM_ID_BYTES{4u};
+
+class fragment_reader {
+ public:
+  fragment_reader(const uint8_t* begin, const uint8_t* end)
+      : m_current{begin}, m_end{end} {}
+
+  bool has_data() const { return m_current < m_end; }
+  uint8_t peek() const { return *m_current; }
+
+  // cf. https://tools.ietf.org/html/rfc7541#section-5.1
+  size_t read_integer(const uint8_t prefix_bits) {
+    const uint8_t max_prefix = (1u << prefix_bits) - 1u;
+    size_t value = *m_current++ & max_prefix;
+    if (value < max_prefix) {
+      return value;
+    }
+
+    for (size_t shift = 0; m_current < m_end; shift += 7u) {
+      const auto byte = *m_current++;
+      value += static_cast<size_t>(byte & 0x7fu) << shift;
+      if ((byte & 0x80u) == 0) {
+        break;
+      }
+    }
+    return value;
+  }
+
+  // Returns the encoded length if the string is Huffman encoded, 0 otherwise.
+  // The string may continue in the next fragment.
+  size_t skip_string() {
+    if (has_data() == false) {
+      return 0u;
+    }
+    const auto is_huffman = (peek() & HUFFMAN_FLAG) != 0;
+    const auto length = read_integer(7u);
+    m_current += length;
+    return is_huffman ? length : 0u;
+  }
+
+ private:
+  const uint8_t* m_current;
+  const uint8_t* m_end;
+};
+
+uint64_t saved_bytes(const size_t decoded_length, const size_t encoded_length) {
+  return encoded_length > 0 && decoded_length > encoded_length
+             ? decoded_length - encoded_length
+             : 0u;
+}
+
+}  // namespace
+
+header_block_stats inspect_header_block(const frame_header& fh,
+                                        const uint8_t* raw_payload,
+                                        const header_block_t& header_block) {
+  size_t begin{};
+  size_t end{fh.m_length};
+  const auto type = cast_to_frame_type_registry(fh.m_type);
+  if (type != frame_type_registry::CONTINUATION) {
+    // HEADERS and PUSH_PROMISE share the PADDED flag.
+    if (is_flag_set(fh.m_flags, hf_flag::PADDED)) {
+      end -= raw_payload[begin++];
+    }
+    if (type == frame_type_registry::HEADERS &&
+        is_flag_set(fh.m_flags, hf_flag::PRIORITY)) {
+      begin += PRIORITY_FIELDS_BYTES;
+    }
+    if (type == frame_type_registry::PUSH_PROMISE) {
+      begin += PROMISED_STREAM_ID_BYTES;
+    }
+  }
+
+  header_block_stats stats{};
+  fragment_reader reader{raw_payload + begin, raw_payload + end};
+  for (const auto& entry : header_block) {
+    if (reader.has_data() == false) {
+      break;
+    }
+
+    const auto prefix_byte = reader.peek();
+    if (prefix_byte & 0x80u) {
+      // cf. https://tools.ietf.org/html/rfc7541#section-6.1
+      const auto index = reader.read_integer(7u);
+      if (index < dynamic_table::FIRST_INDEX) {
+        ++stats.m_static_hits;
+      } else {
+        ++stats.m_dynamic_hits;
+      }
+      continue;
+    }
+    if ((prefix_byte & 0xe0u) == 0x20u) {
+      // cf. https://tools.ietf.org/html/rfc7541#section-6.3
+      reader.read_integer(5u);
+      continue;
+    }
+
+    // cf. https://tools.ietf.org/html/rfc7541#section-6.2
+    ++stats.m_literals;
+    const auto name_index = reader.read_integer(
+        (prefix_byte & 0xc0u) == 0x40u ? 6u : 4u);
+    const auto header = entry.get_header();
+    if (name_index == 0) {
+      stats.m_huffman_bytes_saved +=
+          saved_bytes(header.first.length(), reader.skip_string());
+    }
+    stats.m_huffman_bytes_saved +=
+        saved_bytes(header.second.length(), reader.skip_string());
+  }
+
+  return stats;
+}
+
+}  // namespace metrics
+
+}  // namespace mh2c
@@ -0,0 +1,35 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_METRICS_HEADER_BLOCK_INSPECTOR_H_
+#define MH2C_METRICS_HEADER_BLOCK_INSPECTOR_H_
+
+#include <cstdint>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/hpack/header_type.h"
+
+namespace mh2c {
+
+namespace metrics {
+
+struct header_block_stats {
+  uint64_t m_static_hits;
+  uint64_t m_dynamic_hits;
+  uint64_t m_literals;
+  uint64_t m_huffman_bytes_saved;
+};
+
+// Classifies the representations of the header block fragment carried by a
+// serialized HEADERS, PUSH_PROMISE or CONTINUATION frame. Only the prefixes
+// and lengths are parsed; the string lengths come from the decoded block.
+header_block_stats inspect_header_block(const frame_header& fh,
+                                        const uint8_t* raw_payload,
+                                        const header_block_t& header_block);
+
+}  // namespace metrics
+
+}  // namespace mh2c
+
+#endif  // MH2C_METRICS_HEADER_BLOCK_INSPECTOR_H_
@@ -0,0 +1,134 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/metrics/latency_histogram.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace mh2c {
+
+namespace metrics {
+
+namespace {
+
+using histogram = latency_histogram;
+
+uint64_t get_bucket_upper_bound(const size_t index) {
+  if (index < histogram::SUB_BUCKETS) {
+    return index;
+  }
+
+  const auto shift = index / histogram::SUB_BUCKETS - 1u;
+  const auto sub_bucket = index % histogram::SUB_BUCKETS;
+  return ((histogram::SUB_BUCKETS + sub_bucket + 1u) << shift) - 1u;
+}
+
+}  // namespace
+
+latency_histogram::latency_histogram()
+    : m_buckets{},
+      m_count{0},
+      m_sum_ns{0},
+      m_min_ns{std::numeric_limits<uint64_t>::max()},
+      m_max_ns{0} {}
+
+latency_histogram::latency_histogram(const buckets_t& buckets,
+                                     const uint64_t sum_ns,
+                                     const uint64_t min_ns,
+                                     const uint64_t max_ns)
+    : m_buckets{buckets},
+      m_count{0},
+      m_sum_ns{sum_ns},
+      m_min_ns{min_ns},
+      m_max_ns{max_ns} {
+  for (const auto count : m_buckets) {
+    m_count += count;
+  }
+}
+
+uint64_t latency_histogram::to_value_ns(const std::chrono::nanoseconds value) {
+  return static_cast<uint64_t>(std::max<int64_t>(value.count(), 0));
+}
+
+size_t latency_histogram::get_bucket_index(const uint64_t value_ns) {
+  if (value_ns < SUB_BUCKETS) {
+    return value_ns;
+  }
+
+  size_t exponent{};
+  for (auto remain = value_ns >> 1u; remain > 0; remain >>= 1u) {
+    ++exponent;
+  }
+  if (exponent >= MAX_VALUE_BITS) {
+    return BUCKETS - 1u;
+  }
+
+  const auto sub_bucket =
+      (value_ns >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1u);
+  return (exponent - SUB_BUCKET_BITS + 1u) * SUB_BUCKETS + sub_bucket;
+}
+
+void latency_histogram::record(const std::chrono::nanoseconds value) {
+  const auto value_ns = to_value_ns(value);
+  ++m_buckets[get_bucket_index(value_ns)];
+  ++m_count;
+  m_sum_ns += value_ns;
+  m_min_ns = std::min(m_min_ns, value_ns);
+  m_max_ns = std::max(m_max_ns, value_ns);
+  return;
+}
+
+uint64_t latency_histogram::get_count() const { return m_count; }
+
+std::chrono::nanoseconds latency_histogram::get_min() const {
+  return std::chrono::nanoseconds{m_count == 0 ? 0 : m_min_ns};
+}
+
+std::chrono::nanoseconds latency_histogram::get_max() const {
+  return std::chrono::nanoseconds{m_max_ns};
+}
+
+std::chrono::nanoseconds latency_histogram::get_mean() const {
+  return std::chrono::nanoseconds{m_count == 0 ? 0 : m_sum_ns / m_count};
+}
+
+std::chrono::nanoseconds latency_histogram::get_percentile(
+    const double quantile) const {
+  if (m_count == 0) {
+    return std::chrono::nanoseconds{0};
+  }
+
+  const auto rank = std::max<uint64_t>(
+      static_cast<uint64_t>(std::ceil(quantile * m_count)), 1u);
+  uint64_t seen{};
+  for (size_t i = 0; i + 1u < m_buckets.size(); ++i) {
+    seen += m_buckets[i];
+    if (seen >= rank) {
+      return std::chrono::nanoseconds{
+          std::min(get_bucket_upper_bound(i), m_max_ns)};
+    }
+  }
+  // The last bucket has no upper bound of its own.
+  return get_max();
+}
+
+latency_histogram& latency_histogram::operator+=(
+    const latency_histogram& other) {
+  for (size_t i = 0; i < m_buckets.size(); ++i) {
+    m_buckets[i] += other.m_buckets[i];
+  }
+  m_count += other.m_count;
+  m_sum_ns += other.m_sum_ns;
+  m_min_ns = std::min(m_min_ns, other.m_min_ns);
+  m_max_ns = std::max(m_max_ns, other.m_max_ns);
+  return *this;
+}
+
+}  // namespace metrics
+
+}  // namespace mh2c
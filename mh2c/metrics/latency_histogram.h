@@ -0,0 +1,63 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_METRICS_LATENCY_HISTOGRAM_H_
+#define MH2C_METRICS_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace mh2c {
+
+namespace metrics {
+
+// Log-linear histogram in the style of HdrHistogram: every power of two is
+// split into SUB_BUCKETS linear buckets, so percentiles stay within 12.5% of
+// the recorded values from nanoseconds up to MAX_VALUE_BITS. It is a plain
+// value; histograms recorded on several threads are merged with +=.
+class latency_histogram {
+ public:
+  static constexpr size_t SUB_BUCKET_BITS{3u};
+  static constexpr size_t SUB_BUCKETS{size_t{1u} << SUB_BUCKET_BITS};
+  // Larger values, above 18 minutes, are counted in the last bucket.
+  static constexpr size_t MAX_VALUE_BITS{40u};
+  static constexpr size_t BUCKETS{(MAX_VALUE_BITS - SUB_BUCKET_BITS + 1u) *
+                                  SUB_BUCKETS};
+  using buckets_t = std::array<uint64_t, BUCKETS>;
+
+  latency_histogram();
+  // Histogram of counts kept elsewhere, e.g. in atomic counters that are
+  // updated with get_bucket_index(). The count is the sum of the buckets.
+  latency_histogram(const buckets_t& buckets, const uint64_t sum_ns,
+                    const uint64_t min_ns, const uint64_t max_ns);
+
+  // Negative values are counted as 0.
+  static uint64_t to_value_ns(const std::chrono::nanoseconds value);
+  static size_t get_bucket_index(const uint64_t value_ns);
+
+  void record(const std::chrono::nanoseconds value);
+
+  uint64_t get_count() const;
+  std::chrono::nanoseconds get_min() const;
+  std::chrono::nanoseconds get_max() const;
+  std::chrono::nanoseconds get_mean() const;
+  // Highest value of the bucket holding the quantile, 0 <= quantile <= 1
+  std::chrono::nanoseconds get_percentile(const double quantile) const;
+
+  latency_histogram& operator+=(const latency_histogram& other);
+
+ private:
+  buckets_t m_buckets;
+  uint64_t m_count;
+  uint64_t m_sum_ns;
+  uint64_t m_min_ns;
+  uint64_t m_max_ns;
+};
+
+}  // namespace metrics
+
+}  // namespace mh2c
+
+#endif  // MH2C_METRICS_LATENCY_HISTOGRAM_H_
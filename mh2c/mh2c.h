@@ -4,7 +4,12 @@
 #ifndef MH2C_MH2C_H_
 #define MH2C_MH2C_H_
 
+#include "mh2c/body/body_source.h"
+#include "mh2c/body/content_decoder.h"
 #include "mh2c/common/byte_array.h"
+#include "mh2c/connection_dispatcher.h"
+#include "mh2c/flow_control/send_window.h"
+#include "mh2c/flow_control/window_autotuning.h"
 #include "mh2c/frame/common_type.h"
 #include "mh2c/frame/continuation_frame.h"
 #include "mh2c/frame/data_frame.h"
@@ -22,10 +27,35 @@
 #include "mh2c/frame/settings_frame.h"
 #include "mh2c/frame/window_update_frame.h"
 #include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_block_template.h"
 #include "mh2c/hpack/header_type.h"
+#include "mh2c/hpack/indexing_policy.h"
 #include "mh2c/http2_client.h"
+#include "mh2c/metrics/connection_metrics.h"
+#include "mh2c/metrics/latency_histogram.h"
+#include "mh2c/net/connect_options.h"
+#include "mh2c/server/http2_server.h"
+#include "mh2c/server/server_options.h"
+#include "mh2c/server/server_session.h"
+#include "mh2c/settings/connection_settings.h"
+#include "mh2c/ssl/ssl_ktls_mode.h"
+#include "mh2c/ssl/ssl_session_cache.h"
 #include "mh2c/ssl/ssl_verify_mode.h"
+#include "mh2c/stream/latency_breakdown.h"
+#include "mh2c/stream/push_cache.h"
+#include "mh2c/stream/stream_state.h"
+#include "mh2c/trace/frame_capture.h"
+#include "mh2c/trace/ring_buffer_recorder.h"
+#include "mh2c/trace/trace_observer.h"
+#include "mh2c/transport/i_transport.h"
+#include "mh2c/transport/memory_transport.h"
+#include "mh2c/transport/tcp_transport.h"
 #include "mh2c/util/bit_operation.h"
 #include "mh2c/util/cast.h"
 
+#ifdef MH2C_ENABLE_COROUTINES
+#include "mh2c/coro/async_client.h"
+#include "mh2c/coro/task.h"
+#endif  // MH2C_ENABLE_COROUTINES
+
 #endif  // MH2C_MH2C_H_
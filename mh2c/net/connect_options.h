@@ -0,0 +1,42 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_NET_CONNECT_OPTIONS_H_
+#define MH2C_NET_CONNECT_OPTIONS_H_
+
+#include <chrono>
+#include <memory>
+
+#include "mh2c/ssl/ssl_session_cache.h"
+
+namespace mh2c {
+
+namespace net {
+
+// Deadlines for each phase of connection establishment.
+struct connect_options {
+  // Covers every TCP connection attempt. It starts before name resolution,
+  // which is not interrupted: a slow resolver only leaves less time for the
+  // attempts.
+  std::chrono::milliseconds m_connect_timeout{std::chrono::seconds{10}};
+  std::chrono::milliseconds m_handshake_timeout{std::chrono::seconds{10}};
+  // Time to wait for the server's SETTINGS frame after the preface.
+  std::chrono::milliseconds m_settings_timeout{std::chrono::seconds{10}};
+  // Delay before racing the next address.
+  // cf. https://tools.ietf.org/html/rfc8305#section-5
+  std::chrono::milliseconds m_attempt_delay{std::chrono::milliseconds{250}};
+  // Resumes the TLS sessions of earlier connections and keeps the ones the
+  // server issues on this one.
+  std::shared_ptr<ssl::session_cache> m_session_cache{};
+  // On a resumed session that allows it, what is written before the first
+  // read goes out as TLS 1.3 early data, ahead of the server's handshake
+  // messages. Only takes effect with m_session_cache.
+  // cf. https://tools.ietf.org/html/rfc8446#section-2.3
+  bool m_early_data{false};
+};
+
+}  // namespace net
+
+}  // namespace mh2c
+
+#endif  // MH2C_NET_CONNECT_OPTIONS_H_
@@ -0,0 +1,101 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/net/socket_fd.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+namespace mh2c {
+
+namespace net {
+
+socket_fd::socket_fd() : m_fd{-1} {}
+
+socket_fd::socket_fd(const int fd) : m_fd{fd} {}
+
+socket_fd::~socket_fd() { reset(); }
+
+socket_fd::socket_fd(socket_fd&& other) noexcept : m_fd{other.release()} {}
+
+socket_fd& socket_fd::operator=(socket_fd&& other) noexcept {
+  if (this != &other) {
+    reset(other.release());
+  }
+  return *this;
+}
+
+int socket_fd::get() const { return m_fd; }
+
+int socket_fd::release() {
+  const auto fd = m_fd;
+  m_fd = -1;
+  return fd;
+}
+
+void socket_fd::reset(const int fd) {
+  if (m_fd >= 0) {
+    close(m_fd);
+  }
+  m_fd = fd;
+  return;
+}
+
+void set_blocking(const int fd, const bool blocking) {
+  const auto flags = fcntl(fd, F_GETFL, 0);
+  if (flags < 0) {
+    int err_code = errno;
+    throw std::runtime_error("fcntl failed: err_code=" +
+                             std::to_string(err_code));
+  }
+
+  const auto new_flags =
+      blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
+  if (fcntl(fd, F_SETFL, new_flags) < 0) {
+    int err_code = errno;
+    throw std::runtime_error("fcntl failed: err_code=" +
+                             std::to_string(err_code));
+  }
+
+  return;
+}
+
+bool wait_for_events(const int fd, const short events,
+                     const std::chrono::milliseconds timeout) {
+  return wait_for_events(fd, events, -1, timeout);
+}
+
+bool wait_for_events(const int fd, const short events, const int wake_fd,
+                     const std::chrono::milliseconds timeout) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  // poll() skips a negative descriptor.
+  pollfd targets[] = {{fd, events, 0}, {wake_fd, POLLIN, 0}};
+
+  while (true) {
+    const auto remain = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    const auto result =
+        poll(targets, 2, remain.count() > 0 ? remain.count() : 0);
+    if (result > 0) {
+      return targets[0].revents != 0;
+    }
+    if (result == 0) {
+      return false;
+    }
+    if (errno != EINTR) {
+      int err_code = errno;
+      throw std::runtime_error("poll failed: err_code=" +
+                               std::to_string(err_code));
+    }
+  }
+}
+
+}  // namespace net
+
+}  // namespace mh2c
@@ -0,0 +1,46 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_NET_SOCKET_FD_H_
+#define MH2C_NET_SOCKET_FD_H_
+
+#include <chrono>
+
+namespace mh2c {
+
+namespace net {
+
+class socket_fd {
+ public:
+  socket_fd();
+  explicit socket_fd(const int fd);
+  ~socket_fd();
+
+  socket_fd(const socket_fd&) = delete;
+  socket_fd& operator=(const socket_fd&) = delete;
+  socket_fd(socket_fd&& other) noexcept;
+  socket_fd& operator=(socket_fd&& other) noexcept;
+
+  int get() const;
+  int release();
+  void reset(const int fd = -1);
+
+ private:
+  int m_fd;
+};
+
+void set_blocking(const int fd, const bool blocking);
+
+// Returns false if none of the events became ready before the timeout.
+bool wait_for_events(const int fd, const short events,
+                     const std::chrono::milliseconds timeout);
+// Also returns false as soon as wake_fd becomes readable, e.g. an eventfd
+// another thread writes to; -1 for none.
+bool wait_for_events(const int fd, const short events, const int wake_fd,
+                     const std::chrono::milliseconds timeout);
+
+}  // namespace net
+
+}  // namespace mh2c
+
+#endif  // MH2C_NET_SOCKET_FD_H_
@@ -0,0 +1,176 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/net/tcp_connector.h"
+
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mh2c/net/connect_options.h"
+#include "mh2c/net/socket_fd.h"
+
+namespace mh2c {
+
+namespace net {
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+using addrinfo_ptr = std::unique_ptr<addrinfo, decltype(&freeaddrinfo)>;
+
+addrinfo_ptr resolve(const std::string& hostname, const uint16_t port) {
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_ADDRCONFIG;
+
+  addrinfo* result{};
+  const auto err = getaddrinfo(hostname.c_str(), std::to_string(port).c_str(),
+                               &hints, &result);
+  if (err != 0) {
+    throw std::runtime_error("getaddrinfo failed: err=" +
+                             std::string{gai_strerror(err)});
+  }
+
+  return {result, freeaddrinfo};
+}
+
+// Alternate address families, keeping the resolver's preference within each
+// family and starting with the family of the first result.
+// cf. https://tools.ietf.org/html/rfc8305#section-4
+std::deque<const addrinfo*> sort_addresses(const addrinfo* addresses) {
+  std::deque<const addrinfo*> first_family{};
+  std::deque<const addrinfo*> other_family{};
+  for (auto ite = addresses; ite != nullptr; ite = ite->ai_next) {
+    if (ite->ai_family == addresses->ai_family) {
+      first_family.push_back(ite);
+    } else {
+      other_family.push_back(ite);
+    }
+  }
+
+  std::deque<const addrinfo*> sorted{};
+  while (first_family.empty() == false || other_family.empty() == false) {
+    if (first_family.empty() == false) {
+      sorted.push_back(first_family.front());
+      first_family.pop_front();
+    }
+    if (other_family.empty() == false) {
+      sorted.push_back(other_family.front());
+      other_family.pop_front();
+    }
+  }
+
+  return sorted;
+}
+
+int get_socket_error(const int fd) {
+  int err_code{};
+  socklen_t length = sizeof(err_code);
+  if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err_code, &length) != 0) {
+    return errno;
+  }
+  return err_code;
+}
+
+}  // namespace
+
+socket_fd connect_tcp(const std::string& hostname, const uint16_t port,
+                      const connect_options& options) {
+  const auto deadline = clock_type::now() + options.m_connect_timeout;
+  const auto resolved = resolve(hostname, port);
+  auto addresses = sort_addresses(resolved.get());
+
+  std::vector<socket_fd> attempts{};
+  std::vector<pollfd> poll_targets{};
+  auto next_attempt_time = clock_type::now();
+  int last_err_code{};
+
+  while (true) {
+    // Start the next attempt if the previous one failed or took too long.
+    auto now = clock_type::now();
+    if (addresses.empty() == false && now >= next_attempt_time) {
+      const auto address = addresses.front();
+      addresses.pop_front();
+
+      socket_fd fd{socket(address->ai_family,
+                          address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                          address->ai_protocol)};
+      if (fd.get() < 0) {
+        last_err_code = errno;
+        continue;
+      }
+      if (connect(fd.get(), address->ai_addr, address->ai_addrlen) == 0) {
+        return fd;
+      }
+      if (errno != EINPROGRESS) {
+        last_err_code = errno;
+        continue;
+      }
+
+      poll_targets.push_back({fd.get(), POLLOUT, 0});
+      attempts.push_back(std::move(fd));
+      next_attempt_time = now + options.m_attempt_delay;
+    }
+
+    if (attempts.empty() && addresses.empty()) {
+      throw std::runtime_error("connect failed: host=" + hostname +
+                               ", err_code=" + std::to_string(last_err_code));
+    }
+    if (now >= deadline) {
+      throw std::runtime_error("connect timed out: host=" + hostname);
+    }
+
+    // Wait until an attempt finishes, the next attempt is due or time is up.
+    auto wake_up_time = deadline;
+    if (addresses.empty() == false) {
+      wake_up_time = std::min(wake_up_time, next_attempt_time);
+    }
+    const auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+        wake_up_time - now);
+    const auto result = poll(poll_targets.data(), poll_targets.size(),
+                             std::max<int64_t>(timeout.count(), 0));
+    if (result < 0 && errno != EINTR) {
+      int err_code = errno;
+      throw std::runtime_error("poll failed: err_code=" +
+                               std::to_string(err_code));
+    }
+    if (result <= 0) {
+      continue;
+    }
+
+    now = clock_type::now();
+    for (size_t i = 0; i < poll_targets.size();) {
+      if (poll_targets[i].revents == 0) {
+        ++i;
+        continue;
+      }
+
+      const auto err_code = get_socket_error(poll_targets[i].fd);
+      if (err_code == 0) {
+        return std::move(attempts[i]);
+      }
+
+      // A failed attempt lets the next address start immediately.
+      last_err_code = err_code;
+      next_attempt_time = now;
+      poll_targets.erase(poll_targets.begin() + i);
+      attempts.erase(attempts.begin() + i);
+    }
+  }
+}
+
+}  // namespace net
+
+}  // namespace mh2c
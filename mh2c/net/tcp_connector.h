@@ -0,0 +1,27 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_NET_TCP_CONNECTOR_H_
+#define MH2C_NET_TCP_CONNECTOR_H_
+
+#include <cstdint>
+#include <string>
+
+#include "mh2c/net/connect_options.h"
+#include "mh2c/net/socket_fd.h"
+
+namespace mh2c {
+
+namespace net {
+
+// Resolves hostname and races the resolved addresses in Happy Eyeballs style,
+// alternating address families. The returned socket is non-blocking.
+// cf. https://tools.ietf.org/html/rfc8305
+socket_fd connect_tcp(const std::string& hostname, const uint16_t port,
+                      const connect_options& options);
+
+}  // namespace net
+
+}  // namespace mh2c
+
+#endif  // MH2C_NET_TCP_CONNECTOR_H_
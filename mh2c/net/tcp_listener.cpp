@@ -0,0 +1,76 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/net/tcp_listener.h"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "mh2c/net/socket_fd.h"
+
+namespace mh2c {
+
+namespace net {
+
+socket_fd listen_tcp(const std::string& address, const uint16_t port) {
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST | AI_NUMERICSERV;
+
+  addrinfo* result{};
+  const auto err = getaddrinfo(address.c_str(), std::to_string(port).c_str(),
+                               &hints, &result);
+  if (err != 0) {
+    throw std::runtime_error("getaddrinfo failed: err=" +
+                             std::string{gai_strerror(err)});
+  }
+  const std::unique_ptr<addrinfo, decltype(&freeaddrinfo)> addresses{
+      result, freeaddrinfo};
+
+  socket_fd fd{socket(result->ai_family, result->ai_socktype | SOCK_CLOEXEC,
+                      result->ai_protocol)};
+  if (fd.get() < 0) {
+    int err_code = errno;
+    throw std::runtime_error("socket failed: err_code=" +
+                             std::to_string(err_code));
+  }
+
+  const int on{1};
+  setsockopt(fd.get(), SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  if (bind(fd.get(), result->ai_addr, result->ai_addrlen) != 0 ||
+      listen(fd.get(), SOMAXCONN) != 0) {
+    int err_code = errno;
+    throw std::runtime_error("bind/listen failed: err_code=" +
+                             std::to_string(err_code));
+  }
+
+  return fd;
+}
+
+uint16_t get_local_port(const int fd) {
+  sockaddr_storage address{};
+  socklen_t address_len{sizeof(address)};
+  if (getsockname(fd, reinterpret_cast<sockaddr*>(&address), &address_len) !=
+      0) {
+    int err_code = errno;
+    throw std::runtime_error("getsockname failed: err_code=" +
+                             std::to_string(err_code));
+  }
+
+  if (address.ss_family == AF_INET6) {
+    return ntohs(reinterpret_cast<const sockaddr_in6*>(&address)->sin6_port);
+  }
+  return ntohs(reinterpret_cast<const sockaddr_in*>(&address)->sin_port);
+}
+
+}  // namespace net
+
+}  // namespace mh2c
@@ -0,0 +1,26 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_NET_TCP_LISTENER_H_
+#define MH2C_NET_TCP_LISTENER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "mh2c/net/socket_fd.h"
+
+namespace mh2c {
+
+namespace net {
+
+// Binds a listening socket to a numeric address. Port 0 picks an ephemeral
+// port, see get_local_port().
+socket_fd listen_tcp(const std::string& address, const uint16_t port);
+
+uint16_t get_local_port(const int fd);
+
+}  // namespace net
+
+}  // namespace mh2c
+
+#endif  // MH2C_NET_TCP_LISTENER_H_
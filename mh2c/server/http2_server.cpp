@@ -0,0 +1,168 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/server/http2_server.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "mh2c/net/socket_fd.h"
+#include "mh2c/net/tcp_listener.h"
+#include "mh2c/server/server_options.h"
+#include "mh2c/server/server_session.h"
+#include "mh2c/server/tls_acceptor.h"
+#include "mh2c/transport/i_transport.h"
+#include "mh2c/transport/tcp_transport.h"
+
+namespace mh2c {
+
+namespace server {
+
+class http2_server::impl {
+ public:
+  explicit impl(const server_options& options);
+
+  uint16_t listen(const std::string& address, const uint16_t port,
+                  const server_transport transport);
+  void stop();
+
+ private:
+  void accept_loop();
+  void serve(net::socket_fd fd);
+
+  server_options m_options;
+  std::optional<tls_acceptor> m_tls_acceptor;
+  net::socket_fd m_listen_fd;
+  std::atomic<bool> m_stopped;
+  std::thread m_accept_thread;
+  std::mutex m_mutex;
+  std::vector<std::thread> m_session_threads;
+  // Sockets of the running sessions, shut down by stop()
+  std::unordered_set<int> m_session_fds;
+};
+
+http2_server::impl::impl(const server_options& options)
+    : m_options{options},
+      m_tls_acceptor{},
+      m_listen_fd{},
+      m_stopped{false},
+      m_accept_thread{},
+      m_mutex{},
+      m_session_threads{},
+      m_session_fds{} {}
+
+uint16_t http2_server::impl::listen(const std::string& address,
+                                    const uint16_t port,
+                                    const server_transport transport) {
+  if (m_listen_fd.get() >= 0) {
+    throw std::runtime_error("http2_server is already listening");
+  }
+
+  if (transport == server_transport::TLS) {
+    m_tls_acceptor.emplace(m_options.m_certificate_file,
+                           m_options.m_private_key_file,
+                           m_options.m_max_early_data);
+  }
+  m_listen_fd = net::listen_tcp(address, port);
+  m_accept_thread = std::thread{[this]() { accept_loop(); }};
+
+  return net::get_local_port(m_listen_fd.get());
+}
+
+void http2_server::impl::stop() {
+  if (m_stopped.exchange(true) || m_listen_fd.get() < 0) {
+    return;
+  }
+
+  // Wakes up accept()
+  shutdown(m_listen_fd.get(), SHUT_RDWR);
+  m_accept_thread.join();
+
+  std::vector<std::thread> session_threads{};
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    for (const auto fd : m_session_fds) {
+      shutdown(fd, SHUT_RDWR);
+    }
+    session_threads.swap(m_session_threads);
+  }
+  for (auto& thread : session_threads) {
+    thread.join();
+  }
+
+  m_listen_fd.reset();
+  return;
+}
+
+void http2_server::impl::accept_loop() {
+  while (m_stopped == false) {
+    net::socket_fd fd{accept4(m_listen_fd.get(), nullptr, nullptr,
+                              SOCK_CLOEXEC)};
+    if (fd.get() < 0) {
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_stopped) {
+      break;
+    }
+    m_session_fds.insert(fd.get());
+    m_session_threads.emplace_back(
+        [this, fd = std::move(fd)]() mutable { serve(std::move(fd)); });
+  }
+
+  return;
+}
+
+void http2_server::impl::serve(net::socket_fd fd) {
+  // The session works on a duplicate so that the socket registered for stop()
+  // stays open, and its number unused, until it is unregistered below.
+  net::socket_fd session_fd{dup(fd.get())};
+
+  // A broken connection only ends its own session.
+  try {
+    auto transport =
+        m_tls_acceptor
+            ? m_tls_acceptor->accept(std::move(session_fd),
+                                     m_options.m_handshake_timeout)
+            : transport::make_tcp_transport(session_fd.release());
+    server_session{std::move(transport), m_options}.run();
+  } catch (const std::exception&) {
+  }
+
+  std::lock_guard<std::mutex> lock{m_mutex};
+  m_session_fds.erase(fd.get());
+  return;
+}
+
+http2_server::http2_server(const server_options& options)
+    : m_pimpl(std::make_unique<http2_server::impl>(options)) {}
+
+http2_server::~http2_server() { m_pimpl->stop(); }
+
+uint16_t http2_server::listen(const std::string& address, const uint16_t port,
+                              const server_transport transport) {
+  return m_pimpl->listen(address, port, transport);
+}
+
+void http2_server::stop() {
+  m_pimpl->stop();
+  return;
+}
+
+}  // namespace server
+
+}  // namespace mh2c
@@ -0,0 +1,48 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_SERVER_HTTP2_SERVER_H_
+#define MH2C_SERVER_HTTP2_SERVER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "mh2c/server/server_options.h"
+
+namespace mh2c {
+
+namespace server {
+
+enum class server_transport : uint8_t {
+  CLEARTEXT,  // h2c with prior knowledge
+  TLS,
+};
+
+// Local HTTP/2 peer for benchmarks and tests. Every accepted connection is
+// served by a server_session on its own thread.
+class http2_server {
+ public:
+  explicit http2_server(const server_options& options);
+  ~http2_server();
+
+  http2_server(const http2_server&) = delete;
+  http2_server& operator=(const http2_server&) = delete;
+
+  // Starts accepting connections and returns the bound port, which is an
+  // ephemeral one if port is 0.
+  uint16_t listen(const std::string& address, const uint16_t port,
+                  const server_transport transport);
+  // Closes the listening socket and every open connection.
+  void stop();
+
+ private:
+  class impl;
+  std::unique_ptr<impl> m_pimpl;
+};
+
+}  // namespace server
+
+}  // namespace mh2c
+
+#endif  // MH2C_SERVER_HTTP2_SERVER_H_
@@ -0,0 +1,59 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_SERVER_SERVER_OPTIONS_H_
+#define MH2C_SERVER_SERVER_OPTIONS_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/settings_frame.h"
+#include "mh2c/hpack/header_type.h"
+
+namespace mh2c {
+
+namespace server {
+
+// Response returned for a request. The body is m_body when it is not empty,
+// and otherwise m_body_size bytes filled with a fixed byte.
+struct response_spec {
+  uint16_t m_status{200u};
+  headers_t m_headers{};
+  size_t m_body_size{0u};
+  byte_array_t m_body{};
+};
+
+struct server_options {
+  // SETTINGS sent right after the server connection preface
+  sf_payload_t m_settings{};
+  // Responses keyed by :path; m_default_response serves everything else.
+  std::unordered_map<std::string, response_spec> m_responses{};
+  response_spec m_default_response{};
+  // Paths pushed along with the response to a :path, when the client allows
+  // server push
+  std::unordered_map<std::string, std::vector<std::string>> m_pushes{};
+  header_encode_mode m_encode_mode{header_encode_mode::HUFFMAN};
+  // Requests served on a connection before it drains: GOAWAY names the last
+  // of them, later streams are left unprocessed, and the connection closes
+  // once the responses are sent, like a server being restarted. 0 for no
+  // limit.
+  size_t m_max_requests{0u};
+  // Used by http2_server for TLS connections
+  std::string m_certificate_file{};
+  std::string m_private_key_file{};
+  std::chrono::milliseconds m_handshake_timeout{10000};
+  // Bytes of TLS 1.3 early data a resuming client may send, see
+  // tls_acceptor. 0 rejects early data.
+  uint32_t m_max_early_data{0u};
+};
+
+}  // namespace server
+
+}  // namespace mh2c
+
+#endif  // MH2C_SERVER_SERVER_OPTIONS_H_
@@ -0,0 +1,500 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/server/server_session.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/flow_control/receive_window.h"
+#include "mh2c/flow_control/send_window.h"
+#include "mh2c/flow_control/window_autotuning.h"
+#include "mh2c/frame/common_type.h"
+#include "mh2c/frame/continuation_frame.h"
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/error_codes.h"
+#include "mh2c/frame/frame_builder.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/goaway_frame.h"
+#include "mh2c/frame/header_block_fragment.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/i_frame.h"
+#include "mh2c/frame/ping_frame.h"
+#include "mh2c/frame/push_promise_frame.h"
+#include "mh2c/frame/settings_frame.h"
+#include "mh2c/frame/window_update_frame.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/server/server_options.h"
+#include "mh2c/settings/connection_settings.h"
+#include "mh2c/transport/i_transport.h"
+#include "mh2c/util/bit_operation.h"
+#include "mh2c/util/cast.h"
+
+namespace mh2c {
+
+namespace server {
+
+namespace {
+
+// Byte the response bodies are filled with
+constexpr uint8_t BODY_FILL_BYTE{'x'};
+// How long a drained connection waits for the client to go quiet
+constexpr std::chrono::milliseconds LINGER_TIMEOUT{100};
+
+struct request_state {
+  std::string m_path;
+  // Copied to the requests of the pushed responses
+  std::string m_scheme;
+  std::string m_authority;
+  bool m_headers_complete;
+  bool m_end_stream;
+};
+
+struct pending_body {
+  fh_stream_id_t m_stream_id;
+  size_t m_remaining;
+  // m_body of the response_spec, which m_options keeps alive; nullptr for
+  // filler bytes
+  const byte_array_t* m_content;
+};
+
+}  // namespace
+
+class server_session::impl {
+ public:
+  impl(std::unique_ptr<transport::i_transport> transport,
+       const server_options& options);
+
+  void run();
+
+ private:
+  void receive_connection_preface();
+  void receive_raw_frame(frame_header* fh, byte_array_t* raw_payload);
+  h2_frame_ptr receive_frame();
+  void send_control_frame(const i_frame<frame_header>& frame);
+
+  bool handle_frame(const h2_frame_ptr& frame_ptr);
+  void handle_header_block(const frame_header& fh,
+                           const header_block_t& header_block);
+  void handle_settings(const settings_frame& frame);
+  void handle_window_update(const fh_stream_id_t stream_id,
+                            const window_size_t increment);
+  void reset_stream(const fh_stream_id_t stream_id);
+
+  void respond(const fh_stream_id_t stream_id);
+  fh_stream_id_t promise(const fh_stream_id_t stream_id,
+                         const request_state& request,
+                         const std::string& path);
+  void send_response(const fh_stream_id_t stream_id, const std::string& path);
+  void flush_bodies();
+  void linger();
+
+  server_options m_options;
+  std::unique_ptr<transport::i_transport> m_transport;
+  dynamic_table m_request_dynamic_table;
+  dynamic_table m_response_dynamic_table;
+  flow_control::receive_window m_receive_window;
+  std::unordered_map<fh_stream_id_t, request_state> m_requests;
+  std::deque<pending_body> m_pending_bodies;
+  settings::connection_settings m_settings;
+  flow_control::send_window m_send_window;
+  fh_stream_id_t m_next_push_stream_id;
+  size_t m_request_count;
+  // Last stream of the GOAWAY sent, 0 before
+  fh_stream_id_t m_last_stream_id;
+};
+
+server_session::impl::impl(std::unique_ptr<transport::i_transport> transport,
+                           const server_options& options)
+    : m_options{options},
+      m_transport{std::move(transport)},
+      m_request_dynamic_table{},
+      m_response_dynamic_table{},
+      m_receive_window{flow_control::DEFAULT_WINDOW_SIZE},
+      m_requests{},
+      m_pending_bodies{},
+      m_settings{},
+      m_send_window{},
+      m_next_push_stream_id{2u},
+      m_request_count{0},
+      m_last_stream_id{0} {}
+
+void server_session::impl::run() {
+  try {
+    receive_connection_preface();
+
+    // cf. https://tools.ietf.org/html/rfc7540#section-3.5
+    send_control_frame(settings_frame{0u, 0u, m_options.m_settings});
+    m_settings.on_local_settings(m_options.m_settings);
+    const auto table_size_key =
+        underlying_cast(sf_parameter::SETTINGS_HEADER_TABLE_SIZE);
+    if (m_options.m_settings.find(table_size_key) !=
+        m_options.m_settings.end()) {
+      m_response_dynamic_table.update_table_size(
+          m_options.m_settings.at(table_size_key));
+    }
+
+    while (handle_frame(receive_frame())) {
+      flush_bodies();
+      if (m_last_stream_id != 0 && m_requests.empty() &&
+          m_pending_bodies.empty()) {
+        linger();
+        break;
+      }
+    }
+  } catch (const transport::transport_closed&) {
+    // The client went away.
+  }
+
+  return;
+}
+
+void server_session::impl::receive_connection_preface() {
+  static const std::string client_connection_preface{
+      "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"};
+
+  byte_array_t preface(client_connection_preface.length());
+  m_transport->read(&preface[0], preface.size());
+  if (std::equal(preface.begin(), preface.end(),
+                 client_connection_preface.begin()) == false) {
+    throw std::runtime_error("invalid client connection preface");
+  }
+
+  return;
+}
+
+void server_session::impl::receive_raw_frame(frame_header* fh,
+                                             byte_array_t* raw_payload) {
+  byte_array_t raw_fh(FRAME_HEADER_BYTES);
+  m_transport->read(&raw_fh[0], raw_fh.size());
+  *fh = build_frame_header(raw_fh);
+
+  raw_payload->resize(fh->m_length);
+  if (fh->m_length > 0) {
+    m_transport->read(&(*raw_payload)[0], raw_payload->size());
+  }
+
+  return;
+}
+
+h2_frame_ptr server_session::impl::receive_frame() {
+  frame_header fh{};
+  byte_array_t raw_payload{};
+  receive_raw_frame(&fh, &raw_payload);
+
+  // A header field may be split across the frames of a header block, so the
+  // CONTINUATION frames are merged into the HEADERS frame before decoding.
+  if (cast_to_frame_type_registry(fh.m_type) == frame_type_registry::HEADERS) {
+    while (is_flag_set(fh.m_flags, hf_flag::END_HEADERS) == false) {
+      frame_header continuation_fh{};
+      byte_array_t continuation_payload{};
+      receive_raw_frame(&continuation_fh, &continuation_payload);
+      append_header_block_fragment(continuation_fh, continuation_payload, &fh,
+                                   &raw_payload);
+    }
+  }
+
+  return build_frame(fh, raw_payload, m_request_dynamic_table);
+}
+
+void server_session::impl::send_control_frame(
+    const i_frame<frame_header>& frame) {
+  const auto raw_frame = frame.serialize();
+  m_transport->write(raw_frame.data(), raw_frame.size());
+  return;
+}
+
+bool server_session::impl::handle_frame(const h2_frame_ptr& frame_ptr) {
+  const auto fh = frame_ptr->get_header();
+
+  switch (cast_to_frame_type_registry(fh.m_type)) {
+    case frame_type_registry::HEADERS:
+      handle_header_block(
+          fh, dynamic_cast<const headers_frame*>(frame_ptr.get())
+                  ->get_payload());
+      break;
+    case frame_type_registry::CONTINUATION:
+      handle_header_block(
+          fh, dynamic_cast<const continuation_frame*>(frame_ptr.get())
+                  ->get_payload());
+      break;
+    case frame_type_registry::DATA: {
+      const auto end_stream = is_flag_set(fh.m_flags, df_flag::END_STREAM);
+      const auto updates =
+          m_receive_window.consume(fh.m_stream_id, fh.m_length, end_stream);
+      for (const auto& [stream_id, increment] : updates) {
+        send_control_frame(window_update_frame{stream_id, increment});
+      }
+
+      const auto ite = m_requests.find(fh.m_stream_id);
+      if (end_stream && ite != m_requests.end()) {
+        ite->second.m_end_stream = true;
+        respond(fh.m_stream_id);
+      }
+      break;
+    }
+    case frame_type_registry::SETTINGS:
+      if (is_flag_set(fh.m_flags, sf_flag::ACK)) {
+        m_settings.on_local_ack();
+      } else {
+        handle_settings(*dynamic_cast<const settings_frame*>(frame_ptr.get()));
+      }
+      break;
+    case frame_type_registry::PING:
+      if (is_flag_set(fh.m_flags, pf_flag::ACK) == false) {
+        send_control_frame(ping_frame{
+            make_frame_header_flags(pf_flag::ACK),
+            dynamic_cast<const ping_frame*>(frame_ptr.get())->get_payload()});
+      }
+      break;
+    case frame_type_registry::WINDOW_UPDATE:
+      handle_window_update(
+          fh.m_stream_id,
+          dynamic_cast<const window_update_frame*>(frame_ptr.get())
+              ->get_payload());
+      break;
+    case frame_type_registry::RST_STREAM:
+      reset_stream(fh.m_stream_id);
+      break;
+    case frame_type_registry::GOAWAY:
+      return false;
+    default:
+      break;
+  }
+
+  return true;
+}
+
+void server_session::impl::handle_header_block(
+    const frame_header& fh, const header_block_t& header_block) {
+  update_dynamic_table(header_block, &m_request_dynamic_table);
+
+  // Ignored once GOAWAY has named an earlier stream as the last
+  // cf. https://tools.ietf.org/html/rfc7540#section-6.8
+  if (m_last_stream_id != 0 && fh.m_stream_id > m_last_stream_id) {
+    return;
+  }
+  if (m_requests.count(fh.m_stream_id) == 0 &&
+      ++m_request_count == m_options.m_max_requests) {
+    m_last_stream_id = fh.m_stream_id;
+    send_control_frame(
+        goaway_frame{{0u, m_last_stream_id, error_codes::NO_ERROR, {}}});
+  }
+
+  auto& request = m_requests[fh.m_stream_id];
+  for (const auto& entry : header_block) {
+    if (entry.get_prefix() == header_prefix_pattern::SIZE_UPDATE) {
+      continue;
+    }
+    const auto& [name, value] = entry.get_header();
+    if (name == ":path") {
+      request.m_path = value;
+    } else if (name == ":scheme") {
+      request.m_scheme = value;
+    } else if (name == ":authority") {
+      request.m_authority = value;
+    }
+  }
+
+  // END_STREAM and END_HEADERS share their bit between HEADERS and
+  // CONTINUATION.
+  if (is_flag_set(fh.m_flags, hf_flag::END_HEADERS)) {
+    request.m_headers_complete = true;
+  }
+  if (cast_to_frame_type_registry(fh.m_type) == frame_type_registry::HEADERS &&
+      is_flag_set(fh.m_flags, hf_flag::END_STREAM)) {
+    request.m_end_stream = true;
+  }
+
+  if (request.m_headers_complete && request.m_end_stream) {
+    respond(fh.m_stream_id);
+  }
+
+  return;
+}
+
+void server_session::impl::handle_settings(const settings_frame& frame) {
+  m_settings.on_remote_settings(frame.get_payload());
+  m_send_window.set_initial_stream_window(m_settings.get_remote().get(
+      sf_parameter::SETTINGS_INITIAL_WINDOW_SIZE));
+
+  send_control_frame(
+      settings_frame{make_frame_header_flags(sf_flag::ACK), 0u, {}});
+  return;
+}
+
+void server_session::impl::handle_window_update(
+    const fh_stream_id_t stream_id, const window_size_t increment) {
+  m_send_window.on_window_update(stream_id, increment);
+  return;
+}
+
+void server_session::impl::reset_stream(const fh_stream_id_t stream_id) {
+  m_requests.erase(stream_id);
+  m_send_window.close_stream(stream_id);
+  m_receive_window.close_stream(stream_id);
+  m_pending_bodies.erase(
+      std::remove_if(m_pending_bodies.begin(), m_pending_bodies.end(),
+                     [stream_id](const auto& body) {
+                       return body.m_stream_id == stream_id;
+                     }),
+      m_pending_bodies.end());
+  return;
+}
+
+void server_session::impl::respond(const fh_stream_id_t stream_id) {
+  const auto request = m_requests.at(stream_id);
+  m_requests.erase(stream_id);
+  m_receive_window.close_stream(stream_id);
+
+  // Promised before the response, which may refer to the pushed resources
+  // cf. https://tools.ietf.org/html/rfc7540#section-8.2.1
+  std::vector<std::pair<fh_stream_id_t, std::string>> pushes{};
+  const auto push_ite = m_options.m_pushes.find(request.m_path);
+  if (push_ite != m_options.m_pushes.end() &&
+      m_settings.get_remote().get(sf_parameter::SETTINGS_ENABLE_PUSH) != 0) {
+    for (const auto& path : push_ite->second) {
+      pushes.emplace_back(promise(stream_id, request, path), path);
+    }
+  }
+
+  send_response(stream_id, request.m_path);
+  for (const auto& [promised_stream_id, path] : pushes) {
+    send_response(promised_stream_id, path);
+  }
+  return;
+}
+
+fh_stream_id_t server_session::impl::promise(const fh_stream_id_t stream_id,
+                                             const request_state& request,
+                                             const std::string& path) {
+  const auto promised_stream_id = m_next_push_stream_id;
+  m_next_push_stream_id += 2u;
+
+  // Not indexed, so that the dynamic tables need no update
+  const auto header_block =
+      make_header_block(header_prefix_pattern::WITHOUT_INDEXING,
+                        headers_t{
+                            {":method", "GET"},
+                            {":scheme", request.m_scheme},
+                            {":authority", request.m_authority},
+                            {":path", path},
+                        });
+  send_control_frame(push_promise_frame{
+      make_frame_header_flags(ppf_flag::END_HEADERS), stream_id,
+      {0u, promised_stream_id, header_block, {}}, m_options.m_encode_mode,
+      m_response_dynamic_table});
+  return promised_stream_id;
+}
+
+void server_session::impl::send_response(const fh_stream_id_t stream_id,
+                                         const std::string& path) {
+  const auto spec_ite = m_options.m_responses.find(path);
+  const auto& spec = spec_ite != m_options.m_responses.end()
+                         ? spec_ite->second
+                         : m_options.m_default_response;
+
+  const auto body_size =
+      spec.m_body.empty() ? spec.m_body_size : spec.m_body.size();
+  headers_t headers{
+      {":status", std::to_string(spec.m_status)},
+      {"content-length", std::to_string(body_size)},
+  };
+  headers.insert(headers.end(), spec.m_headers.begin(), spec.m_headers.end());
+  const auto header_block =
+      make_header_block(header_prefix_pattern::INCREMENTAL_INDEXING, headers);
+
+  const auto flags =
+      body_size == 0
+          ? make_frame_header_flags(hf_flag::END_STREAM, hf_flag::END_HEADERS)
+          : make_frame_header_flags(hf_flag::END_HEADERS);
+  const headers_frame frame{flags, stream_id, header_block,
+                            m_options.m_encode_mode, m_response_dynamic_table};
+  send_control_frame(frame);
+  update_dynamic_table(frame.get_payload(), &m_response_dynamic_table);
+
+  if (body_size > 0) {
+    m_pending_bodies.push_back(
+        {stream_id, body_size, spec.m_body.empty() ? nullptr : &spec.m_body});
+  }
+
+  return;
+}
+
+void server_session::impl::flush_bodies() {
+  const size_t max_frame_size{
+      m_settings.get_remote().get(sf_parameter::SETTINGS_MAX_FRAME_SIZE)};
+  auto ite = m_pending_bodies.begin();
+
+  while (ite != m_pending_bodies.end() &&
+         m_send_window.get_connection_window() > 0) {
+    while (ite->m_remaining > 0 &&
+           m_send_window.get_available(ite->m_stream_id) > 0) {
+      const auto chunk_length =
+          std::min({ite->m_remaining, max_frame_size,
+                    m_send_window.get_available(ite->m_stream_id)});
+      byte_array_t chunk(chunk_length, BODY_FILL_BYTE);
+      if (ite->m_content != nullptr) {
+        const auto offset = ite->m_content->size() - ite->m_remaining;
+        std::copy_n(ite->m_content->begin() + offset, chunk_length,
+                    chunk.begin());
+      }
+      ite->m_remaining -= chunk_length;
+      m_send_window.consume(ite->m_stream_id, chunk_length);
+
+      const auto flags = ite->m_remaining == 0
+                             ? make_frame_header_flags(df_flag::END_STREAM)
+                             : fh_flags_t{0u};
+      send_control_frame(data_frame{flags, ite->m_stream_id, chunk});
+    }
+
+    if (ite->m_remaining == 0) {
+      m_send_window.close_stream(ite->m_stream_id);
+      ite = m_pending_bodies.erase(ite);
+    } else {
+      ++ite;
+    }
+  }
+
+  return;
+}
+
+// Closing with unread data would reset the connection, and the client could
+// lose the last responses; what it still sends, e.g. WINDOW_UPDATE for the
+// last DATA, is read and dropped until it closes or goes quiet.
+void server_session::impl::linger() {
+  frame_header fh{};
+  byte_array_t raw_payload{};
+  while (m_transport->wait_readable(LINGER_TIMEOUT)) {
+    receive_raw_frame(&fh, &raw_payload);
+  }
+  return;
+}
+
+server_session::server_session(
+    std::unique_ptr<transport::i_transport> transport,
+    const server_options& options)
+    : m_pimpl(std::make_unique<server_session::impl>(std::move(transport),
+                                                     options)) {}
+
+server_session::~server_session() = default;
+
+void server_session::run() {
+  m_pimpl->run();
+  return;
+}
+
+}  // namespace server
+
+}  // namespace mh2c
@@ -0,0 +1,42 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_SERVER_SERVER_SESSION_H_
+#define MH2C_SERVER_SERVER_SESSION_H_
+
+#include <memory>
+
+#include "mh2c/server/server_options.h"
+#include "mh2c/transport/i_transport.h"
+
+namespace mh2c {
+
+namespace server {
+
+// Server side of one HTTP/2 connection built from the frame codecs. It reads
+// the client connection preface, exchanges SETTINGS and answers every request
+// with the configured response_spec, honoring the peer's flow control windows
+// and SETTINGS_MAX_FRAME_SIZE.
+class server_session {
+ public:
+  server_session(std::unique_ptr<transport::i_transport> transport,
+                 const server_options& options);
+  ~server_session();
+
+  server_session(const server_session&) = delete;
+  server_session& operator=(const server_session&) = delete;
+
+  // Serves until the peer sends GOAWAY or closes the transport, or until the
+  // connection has drained after server_options::m_max_requests.
+  void run();
+
+ private:
+  class impl;
+  std::unique_ptr<impl> m_pimpl;
+};
+
+}  // namespace server
+
+}  // namespace mh2c
+
+#endif  // MH2C_SERVER_SERVER_SESSION_H_
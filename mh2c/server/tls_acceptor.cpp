@@ -0,0 +1,236 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/server/tls_acceptor.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/ssl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/net/socket_fd.h"
+#include "mh2c/ssl/ssl_ctx.h"
+#include "mh2c/transport/file_copy.h"
+#include "mh2c/transport/i_transport.h"
+
+namespace mh2c {
+
+namespace server {
+
+namespace {
+
+using ssl_ptr = std::unique_ptr<SSL, decltype(&SSL_free)>;
+
+int select_alpn(SSL*, const unsigned char** out, unsigned char* outlen,
+                const unsigned char* in, unsigned int inlen, void*) {
+  static const byte_array_t alpn_protos{0x02, 'h', '2'};
+
+  unsigned char* selected{};
+  if (SSL_select_next_proto(&selected, outlen, alpn_protos.data(),
+                            alpn_protos.size(), in,
+                            inlen) != OPENSSL_NPN_NEGOTIATED) {
+    return SSL_TLSEXT_ERR_ALERT_FATAL;
+  }
+  *out = selected;
+
+  return SSL_TLSEXT_ERR_OK;
+}
+
+bool is_closed_by_peer(SSL* ssl, const int result) {
+  const auto err = SSL_get_error(ssl, result);
+  return err == SSL_ERROR_ZERO_RETURN || err == SSL_ERROR_SYSCALL;
+}
+
+class tls_transport : public transport::i_transport {
+ public:
+  tls_transport(net::socket_fd fd, ssl_ptr ssl, byte_array_t early_data)
+      : m_fd{std::move(fd)},
+        m_ssl{std::move(ssl)},
+        m_early_data{std::move(early_data)},
+        m_early_data_offset{0} {}
+  ~tls_transport() override {
+    // HTTP/2 ends the connection, not close_notify. Without a shutdown,
+    // SSL_free() takes the session out of the cache as a bad one, and the
+    // tickets issued for it cannot be resumed.
+    SSL_set_quiet_shutdown(m_ssl.get(), 1);
+    SSL_shutdown(m_ssl.get());
+  }
+
+  void write(const uint8_t* data, const size_t length) override {
+    size_t written_length{};
+
+    while (written_length < length) {
+      const auto result = SSL_write(m_ssl.get(), data + written_length,
+                                    length - written_length);
+      if (result <= 0) {
+        if (is_closed_by_peer(m_ssl.get(), result)) {
+          throw transport::transport_closed("connection closed by peer");
+        }
+        throw std::runtime_error("SSL_write failed: result=" +
+                                 std::to_string(result));
+      }
+      written_length += result;
+    }
+
+    return;
+  }
+
+  void read(uint8_t* data, const size_t length) override {
+    const auto early_length =
+        std::min(length, m_early_data.size() - m_early_data_offset);
+    std::copy_n(m_early_data.begin() + m_early_data_offset, early_length,
+                data);
+    m_early_data_offset += early_length;
+    size_t read_length{early_length};
+
+    while (read_length < length) {
+      const auto result =
+          SSL_read(m_ssl.get(), data + read_length, length - read_length);
+      if (result <= 0) {
+        if (is_closed_by_peer(m_ssl.get(), result)) {
+          throw transport::transport_closed("connection closed by peer");
+        }
+        throw std::runtime_error("SSL_read failed: result=" +
+                                 std::to_string(result));
+      }
+      read_length += result;
+    }
+
+    return;
+  }
+
+  void sendfile(const int fd, const off_t offset,
+                const size_t length) override {
+    transport::copy_file(this, fd, offset, length);
+    return;
+  }
+
+  bool wait_readable(const std::chrono::milliseconds timeout) override {
+    return wait_readable(timeout, -1);
+  }
+
+  bool wait_readable(const std::chrono::milliseconds timeout,
+                     const int wake_fd) override {
+    if (m_early_data_offset < m_early_data.size() ||
+        SSL_pending(m_ssl.get()) > 0) {
+      return true;
+    }
+    return net::wait_for_events(m_fd.get(), POLLIN, wake_fd, timeout);
+  }
+
+ private:
+  net::socket_fd m_fd;
+  ssl_ptr m_ssl;
+  // Read by the handshake, returned before the later records
+  byte_array_t m_early_data;
+  size_t m_early_data_offset;
+};
+
+void wait_for_handshake(SSL* ssl, const int result, const int fd,
+                        const std::chrono::steady_clock::time_point deadline,
+                        const std::string& operation) {
+  const auto err = SSL_get_error(ssl, result);
+  if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
+    throw std::runtime_error(operation + " failed: err=" +
+                             std::to_string(err));
+  }
+
+  const short events = err == SSL_ERROR_WANT_READ ? POLLIN : POLLOUT;
+  const auto remain = std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - std::chrono::steady_clock::now());
+  if (remain.count() <= 0 ||
+      net::wait_for_events(fd, events, remain) == false) {
+    throw std::runtime_error(operation + " timed out");
+  }
+  return;
+}
+
+// Reads the early data of a client resuming a session, if any, up to the end
+// of the early data. A client sending none ends it at once.
+// cf. https://www.openssl.org/docs/man3.0/man3/SSL_read_early_data.html
+byte_array_t read_early_data(
+    SSL* ssl, const int fd,
+    const std::chrono::steady_clock::time_point deadline) {
+  byte_array_t early_data{};
+  byte_array_t buffer(16384u);
+  while (true) {
+    size_t read_length{};
+    const auto result =
+        SSL_read_early_data(ssl, buffer.data(), buffer.size(), &read_length);
+    early_data.insert(early_data.end(), buffer.begin(),
+                      buffer.begin() + read_length);
+    if (result == SSL_READ_EARLY_DATA_FINISH) {
+      return early_data;
+    }
+    if (result == SSL_READ_EARLY_DATA_ERROR) {
+      wait_for_handshake(ssl, result, fd, deadline, "SSL_read_early_data");
+    }
+  }
+}
+
+}  // namespace
+
+tls_acceptor::tls_acceptor(const std::string& certificate_file,
+                           const std::string& private_key_file,
+                           const uint32_t max_early_data)
+    : m_ssl_ctx(TLS_server_method()), m_max_early_data{max_early_data} {
+  if (SSL_CTX_use_certificate_chain_file(m_ssl_ctx,
+                                         certificate_file.c_str()) != 1) {
+    throw std::runtime_error("SSL_CTX_use_certificate_chain_file failed: " +
+                             certificate_file);
+  }
+  if (SSL_CTX_use_PrivateKey_file(m_ssl_ctx, private_key_file.c_str(),
+                                  SSL_FILETYPE_PEM) != 1) {
+    throw std::runtime_error("SSL_CTX_use_PrivateKey_file failed: " +
+                             private_key_file);
+  }
+
+  // cf. https://tools.ietf.org/html/rfc7540#section-9.2
+  SSL_CTX_set_min_proto_version(m_ssl_ctx, TLS1_2_VERSION);
+  SSL_CTX_set_alpn_select_cb(m_ssl_ctx, select_alpn, nullptr);
+  if (m_max_early_data > 0) {
+    SSL_CTX_set_max_early_data(m_ssl_ctx, m_max_early_data);
+  }
+}
+
+std::unique_ptr<transport::i_transport> tls_acceptor::accept(
+    net::socket_fd fd, const std::chrono::milliseconds timeout) {
+  ssl_ptr ssl{SSL_new(m_ssl_ctx), SSL_free};
+  if (ssl == nullptr || SSL_set_fd(ssl.get(), fd.get()) != 1) {
+    throw std::runtime_error("SSL_new failed");
+  }
+
+  // Frames are written whole, so Nagle only adds latency.
+  const int on{1};
+  setsockopt(fd.get(), IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+  // Handshake on the non-blocking socket, then switch back to blocking I/O
+  net::set_blocking(fd.get(), false);
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  auto early_data = m_max_early_data > 0
+                        ? read_early_data(ssl.get(), fd.get(), deadline)
+                        : byte_array_t{};
+  int result{};
+  while ((result = SSL_accept(ssl.get())) != 1) {
+    wait_for_handshake(ssl.get(), result, fd.get(), deadline, "SSL_accept");
+  }
+  net::set_blocking(fd.get(), true);
+
+  return std::make_unique<tls_transport>(std::move(fd), std::move(ssl),
+                                         std::move(early_data));
+}
+
+}  // namespace server
+
+}  // namespace mh2c
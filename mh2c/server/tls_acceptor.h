@@ -0,0 +1,44 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_SERVER_TLS_ACCEPTOR_H_
+#define MH2C_SERVER_TLS_ACCEPTOR_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "mh2c/net/socket_fd.h"
+#include "mh2c/ssl/ssl_ctx.h"
+#include "mh2c/transport/i_transport.h"
+
+namespace mh2c {
+
+namespace server {
+
+// Server side TLS handshake that only accepts clients offering "h2" by ALPN.
+// With max_early_data, the tickets it issues let a resuming client send that
+// many bytes of TLS 1.3 early data, which the transport returns first. The
+// session cache refuses a ticket used twice, so early data is not replayed
+// to the same acceptor.
+// cf. https://tools.ietf.org/html/rfc8446#section-8
+class tls_acceptor {
+ public:
+  tls_acceptor(const std::string& certificate_file,
+               const std::string& private_key_file,
+               const uint32_t max_early_data = 0);
+
+  std::unique_ptr<transport::i_transport> accept(
+      net::socket_fd fd, const std::chrono::milliseconds timeout);
+
+ private:
+  ssl::ssl_ctx m_ssl_ctx;
+  uint32_t m_max_early_data;
+};
+
+}  // namespace server
+
+}  // namespace mh2c
+
+#endif  // MH2C_SERVER_TLS_ACCEPTOR_H_
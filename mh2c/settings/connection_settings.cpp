@@ -0,0 +1,118 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/settings/connection_settings.h"
+
+#include <cstddef>
+#include <string>
+
+#include "mh2c/frame/error_codes.h"
+#include "mh2c/frame/settings_frame.h"
+#include "mh2c/util/cast.h"
+
+namespace mh2c {
+
+namespace settings {
+
+namespace {
+
+size_t get_slot(const sf_id_t id) { return id - 1u; }
+
+void validate(const sf_parameter parameter, const sf_value_t value) {
+  switch (parameter) {
+    case sf_parameter::SETTINGS_ENABLE_PUSH:
+      if (value > 1u) {
+        throw connection_error(error_codes::PROTOCOL_ERROR,
+                               "SETTINGS_ENABLE_PUSH=" + std::to_string(value));
+      }
+      break;
+    case sf_parameter::SETTINGS_INITIAL_WINDOW_SIZE:
+      if (value > MAX_INITIAL_WINDOW_SIZE) {
+        throw connection_error(
+            error_codes::FLOW_CONTROL_ERROR,
+            "SETTINGS_INITIAL_WINDOW_SIZE=" + std::to_string(value));
+      }
+      break;
+    case sf_parameter::SETTINGS_MAX_FRAME_SIZE:
+      if (value < MIN_MAX_FRAME_SIZE || value > MAX_MAX_FRAME_SIZE) {
+        throw connection_error(
+            error_codes::PROTOCOL_ERROR,
+            "SETTINGS_MAX_FRAME_SIZE=" + std::to_string(value));
+      }
+      break;
+    default:
+      break;
+  }
+
+  return;
+}
+
+}  // namespace
+
+settings_values::settings_values()
+    : m_values{DEFAULT_HEADER_TABLE_SIZE, DEFAULT_ENABLE_PUSH,
+               UNLIMITED,                 DEFAULT_INITIAL_WINDOW_SIZE,
+               MIN_MAX_FRAME_SIZE,        UNLIMITED} {}
+
+sf_value_t settings_values::get(const sf_parameter parameter) const {
+  return m_values.at(get_slot(underlying_cast(parameter)));
+}
+
+void settings_values::apply(const sf_payload_t& payload) {
+  // Validate all before applying any, so a rejected frame changes nothing.
+  for (const auto& [id, value] : payload) {
+    if (id < underlying_cast(sf_parameter::SETTINGS_HEADER_TABLE_SIZE) ||
+        id >= underlying_cast(sf_parameter::SETTINGS_UNKNOWN)) {
+      continue;
+    }
+    validate(cast_to_sf_parameter(id), value);
+  }
+
+  for (const auto& [id, value] : payload) {
+    if (id >= underlying_cast(sf_parameter::SETTINGS_HEADER_TABLE_SIZE) &&
+        id < underlying_cast(sf_parameter::SETTINGS_UNKNOWN)) {
+      m_values[get_slot(id)] = value;
+    }
+  }
+
+  return;
+}
+
+connection_settings::connection_settings()
+    : m_local{}, m_remote{}, m_unacknowledged{} {}
+
+void connection_settings::on_local_settings(const sf_payload_t& payload) {
+  m_unacknowledged.push_back(payload);
+  return;
+}
+
+bool connection_settings::on_local_ack() {
+  if (m_unacknowledged.empty()) {
+    return false;
+  }
+
+  m_local.apply(m_unacknowledged.front());
+  m_unacknowledged.pop_front();
+  return true;
+}
+
+void connection_settings::on_remote_settings(const sf_payload_t& payload) {
+  m_remote.apply(payload);
+  return;
+}
+
+const settings_values& connection_settings::get_local() const {
+  return m_local;
+}
+
+const settings_values& connection_settings::get_remote() const {
+  return m_remote;
+}
+
+size_t connection_settings::get_unacknowledged_count() const {
+  return m_unacknowledged.size();
+}
+
+}  // namespace settings
+
+}  // namespace mh2c
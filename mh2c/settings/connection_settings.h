@@ -0,0 +1,75 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_SETTINGS_CONNECTION_SETTINGS_H_
+#define MH2C_SETTINGS_CONNECTION_SETTINGS_H_
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <limits>
+
+#include "mh2c/frame/settings_frame.h"
+
+namespace mh2c {
+
+namespace settings {
+
+// cf. https://tools.ietf.org/html/rfc7540#section-6.5.2
+constexpr sf_value_t DEFAULT_HEADER_TABLE_SIZE{4096u};
+constexpr sf_value_t DEFAULT_ENABLE_PUSH{1u};
+constexpr sf_value_t DEFAULT_INITIAL_WINDOW_SIZE{65535u};
+constexpr sf_value_t MIN_MAX_FRAME_SIZE{16384u};
+constexpr sf_value_t MAX_MAX_FRAME_SIZE{16777215u};
+constexpr sf_value_t MAX_INITIAL_WINDOW_SIZE{0x7fffffffu};
+// MAX_CONCURRENT_STREAMS and MAX_HEADER_LIST_SIZE have no limit initially.
+constexpr sf_value_t UNLIMITED{std::numeric_limits<sf_value_t>::max()};
+
+// The values of the parameters defined by RFC 7540, one slot each, starting
+// from the defaults.
+class settings_values {
+ public:
+  settings_values();
+
+  sf_value_t get(const sf_parameter parameter) const;
+  // Throw connection_error for a value out of range. Unknown parameters are
+  // ignored.
+  // cf. https://tools.ietf.org/html/rfc7540#section-6.5.2
+  void apply(const sf_payload_t& payload);
+
+ private:
+  static constexpr size_t PARAMETER_SLOTS{6u};
+
+  std::array<sf_value_t, PARAMETER_SLOTS> m_values;
+};
+
+// Both sides of the SETTINGS negotiation of a connection. The values sent
+// bind the peer only once it has acknowledged them, so they are queued until
+// the matching ACK; the values received take effect immediately.
+// cf. https://tools.ietf.org/html/rfc7540#section-6.5.3
+class connection_settings {
+ public:
+  connection_settings();
+
+  void on_local_settings(const sf_payload_t& payload);
+  // Return false for an ACK no SETTINGS was waiting for
+  bool on_local_ack();
+  void on_remote_settings(const sf_payload_t& payload);
+
+  // Values acknowledged by the peer, which limit what it sends
+  const settings_values& get_local() const;
+  // Values of the peer, which limit what this endpoint sends
+  const settings_values& get_remote() const;
+  size_t get_unacknowledged_count() const;
+
+ private:
+  settings_values m_local;
+  settings_values m_remote;
+  std::deque<sf_payload_t> m_unacknowledged;
+};
+
+}  // namespace settings
+
+}  // namespace mh2c
+
+#endif  // MH2C_SETTINGS_CONNECTION_SETTINGS_H_
@@ -4,6 +4,7 @@
 #include "mh2c/ssl/ssl_bio.h"
 
 #include <openssl/ssl.h>
+#include <unistd.h>
 
 #include <stdexcept>
 #include <string>
@@ -14,11 +15,20 @@ namespace mh2c {
 
 namespace ssl {
 
-ssl_bio::ssl_bio(const ssl_ctx& ssl_ctx)
-    : m_ssl_bio(BIO_new_ssl_connect(ssl_ctx)) {
+ssl_bio::ssl_bio(const ssl_ctx& ssl_ctx, const int fd)
+    : m_ssl_bio(BIO_new_ssl(ssl_ctx, 1)) {
   if (m_ssl_bio == nullptr) {
-    throw std::runtime_error("BIO_new_ssl_connect failed");
+    close(fd);
+    throw std::runtime_error("BIO_new_ssl failed");
   }
+
+  auto socket_bio = BIO_new_socket(fd, BIO_CLOSE);
+  if (socket_bio == nullptr) {
+    close(fd);
+    BIO_free_all(m_ssl_bio);
+    throw std::runtime_error("BIO_new_socket failed");
+  }
+  BIO_push(m_ssl_bio, socket_bio);
 }
 
 ssl_bio::~ssl_bio() { BIO_free_all(m_ssl_bio); }
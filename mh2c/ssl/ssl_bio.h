@@ -14,7 +14,8 @@ namespace ssl {
 
 class ssl_bio {
  public:
-  explicit ssl_bio(const ssl_ctx& ssl_ctx);
+  // Takes ownership of the connected socket.
+  ssl_bio(const ssl_ctx& ssl_ctx, const int fd);
   ~ssl_bio();
 
   ssl_bio(const ssl_bio&) = delete;
@@ -3,18 +3,35 @@
 // See accompanying file LICENSE.
 #include "mh2c/ssl/ssl_connection.h"
 
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <openssl/err.h>
 #include <openssl/ssl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <stdexcept>
 #include <string>
+#include <utility>
 
 #include "mh2c/common/byte_array.h"
+#include "mh2c/net/connect_options.h"
+#include "mh2c/net/socket_fd.h"
+#include "mh2c/net/tcp_connector.h"
 #include "mh2c/ssl/ssl_bio.h"
 #include "mh2c/ssl/ssl_ctx.h"
+#include "mh2c/ssl/ssl_ktls_mode.h"
+#include "mh2c/ssl/ssl_session_cache.h"
 #include "mh2c/ssl/ssl_verify_mode.h"
+#include "mh2c/transport/file_copy.h"
+#include "mh2c/transport/i_transport.h"
 
 namespace mh2c {
 
@@ -23,84 +40,151 @@ namespace ssl {
 namespace {
 std::once_flag load_once;
 
+const byte_array_t ALPN_PROTOS{0x02, 'h', '2'};
+// cf. https://tools.ietf.org/html/rfc8446#section-5.1
+constexpr size_t MAX_RECORD_PLAINTEXT_BYTES{16384u};
+
 void load_ssl_lib() {
   SSL_library_init();
   SSL_load_error_strings();
 }
 
+void enable_ktls(SSL* ssl) {
+#ifdef SSL_OP_ENABLE_KTLS
+  // OpenSSL installs the keys into the kernel once the handshake completes.
+  SSL_set_options(ssl, SSL_OP_ENABLE_KTLS);
+#else
+  static_cast<void>(ssl);
+#endif
+  return;
+}
+
+ktls_status check_ktls_status(SSL* ssl) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  return {BIO_get_ktls_send(SSL_get_wbio(ssl)) != 0,
+          BIO_get_ktls_recv(SSL_get_rbio(ssl)) != 0};
+#else
+  // Earlier versions cannot offload, whatever the kernel supports.
+  static_cast<void>(ssl);
+  return {false, false};
+#endif
+}
+
+void wait_for_handshake(const int fd, const short events,
+                        const std::chrono::steady_clock::time_point deadline,
+                        const std::string& operation) {
+  const auto remain = std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - std::chrono::steady_clock::now());
+  if (remain.count() <= 0 ||
+      net::wait_for_events(fd, events, remain) == false) {
+    throw std::runtime_error(operation + " timed out");
+  }
+  return;
+}
+
+void do_handshake(BIO* ssl_bio, const int fd,
+                  const std::chrono::milliseconds timeout) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+  while (BIO_do_handshake(ssl_bio) <= 0) {
+    if (BIO_should_retry(ssl_bio) == false) {
+      int err_code = errno;
+      throw std::runtime_error("BIO_do_handshake failed: err_code=" +
+                               std::to_string(err_code));
+    }
+
+    wait_for_handshake(fd, BIO_should_read(ssl_bio) ? POLLIN : POLLOUT,
+                       deadline, "BIO_do_handshake");
+  }
+
+  return;
+}
+
+// Takes a resumable session out of the cache and sets it to ssl. Returns the
+// early data limit of the session, 0 when there is none.
+uint32_t resume_session(SSL* ssl, session_cache* cache,
+                        const std::string& server) {
+  const auto der = cache->take(server);
+  const uint8_t* in = der.data();
+  SSL_SESSION* session =
+      der.empty() ? nullptr : d2i_SSL_SESSION(nullptr, &in, der.size());
+  if (session == nullptr) {
+    return 0;
+  }
+
+  // A session that cannot be resumed leaves a full handshake.
+  const auto is_set = SSL_set_session(ssl, session) == 1;
+  const auto max_early_data = SSL_SESSION_get_max_early_data(session);
+  SSL_SESSION_free(session);
+  return is_set ? max_early_data : 0;
+}
+
 }  // namespace
 
 ssl_connection::ssl_connection(const std::string& hostname, const uint16_t port,
-                               const verify_mode mode)
-    : m_ssl_ctx(ssl::ssl_ctx{}), m_ssl_bio(m_ssl_ctx) {
+                               const verify_mode mode, const ktls_mode ktls,
+                               const net::connect_options& options)
+    : m_fd{net::connect_tcp(hostname, port, options).release()},
+      m_ssl_bio(get_client_ctx(), m_fd),
+      m_verify_mode{mode},
+      m_ktls_mode{ktls},
+      m_options{options},
+      m_server{hostname + ':' + std::to_string(port)},
+      m_ktls_status{},
+      m_early_data_status{early_data_status::NOT_SENT},
+      m_early_data{},
+      m_write_buffer{},
+      m_max_early_data{0} {
   // Setup
   std::call_once(load_once, load_ssl_lib);
 
-  const auto host_port = hostname + ":" + std::to_string(port);
-  BIO_set_conn_hostname(m_ssl_bio, host_port.c_str());
+  // Frames are written whole, so Nagle only adds latency; it would also hold
+  // back early data written after the first record.
+  const int on{1};
+  setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
 
-  SSL* ssl{};
-  BIO_get_ssl(m_ssl_bio, &ssl);
-  if (ssl == nullptr) {
-    throw std::runtime_error("BIO_get_ssl failed");
-  }
+  SSL* ssl = get_ssl();
   SSL_set_mode(ssl, SSL_MODE_AUTO_RETRY);
+  SSL_set_tlsext_host_name(ssl, hostname.c_str());
+  if (ktls == ktls_mode::ENABLED) {
+    enable_ktls(ssl);
+  }
 
-  static const byte_array_t alpn_protos{0x02, 'h', '2'};
-  auto err = SSL_set_alpn_protos(ssl, alpn_protos.data(), alpn_protos.size());
+  const auto err =
+      SSL_set_alpn_protos(ssl, ALPN_PROTOS.data(), ALPN_PROTOS.size());
   if (err != 0) {
     throw std::runtime_error("SSL_set_alpn_protos failed: err=" +
                              std::to_string(err));
   }
 
-  err = SSL_CTX_set_default_verify_paths(m_ssl_ctx);
-  if (err != 1) {
-    throw std::runtime_error("SSL_CTX_set_default_verify_paths failed: err=" +
-                             std::to_string(err));
-  }
-
-  // Connect
-  err = BIO_do_connect(m_ssl_bio);
-  if (err <= 0) {
-    int err_code = errno;
-    throw std::runtime_error("BIO_do_connect failed: err_code=" +
-                             std::to_string(err_code));
-  }
-
-  err = BIO_do_handshake(m_ssl_bio);
-  if (err <= 0) {
-    int err_code = errno;
-    throw std::runtime_error("BIO_do_handshake failed: err_code=" +
-                             std::to_string(err_code));
-  }
-
-  // Check verification result
-  if (mode != verify_mode::VERIFY_NONE) {
-    const auto verify_result = SSL_get_verify_result(ssl);
-    if (verify_result != X509_V_OK) {
-      throw std::runtime_error("SSL_get_verify_result failed: verify_result=" +
-                               std::to_string(verify_result));
-    }
+  if (m_options.m_session_cache) {
+    SSL_set_app_data(ssl, this);
+    m_max_early_data =
+        resume_session(ssl, m_options.m_session_cache.get(), m_server);
   }
 
-  // Check ALPN result
-  const unsigned char* alpn_result;
-  unsigned int alpn_result_len;
-  SSL_get0_alpn_selected(ssl, &alpn_result, &alpn_result_len);
-
-  std::string alpn_str{reinterpret_cast<const char*>(alpn_result),
-                       alpn_result_len};
-  const bool is_expected_result =
-      (alpn_result_len == alpn_protos.size() - 1) &&
-      std::equal(alpn_str.begin(), alpn_str.end(), &alpn_protos[1]);
-  if (is_expected_result == false) {
-    throw std::runtime_error("unexpected alpn result: alpn_result=" + alpn_str);
+  // ClientHello goes out with the first early data.
+  if (m_options.m_early_data && m_max_early_data > 0) {
+    m_early_data_status = early_data_status::PENDING;
+    return;
   }
 
+  // Handshake on the non-blocking socket, then switch back to blocking I/O
+  do_handshake(m_ssl_bio, m_fd, m_options.m_handshake_timeout);
+  net::set_blocking(m_fd, true);
+  check_handshake_result();
   return;
 }
 
 void ssl_connection::write(const uint8_t* data, const size_t length) {
+  if (m_early_data_status == early_data_status::PENDING) {
+    if (m_early_data.size() + length <= m_max_early_data) {
+      write_early_data(data, length);
+      return;
+    }
+    complete_handshake();
+  }
+
   size_t written_length{};
 
   while (written_length < length) {
@@ -118,13 +202,51 @@ void ssl_connection::write(const uint8_t* data, const size_t length) {
   return;
 }
 
+void ssl_connection::writev(const iovec* vectors, const size_t count) {
+  m_write_buffer.clear();
+  for (size_t i = 0; i < count; ++i) {
+    auto data = static_cast<const uint8_t*>(vectors[i].iov_base);
+    auto length = vectors[i].iov_len;
+    while (length > 0) {
+      // Whole records straight from the buffer, without joining them first
+      if (m_write_buffer.empty() && length >= MAX_RECORD_PLAINTEXT_BYTES) {
+        const auto record_length =
+            length - length % MAX_RECORD_PLAINTEXT_BYTES;
+        write(data, record_length);
+        data += record_length;
+        length -= record_length;
+        continue;
+      }
+
+      const auto joined_length = std::min(
+          length, MAX_RECORD_PLAINTEXT_BYTES - m_write_buffer.size());
+      m_write_buffer.insert(m_write_buffer.end(), data, data + joined_length);
+      data += joined_length;
+      length -= joined_length;
+      if (m_write_buffer.size() == MAX_RECORD_PLAINTEXT_BYTES) {
+        write(m_write_buffer.data(), m_write_buffer.size());
+        m_write_buffer.clear();
+      }
+    }
+  }
+
+  if (m_write_buffer.empty() == false) {
+    write(m_write_buffer.data(), m_write_buffer.size());
+  }
+  return;
+}
+
 void ssl_connection::read(uint8_t* data, const size_t length) {
+  complete_handshake();
   size_t read_length{};
 
   while (read_length < length) {
     const auto remain_length = length - read_length;
     const auto result = BIO_read(m_ssl_bio, data + read_length, remain_length);
-    if (result <= 0) {
+    if (result == 0) {
+      throw transport::transport_closed("connection closed by peer");
+    }
+    if (result < 0) {
       throw std::runtime_error(
           "BIO_read failed: result=" + std::to_string(result) +
           ", length=" + std::to_string(length));
@@ -135,6 +257,199 @@ void ssl_connection::read(uint8_t* data, const size_t length) {
   return;
 }
 
+void ssl_connection::sendfile(const int fd, const off_t offset,
+                              const size_t length) {
+  complete_handshake();
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  if (m_ktls_status.m_send) {
+    SSL* ssl = get_ssl();
+    size_t sent_length{};
+    while (sent_length < length) {
+      const auto result = SSL_sendfile(ssl, fd, offset + sent_length,
+                                       length - sent_length, 0);
+      if (result <= 0) {
+        throw std::runtime_error(
+            "SSL_sendfile failed: result=" + std::to_string(result) +
+            ", length=" + std::to_string(length));
+      }
+      sent_length += result;
+    }
+    return;
+  }
+#endif
+
+  transport::copy_file(this, fd, offset, length);
+  return;
+}
+
+bool ssl_connection::wait_readable(const std::chrono::milliseconds timeout) {
+  return wait_readable(timeout, -1);
+}
+
+bool ssl_connection::wait_readable(const std::chrono::milliseconds timeout,
+                                   const int wake_fd) {
+  complete_handshake();
+  // Decrypted data may already be buffered inside OpenSSL.
+  if (BIO_pending(m_ssl_bio) > 0) {
+    return true;
+  }
+  return net::wait_for_events(m_fd, POLLIN, wake_fd, timeout);
+}
+
+ktls_status ssl_connection::get_ktls_status() const { return m_ktls_status; }
+
+early_data_status ssl_connection::get_early_data_status() const {
+  return m_early_data_status;
+}
+
+void ssl_connection::complete_handshake() {
+  if (m_early_data_status != early_data_status::PENDING) {
+    return;
+  }
+
+  do_handshake(m_ssl_bio, m_fd, m_options.m_handshake_timeout);
+  net::set_blocking(m_fd, true);
+  switch (SSL_get_early_data_status(get_ssl())) {
+    case SSL_EARLY_DATA_ACCEPTED:
+      m_early_data_status = early_data_status::ACCEPTED;
+      break;
+    case SSL_EARLY_DATA_REJECTED:
+      m_early_data_status = early_data_status::REJECTED;
+      break;
+    default:
+      m_early_data_status = early_data_status::NOT_SENT;
+      break;
+  }
+  check_handshake_result();
+
+  // The server skipped the early data without processing any of it.
+  // cf. https://tools.ietf.org/html/rfc8446#section-4.2.10
+  const auto early_data = std::exchange(m_early_data, {});
+  if (m_early_data_status == early_data_status::REJECTED) {
+    write(early_data.data(), early_data.size());
+  }
+  return;
+}
+
+const ssl_ctx& ssl_connection::get_client_ctx() {
+  static const auto client_ctx = []() {
+    auto ctx = std::make_unique<ssl_ctx>();
+    const auto err = SSL_CTX_set_default_verify_paths(*ctx);
+    if (err != 1) {
+      throw std::runtime_error(
+          "SSL_CTX_set_default_verify_paths failed: err=" +
+          std::to_string(err));
+    }
+
+    // TLS 1.3 tickets arrive after the handshake, so they are stored from
+    // the callback as the reads process them.
+    // cf. https://tools.ietf.org/html/rfc8446#section-4.6.1
+    SSL_CTX_set_session_cache_mode(
+        *ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(*ctx, new_session_callback);
+    return ctx;
+  }();
+  return *client_ctx;
+}
+
+SSL* ssl_connection::get_ssl() const {
+  SSL* ssl{};
+  BIO_get_ssl(m_ssl_bio, &ssl);
+  if (ssl == nullptr) {
+    throw std::runtime_error("BIO_get_ssl failed");
+  }
+  return ssl;
+}
+
+void ssl_connection::write_early_data(const uint8_t* data,
+                                      const size_t length) {
+  SSL* ssl = get_ssl();
+  const auto deadline =
+      std::chrono::steady_clock::now() + m_options.m_handshake_timeout;
+  size_t written_length{};
+
+  while (written_length < length) {
+    size_t written{};
+    const auto result = SSL_write_early_data(
+        ssl, data + written_length, length - written_length, &written);
+    if (result == 1) {
+      written_length += written;
+      continue;
+    }
+
+    const auto err = SSL_get_error(ssl, result);
+    if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
+      throw std::runtime_error("SSL_write_early_data failed: err=" +
+                               std::to_string(err));
+    }
+    wait_for_handshake(m_fd, err == SSL_ERROR_WANT_READ ? POLLIN : POLLOUT,
+                       deadline, "SSL_write_early_data");
+  }
+
+  m_early_data.insert(m_early_data.end(), data, data + length);
+  return;
+}
+
+void ssl_connection::check_handshake_result() {
+  SSL* ssl = get_ssl();
+
+  // Check verification result
+  if (m_verify_mode != verify_mode::VERIFY_NONE) {
+    const auto verify_result = SSL_get_verify_result(ssl);
+    if (verify_result != X509_V_OK) {
+      throw std::runtime_error("SSL_get_verify_result failed: verify_result=" +
+                               std::to_string(verify_result));
+    }
+  }
+
+  // Check ALPN result
+  const unsigned char* alpn_result;
+  unsigned int alpn_result_len;
+  SSL_get0_alpn_selected(ssl, &alpn_result, &alpn_result_len);
+
+  std::string alpn_str{reinterpret_cast<const char*>(alpn_result),
+                       alpn_result_len};
+  const bool is_expected_result =
+      (alpn_result_len == ALPN_PROTOS.size() - 1) &&
+      std::equal(alpn_str.begin(), alpn_str.end(), &ALPN_PROTOS[1]);
+  if (is_expected_result == false) {
+    throw std::runtime_error("unexpected alpn result: alpn_result=" + alpn_str);
+  }
+
+  // Check kTLS result. Both directions fall back to user space silently.
+  if (m_ktls_mode == ktls_mode::ENABLED) {
+    m_ktls_status = check_ktls_status(ssl);
+  }
+
+  return;
+}
+
+void ssl_connection::store_session(SSL_SESSION* session) {
+  if (SSL_SESSION_is_resumable(session) == 0) {
+    return;
+  }
+  const auto length = i2d_SSL_SESSION(session, nullptr);
+  if (length <= 0) {
+    return;
+  }
+
+  byte_array_t der(length);
+  auto out = der.data();
+  i2d_SSL_SESSION(session, &out);
+  m_options.m_session_cache->store(m_server, der);
+  return;
+}
+
+int ssl_connection::new_session_callback(SSL* ssl, SSL_SESSION* session) {
+  // Set only with a session cache
+  const auto connection = static_cast<ssl_connection*>(SSL_get_app_data(ssl));
+  if (connection != nullptr) {
+    connection->store_session(session);
+  }
+  // The session is kept in DER, so OpenSSL may free it.
+  return 0;
+}
+
 }  // namespace ssl
 
 }  // namespace mh2c
@@ -4,34 +4,88 @@
 #ifndef MH2C_SSL_SSL_CONNECTION_H_
 #define MH2C_SSL_SSL_CONNECTION_H_
 
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <chrono>
 #include <cstdint>
+#include <memory>
 #include <string>
 
 #include "mh2c/common/byte_array.h"
+#include "mh2c/net/connect_options.h"
 #include "mh2c/ssl/ssl_bio.h"
 #include "mh2c/ssl/ssl_ctx.h"
+#include "mh2c/ssl/ssl_ktls_mode.h"
+#include "mh2c/ssl/ssl_session_cache.h"
 #include "mh2c/ssl/ssl_verify_mode.h"
+#include "mh2c/transport/i_transport.h"
 
 namespace mh2c {
 
 namespace ssl {
 
-class ssl_connection {
+// With net::connect_options::m_early_data on a session that allows it, the
+// constructor only sends ClientHello and the handshake completes on the
+// first read, wait_readable() or sendfile(), or once the writes outgrow the
+// early data limit of the session. The handshake errors are thrown there.
+class ssl_connection : public transport::i_transport {
  public:
   ssl_connection(const std::string& hostname, const uint16_t port,
-                 const verify_mode mode);
+                 const verify_mode mode,
+                 const ktls_mode ktls = ktls_mode::DISABLED,
+                 const net::connect_options& options = {});
 
   ssl_connection(const ssl_connection&) = delete;
   ssl_connection& operator=(const ssl_connection&) = delete;
   ssl_connection(ssl_connection&&) = delete;
   ssl_connection&& operator=(ssl_connection&&) = delete;
 
-  void write(const uint8_t* data, const size_t length);
-  void read(uint8_t* data, const size_t length);
+  void write(const uint8_t* data, const size_t length) override;
+  // Fills each TLS record up to its limit across the buffers, so that a frame
+  // header and its payload, or control frames and the frame after them, do
+  // not go out as records of their own.
+  void writev(const iovec* vectors, const size_t count) override;
+  void read(uint8_t* data, const size_t length) override;
+  void sendfile(const int fd, const off_t offset,
+                const size_t length) override;
+  bool wait_readable(const std::chrono::milliseconds timeout) override;
+  bool wait_readable(const std::chrono::milliseconds timeout,
+                     const int wake_fd) override;
+
+  ktls_status get_ktls_status() const;
+  early_data_status get_early_data_status() const;
+  // Completes the handshake if early data is pending, sending the early data
+  // again when the server rejected it. Call it before writing anything that
+  // is not safe to be replayed.
+  // cf. https://tools.ietf.org/html/rfc8470#section-5.1
+  void complete_handshake();
 
  private:
-  ssl_ctx m_ssl_ctx;
+  SSL* get_ssl() const;
+  void write_early_data(const uint8_t* data, const size_t length);
+  void check_handshake_result();
+  void store_session(SSL_SESSION* session);
+
+  // Loading the default verify paths reads the whole CA bundle, so the
+  // connections share one context.
+  static const ssl_ctx& get_client_ctx();
+  static int new_session_callback(SSL* ssl, SSL_SESSION* session);
+
+  int m_fd;  // Owned by m_ssl_bio
   ssl_bio m_ssl_bio;
+  verify_mode m_verify_mode;
+  ktls_mode m_ktls_mode;
+  net::connect_options m_options;
+  // "hostname:port" in m_options.m_session_cache
+  std::string m_server;
+  ktls_status m_ktls_status;
+  early_data_status m_early_data_status;
+  // Written as early data, kept to be sent again on rejection
+  byte_array_t m_early_data;
+  // Reused by writev() to join the buffers
+  byte_array_t m_write_buffer;
+  uint32_t m_max_early_data;
 };
 
 }  // namespace ssl
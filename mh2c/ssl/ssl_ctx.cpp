@@ -12,7 +12,9 @@ namespace mh2c {
 
 namespace ssl {
 
-ssl_ctx::ssl_ctx() : m_ssl_ctx(SSL_CTX_new(TLS_client_method())) {
+ssl_ctx::ssl_ctx() : ssl_ctx(TLS_client_method()) {}
+
+ssl_ctx::ssl_ctx(const SSL_METHOD* method) : m_ssl_ctx(SSL_CTX_new(method)) {
   if (m_ssl_ctx == nullptr) {
     throw std::runtime_error("SSL_CTX_new failed");
   }
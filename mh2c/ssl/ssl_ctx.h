@@ -13,6 +13,7 @@ namespace ssl {
 class ssl_ctx {
  public:
   ssl_ctx();
+  explicit ssl_ctx(const SSL_METHOD* method);
   ~ssl_ctx();
 
   ssl_ctx(const ssl_ctx&) = delete;
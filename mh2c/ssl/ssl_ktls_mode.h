@@ -0,0 +1,30 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_SSL_SSL_KTLS_MODE_H_
+#define MH2C_SSL_SSL_KTLS_MODE_H_
+
+#include <cstdint>
+
+namespace mh2c {
+
+namespace ssl {
+
+// Kernel TLS offload is only a request. The kernel or the negotiated cipher
+// may not support it, in which case records stay in user space.
+enum class ktls_mode : uint8_t {
+  DISABLED,
+  ENABLED,
+};
+
+// Which directions are actually offloaded after the handshake.
+struct ktls_status {
+  bool m_send;
+  bool m_receive;
+};
+
+}  // namespace ssl
+
+}  // namespace mh2c
+
+#endif  // MH2C_SSL_SSL_KTLS_MODE_H_
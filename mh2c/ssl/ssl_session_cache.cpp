@@ -0,0 +1,39 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/ssl/ssl_session_cache.h"
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "mh2c/common/byte_array.h"
+
+namespace mh2c {
+
+namespace ssl {
+
+session_cache::session_cache() : m_mutex{}, m_sessions{} {}
+
+void session_cache::store(const std::string& server,
+                          const byte_array_t& session) {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  m_sessions[server] = session;
+  return;
+}
+
+byte_array_t session_cache::take(const std::string& server) {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  auto node = m_sessions.extract(server);
+  return node.empty() ? byte_array_t{} : std::move(node.mapped());
+}
+
+size_t session_cache::get_size() const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return m_sessions.size();
+}
+
+}  // namespace ssl
+
+}  // namespace mh2c
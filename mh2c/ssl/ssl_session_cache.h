@@ -0,0 +1,58 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_SSL_SSL_SESSION_CACHE_H_
+#define MH2C_SSL_SSL_SESSION_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "mh2c/common/byte_array.h"
+
+namespace mh2c {
+
+namespace ssl {
+
+// What became of the TLS 1.3 early data of a connection.
+// cf. https://tools.ietf.org/html/rfc8446#section-4.2.10
+enum class early_data_status : uint8_t {
+  // Disabled, or no resumable session allowed it
+  NOT_SENT,
+  // Sent; the handshake has not completed yet
+  PENDING,
+  ACCEPTED,
+  // The server did not take it, so it was sent again after the handshake.
+  REJECTED,
+};
+
+// Sessions the servers issued, in DER, keyed by "hostname:port". A session
+// is taken out when a connection resumes it, and the connection stores the
+// tickets the server issues in turn, so a ticket is never used twice.
+// Shared by the connections to the servers; every member is thread-safe.
+// cf. https://tools.ietf.org/html/rfc8446#appendix-C.4
+class session_cache {
+ public:
+  session_cache();
+
+  session_cache(const session_cache&) = delete;
+  session_cache& operator=(const session_cache&) = delete;
+
+  // Keeps the latest session of the server.
+  void store(const std::string& server, const byte_array_t& session);
+  // Removes and returns the session of the server, empty when there is none.
+  byte_array_t take(const std::string& server);
+  size_t get_size() const;
+
+ private:
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, byte_array_t> m_sessions;
+};
+
+}  // namespace ssl
+
+}  // namespace mh2c
+
+#endif  // MH2C_SSL_SSL_SESSION_CACHE_H_
@@ -0,0 +1,62 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/stream/latency_breakdown.h"
+
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+
+#include "mh2c/metrics/latency_histogram.h"
+
+namespace mh2c {
+
+namespace stream {
+
+namespace {
+
+void print_phase(std::ostream& out_stream, const char* name,
+                 const metrics::latency_histogram& histogram) {
+  const auto to_us = [](const std::chrono::nanoseconds value) {
+    return value.count() / 1000.0;
+  };
+
+  out_stream << std::left << std::setw(18) << name << std::right
+             << "count " << histogram.get_count() << ", min "
+             << to_us(histogram.get_min()) << "us, mean "
+             << to_us(histogram.get_mean()) << "us, p50 "
+             << to_us(histogram.get_percentile(0.5)) << "us, p90 "
+             << to_us(histogram.get_percentile(0.9)) << "us, p99 "
+             << to_us(histogram.get_percentile(0.99)) << "us, p99.9 "
+             << to_us(histogram.get_percentile(0.999)) << "us, max "
+             << to_us(histogram.get_max()) << "us\n";
+  return;
+}
+
+}  // namespace
+
+latency_breakdown& latency_breakdown::operator+=(
+    const latency_breakdown& other) {
+  m_queued += other.m_queued;
+  m_response_headers += other.m_response_headers;
+  m_first_data += other.m_first_data;
+  m_end_stream += other.m_end_stream;
+  m_completed_streams += other.m_completed_streams;
+  m_reset_streams += other.m_reset_streams;
+  return *this;
+}
+
+std::ostream& operator<<(std::ostream& out_stream,
+                         const latency_breakdown& breakdown) {
+  out_stream << "streams: " << breakdown.m_completed_streams << " completed, "
+             << breakdown.m_reset_streams << " reset\n";
+  print_phase(out_stream, "queued", breakdown.m_queued);
+  print_phase(out_stream, "response headers", breakdown.m_response_headers);
+  print_phase(out_stream, "first data", breakdown.m_first_data);
+  print_phase(out_stream, "end stream", breakdown.m_end_stream);
+  return out_stream;
+}
+
+}  // namespace stream
+
+}  // namespace mh2c
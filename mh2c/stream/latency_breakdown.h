@@ -0,0 +1,44 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_STREAM_LATENCY_BREAKDOWN_H_
+#define MH2C_STREAM_LATENCY_BREAKDOWN_H_
+
+#include <cstdint>
+#include <ostream>
+
+#include "mh2c/metrics/latency_histogram.h"
+
+namespace mh2c {
+
+namespace stream {
+
+// Phases of the requests completed on a connection. All but m_queued are
+// measured from the moment the request HEADERS were written.
+struct latency_breakdown {
+  // From http2_client::mark_stream_queued() to the HEADERS written
+  metrics::latency_histogram m_queued{};
+  // To the first response HEADERS received
+  metrics::latency_histogram m_response_headers{};
+  // To the first DATA received
+  metrics::latency_histogram m_first_data{};
+  // To END_STREAM received
+  metrics::latency_histogram m_end_stream{};
+
+  uint64_t m_completed_streams{};
+  // Streams reset before the response ended, not part of the histograms
+  uint64_t m_reset_streams{};
+
+  latency_breakdown& operator+=(const latency_breakdown& other);
+};
+
+// One line per phase with its count, min, mean, percentiles and max in
+// microseconds
+std::ostream& operator<<(std::ostream& out_stream,
+                         const latency_breakdown& breakdown);
+
+}  // namespace stream
+
+}  // namespace mh2c
+
+#endif  // MH2C_STREAM_LATENCY_BREAKDOWN_H_
@@ -0,0 +1,217 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/stream/priority_scheduler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/priority_frame.h"
+
+namespace mh2c {
+
+namespace stream {
+
+namespace {
+
+constexpr uint64_t MAX_WEIGHT{256u};
+
+}  // namespace
+
+priority_scheduler::priority_scheduler() : m_nodes{} {
+  m_nodes.emplace(0u, node{0u, MAX_WEIGHT, {}, false, 0u, 0u});
+}
+
+void priority_scheduler::set_priority(const fh_stream_id_t stream_id,
+                                      const priority_payload& priority) {
+  if (stream_id == 0 || priority.m_stream_dependency == stream_id) {
+    throw std::invalid_argument("stream " + std::to_string(stream_id) +
+                                " cannot depend on stream " +
+                                std::to_string(priority.m_stream_dependency));
+  }
+
+  auto parent = priority.m_stream_dependency;
+  uint16_t weight = priority.m_weight + 1u;
+  bool exclusive = priority.m_exclusive != 0;
+  // cf. https://tools.ietf.org/html/rfc7540#section-5.3.1
+  if (contains(parent) == false) {
+    parent = 0;
+    weight = DEFAULT_WIRE_WEIGHT + 1u;
+    exclusive = false;
+  }
+
+  if (contains(stream_id)) {
+    if (is_descendant(parent, stream_id)) {
+      const auto former_parent = m_nodes.at(stream_id).m_parent;
+      detach(parent);
+      attach(parent, former_parent, false);
+    }
+    detach(stream_id);
+  } else {
+    m_nodes.emplace(stream_id, node{0u, weight, {}, false, 0u, 0u});
+  }
+
+  m_nodes.at(stream_id).m_weight = weight;
+  attach(stream_id, parent, exclusive);
+  return;
+}
+
+void priority_scheduler::remove_stream(const fh_stream_id_t stream_id) {
+  const auto ite = m_nodes.find(stream_id);
+  if (stream_id == 0 || ite == m_nodes.end()) {
+    return;
+  }
+
+  const auto& target = ite->second;
+  detach(stream_id);
+  uint64_t total_weight{};
+  for (const auto child_id : target.m_children) {
+    total_weight += m_nodes.at(child_id).m_weight;
+  }
+  auto& parent = m_nodes.at(target.m_parent);
+  for (const auto child_id : target.m_children) {
+    auto& child = m_nodes.at(child_id);
+    child.m_weight = static_cast<uint16_t>(std::max<uint64_t>(
+        1u, child.m_weight * target.m_weight / total_weight));
+    child.m_parent = target.m_parent;
+    parent.m_children.push_back(child_id);
+  }
+
+  m_nodes.erase(ite);
+  return;
+}
+
+void priority_scheduler::set_ready(const fh_stream_id_t stream_id,
+                                   const bool ready) {
+  const auto ite = m_nodes.find(stream_id);
+  if (ite != m_nodes.end()) {
+    ite->second.m_ready = ready;
+  } else if (ready) {
+    add_default(stream_id).m_ready = true;
+  }
+  return;
+}
+
+fh_stream_id_t priority_scheduler::select() {
+  fh_stream_id_t current{0};
+  while (true) {
+    auto& current_node = m_nodes.at(current);
+    if (current != 0 && current_node.m_ready) {
+      return current;
+    }
+
+    node* best{nullptr};
+    fh_stream_id_t best_id{0};
+    uint64_t best_pass{};
+    for (const auto child_id : current_node.m_children) {
+      auto& child = m_nodes.at(child_id);
+      if (has_ready(child) == false) {
+        continue;
+      }
+      const auto pass = std::max(child.m_pass, current_node.m_virtual_time);
+      if (best == nullptr || pass < best_pass) {
+        best = &child;
+        best_id = child_id;
+        best_pass = pass;
+      }
+    }
+    if (best == nullptr) {
+      return 0;
+    }
+
+    best->m_pass = best_pass;
+    current_node.m_virtual_time = best_pass;
+    current = best_id;
+  }
+}
+
+void priority_scheduler::on_sent(const fh_stream_id_t stream_id,
+                                 const size_t length) {
+  auto current = stream_id;
+  while (current != 0) {
+    auto& current_node = m_nodes.at(current);
+    current_node.m_pass += length * MAX_WEIGHT / current_node.m_weight;
+    current = current_node.m_parent;
+  }
+  return;
+}
+
+bool priority_scheduler::contains(const fh_stream_id_t stream_id) const {
+  return m_nodes.find(stream_id) != m_nodes.end();
+}
+
+fh_stream_id_t priority_scheduler::get_parent(
+    const fh_stream_id_t stream_id) const {
+  return m_nodes.at(stream_id).m_parent;
+}
+
+uint16_t priority_scheduler::get_weight(const fh_stream_id_t stream_id) const {
+  return m_nodes.at(stream_id).m_weight;
+}
+
+priority_scheduler::node& priority_scheduler::add_default(
+    const fh_stream_id_t stream_id) {
+  auto& target =
+      m_nodes
+          .emplace(stream_id,
+                   node{0u, DEFAULT_WIRE_WEIGHT + 1u, {}, false, 0u, 0u})
+          .first->second;
+  attach(stream_id, 0u, false);
+  return target;
+}
+
+void priority_scheduler::attach(const fh_stream_id_t stream_id,
+                                const fh_stream_id_t parent,
+                                const bool exclusive) {
+  auto& parent_node = m_nodes.at(parent);
+  auto& target = m_nodes.at(stream_id);
+  // cf. https://tools.ietf.org/html/rfc7540#section-5.3.3
+  if (exclusive) {
+    for (const auto child_id : parent_node.m_children) {
+      m_nodes.at(child_id).m_parent = stream_id;
+      target.m_children.push_back(child_id);
+    }
+    parent_node.m_children.clear();
+  }
+
+  parent_node.m_children.push_back(stream_id);
+  target.m_parent = parent;
+  return;
+}
+
+void priority_scheduler::detach(const fh_stream_id_t stream_id) {
+  auto& siblings = m_nodes.at(m_nodes.at(stream_id).m_parent).m_children;
+  siblings.erase(std::find(siblings.begin(), siblings.end(), stream_id));
+  return;
+}
+
+bool priority_scheduler::is_descendant(const fh_stream_id_t stream_id,
+                                       const fh_stream_id_t ancestor) const {
+  auto current = stream_id;
+  while (current != 0) {
+    current = m_nodes.at(current).m_parent;
+    if (current == ancestor) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool priority_scheduler::has_ready(const node& target) const {
+  if (target.m_ready) {
+    return true;
+  }
+  return std::any_of(target.m_children.begin(), target.m_children.end(),
+                     [this](const fh_stream_id_t child_id) {
+                       return has_ready(m_nodes.at(child_id));
+                     });
+}
+
+}  // namespace stream
+
+}  // namespace mh2c
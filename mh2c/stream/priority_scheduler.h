@@ -0,0 +1,83 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_STREAM_PRIORITY_SCHEDULER_H_
+#define MH2C_STREAM_PRIORITY_SCHEDULER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/priority_frame.h"
+
+namespace mh2c {
+
+namespace stream {
+
+// Orders the output of concurrent streams by the dependency tree and the
+// weights of RFC 7540. A stream gets nothing while one of its ancestors is
+// ready to send; siblings share the bytes in proportion to their weights by
+// stride scheduling, a form of weighted fair queuing.
+// cf. https://tools.ietf.org/html/rfc7540#section-5.3
+class priority_scheduler {
+ public:
+  // Weight given to streams without priority, as carried on the wire
+  static constexpr uint8_t DEFAULT_WIRE_WEIGHT{15u};
+
+  priority_scheduler();
+
+  // Adds the stream when unknown. A dependency on a stream not in the tree
+  // gives the default priority; one on a descendant first moves the
+  // descendant to the former parent of the stream. Throw
+  // std::invalid_argument for a stream depending on itself.
+  // cf. https://tools.ietf.org/html/rfc7540#section-5.3.3
+  void set_priority(const fh_stream_id_t stream_id,
+                    const priority_payload& priority);
+  // The children of the stream take its place and share its weight
+  // cf. https://tools.ietf.org/html/rfc7540#section-5.3.4
+  void remove_stream(const fh_stream_id_t stream_id);
+  // A stream made ready is added with the default priority when unknown
+  void set_ready(const fh_stream_id_t stream_id, const bool ready);
+  // Stream to send for next, 0 when none is ready
+  fh_stream_id_t select();
+  // Charges the bytes sent to the stream and its ancestors
+  void on_sent(const fh_stream_id_t stream_id, const size_t length);
+
+  bool contains(const fh_stream_id_t stream_id) const;
+  // 0 for the root
+  fh_stream_id_t get_parent(const fh_stream_id_t stream_id) const;
+  // 1 to 256, the wire value plus one
+  uint16_t get_weight(const fh_stream_id_t stream_id) const;
+
+ private:
+  struct node {
+    fh_stream_id_t m_parent;
+    uint16_t m_weight;
+    std::vector<fh_stream_id_t> m_children;
+    bool m_ready;
+    // Virtual time of the stride scheduling: the bytes sent for the subtree
+    // divided by the weight, and for a parent, that of the child it last
+    // chose, so that a child coming back from idle does not catch up.
+    uint64_t m_pass;
+    uint64_t m_virtual_time;
+  };
+
+  node& add_default(const fh_stream_id_t stream_id);
+  void attach(const fh_stream_id_t stream_id, const fh_stream_id_t parent,
+              const bool exclusive);
+  void detach(const fh_stream_id_t stream_id);
+  bool is_descendant(const fh_stream_id_t stream_id,
+                     const fh_stream_id_t ancestor) const;
+  bool has_ready(const node& target) const;
+
+  // Stream 0 is the root of the tree.
+  std::unordered_map<fh_stream_id_t, node> m_nodes;
+};
+
+}  // namespace stream
+
+}  // namespace mh2c
+
+#endif  // MH2C_STREAM_PRIORITY_SCHEDULER_H_
@@ -0,0 +1,345 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/stream/push_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/frame_builder.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/goaway_frame.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/i_frame.h"
+#include "mh2c/frame/push_promise_frame.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/util/bit_operation.h"
+
+namespace mh2c {
+
+namespace stream {
+
+namespace {
+
+void append_headers(const header_block_t& header_block, headers_t* headers) {
+  for (const auto& entry : header_block) {
+    if (entry.get_prefix() != header_prefix_pattern::SIZE_UPDATE) {
+      headers->push_back(entry.get_header());
+    }
+  }
+  return;
+}
+
+header_value_t find_value(const headers_t& headers, const header_name_t& name) {
+  for (const auto& header : headers) {
+    if (header.first == name) {
+      return header.second;
+    }
+  }
+  return {};
+}
+
+std::string make_key(const headers_t& request) {
+  auto authority = find_value(request, ":authority");
+  if (authority.empty()) {
+    authority = find_value(request, "host");
+  }
+  return find_value(request, ":method") + ' ' +
+         find_value(request, ":scheme") + "://" + authority +
+         find_value(request, ":path");
+}
+
+// cf. https://tools.ietf.org/html/rfc7234#section-1.2.1
+constexpr long long MAX_DELTA_SECONDS{2147483648LL};
+
+// max-age of a cache-control value, none when it has no valid one
+// cf. https://tools.ietf.org/html/rfc7234#section-5.2.2.8
+std::optional<std::chrono::seconds> parse_max_age(
+    const header_value_t& cache_control) {
+  static const std::string directive{"max-age="};
+  const auto position = cache_control.find(directive);
+  if (position == header_value_t::npos) {
+    return std::nullopt;
+  }
+  try {
+    return std::chrono::seconds{std::min(
+        std::stoll(cache_control.substr(position + directive.length())),
+        MAX_DELTA_SECONDS)};
+  } catch (const std::exception&) {
+    return std::nullopt;
+  }
+}
+
+// Pushed requests must be cacheable and safe.
+// cf. https://tools.ietf.org/html/rfc7540#section-8.2
+bool is_pushable(const headers_t& request) {
+  const auto method = find_value(request, ":method");
+  return method == "GET" || method == "HEAD";
+}
+
+}  // namespace
+
+push_cache::push_cache(const push_cache_options& options)
+    : m_options{options},
+      m_pushes{},
+      m_entries{},
+      m_index{},
+      m_size{0},
+      m_continued_stream_id{0},
+      m_continuation_stream_id{0},
+      m_status{} {}
+
+fh_stream_id_t push_cache::on_frame(const i_frame<frame_header>& frame,
+                                    const byte_array_t& raw_payload) {
+  const auto fh = frame.get_header();
+  switch (cast_to_frame_type_registry(fh.m_type)) {
+    case frame_type_registry::PUSH_PROMISE: {
+      const auto payload =
+          dynamic_cast<const push_promise_frame&>(frame).get_payload();
+      const auto promised_stream_id = payload.m_promised_stream_id;
+      ++m_status.m_promised;
+      auto& pushed = m_pushes[promised_stream_id];
+      pushed = {};
+      append_headers(payload.m_header_block, &pushed.m_request);
+      if (is_flag_set(fh.m_flags, ppf_flag::END_HEADERS)) {
+        return on_promise(promised_stream_id);
+      }
+      m_continued_stream_id = promised_stream_id;
+      m_continuation_stream_id = fh.m_stream_id;
+      return 0;
+    }
+    case frame_type_registry::CONTINUATION: {
+      if (m_continued_stream_id == 0 ||
+          fh.m_stream_id != m_continuation_stream_id) {
+        return 0;
+      }
+      const auto stream_id = m_continued_stream_id;
+      auto& pushed = m_pushes.at(stream_id);
+      const auto is_promise = pushed.m_key.empty();
+      append_headers(get_header_block(frame),
+                     is_promise ? &pushed.m_request
+                                : &pushed.m_response.m_headers);
+      if (is_flag_set(fh.m_flags, hf_flag::END_HEADERS) == false) {
+        return 0;
+      }
+      m_continued_stream_id = 0;
+      return is_promise ? on_promise(stream_id)
+                        : on_response_headers(stream_id);
+    }
+    case frame_type_registry::HEADERS: {
+      const auto ite = m_pushes.find(fh.m_stream_id);
+      if (ite == m_pushes.end()) {
+        return 0;
+      }
+      auto& pushed = ite->second;
+      pushed.m_end_stream = is_flag_set(fh.m_flags, hf_flag::END_STREAM);
+      // Trailers are not kept.
+      if (pushed.m_response_started) {
+        if (pushed.m_end_stream) {
+          store(fh.m_stream_id);
+        }
+        return 0;
+      }
+      pushed.m_response_started = true;
+      append_headers(get_header_block(frame), &pushed.m_response.m_headers);
+      if (is_flag_set(fh.m_flags, hf_flag::END_HEADERS) == false) {
+        m_continued_stream_id = fh.m_stream_id;
+        m_continuation_stream_id = fh.m_stream_id;
+        return 0;
+      }
+      return on_response_headers(fh.m_stream_id);
+    }
+    case frame_type_registry::DATA: {
+      if (m_pushes.count(fh.m_stream_id) == 0) {
+        return 0;
+      }
+      size_t offset{0};
+      size_t length{raw_payload.size()};
+      if (is_flag_set(fh.m_flags, df_flag::PADDED)) {
+        offset = 1u;
+        length -= 1u + get_pad_length(raw_payload);
+      }
+      const auto cancelled =
+          on_data(fh.m_stream_id, raw_payload.data() + offset, length);
+      if (cancelled == 0 && is_flag_set(fh.m_flags, df_flag::END_STREAM)) {
+        store(fh.m_stream_id);
+      }
+      return cancelled;
+    }
+    case frame_type_registry::RST_STREAM: {
+      const auto ite = m_pushes.find(fh.m_stream_id);
+      if (ite != m_pushes.end()) {
+        m_size -= ite->second.m_response.m_body.size();
+        m_pushes.erase(ite);
+      }
+      return 0;
+    }
+    // The pushes the server will not complete would never leave the cache.
+    case frame_type_registry::GOAWAY: {
+      const auto payload =
+          dynamic_cast<const goaway_frame&>(frame).get_payload();
+      for (auto ite = m_pushes.begin(); ite != m_pushes.end();) {
+        if (ite->first <= payload.m_last_stream_id) {
+          ++ite;
+          continue;
+        }
+        if (m_continued_stream_id == ite->first) {
+          m_continued_stream_id = 0;
+        }
+        m_size -= ite->second.m_response.m_body.size();
+        ite = m_pushes.erase(ite);
+      }
+      return 0;
+    }
+    default:
+      return 0;
+  }
+}
+
+const pushed_response* push_cache::find(const headers_t& request) {
+  const auto ite = m_index.find(make_key(request));
+  if (ite == m_index.end()) {
+    return nullptr;
+  }
+  if (std::chrono::steady_clock::now() >= ite->second->m_expiry) {
+    erase(ite->second);
+    return nullptr;
+  }
+
+  m_entries.splice(m_entries.begin(), m_entries, ite->second);
+  ++m_status.m_hits;
+  return &m_entries.front().m_response;
+}
+
+fh_stream_id_t push_cache::get_promised_stream(
+    const headers_t& request) const {
+  const auto key = make_key(request);
+  for (const auto& [stream_id, pushed] : m_pushes) {
+    if (pushed.m_key == key) {
+      return stream_id;
+    }
+  }
+  return 0;
+}
+
+push_cache_status push_cache::get_status() const { return m_status; }
+
+size_t push_cache::get_size() const { return m_size; }
+
+fh_stream_id_t push_cache::on_promise(
+    const fh_stream_id_t promised_stream_id) {
+  auto& pushed = m_pushes.at(promised_stream_id);
+  if (is_pushable(pushed.m_request) == false ||
+      is_fresh(make_key(pushed.m_request)) ||
+      get_promised_stream(pushed.m_request) != 0 ||
+      (m_options.m_filter && m_options.m_filter(pushed.m_request) == false)) {
+    return cancel(promised_stream_id);
+  }
+
+  pushed.m_key = make_key(pushed.m_request);
+  return 0;
+}
+
+fh_stream_id_t push_cache::on_response_headers(
+    const fh_stream_id_t stream_id) {
+  auto& pushed = m_pushes.at(stream_id);
+  const auto content_length =
+      find_value(pushed.m_response.m_headers, "content-length");
+  if (content_length.empty() == false) {
+    try {
+      if (std::stoull(content_length) > m_options.m_max_body_size) {
+        return cancel(stream_id);
+      }
+    } catch (const std::exception&) {
+      return cancel(stream_id);
+    }
+  }
+
+  if (pushed.m_end_stream) {
+    store(stream_id);
+  }
+  return 0;
+}
+
+fh_stream_id_t push_cache::on_data(const fh_stream_id_t stream_id,
+                                   const uint8_t* data, const size_t length) {
+  auto& body = m_pushes.at(stream_id).m_response.m_body;
+  if (body.size() + length > m_options.m_max_body_size) {
+    return cancel(stream_id);
+  }
+  while (m_size + length > m_options.m_max_size && m_entries.empty() == false) {
+    evict();
+  }
+  if (m_size + length > m_options.m_max_size) {
+    return cancel(stream_id);
+  }
+
+  body.insert(body.end(), data, data + length);
+  m_size += length;
+  return 0;
+}
+
+fh_stream_id_t push_cache::cancel(const fh_stream_id_t stream_id) {
+  const auto ite = m_pushes.find(stream_id);
+  m_size -= ite->second.m_response.m_body.size();
+  m_pushes.erase(ite);
+  if (m_continued_stream_id == stream_id) {
+    m_continued_stream_id = 0;
+  }
+
+  ++m_status.m_cancelled;
+  return stream_id;
+}
+
+void push_cache::store(const fh_stream_id_t stream_id) {
+  auto node = m_pushes.extract(stream_id);
+  auto& pushed = node.mapped();
+  // The stale response the push was accepted for
+  const auto stale = m_index.find(pushed.m_key);
+  if (stale != m_index.end()) {
+    erase(stale->second);
+  }
+  const auto max_age =
+      parse_max_age(find_value(pushed.m_response.m_headers, "cache-control"))
+          .value_or(m_options.m_default_max_age);
+  m_entries.push_front({pushed.m_key, std::move(pushed.m_response),
+                        std::chrono::steady_clock::now() + max_age});
+  m_index[m_entries.front().m_key] = m_entries.begin();
+  ++m_status.m_stored;
+
+  while (m_entries.size() > m_options.m_max_entries) {
+    evict();
+  }
+  return;
+}
+
+bool push_cache::is_fresh(const std::string& key) const {
+  const auto ite = m_index.find(key);
+  return ite != m_index.end() &&
+         std::chrono::steady_clock::now() < ite->second->m_expiry;
+}
+
+void push_cache::erase(const std::list<entry>::iterator ite) {
+  m_size -= ite->m_response.m_body.size();
+  m_index.erase(ite->m_key);
+  m_entries.erase(ite);
+  return;
+}
+
+void push_cache::evict() {
+  erase(std::prev(m_entries.end()));
+  return;
+}
+
+}  // namespace stream
+
+}  // namespace mh2c
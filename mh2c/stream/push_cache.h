@@ -0,0 +1,120 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_STREAM_PUSH_CACHE_H_
+#define MH2C_STREAM_PUSH_CACHE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/i_frame.h"
+#include "mh2c/hpack/header_type.h"
+
+namespace mh2c {
+
+namespace stream {
+
+struct push_cache_options {
+  // Completed responses kept; the least recently used one goes first.
+  size_t m_max_entries{64u};
+  // Body bytes of the completed and the incoming pushes together
+  size_t m_max_size{8u * 1024u * 1024u};
+  // A push whose body is larger is cancelled, as soon as its content-length
+  // tells it when there is one.
+  size_t m_max_body_size{1024u * 1024u};
+  // How long a response stays fresh when its cache-control has no max-age
+  std::chrono::seconds m_default_max_age{std::chrono::minutes{5}};
+  // Tells from the promised request whether the push is wanted; every push
+  // of a safe method is when empty.
+  std::function<bool(const headers_t& request)> m_filter{};
+};
+
+struct pushed_response {
+  headers_t m_headers;
+  byte_array_t m_body;
+};
+
+struct push_cache_status {
+  uint64_t m_promised{0};
+  uint64_t m_cancelled{0};
+  uint64_t m_stored{0};
+  uint64_t m_hits{0};
+};
+
+// Collects the responses a server pushes and answers the later requests they
+// were promised for. A push is keyed by :method, :scheme, :authority and
+// :path of the request in its PUSH_PROMISE; one that is not wanted, not for
+// GET or HEAD, already cached and fresh or too large is to be cancelled with
+// RST_STREAM. A push for a cached response that has gone stale replaces it.
+// cf. https://tools.ietf.org/html/rfc7540#section-8.2
+// cf. https://tools.ietf.org/html/rfc7234#section-4.2
+class push_cache {
+ public:
+  explicit push_cache(const push_cache_options& options = {});
+
+  // Follows PUSH_PROMISE, and HEADERS, CONTINUATION, DATA and RST_STREAM of
+  // the promised streams. On GOAWAY, forgets the incoming pushes on streams
+  // above its last stream ID. Returns the promised stream to cancel, 0 for
+  // none; the cache has forgotten it already. Throws connection_error for a
+  // pushed DATA frame whose padding does not fit in it.
+  fh_stream_id_t on_frame(const i_frame<frame_header>& frame,
+                          const byte_array_t& raw_payload);
+  // Fresh response pushed for the request, nullptr when there is none
+  const pushed_response* find(const headers_t& request);
+  // Promised stream still bringing the response for the request, 0 for none
+  fh_stream_id_t get_promised_stream(const headers_t& request) const;
+
+  push_cache_status get_status() const;
+  // Body bytes held
+  size_t get_size() const;
+
+ private:
+  struct push {
+    std::string m_key;
+    headers_t m_request;
+    pushed_response m_response;
+    bool m_response_started;
+    bool m_end_stream;
+  };
+  struct entry {
+    std::string m_key;
+    pushed_response m_response;
+    std::chrono::steady_clock::time_point m_expiry;
+  };
+
+  fh_stream_id_t on_promise(const fh_stream_id_t promised_stream_id);
+  fh_stream_id_t on_response_headers(const fh_stream_id_t stream_id);
+  fh_stream_id_t on_data(const fh_stream_id_t stream_id, const uint8_t* data,
+                         const size_t length);
+  fh_stream_id_t cancel(const fh_stream_id_t stream_id);
+  void store(const fh_stream_id_t stream_id);
+  bool is_fresh(const std::string& key) const;
+  void erase(const std::list<entry>::iterator ite);
+  void evict();
+
+  push_cache_options m_options;
+  // Incoming pushes by promised stream
+  std::unordered_map<fh_stream_id_t, push> m_pushes;
+  // Most recently used first
+  std::list<entry> m_entries;
+  std::unordered_map<std::string, std::list<entry>::iterator> m_index;
+  size_t m_size;
+  // Promised stream whose header block goes on in CONTINUATION frames, and
+  // the stream these are sent on
+  fh_stream_id_t m_continued_stream_id;
+  fh_stream_id_t m_continuation_stream_id;
+  push_cache_status m_status;
+};
+
+}  // namespace stream
+
+}  // namespace mh2c
+
+#endif  // MH2C_STREAM_PUSH_CACHE_H_
@@ -0,0 +1,123 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/stream/stream_latency_tracker.h"
+
+#include <chrono>
+
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/stream/latency_breakdown.h"
+#include "mh2c/stream/stream_tracker.h"
+#include "mh2c/util/bit_operation.h"
+
+namespace mh2c {
+
+namespace stream {
+
+stream_latency_tracker::stream_latency_tracker()
+    : m_streams{}, m_breakdown{} {}
+
+void stream_latency_tracker::on_queued(const fh_stream_id_t stream_id,
+                                       const clock_type::time_point now) {
+  auto& timestamps = m_streams[stream_id];
+  if (timestamps.m_headers_sent.has_value() == false) {
+    timestamps.m_queued = now;
+  }
+  return;
+}
+
+void stream_latency_tracker::on_frame(const frame_header& fh,
+                                      const frame_origin origin,
+                                      const clock_type::time_point now) {
+  const auto type = cast_to_frame_type_registry(fh.m_type);
+  if (fh.m_stream_id == 0 || (type != frame_type_registry::HEADERS &&
+                              type != frame_type_registry::DATA &&
+                              type != frame_type_registry::RST_STREAM)) {
+    return;
+  }
+
+  if (origin == frame_origin::LOCAL && type == frame_type_registry::HEADERS) {
+    auto& timestamps = m_streams[fh.m_stream_id];
+    if (timestamps.m_headers_sent.has_value() == false) {
+      timestamps.m_headers_sent = now;
+    }
+    return;
+  }
+
+  // Only the streams whose request was sent here are timed.
+  const auto it = m_streams.find(fh.m_stream_id);
+  if (it == m_streams.end()) {
+    return;
+  }
+  auto& timestamps = it->second;
+
+  switch (type) {
+    case frame_type_registry::HEADERS:
+      if (timestamps.m_response_headers.has_value() == false) {
+        timestamps.m_response_headers = now;
+      }
+      if (is_flag_set(fh.m_flags, hf_flag::END_STREAM)) {
+        complete(timestamps, now);
+        m_streams.erase(it);
+      }
+      break;
+    case frame_type_registry::DATA:
+      if (origin == frame_origin::LOCAL) {
+        break;
+      }
+      if (timestamps.m_first_data.has_value() == false) {
+        timestamps.m_first_data = now;
+      }
+      if (is_flag_set(fh.m_flags, df_flag::END_STREAM)) {
+        complete(timestamps, now);
+        m_streams.erase(it);
+      }
+      break;
+    default:
+      if (timestamps.m_headers_sent.has_value()) {
+        ++m_breakdown.m_reset_streams;
+      }
+      m_streams.erase(it);
+      break;
+  }
+
+  return;
+}
+
+void stream_latency_tracker::drop_stream(const fh_stream_id_t stream_id) {
+  m_streams.erase(stream_id);
+  return;
+}
+
+const latency_breakdown& stream_latency_tracker::get_breakdown() const {
+  return m_breakdown;
+}
+
+void stream_latency_tracker::complete(const stream_timestamps& timestamps,
+                                      const clock_type::time_point now) {
+  if (timestamps.m_headers_sent.has_value() == false) {
+    return;
+  }
+
+  const auto headers_sent = *timestamps.m_headers_sent;
+  if (timestamps.m_queued) {
+    m_breakdown.m_queued.record(headers_sent - *timestamps.m_queued);
+  }
+  if (timestamps.m_response_headers) {
+    m_breakdown.m_response_headers.record(*timestamps.m_response_headers -
+                                          headers_sent);
+  }
+  if (timestamps.m_first_data) {
+    m_breakdown.m_first_data.record(*timestamps.m_first_data - headers_sent);
+  }
+  m_breakdown.m_end_stream.record(now - headers_sent);
+  ++m_breakdown.m_completed_streams;
+  return;
+}
+
+}  // namespace stream
+
+}  // namespace mh2c
@@ -0,0 +1,57 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_STREAM_STREAM_LATENCY_TRACKER_H_
+#define MH2C_STREAM_STREAM_LATENCY_TRACKER_H_
+
+#include <chrono>
+#include <optional>
+#include <unordered_map>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/stream/latency_breakdown.h"
+#include "mh2c/stream/stream_tracker.h"
+
+namespace mh2c {
+
+namespace stream {
+
+// Timestamps the phases of the requests sent on a connection and folds them
+// into a latency_breakdown once their response ends.
+class stream_latency_tracker {
+ public:
+  using clock_type = std::chrono::steady_clock;
+
+  stream_latency_tracker();
+
+  void on_queued(const fh_stream_id_t stream_id,
+                 const clock_type::time_point now);
+  void on_frame(const frame_header& fh, const frame_origin origin,
+                const clock_type::time_point now);
+
+  // Forgets a stream closed without a frame on it, e.g. one left unprocessed
+  // by GOAWAY
+  void drop_stream(const fh_stream_id_t stream_id);
+
+  const latency_breakdown& get_breakdown() const;
+
+ private:
+  struct stream_timestamps {
+    std::optional<clock_type::time_point> m_queued;
+    std::optional<clock_type::time_point> m_headers_sent;
+    std::optional<clock_type::time_point> m_response_headers;
+    std::optional<clock_type::time_point> m_first_data;
+  };
+
+  void complete(const stream_timestamps& timestamps,
+                const clock_type::time_point now);
+
+  std::unordered_map<fh_stream_id_t, stream_timestamps> m_streams;
+  latency_breakdown m_breakdown;
+};
+
+}  // namespace stream
+
+}  // namespace mh2c
+
+#endif  // MH2C_STREAM_STREAM_LATENCY_TRACKER_H_
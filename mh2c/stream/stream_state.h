@@ -0,0 +1,40 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_STREAM_STREAM_STATE_H_
+#define MH2C_STREAM_STREAM_STATE_H_
+
+#include <cstdint>
+#include <ostream>
+
+#include "mh2c/frame/frame_header.h"
+
+namespace mh2c {
+
+namespace stream {
+
+// cf. https://tools.ietf.org/html/rfc7540#section-5.1
+enum class stream_state : uint8_t {
+  IDLE,
+  RESERVED_LOCAL,
+  RESERVED_REMOTE,
+  OPEN,
+  HALF_CLOSED_LOCAL,
+  HALF_CLOSED_REMOTE,
+  CLOSED,
+};
+
+struct stream_transition {
+  fh_stream_id_t m_stream_id;
+  stream_state m_from;
+  stream_state m_to;
+};
+
+std::ostream& operator<<(std::ostream& out_stream, const stream_state state);
+bool operator==(const stream_transition& lhs, const stream_transition& rhs);
+
+}  // namespace stream
+
+}  // namespace mh2c
+
+#endif  // MH2C_STREAM_STREAM_STATE_H_
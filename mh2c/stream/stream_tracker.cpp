@@ -0,0 +1,181 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/stream/stream_tracker.h"
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/i_frame.h"
+#include "mh2c/frame/push_promise_frame.h"
+#include "mh2c/stream/stream_state.h"
+#include "mh2c/util/bit_operation.h"
+
+namespace mh2c {
+
+namespace stream {
+
+stream_tracker::stream_tracker()
+    : m_states{}, m_last_odd_stream_id{0}, m_last_even_stream_id{0} {}
+
+std::vector<stream_transition> stream_tracker::on_frame(
+    const i_frame<frame_header>& frame, const frame_origin origin) {
+  std::vector<stream_transition> transitions{};
+  const auto fh = frame.get_header();
+  if (fh.m_stream_id == 0) {
+    return transitions;
+  }
+
+  const auto local = origin == frame_origin::LOCAL;
+  const auto state = get_state(fh.m_stream_id);
+  switch (cast_to_frame_type_registry(fh.m_type)) {
+    case frame_type_registry::HEADERS:
+      if (state == stream_state::IDLE) {
+        set_state(fh.m_stream_id, stream_state::OPEN, &transitions);
+      } else if (state == stream_state::RESERVED_LOCAL && local) {
+        set_state(fh.m_stream_id, stream_state::HALF_CLOSED_REMOTE,
+                  &transitions);
+      } else if (state == stream_state::RESERVED_REMOTE && local == false) {
+        set_state(fh.m_stream_id, stream_state::HALF_CLOSED_LOCAL,
+                  &transitions);
+      }
+      if (is_flag_set(fh.m_flags, hf_flag::END_STREAM)) {
+        on_end_stream(fh.m_stream_id, origin, &transitions);
+      }
+      break;
+    case frame_type_registry::DATA:
+      if (is_flag_set(fh.m_flags, df_flag::END_STREAM)) {
+        on_end_stream(fh.m_stream_id, origin, &transitions);
+      }
+      break;
+    case frame_type_registry::PUSH_PROMISE: {
+      const auto promised_stream_id =
+          dynamic_cast<const push_promise_frame&>(frame)
+              .get_payload()
+              .m_promised_stream_id;
+      if (get_state(promised_stream_id) == stream_state::IDLE) {
+        set_state(promised_stream_id,
+                  local ? stream_state::RESERVED_LOCAL
+                        : stream_state::RESERVED_REMOTE,
+                  &transitions);
+      }
+      break;
+    }
+    case frame_type_registry::RST_STREAM:
+      if (state != stream_state::IDLE && state != stream_state::CLOSED) {
+        set_state(fh.m_stream_id, stream_state::CLOSED, &transitions);
+      }
+      break;
+    default:
+      break;
+  }
+
+  return transitions;
+}
+
+std::vector<stream_transition> stream_tracker::on_goaway(
+    const fh_stream_id_t last_stream_id, const bool receiver_is_client) {
+  const fh_stream_id_t parity{receiver_is_client ? 1u : 0u};
+  std::vector<fh_stream_id_t> unprocessed_stream_ids{};
+  for (const auto& [stream_id, state] : m_states) {
+    if (stream_id > last_stream_id && stream_id % 2 == parity) {
+      unprocessed_stream_ids.push_back(stream_id);
+    }
+  }
+  std::sort(unprocessed_stream_ids.begin(), unprocessed_stream_ids.end());
+
+  std::vector<stream_transition> transitions{};
+  for (const auto stream_id : unprocessed_stream_ids) {
+    set_state(stream_id, stream_state::CLOSED, &transitions);
+  }
+  return transitions;
+}
+
+stream_state stream_tracker::get_state(const fh_stream_id_t stream_id) const {
+  const auto it = m_states.find(stream_id);
+  if (it != m_states.end()) {
+    return it->second;
+  }
+
+  // cf. https://tools.ietf.org/html/rfc7540#section-5.1.1
+  const auto last_stream_id =
+      stream_id % 2 == 1 ? m_last_odd_stream_id : m_last_even_stream_id;
+  return stream_id <= last_stream_id ? stream_state::CLOSED
+                                     : stream_state::IDLE;
+}
+
+size_t stream_tracker::get_active_stream_count() const {
+  return m_states.size();
+}
+
+void stream_tracker::set_state(const fh_stream_id_t stream_id,
+                               const stream_state state,
+                               std::vector<stream_transition>* transitions) {
+  transitions->push_back({stream_id, get_state(stream_id), state});
+
+  auto& last_stream_id =
+      stream_id % 2 == 1 ? m_last_odd_stream_id : m_last_even_stream_id;
+  last_stream_id = std::max(last_stream_id, stream_id);
+  if (state == stream_state::CLOSED) {
+    m_states.erase(stream_id);
+  } else {
+    m_states[stream_id] = state;
+  }
+
+  return;
+}
+
+void stream_tracker::on_end_stream(
+    const fh_stream_id_t stream_id, const frame_origin origin,
+    std::vector<stream_transition>* transitions) {
+  const auto state = get_state(stream_id);
+  if (origin == frame_origin::LOCAL) {
+    if (state == stream_state::OPEN) {
+      set_state(stream_id, stream_state::HALF_CLOSED_LOCAL, transitions);
+    } else if (state == stream_state::HALF_CLOSED_REMOTE) {
+      set_state(stream_id, stream_state::CLOSED, transitions);
+    }
+  } else {
+    if (state == stream_state::OPEN) {
+      set_state(stream_id, stream_state::HALF_CLOSED_REMOTE, transitions);
+    } else if (state == stream_state::HALF_CLOSED_LOCAL) {
+      set_state(stream_id, stream_state::CLOSED, transitions);
+    }
+  }
+
+  return;
+}
+
+std::ostream& operator<<(std::ostream& out_stream, const stream_state state) {
+  switch (state) {
+    case stream_state::IDLE:
+      return out_stream << "idle";
+    case stream_state::RESERVED_LOCAL:
+      return out_stream << "reserved (local)";
+    case stream_state::RESERVED_REMOTE:
+      return out_stream << "reserved (remote)";
+    case stream_state::OPEN:
+      return out_stream << "open";
+    case stream_state::HALF_CLOSED_LOCAL:
+      return out_stream << "half-closed (local)";
+    case stream_state::HALF_CLOSED_REMOTE:
+      return out_stream << "half-closed (remote)";
+    case stream_state::CLOSED:
+      return out_stream << "closed";
+  }
+  return out_stream;
+}
+
+bool operator==(const stream_transition& lhs, const stream_transition& rhs) {
+  return lhs.m_stream_id == rhs.m_stream_id && lhs.m_from == rhs.m_from &&
+         lhs.m_to == rhs.m_to;
+}
+
+}  // namespace stream
+
+}  // namespace mh2c
@@ -0,0 +1,59 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_STREAM_STREAM_TRACKER_H_
+#define MH2C_STREAM_STREAM_TRACKER_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/i_frame.h"
+#include "mh2c/stream/stream_state.h"
+
+namespace mh2c {
+
+namespace stream {
+
+enum class frame_origin {
+  LOCAL,   // Sent by this endpoint
+  REMOTE,  // Received from the peer
+};
+
+// Follows the stream state machine of RFC 7540 from the frames exchanged on a
+// connection. Only streams that are neither idle nor closed are stored;
+// closed ones are recognized by their identifier being below the highest one
+// opened so far.
+class stream_tracker {
+ public:
+  stream_tracker();
+
+  // Returns the transitions caused by the frame, usually none or one
+  std::vector<stream_transition> on_frame(const i_frame<frame_header>& frame,
+                                          const frame_origin origin);
+  // Closes the active streams above last_stream_id that the receiver of
+  // GOAWAY initiated, odd ones when it is a client: the sender of GOAWAY has
+  // not processed them and never will.
+  // cf. https://tools.ietf.org/html/rfc7540#section-6.8
+  std::vector<stream_transition> on_goaway(const fh_stream_id_t last_stream_id,
+                                           const bool receiver_is_client);
+  stream_state get_state(const fh_stream_id_t stream_id) const;
+  size_t get_active_stream_count() const;
+
+ private:
+  void set_state(const fh_stream_id_t stream_id, const stream_state state,
+                 std::vector<stream_transition>* transitions);
+  void on_end_stream(const fh_stream_id_t stream_id, const frame_origin origin,
+                     std::vector<stream_transition>* transitions);
+
+  std::unordered_map<fh_stream_id_t, stream_state> m_states;
+  // Highest identifiers that left the idle state, per initiator
+  fh_stream_id_t m_last_odd_stream_id;
+  fh_stream_id_t m_last_even_stream_id;
+};
+
+}  // namespace stream
+
+}  // namespace mh2c
+
+#endif  // MH2C_STREAM_STREAM_TRACKER_H_
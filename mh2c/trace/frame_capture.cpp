@@ -0,0 +1,131 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/trace/frame_capture.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/common_type.h"
+#include "mh2c/frame/frame_builder.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/trace/trace_observer.h"
+#include "mh2c/util/byte_order.h"
+
+namespace mh2c {
+
+namespace trace {
+
+namespace {
+
+const std::string CAPTURE_MAGIC{"MH2CCAP1"};
+constexpr size_t TIMESTAMP_BYTES{sizeof(uint64_t)};
+constexpr size_t RECORD_HEADER_BYTES{TIMESTAMP_BYTES + 1u};
+
+}  // namespace
+
+frame_capture_writer::frame_capture_writer(const std::string& path)
+    : m_file{path, std::ios::binary | std::ios::trunc} {
+  if (m_file.is_open() == false) {
+    throw std::runtime_error("failed to create " + path);
+  }
+
+  m_file.write(CAPTURE_MAGIC.data(), CAPTURE_MAGIC.size());
+}
+
+void frame_capture_writer::write(const timestamp_t timestamp,
+                                 const capture_direction direction,
+                                 const uint8_t* raw_header,
+                                 const uint8_t* raw_payload,
+                                 const size_t payload_length) {
+  auto record = integral2bytes<byte_array_t>(
+      static_cast<uint64_t>(timestamp.count()));
+  record.push_back(static_cast<uint8_t>(direction));
+  m_file.write(reinterpret_cast<const char*>(record.data()), record.size());
+  m_file.write(reinterpret_cast<const char*>(raw_header), FRAME_HEADER_BYTES);
+  m_file.write(reinterpret_cast<const char*>(raw_payload), payload_length);
+  return;
+}
+
+void frame_capture_writer::flush() {
+  m_file.flush();
+  return;
+}
+
+std::vector<captured_frame> read_frame_capture(const std::string& path) {
+  std::ifstream file{path, std::ios::binary};
+  if (file.is_open() == false) {
+    throw std::runtime_error("failed to open " + path);
+  }
+
+  const byte_array_t data{std::istreambuf_iterator<char>{file},
+                          std::istreambuf_iterator<char>{}};
+  if (data.size() < CAPTURE_MAGIC.size() ||
+      std::string(data.begin(), data.begin() + CAPTURE_MAGIC.size()) !=
+          CAPTURE_MAGIC) {
+    throw std::runtime_error(path + " is not a frame capture");
+  }
+
+  std::vector<captured_frame> frames{};
+  for (auto pos = data.begin() + CAPTURE_MAGIC.size(); pos != data.end();) {
+    if (static_cast<size_t>(data.end() - pos) <
+        RECORD_HEADER_BYTES + FRAME_HEADER_BYTES) {
+      throw std::runtime_error(path + " is truncated");
+    }
+
+    captured_frame frame{};
+    frame.m_timestamp = timestamp_t{bytes2integral<uint64_t>(pos)};
+    frame.m_direction = static_cast<capture_direction>(pos[TIMESTAMP_BYTES]);
+    pos += RECORD_HEADER_BYTES;
+    frame.m_raw_header.assign(pos, pos + FRAME_HEADER_BYTES);
+    pos += FRAME_HEADER_BYTES;
+
+    const auto length = build_frame_header(frame.m_raw_header).m_length;
+    if (static_cast<size_t>(data.end() - pos) < length) {
+      throw std::runtime_error(path + " is truncated");
+    }
+    frame.m_raw_payload.assign(pos, pos + length);
+    pos += length;
+    frames.push_back(std::move(frame));
+  }
+
+  return frames;
+}
+
+capture_replayer::capture_replayer()
+    : m_request_dynamic_table{}, m_response_dynamic_table{} {}
+
+h2_frame_ptr capture_replayer::replay(const captured_frame& frame) {
+  const auto fh = build_frame_header(frame.m_raw_header);
+  if (frame.m_direction == capture_direction::RECEIVED) {
+    auto frame_ptr =
+        build_frame(fh, frame.m_raw_payload, m_response_dynamic_table);
+    update_dynamic_table(frame_ptr, &m_response_dynamic_table);
+    return frame_ptr;
+  }
+
+  // Same as http2_client::update_request_dynamic_table(), which only follows
+  // the header blocks sent
+  auto frame_ptr =
+      build_frame(fh, frame.m_raw_payload, m_request_dynamic_table);
+  update_dynamic_table(get_header_block(*frame_ptr), &m_request_dynamic_table);
+  return frame_ptr;
+}
+
+void capture_replayer::reset() {
+  m_request_dynamic_table = dynamic_table{};
+  m_response_dynamic_table = dynamic_table{};
+  return;
+}
+
+}  // namespace trace
+
+}  // namespace mh2c
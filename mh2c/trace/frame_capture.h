@@ -0,0 +1,78 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_TRACE_FRAME_CAPTURE_H_
+#define MH2C_TRACE_FRAME_CAPTURE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/common_type.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/trace/trace_observer.h"
+
+namespace mh2c {
+
+namespace trace {
+
+enum class capture_direction : uint8_t {
+  SENT,
+  RECEIVED,
+};
+
+struct captured_frame {
+  timestamp_t m_timestamp;
+  capture_direction m_direction;
+  byte_array_t m_raw_header;  // FRAME_HEADER_BYTES
+  byte_array_t m_raw_payload;
+};
+
+// Writes the frames of a connection, as they are on the wire after TLS, to a
+// capture file:
+//   file   = "MH2CCAP1" *record
+//   record = timestamp(8) direction(1) frame-header(9) payload
+// The timestamp is in nanoseconds in network byte order. The frame header
+// carries the payload length, so records need no framing of their own.
+class frame_capture_writer {
+ public:
+  // Throw std::runtime_error when the file cannot be created
+  explicit frame_capture_writer(const std::string& path);
+
+  void write(const timestamp_t timestamp, const capture_direction direction,
+             const uint8_t* raw_header, const uint8_t* raw_payload,
+             const size_t payload_length);
+  void flush();
+
+ private:
+  std::ofstream m_file;
+};
+
+// Throw std::runtime_error when the file is not a capture or is truncated
+std::vector<captured_frame> read_frame_capture(const std::string& path);
+
+// Decodes captured frames with the HPACK state of both endpoints: the frames
+// sent are decoded with the table the peer keeps for the requests, and the
+// frames received with the table the client keeps for the responses. Feed it
+// every frame of a capture in order.
+class capture_replayer {
+ public:
+  capture_replayer();
+
+  h2_frame_ptr replay(const captured_frame& frame);
+  // Start over with empty tables, e.g. to replay the capture again
+  void reset();
+
+ private:
+  dynamic_table m_request_dynamic_table;
+  dynamic_table m_response_dynamic_table;
+};
+
+}  // namespace trace
+
+}  // namespace mh2c
+
+#endif  // MH2C_TRACE_FRAME_CAPTURE_H_
@@ -0,0 +1,145 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/trace/ring_buffer_recorder.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/stream/stream_state.h"
+#include "mh2c/trace/trace_observer.h"
+
+namespace mh2c {
+
+namespace trace {
+
+namespace {
+
+const char* get_frame_type_name(const fh_type_t type) {
+  static const std::array<const char*, 10> names{
+      "DATA",         "HEADERS", "PRIORITY", "RST_STREAM",    "SETTINGS",
+      "PUSH_PROMISE", "PING",    "GOAWAY",   "WINDOW_UPDATE", "CONTINUATION"};
+  return type < names.size() ? names[type] : "UNKNOWN";
+}
+
+trace_event make_event(const timestamp_t timestamp, const event_type type) {
+  trace_event event{};
+  event.m_timestamp = timestamp;
+  event.m_type = type;
+  return event;
+}
+
+}  // namespace
+
+ring_buffer_recorder::ring_buffer_recorder(const size_t capacity)
+    : m_events(capacity), m_next{0}, m_recorded_count{0} {
+  if (capacity == 0) {
+    throw std::invalid_argument("ring_buffer_recorder needs a capacity");
+  }
+}
+
+void ring_buffer_recorder::on_frame_sent(const timestamp_t timestamp,
+                                         const frame_header& fh) {
+  auto event = make_event(timestamp, event_type::FRAME_SENT);
+  event.m_frame_header = fh;
+  record(event);
+  return;
+}
+
+void ring_buffer_recorder::on_frame_received(const timestamp_t timestamp,
+                                             const frame_header& fh) {
+  auto event = make_event(timestamp, event_type::FRAME_RECEIVED);
+  event.m_frame_header = fh;
+  record(event);
+  return;
+}
+
+void ring_buffer_recorder::on_table_changed(const timestamp_t timestamp,
+                                            const table_kind kind,
+                                            const dynamic_table& table) {
+  auto event = make_event(timestamp, event_type::TABLE_CHANGED);
+  event.m_table = kind;
+  event.m_table_entries = table.get_entries().size();
+  event.m_table_size = table.get_table_size();
+  event.m_max_table_size = table.get_max_table_size();
+  record(event);
+  return;
+}
+
+void ring_buffer_recorder::on_stream_state_changed(
+    const timestamp_t timestamp, const stream::stream_transition& transition) {
+  auto event = make_event(timestamp, event_type::STREAM_STATE_CHANGED);
+  event.m_transition = transition;
+  record(event);
+  return;
+}
+
+std::vector<trace_event> ring_buffer_recorder::get_events() const {
+  if (m_recorded_count < m_events.size()) {
+    return {m_events.begin(), m_events.begin() + m_next};
+  }
+
+  std::vector<trace_event> events{m_events.begin() + m_next, m_events.end()};
+  events.insert(events.end(), m_events.begin(), m_events.begin() + m_next);
+  return events;
+}
+
+uint64_t ring_buffer_recorder::get_dropped_count() const {
+  return m_recorded_count < m_events.size()
+             ? 0
+             : m_recorded_count - m_events.size();
+}
+
+void ring_buffer_recorder::clear() {
+  m_next = 0;
+  m_recorded_count = 0;
+  return;
+}
+
+void ring_buffer_recorder::record(const trace_event& event) {
+  m_events[m_next] = event;
+  m_next = m_next + 1 == m_events.size() ? 0 : m_next + 1;
+  ++m_recorded_count;
+  return;
+}
+
+std::ostream& operator<<(std::ostream& out_stream, const trace_event& event) {
+  out_stream << event.m_timestamp.count() << ' ';
+  switch (event.m_type) {
+    case event_type::FRAME_SENT:
+    case event_type::FRAME_RECEIVED: {
+      const auto& fh = event.m_frame_header;
+      const auto flags = out_stream.flags();
+      out_stream << (event.m_type == event_type::FRAME_SENT ? "send " : "recv ")
+                 << get_frame_type_name(fh.m_type) << " len=" << fh.m_length
+                 << " flags=0x" << std::hex << static_cast<int>(fh.m_flags);
+      out_stream.flags(flags);
+      out_stream << " stream=" << fh.m_stream_id;
+      break;
+    }
+    case event_type::TABLE_CHANGED:
+      out_stream << (event.m_table == table_kind::REQUEST ? "request"
+                                                          : "response")
+                 << " table entries=" << event.m_table_entries
+                 << " size=" << event.m_table_size << '/'
+                 << event.m_max_table_size;
+      break;
+    case event_type::STREAM_STATE_CHANGED:
+      out_stream << "stream=" << event.m_transition.m_stream_id << ' '
+                 << event.m_transition.m_from << " -> "
+                 << event.m_transition.m_to;
+      break;
+  }
+  return out_stream;
+}
+
+}  // namespace trace
+
+}  // namespace mh2c
@@ -0,0 +1,82 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_TRACE_RING_BUFFER_RECORDER_H_
+#define MH2C_TRACE_RING_BUFFER_RECORDER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/stream/stream_state.h"
+#include "mh2c/trace/trace_observer.h"
+
+namespace mh2c {
+
+namespace trace {
+
+enum class event_type : uint8_t {
+  FRAME_SENT,
+  FRAME_RECEIVED,
+  TABLE_CHANGED,
+  STREAM_STATE_CHANGED,
+};
+
+// Fixed-size record. Only the members matching m_type are meaningful.
+struct trace_event {
+  timestamp_t m_timestamp;
+  event_type m_type;
+  // FRAME_SENT, FRAME_RECEIVED
+  frame_header m_frame_header;
+  // TABLE_CHANGED
+  table_kind m_table;
+  uint32_t m_table_entries;
+  uint32_t m_table_size;
+  uint32_t m_max_table_size;
+  // STREAM_STATE_CHANGED
+  stream::stream_transition m_transition;
+};
+
+// Keeps the last events in a preallocated buffer, overwriting the oldest ones.
+// Recording only copies a trace_event, so it can stay attached in production;
+// the events are formatted afterwards. It is not synchronized: read it from
+// the thread driving the connection or once that thread is done.
+class ring_buffer_recorder : public i_trace_observer {
+ public:
+  explicit ring_buffer_recorder(const size_t capacity);
+
+  void on_frame_sent(const timestamp_t timestamp,
+                     const frame_header& fh) override;
+  void on_frame_received(const timestamp_t timestamp,
+                         const frame_header& fh) override;
+  void on_table_changed(const timestamp_t timestamp, const table_kind kind,
+                        const dynamic_table& table) override;
+  void on_stream_state_changed(
+      const timestamp_t timestamp,
+      const stream::stream_transition& transition) override;
+
+  // Oldest first
+  std::vector<trace_event> get_events() const;
+  // Events overwritten because the buffer was full
+  uint64_t get_dropped_count() const;
+  void clear();
+
+ private:
+  void record(const trace_event& event);
+
+  std::vector<trace_event> m_events;
+  size_t m_next;
+  uint64_t m_recorded_count;
+};
+
+// One line per event, e.g. "123456789 recv HEADERS len=42 flags=0x5 stream=1"
+std::ostream& operator<<(std::ostream& out_stream, const trace_event& event);
+
+}  // namespace trace
+
+}  // namespace mh2c
+
+#endif  // MH2C_TRACE_RING_BUFFER_RECORDER_H_
@@ -0,0 +1,21 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_TRACE_TRACE_HOOK_H_
+#define MH2C_TRACE_TRACE_HOOK_H_
+
+#include "mh2c/trace/trace_observer.h"
+
+// Calls a member of an i_trace_observer pointer when one is attached. Without
+// MH2C_ENABLE_TRACING the call is discarded at compile time, arguments such as
+// timestamps included, yet still type-checked so that both builds stay valid.
+#define MH2C_TRACE(observer, call)                  \
+  do {                                              \
+    if constexpr (::mh2c::trace::TRACING_ENABLED) { \
+      if (observer) {                               \
+        (observer)->call;                           \
+      }                                             \
+    }                                               \
+  } while (false)
+
+#endif  // MH2C_TRACE_TRACE_HOOK_H_
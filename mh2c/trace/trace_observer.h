@@ -0,0 +1,61 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_TRACE_TRACE_OBSERVER_H_
+#define MH2C_TRACE_TRACE_OBSERVER_H_
+
+#include <chrono>
+#include <cstdint>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/stream/stream_state.h"
+
+namespace mh2c {
+
+namespace trace {
+
+// The hooks are only compiled into libmh2c when it is configured with
+// -DMH2C_ENABLE_TRACING=ON. Otherwise an attached observer is never called.
+#ifdef MH2C_ENABLE_TRACING
+constexpr bool TRACING_ENABLED{true};
+#else
+constexpr bool TRACING_ENABLED{false};
+#endif
+
+// Nanoseconds of std::chrono::steady_clock
+using timestamp_t = std::chrono::nanoseconds;
+
+inline timestamp_t now() {
+  return std::chrono::duration_cast<timestamp_t>(
+      std::chrono::steady_clock::now().time_since_epoch());
+}
+
+enum class table_kind : uint8_t {
+  REQUEST,   // Encodes the header blocks sent
+  RESPONSE,  // Decodes the header blocks received
+};
+
+// Called on the thread driving the connection, so implementations should
+// return quickly and must not call back into the client.
+class i_trace_observer {
+ public:
+  virtual ~i_trace_observer() = default;
+
+  virtual void on_frame_sent(const timestamp_t timestamp,
+                             const frame_header& fh) = 0;
+  virtual void on_frame_received(const timestamp_t timestamp,
+                                 const frame_header& fh) = 0;
+  virtual void on_table_changed(const timestamp_t timestamp,
+                                const table_kind kind,
+                                const dynamic_table& table) = 0;
+  virtual void on_stream_state_changed(
+      const timestamp_t timestamp,
+      const stream::stream_transition& transition) = 0;
+};
+
+}  // namespace trace
+
+}  // namespace mh2c
+
+#endif  // MH2C_TRACE_TRACE_OBSERVER_H_
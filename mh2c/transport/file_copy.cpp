@@ -0,0 +1,69 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/transport/file_copy.h"
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/transport/i_transport.h"
+
+namespace mh2c {
+
+namespace transport {
+
+namespace {
+
+constexpr size_t COPY_BUFFER_SIZE{16384u};
+
+// Reads up to length bytes at offset, at least one
+size_t read_some(const int fd, uint8_t* buffer, const size_t length,
+                 const off_t offset) {
+  const auto result = pread(fd, buffer, length, offset);
+  if (result <= 0) {
+    int err_code = errno;
+    throw std::runtime_error(
+        "pread failed: result=" + std::to_string(result) +
+        ", err_code=" + std::to_string(err_code));
+  }
+  return static_cast<size_t>(result);
+}
+
+}  // namespace
+
+void copy_file(i_transport* transport, const int fd, const off_t offset,
+               const size_t length) {
+  uint8_t buffer[COPY_BUFFER_SIZE];
+  size_t sent_length{};
+
+  while (sent_length < length) {
+    const auto chunk_length = std::min(sizeof(buffer), length - sent_length);
+    const auto result =
+        read_some(fd, buffer, chunk_length, offset + sent_length);
+    transport->write(buffer, result);
+    sent_length += result;
+  }
+
+  return;
+}
+
+byte_array_t read_file(const int fd, const off_t offset, const size_t length) {
+  byte_array_t data(length);
+  size_t read_length{};
+  while (read_length < length) {
+    read_length += read_some(fd, data.data() + read_length,
+                             length - read_length, offset + read_length);
+  }
+  return data;
+}
+
+}  // namespace transport
+
+}  // namespace mh2c
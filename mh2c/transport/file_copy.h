@@ -0,0 +1,30 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_TRANSPORT_FILE_COPY_H_
+#define MH2C_TRANSPORT_FILE_COPY_H_
+
+#include <sys/types.h>
+
+#include <cstdint>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/transport/i_transport.h"
+
+namespace mh2c {
+
+namespace transport {
+
+// Copies a file range through user space for transports that cannot hand it
+// to the kernel.
+void copy_file(i_transport* transport, const int fd, const off_t offset,
+               const size_t length);
+
+// Reads a file range whole, e.g. to capture what sendfile() has sent.
+byte_array_t read_file(const int fd, const off_t offset, const size_t length);
+
+}  // namespace transport
+
+}  // namespace mh2c
+
+#endif  // MH2C_TRANSPORT_FILE_COPY_H_
@@ -0,0 +1,55 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_TRANSPORT_I_TRANSPORT_H_
+#define MH2C_TRANSPORT_I_TRANSPORT_H_
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+namespace mh2c {
+
+namespace transport {
+
+// Thrown by read() when the peer has closed the connection.
+class transport_closed : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Byte stream that carries HTTP/2 frames, e.g. TLS, cleartext TCP (h2c) or
+// an in-process pipe.
+class i_transport {
+ public:
+  virtual ~i_transport() = default;
+
+  virtual void write(const uint8_t* data, const size_t length) = 0;
+  // Writes the buffers back to back, e.g. a frame header and a payload that
+  // lives elsewhere, without joining them first. Transports that can gather
+  // them in one system call override it.
+  virtual void writev(const iovec* vectors, const size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      write(static_cast<const uint8_t*>(vectors[i].iov_base),
+            vectors[i].iov_len);
+    }
+  }
+  virtual void read(uint8_t* data, const size_t length) = 0;
+  virtual void sendfile(const int fd, const off_t offset,
+                        const size_t length) = 0;
+  // Returns false if no data became readable before the timeout.
+  virtual bool wait_readable(const std::chrono::milliseconds timeout) = 0;
+  // Also returns false as soon as wake_fd becomes readable, so that another
+  // thread can interrupt the wait by writing to it, e.g. to an eventfd.
+  virtual bool wait_readable(const std::chrono::milliseconds timeout,
+                             const int wake_fd) = 0;
+};
+
+}  // namespace transport
+
+}  // namespace mh2c
+
+#endif  // MH2C_TRANSPORT_I_TRANSPORT_H_
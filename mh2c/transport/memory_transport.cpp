@@ -0,0 +1,164 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/transport/memory_transport.h"
+
+#include <poll.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include "mh2c/net/socket_fd.h"
+#include "mh2c/transport/file_copy.h"
+#include "mh2c/transport/i_transport.h"
+
+namespace mh2c {
+
+namespace transport {
+
+namespace {
+
+// Blocking reads wait in slices of this length. Timed waits stay on the
+// monotonic clock.
+constexpr std::chrono::milliseconds IDLE_WAIT_INTERVAL{1000};
+// How often a wait that another thread can interrupt checks for it
+constexpr std::chrono::milliseconds WAKE_CHECK_INTERVAL{1};
+
+// One direction of the byte stream
+class memory_channel {
+ public:
+  memory_channel() : m_mutex{}, m_readable{}, m_buffer{}, m_closed{false} {}
+
+  void write(const uint8_t* data, const size_t length) {
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      if (m_closed) {
+        throw transport_closed("memory channel is closed");
+      }
+      m_buffer.insert(m_buffer.end(), data, data + length);
+    }
+    m_readable.notify_one();
+    return;
+  }
+
+  void read(uint8_t* data, const size_t length) {
+    size_t read_length{};
+    std::unique_lock<std::mutex> lock{m_mutex};
+
+    while (read_length < length) {
+      while (wait_for_data(&lock, IDLE_WAIT_INTERVAL) == false) {
+      }
+      if (m_buffer.empty()) {
+        throw transport_closed("memory channel is closed");
+      }
+
+      const auto chunk_length =
+          std::min(m_buffer.size(), length - read_length);
+      std::copy_n(m_buffer.begin(), chunk_length, data + read_length);
+      m_buffer.erase(m_buffer.begin(), m_buffer.begin() + chunk_length);
+      read_length += chunk_length;
+    }
+
+    return;
+  }
+
+  bool wait_readable(const std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    return wait_for_data(&lock, timeout);
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_closed = true;
+    }
+    m_readable.notify_all();
+    return;
+  }
+
+ private:
+  bool wait_for_data(std::unique_lock<std::mutex>* lock,
+                     const std::chrono::milliseconds timeout) {
+    return m_readable.wait_for(
+        *lock, timeout, [this]() { return !m_buffer.empty() || m_closed; });
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_readable;
+  std::deque<uint8_t> m_buffer;
+  bool m_closed;
+};
+
+class memory_transport : public i_transport {
+ public:
+  memory_transport(std::shared_ptr<memory_channel> incoming,
+                   std::shared_ptr<memory_channel> outgoing)
+      : m_incoming{std::move(incoming)}, m_outgoing{std::move(outgoing)} {}
+
+  ~memory_transport() override {
+    m_incoming->close();
+    m_outgoing->close();
+  }
+
+  void write(const uint8_t* data, const size_t length) override {
+    m_outgoing->write(data, length);
+    return;
+  }
+
+  void read(uint8_t* data, const size_t length) override {
+    m_incoming->read(data, length);
+    return;
+  }
+
+  void sendfile(const int fd, const off_t offset,
+                const size_t length) override {
+    copy_file(this, fd, offset, length);
+    return;
+  }
+
+  bool wait_readable(const std::chrono::milliseconds timeout) override {
+    return m_incoming->wait_readable(timeout);
+  }
+
+  // The channel cannot be polled, so wake_fd is checked between short waits.
+  bool wait_readable(const std::chrono::milliseconds timeout,
+                     const int wake_fd) override {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+      if (m_incoming->wait_readable(WAKE_CHECK_INTERVAL)) {
+        return true;
+      }
+      if (std::chrono::steady_clock::now() >= deadline ||
+          net::wait_for_events(wake_fd, POLLIN,
+                               std::chrono::milliseconds{0})) {
+        return false;
+      }
+    }
+  }
+
+ private:
+  std::shared_ptr<memory_channel> m_incoming;
+  std::shared_ptr<memory_channel> m_outgoing;
+};
+
+}  // namespace
+
+transport_pair_t make_memory_transport_pair() {
+  auto forward = std::make_shared<memory_channel>();
+  auto backward = std::make_shared<memory_channel>();
+
+  return {std::make_unique<memory_transport>(backward, forward),
+          std::make_unique<memory_transport>(forward, backward)};
+}
+
+}  // namespace transport
+
+}  // namespace mh2c
@@ -0,0 +1,27 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_TRANSPORT_MEMORY_TRANSPORT_H_
+#define MH2C_TRANSPORT_MEMORY_TRANSPORT_H_
+
+#include <memory>
+#include <utility>
+
+#include "mh2c/transport/i_transport.h"
+
+namespace mh2c {
+
+namespace transport {
+
+using transport_pair_t =
+    std::pair<std::unique_ptr<i_transport>, std::unique_ptr<i_transport>>;
+
+// Returns two connected ends of an in-process byte stream. Destroying one end
+// makes reads on the other end throw transport_closed once drained.
+transport_pair_t make_memory_transport_pair();
+
+}  // namespace transport
+
+}  // namespace mh2c
+
+#endif  // MH2C_TRANSPORT_MEMORY_TRANSPORT_H_
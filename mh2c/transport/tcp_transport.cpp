@@ -0,0 +1,179 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#include "mh2c/transport/tcp_transport.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "mh2c/net/connect_options.h"
+#include "mh2c/net/socket_fd.h"
+#include "mh2c/net/tcp_connector.h"
+#include "mh2c/transport/i_transport.h"
+
+namespace mh2c {
+
+namespace transport {
+
+namespace {
+
+class tcp_transport : public i_transport {
+ public:
+  explicit tcp_transport(net::socket_fd fd) : m_fd{std::move(fd)} {
+    net::set_blocking(m_fd.get(), true);
+
+    // Frames are written whole, so Nagle only adds latency.
+    const int on{1};
+    setsockopt(m_fd.get(), IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  }
+
+  void write(const uint8_t* data, const size_t length) override {
+    size_t written_length{};
+
+    while (written_length < length) {
+      const auto result = ::send(m_fd.get(), data + written_length,
+                                 length - written_length, MSG_NOSIGNAL);
+      if (result < 0) {
+        int err_code = errno;
+        if (err_code == EINTR) {
+          continue;
+        }
+        throw std::runtime_error("send failed: err_code=" +
+                                 std::to_string(err_code));
+      }
+      written_length += result;
+    }
+
+    return;
+  }
+
+  void writev(const iovec* vectors, const size_t count) override {
+    size_t index{};
+    // Bytes of vectors[index] already written
+    size_t partial_length{};
+
+    while (index < count) {
+      if (partial_length > 0) {
+        write(static_cast<const uint8_t*>(vectors[index].iov_base) +
+                  partial_length,
+              vectors[index].iov_len - partial_length);
+        partial_length = 0;
+        ++index;
+        continue;
+      }
+
+      msghdr message{};
+      message.msg_iov = const_cast<iovec*>(vectors + index);
+      message.msg_iovlen = count - index;
+      const auto result = ::sendmsg(m_fd.get(), &message, MSG_NOSIGNAL);
+      if (result < 0) {
+        int err_code = errno;
+        if (err_code == EINTR) {
+          continue;
+        }
+        throw std::runtime_error("sendmsg failed: err_code=" +
+                                 std::to_string(err_code));
+      }
+
+      size_t written_length = result;
+      while (index < count && written_length >= vectors[index].iov_len) {
+        written_length -= vectors[index].iov_len;
+        ++index;
+      }
+      partial_length = written_length;
+    }
+
+    return;
+  }
+
+  void read(uint8_t* data, const size_t length) override {
+    size_t read_length{};
+
+    while (read_length < length) {
+      const auto result =
+          ::recv(m_fd.get(), data + read_length, length - read_length, 0);
+      if (result == 0) {
+        throw transport_closed("connection closed by peer");
+      }
+      if (result < 0) {
+        int err_code = errno;
+        if (err_code == EINTR) {
+          continue;
+        }
+        if (err_code == ECONNRESET) {
+          throw transport_closed("connection reset by peer");
+        }
+        throw std::runtime_error("recv failed: err_code=" +
+                                 std::to_string(err_code));
+      }
+      read_length += result;
+    }
+
+    return;
+  }
+
+  void sendfile(const int fd, const off_t offset,
+                const size_t length) override {
+    off_t current_offset{offset};
+    size_t sent_length{};
+
+    while (sent_length < length) {
+      const auto result = ::sendfile(m_fd.get(), fd, &current_offset,
+                                     length - sent_length);
+      if (result <= 0) {
+        int err_code = errno;
+        if (result < 0 && err_code == EINTR) {
+          continue;
+        }
+        throw std::runtime_error(
+            "sendfile failed: result=" + std::to_string(result) +
+            ", err_code=" + std::to_string(err_code));
+      }
+      sent_length += result;
+    }
+
+    return;
+  }
+
+  bool wait_readable(const std::chrono::milliseconds timeout) override {
+    return net::wait_for_events(m_fd.get(), POLLIN, timeout);
+  }
+
+  bool wait_readable(const std::chrono::milliseconds timeout,
+                     const int wake_fd) override {
+    return net::wait_for_events(m_fd.get(), POLLIN, wake_fd, timeout);
+  }
+
+ private:
+  net::socket_fd m_fd;
+};
+
+}  // namespace
+
+std::unique_ptr<i_transport> connect_cleartext(
+    const std::string& hostname, const uint16_t port,
+    const net::connect_options& options) {
+  return std::make_unique<tcp_transport>(
+      net::connect_tcp(hostname, port, options));
+}
+
+std::unique_ptr<i_transport> make_tcp_transport(const int fd) {
+  return std::make_unique<tcp_transport>(net::socket_fd{fd});
+}
+
+}  // namespace transport
+
+}  // namespace mh2c
@@ -0,0 +1,31 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_TRANSPORT_TCP_TRANSPORT_H_
+#define MH2C_TRANSPORT_TCP_TRANSPORT_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "mh2c/net/connect_options.h"
+#include "mh2c/transport/i_transport.h"
+
+namespace mh2c {
+
+namespace transport {
+
+// Cleartext TCP for HTTP/2 with prior knowledge (h2c).
+// cf. https://tools.ietf.org/html/rfc7540#section-3.4
+std::unique_ptr<i_transport> connect_cleartext(
+    const std::string& hostname, const uint16_t port,
+    const net::connect_options& options = {});
+
+// Takes ownership of a connected socket.
+std::unique_ptr<i_transport> make_tcp_transport(const int fd);
+
+}  // namespace transport
+
+}  // namespace mh2c
+
+#endif  // MH2C_TRANSPORT_TCP_TRANSPORT_H_
@@ -24,7 +24,7 @@ IntegralType bytes2integral(const RandomAccessIterator begin) {
   auto shift_bit = (size - 1) * BITS_IN_BYTE;
 
   for (auto ite = begin; ite != end; ++ite) {
-    result += *ite << shift_bit;
+    result += static_cast<IntegralType>(*ite) << shift_bit;
     shift_bit -= BITS_IN_BYTE;
   }
 
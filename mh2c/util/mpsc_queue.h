@@ -0,0 +1,47 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_UTIL_MPSC_QUEUE_H_
+#define MH2C_UTIL_MPSC_QUEUE_H_
+
+#include <atomic>
+
+namespace mh2c {
+
+// Unbounded FIFO that any number of threads push to without a lock, each
+// with a single atomic exchange, and one consumer thread pops from. Values
+// pushed stay out of reach of try_pop() while a push() that took its place
+// in the queue before them has not linked its node yet.
+// The algorithm is Dmitry Vyukov's non-intrusive MPSC node-based queue.
+template <typename T>
+class mpsc_queue {
+ public:
+  mpsc_queue();
+  ~mpsc_queue();
+
+  mpsc_queue(const mpsc_queue&) = delete;
+  mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+  void push(T value);
+  // Consumer only. Returns false when empty.
+  bool try_pop(T* value);
+  // Consumer only
+  bool is_empty() const;
+
+ private:
+  struct node {
+    std::atomic<node*> m_next;
+    T m_value;
+  };
+
+  // Last node pushed
+  alignas(64) std::atomic<node*> m_head;
+  // Node before the first value, owned by the consumer
+  alignas(64) node* m_tail;
+};
+
+}  // namespace mh2c
+
+#include "mh2c/util/mpsc_queue.ipp"
+
+#endif  // MH2C_UTIL_MPSC_QUEUE_H_
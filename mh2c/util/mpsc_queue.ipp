@@ -0,0 +1,52 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_UTIL_MPSC_QUEUE_IPP_
+#define MH2C_UTIL_MPSC_QUEUE_IPP_
+
+#include <atomic>
+#include <utility>
+
+namespace mh2c {
+
+template <typename T>
+mpsc_queue<T>::mpsc_queue() : m_head{new node{{nullptr}, T{}}}, m_tail{} {
+  m_tail = m_head.load(std::memory_order_relaxed);
+}
+
+template <typename T>
+mpsc_queue<T>::~mpsc_queue() {
+  while (m_tail != nullptr) {
+    const auto next = m_tail->m_next.load(std::memory_order_relaxed);
+    delete std::exchange(m_tail, next);
+  }
+}
+
+template <typename T>
+void mpsc_queue<T>::push(T value) {
+  auto pushed = new node{{nullptr}, std::move(value)};
+  const auto previous = m_head.exchange(pushed, std::memory_order_acq_rel);
+  // Until this store the consumer sees the queue end at previous.
+  previous->m_next.store(pushed, std::memory_order_release);
+  return;
+}
+
+template <typename T>
+bool mpsc_queue<T>::try_pop(T* value) {
+  const auto next = m_tail->m_next.load(std::memory_order_acquire);
+  if (next == nullptr) {
+    return false;
+  }
+  *value = std::move(next->m_value);
+  delete std::exchange(m_tail, next);
+  return true;
+}
+
+template <typename T>
+bool mpsc_queue<T>::is_empty() const {
+  return m_tail->m_next.load(std::memory_order_acquire) == nullptr;
+}
+
+}  // namespace mh2c
+
+#endif  // MH2C_UTIL_MPSC_QUEUE_IPP_
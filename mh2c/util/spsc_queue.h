@@ -0,0 +1,42 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_UTIL_SPSC_QUEUE_H_
+#define MH2C_UTIL_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace mh2c {
+
+// Bounded lock-free FIFO between exactly one producer thread and one consumer
+// thread. The capacity is rounded up to a power of two.
+template <typename T>
+class spsc_queue {
+ public:
+  explicit spsc_queue(const size_t capacity);
+
+  spsc_queue(const spsc_queue&) = delete;
+  spsc_queue& operator=(const spsc_queue&) = delete;
+
+  // Producer only. Returns false, leaving value as it is, when full.
+  bool try_push(T&& value);
+  // Consumer only. Returns false when empty.
+  bool try_pop(T* value);
+  bool is_empty() const;
+  size_t get_capacity() const;
+
+ private:
+  std::vector<T> m_slots;
+  size_t m_mask;
+  // On their own cache lines so that the two threads do not contend
+  alignas(64) std::atomic<size_t> m_head;
+  alignas(64) std::atomic<size_t> m_tail;
+};
+
+}  // namespace mh2c
+
+#include "mh2c/util/spsc_queue.ipp"
+
+#endif  // MH2C_UTIL_SPSC_QUEUE_H_
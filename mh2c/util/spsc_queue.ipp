@@ -0,0 +1,59 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE.
+#ifndef MH2C_UTIL_SPSC_QUEUE_IPP_
+#define MH2C_UTIL_SPSC_QUEUE_IPP_
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace mh2c {
+
+template <typename T>
+spsc_queue<T>::spsc_queue(const size_t capacity)
+    : m_slots{}, m_mask{0}, m_head{0}, m_tail{0} {
+  size_t size{1u};
+  while (size < capacity) {
+    size <<= 1u;
+  }
+  m_slots.resize(size);
+  m_mask = size - 1u;
+}
+
+template <typename T>
+bool spsc_queue<T>::try_push(T&& value) {
+  const auto tail = m_tail.load(std::memory_order_relaxed);
+  if (tail - m_head.load(std::memory_order_acquire) > m_mask) {
+    return false;
+  }
+  m_slots[tail & m_mask] = std::move(value);
+  m_tail.store(tail + 1u, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+bool spsc_queue<T>::try_pop(T* value) {
+  const auto head = m_head.load(std::memory_order_relaxed);
+  if (head == m_tail.load(std::memory_order_acquire)) {
+    return false;
+  }
+  *value = std::move(m_slots[head & m_mask]);
+  m_head.store(head + 1u, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+bool spsc_queue<T>::is_empty() const {
+  return m_head.load(std::memory_order_acquire) ==
+         m_tail.load(std::memory_order_acquire);
+}
+
+template <typename T>
+size_t spsc_queue<T>::get_capacity() const {
+  return m_slots.size();
+}
+
+}  // namespace mh2c
+
+#endif  // MH2C_UTIL_SPSC_QUEUE_IPP_
@@ -51,43 +51,31 @@ int main() {
   mh2c::http2_client h2_client{host, port,
                                mh2c::ssl::verify_mode::VERIFY_SERVER_CERT};
 
-  // Connection preface
-  h2_client.send_connection_preface();
-
-  // Send settings frame
-  mh2c::fh_flags_t flags{0u};
-  mh2c::fh_stream_id_t stream_id{0u};
+  // Connection preface and settings frame exchange
   const size_t initial_table_size{8192u};
   const auto sf_payload{mh2c::make_sf_payload(
       {{mh2c::sf_parameter::SETTINGS_ENABLE_PUSH, 0u},
        {mh2c::sf_parameter::SETTINGS_INITIAL_WINDOW_SIZE, 65535u},
        {mh2c::sf_parameter::SETTINGS_HEADER_TABLE_SIZE, initial_table_size}})};
-  mh2c::settings_frame sf{flags, stream_id, sf_payload};
-  h2_client.send_frame(sf);
+  // The SETTINGS of the server is acknowledged by the client itself.
+  const auto frame = h2_client.exchange_settings(sf_payload);
   h2_client.update_request_dynamic_table(initial_table_size);
-
-  // Receive settings frame
-  const auto frame = h2_client.receive_frame();
   std::cout << frame;
 
-  // Send settings frame (ack)
-  flags = make_frame_header_flags(mh2c::sf_flag::ACK);
-  stream_id = 0u;
-  const mh2c::settings_frame sf_ack{flags, stream_id, {}};
-  h2_client.send_frame(sf_ack);
-
   // Send headers frame
-  flags = make_frame_header_flags(mh2c::hf_flag::END_STREAM,
-                                  mh2c::hf_flag::END_HEADERS);
-  stream_id = 1u;
-  const mh2c::header_block_t header_block{
-      mh2c::make_header_block(mh2c::header_prefix_pattern::NEVER_INDEXED,
-                              mh2c::headers_t{
-                                  {":method", "GET"},
-                                  {":path", "/httpbin/headers"},
-                                  {":scheme", "https"},
-                                  {":authority", "nghttp2.org"},
-                              })};
+  const auto flags = make_frame_header_flags(mh2c::hf_flag::END_STREAM,
+                                             mh2c::hf_flag::END_HEADERS);
+  const mh2c::fh_stream_id_t stream_id{1u};
+  // Chooses whether each field goes into the dynamic table.
+  mh2c::indexing_policy indexing_policy{};
+  const mh2c::header_block_t header_block{indexing_policy.make_header_block(
+      mh2c::headers_t{
+          {":method", "GET"},
+          {":path", "/httpbin/headers"},
+          {":scheme", "https"},
+          {":authority", "nghttp2.org"},
+      },
+      h2_client.get_request_dynamic_table())};
   const auto mode = mh2c::header_encode_mode::HUFFMAN;
   mh2c::headers_frame hf{flags, stream_id, header_block, mode,
                          h2_client.get_request_dynamic_table()};
@@ -0,0 +1,138 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/body/body_source.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "mh2c/common/byte_array.h"
+
+namespace {
+
+// Drains the source in chunks of up to max_length bytes.
+std::string read_all(mh2c::body::i_body_source* source,
+                     const size_t max_length, size_t* chunk_count) {
+  std::string body{};
+  *chunk_count = 0;
+  while (true) {
+    const auto chunk = source->next(max_length);
+    body.append(chunk.m_data, chunk.m_data + chunk.m_length);
+    ++*chunk_count;
+    if (chunk.m_last) {
+      return body;
+    }
+    EXPECT_GT(chunk.m_length, 0u);
+  }
+}
+
+class file_body_source_test : public ::testing::Test {
+ protected:
+  void TearDown() override { std::remove(m_path.c_str()); }
+
+  void write_file(const std::string& content) {
+    std::ofstream file{m_path, std::ios::binary};
+    file << content;
+  }
+
+  const std::string m_path{::testing::TempDir() + "file_body_source.bin"};
+};
+
+}  // namespace
+
+TEST(buffer_body_source_test, view_and_owned_buffer) {
+  const std::string body{"0123456789"};
+  mh2c::body::buffer_body_source view{
+      reinterpret_cast<const uint8_t*>(body.data()), body.size()};
+  EXPECT_FALSE(view.next(0u).m_last);
+  size_t chunk_count{};
+  EXPECT_EQ(body, read_all(&view, 4u, &chunk_count));
+  EXPECT_EQ(3u, chunk_count);
+
+  mh2c::body::buffer_body_source owned{mh2c::byte_array_t(100u, 'x')};
+  EXPECT_EQ(std::string(100u, 'x'), read_all(&owned, 64u, &chunk_count));
+  EXPECT_EQ(2u, chunk_count);
+
+  // An empty body ends even when nothing may be sent
+  mh2c::body::buffer_body_source empty{mh2c::byte_array_t{}};
+  EXPECT_TRUE(empty.next(0u).m_last);
+}
+
+TEST(producer_body_source_test, produce_until_empty) {
+  int calls{};
+  mh2c::body::producer_body_source source{
+      [&calls](uint8_t* buffer, const size_t max_length) -> size_t {
+        if (calls++ == 3) {
+          return 0u;
+        }
+        std::fill(buffer, buffer + max_length, 'p');
+        return max_length;
+      }};
+
+  EXPECT_FALSE(source.next(0u).m_last);
+  EXPECT_EQ(0, calls);
+  size_t chunk_count{};
+  EXPECT_EQ(std::string(30u, 'p'), read_all(&source, 10u, &chunk_count));
+  // The end is only known from an empty chunk.
+  EXPECT_EQ(4u, chunk_count);
+  EXPECT_TRUE(source.next(10u).m_last);
+}
+
+TEST(producer_body_source_test, reject_overrun) {
+  mh2c::body::producer_body_source source{
+      [](uint8_t*, const size_t max_length) { return max_length + 1u; }};
+  EXPECT_THROW(source.next(10u), std::out_of_range);
+}
+
+TEST_F(file_body_source_test, read_across_map_windows) {
+  const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  std::string content{};
+  for (size_t i = 0; i < page_size * 5u + 100u; ++i) {
+    content.push_back(static_cast<char>('a' + i % 26u));
+  }
+  write_file(content);
+
+  mh2c::body::file_body_source source{m_path, page_size * 2u};
+  EXPECT_EQ(content.size(), source.get_length());
+  size_t chunk_count{};
+  // Chunks end at the window boundaries too.
+  EXPECT_EQ(content, read_all(&source, page_size * 3u, &chunk_count));
+  EXPECT_EQ(3u, chunk_count);
+}
+
+TEST_F(file_body_source_test, send_file_ranges) {
+  write_file(std::string(100u, 'r'));
+  mh2c::body::file_body_source source{
+      m_path, mh2c::body::file_transfer_mode::SENDFILE};
+
+  auto chunk = source.next(64u);
+  EXPECT_EQ(nullptr, chunk.m_data);
+  EXPECT_EQ(64u, chunk.m_length);
+  EXPECT_FALSE(chunk.m_last);
+  EXPECT_NE(-1, chunk.m_fd);
+  EXPECT_EQ(0u, chunk.m_file_offset);
+  chunk = source.next(64u);
+  EXPECT_EQ(36u, chunk.m_length);
+  EXPECT_TRUE(chunk.m_last);
+  EXPECT_EQ(64u, chunk.m_file_offset);
+}
+
+TEST_F(file_body_source_test, empty_file) {
+  write_file("");
+  mh2c::body::file_body_source source{m_path};
+  EXPECT_EQ(0u, source.get_length());
+  EXPECT_TRUE(source.next(0u).m_last);
+}
+
+TEST_F(file_body_source_test, reject_invalid_arguments) {
+  EXPECT_THROW(mh2c::body::file_body_source{m_path + ".missing"},
+               std::runtime_error);
+  write_file("x");
+  EXPECT_THROW((mh2c::body::file_body_source{m_path, 100u}),
+               std::invalid_argument);
+}
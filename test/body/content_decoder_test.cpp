@@ -0,0 +1,171 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/body/content_decoder.h"
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "mh2c/common/byte_array.h"
+
+namespace {
+
+constexpr int GZIP_FORMAT{MAX_WBITS + 16};
+constexpr int ZLIB_FORMAT{MAX_WBITS};
+constexpr int RAW_FORMAT{-MAX_WBITS};
+
+mh2c::byte_array_t compress(const std::string& text, const int window_bits) {
+  z_stream stream{};
+  EXPECT_EQ(Z_OK, deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                               window_bits, 8, Z_DEFAULT_STRATEGY));
+  mh2c::byte_array_t compressed(deflateBound(&stream, text.size()));
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+  stream.avail_in = static_cast<uInt>(text.size());
+  stream.next_out = compressed.data();
+  stream.avail_out = static_cast<uInt>(compressed.size());
+  EXPECT_EQ(Z_STREAM_END, deflate(&stream, Z_FINISH));
+  compressed.resize(stream.total_out);
+  deflateEnd(&stream);
+  return compressed;
+}
+
+std::string make_text() {
+  std::string text{};
+  for (int i = 0; i < 2000; ++i) {
+    text += "line " + std::to_string(i) + " of a compressible body\n";
+  }
+  return text;
+}
+
+// Records the largest piece it was given
+class recording_sink : public mh2c::body::buffer_body_sink {
+ public:
+  void on_data(const uint8_t* data, const size_t length) override {
+    m_max_length = std::max(m_max_length, length);
+    buffer_body_sink::on_data(data, length);
+  }
+
+  std::string get_text() const {
+    return {get_buffer().begin(), get_buffer().end()};
+  }
+
+  size_t m_max_length{0u};
+};
+
+// Feeds the coded body piece_length bytes at a time, as DATA frames would
+void decode_in_pieces(mh2c::body::content_decoder* decoder,
+                      const mh2c::byte_array_t& coded,
+                      const size_t piece_length) {
+  for (size_t offset = 0; offset < coded.size(); offset += piece_length) {
+    decoder->decode(coded.data() + offset,
+                    std::min(piece_length, coded.size() - offset));
+  }
+  decoder->finish();
+}
+
+}  // namespace
+
+TEST(content_decoder, gzip_with_bounded_output) {
+  const auto text = make_text();
+  const auto coded = compress(text, GZIP_FORMAT);
+  ASSERT_LT(coded.size() * 4u, text.size());
+
+  for (const size_t piece_length : {size_t{1u}, size_t{1000u}, coded.size()}) {
+    const auto sink = std::make_shared<recording_sink>();
+    mh2c::body::content_decoder decoder{mh2c::body::content_coding::GZIP,
+                                        sink, 256u};
+    decode_in_pieces(&decoder, coded, piece_length);
+
+    EXPECT_EQ(text, sink->get_text());
+    EXPECT_TRUE(sink->is_complete());
+    EXPECT_LE(sink->m_max_length, 256u);
+    EXPECT_EQ(text.size(), decoder.get_decoded_length());
+  }
+}
+
+TEST(content_decoder, deflate_zlib_and_raw) {
+  const auto text = make_text();
+  for (const int format : {ZLIB_FORMAT, RAW_FORMAT}) {
+    const auto sink = std::make_shared<recording_sink>();
+    mh2c::body::content_decoder decoder{mh2c::body::content_coding::DEFLATE,
+                                        sink};
+    // The first piece holds a single byte of the zlib header.
+    decode_in_pieces(&decoder, compress(text, format), 1u);
+    EXPECT_EQ(text, sink->get_text());
+  }
+}
+
+TEST(content_decoder, concatenated_gzip_members) {
+  auto coded = compress("first member, ", GZIP_FORMAT);
+  const auto second = compress("second member", GZIP_FORMAT);
+  coded.insert(coded.end(), second.begin(), second.end());
+
+  const auto sink = std::make_shared<recording_sink>();
+  mh2c::body::content_decoder decoder{mh2c::body::content_coding::GZIP, sink};
+  decode_in_pieces(&decoder, coded, 7u);
+  EXPECT_EQ("first member, second member", sink->get_text());
+}
+
+TEST(content_decoder, identity_and_empty_body) {
+  const auto sink = std::make_shared<recording_sink>();
+  mh2c::body::content_decoder identity{mh2c::body::content_coding::IDENTITY,
+                                       sink};
+  const mh2c::byte_array_t body{'a', 'b', 'c'};
+  identity.decode(body.data(), body.size());
+  identity.finish();
+  EXPECT_EQ("abc", sink->get_text());
+
+  const auto empty_sink = std::make_shared<recording_sink>();
+  mh2c::body::content_decoder gzip{mh2c::body::content_coding::GZIP,
+                                   empty_sink};
+  gzip.finish();
+  EXPECT_TRUE(empty_sink->is_complete());
+}
+
+TEST(content_decoder, reject_corrupt_and_truncated_bodies) {
+  const auto coded = compress(make_text(), GZIP_FORMAT);
+
+  mh2c::body::content_decoder truncated{
+      mh2c::body::content_coding::GZIP,
+      std::make_shared<mh2c::body::buffer_body_sink>()};
+  truncated.decode(coded.data(), coded.size() / 2u);
+  EXPECT_THROW(truncated.finish(), std::runtime_error);
+
+  auto corrupt_coded = coded;
+  corrupt_coded[0] ^= 0xffu;
+  mh2c::body::content_decoder corrupt{
+      mh2c::body::content_coding::GZIP,
+      std::make_shared<mh2c::body::buffer_body_sink>()};
+  EXPECT_THROW(corrupt.decode(corrupt_coded.data(), corrupt_coded.size()),
+               std::runtime_error);
+
+  auto trailing_coded = compress("body", ZLIB_FORMAT);
+  trailing_coded.push_back('x');
+  mh2c::body::content_decoder trailing{
+      mh2c::body::content_coding::DEFLATE,
+      std::make_shared<mh2c::body::buffer_body_sink>()};
+  EXPECT_THROW(trailing.decode(trailing_coded.data(), trailing_coded.size()),
+               std::runtime_error);
+}
+
+TEST(content_decoder, parse_content_coding) {
+  EXPECT_EQ(mh2c::body::content_coding::IDENTITY,
+            mh2c::body::parse_content_coding(""));
+  EXPECT_EQ(mh2c::body::content_coding::IDENTITY,
+            mh2c::body::parse_content_coding("identity"));
+  EXPECT_EQ(mh2c::body::content_coding::GZIP,
+            mh2c::body::parse_content_coding(" GZip "));
+  EXPECT_EQ(mh2c::body::content_coding::GZIP,
+            mh2c::body::parse_content_coding("x-gzip"));
+  EXPECT_EQ(mh2c::body::content_coding::DEFLATE,
+            mh2c::body::parse_content_coding("deflate"));
+  EXPECT_THROW(mh2c::body::parse_content_coding("br"), std::invalid_argument);
+  EXPECT_THROW(mh2c::body::parse_content_coding("gzip, deflate"),
+               std::invalid_argument);
+}
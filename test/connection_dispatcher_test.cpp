@@ -0,0 +1,258 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/connection_dispatcher.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/ping_frame.h"
+#include "mh2c/frame/settings_frame.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/http2_client.h"
+#include "mh2c/server/server_options.h"
+#include "mh2c/server/server_session.h"
+#include "mh2c/transport/memory_transport.h"
+#include "mh2c/util/bit_operation.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds POP_TIMEOUT{5000};
+
+struct response {
+  std::string m_status;
+  size_t m_body_size;
+};
+
+mh2c::header_block_t make_request(const std::string& path) {
+  return mh2c::make_header_block(
+      mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+      {{":method", "GET"},
+       {":scheme", "http"},
+       {":authority", "localhost"},
+       {":path", path}});
+}
+
+// Adds the frame to the response; returns true at END_STREAM.
+bool on_frame(const mh2c::h2_frame_ptr& frame, response* result) {
+  const auto fh = frame->get_header();
+  switch (mh2c::cast_to_frame_type_registry(fh.m_type)) {
+    case mh2c::frame_type_registry::HEADERS:
+      result->m_status =
+          dynamic_cast<const mh2c::headers_frame&>(*frame)
+              .get_payload()
+              .front()
+              .get_header()
+              .second;
+      return mh2c::is_flag_set(fh.m_flags, mh2c::hf_flag::END_STREAM);
+    case mh2c::frame_type_registry::DATA:
+      result->m_body_size += fh.m_length;
+      return mh2c::is_flag_set(fh.m_flags, mh2c::df_flag::END_STREAM);
+    default:
+      return false;
+  }
+}
+
+response receive_response(mh2c::dispatched_stream* stream) {
+  response result{};
+  while (true) {
+    const auto frame = stream->pop(POP_TIMEOUT);
+    if (frame == nullptr) {
+      ADD_FAILURE() << "no END_STREAM on stream " << stream->get_stream_id();
+      return result;
+    }
+    if (on_frame(frame, &result)) {
+      return result;
+    }
+  }
+}
+
+class connection_dispatcher_test : public ::testing::Test {
+ protected:
+  void start(const mh2c::server::server_options& options,
+             const mh2c::dispatcher_options& dispatcher_options = {}) {
+    auto [client_transport, server_transport] =
+        mh2c::transport::make_memory_transport_pair();
+    m_server_thread = std::thread{
+        [options, transport = std::move(server_transport)]() mutable {
+          mh2c::server::server_session{std::move(transport), options}.run();
+        }};
+
+    auto client =
+        std::make_unique<mh2c::http2_client>(std::move(client_transport));
+    client->exchange_settings({});
+    m_dispatcher = std::make_unique<mh2c::connection_dispatcher>(
+        std::move(client), dispatcher_options);
+  }
+
+  void TearDown() override {
+    m_dispatcher.reset();
+    m_server_thread.join();
+  }
+
+  std::unique_ptr<mh2c::connection_dispatcher> m_dispatcher;
+  std::thread m_server_thread;
+};
+
+}  // namespace
+
+TEST_F(connection_dispatcher_test, share_connection_among_threads) {
+  constexpr int THREADS{8};
+  constexpr int REQUESTS{20};
+  mh2c::server::server_options options{};
+  options.m_default_response = {200u, {}, 100u};
+  start(options);
+
+  std::atomic<int> completed{0};
+  std::vector<std::thread> threads{};
+  for (int i = 0; i < THREADS; ++i) {
+    threads.emplace_back([this, i, &completed]() {
+      for (int j = 0; j < REQUESTS; ++j) {
+        const auto stream = m_dispatcher->submit(
+            make_request("/" + std::to_string(i) + "/" + std::to_string(j)),
+            mh2c::header_encode_mode::HUFFMAN);
+        const auto result = receive_response(stream.get());
+        EXPECT_EQ("200", result.m_status);
+        EXPECT_EQ(100u, result.m_body_size);
+        EXPECT_EQ(1u, stream->get_stream_id() % 2u);
+        // Once the reader thread has ended the stream
+        EXPECT_EQ(nullptr, stream->pop(POP_TIMEOUT));
+        EXPECT_TRUE(stream->is_finished());
+        ++completed;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(THREADS * REQUESTS, completed.load());
+  EXPECT_EQ(nullptr, m_dispatcher->get_error());
+}
+
+TEST_F(connection_dispatcher_test, set_aside_frames_of_full_queue) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {200u, {}, 100000u};
+  mh2c::dispatcher_options dispatcher_options{};
+  dispatcher_options.m_stream_queue_capacity = 1u;
+  start(options, dispatcher_options);
+  // Opens the receive windows as the bodies arrive
+  m_dispatcher->post(
+      [](mh2c::http2_client* client) { client->enable_window_autotuning(); });
+
+  // The frames keep arriving on the other stream meanwhile.
+  const auto stalled = m_dispatcher->submit(
+      make_request("/stalled"), mh2c::header_encode_mode::HUFFMAN);
+  const auto other = m_dispatcher->submit(make_request("/other"),
+                                          mh2c::header_encode_mode::HUFFMAN);
+  EXPECT_EQ(100000u, receive_response(other.get()).m_body_size);
+  EXPECT_FALSE(stalled->is_finished());
+  EXPECT_EQ(100000u, receive_response(stalled.get()).m_body_size);
+}
+
+TEST_F(connection_dispatcher_test, deliver_to_callback) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {200u, {}, 20000u};
+  std::promise<void> pinged{};
+  mh2c::dispatcher_options dispatcher_options{};
+  dispatcher_options.m_on_connection_frame =
+      [&pinged](const mh2c::h2_frame_ptr& frame) {
+        const auto fh = frame->get_header();
+        if (mh2c::cast_to_frame_type_registry(fh.m_type) ==
+                mh2c::frame_type_registry::PING &&
+            mh2c::is_flag_set(fh.m_flags, mh2c::pf_flag::ACK)) {
+          pinged.set_value();
+        }
+      };
+  start(options, dispatcher_options);
+
+  std::promise<response> completed{};
+  response result{};
+  m_dispatcher->submit(
+      make_request("/"), mh2c::header_encode_mode::HUFFMAN,
+      [&completed, &result](mh2c::h2_frame_ptr frame,
+                            std::exception_ptr error) {
+        if (error) {
+          completed.set_exception(error);
+        } else if (on_frame(frame, &result)) {
+          completed.set_value(result);
+        }
+      });
+  auto future = completed.get_future();
+  ASSERT_EQ(std::future_status::ready, future.wait_for(POP_TIMEOUT));
+  const auto received = future.get();
+  EXPECT_EQ("200", received.m_status);
+  EXPECT_EQ(20000u, received.m_body_size);
+
+  m_dispatcher->post_frame(
+      mh2c::ping_frame{0u, {1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u}});
+  EXPECT_EQ(std::future_status::ready,
+            pinged.get_future().wait_for(POP_TIMEOUT));
+}
+
+TEST_F(connection_dispatcher_test, queue_requests_beyond_stream_limit) {
+  constexpr size_t REQUESTS{12u};
+  mh2c::server::server_options options{};
+  options.m_settings = mh2c::make_sf_payload(
+      {{mh2c::sf_parameter::SETTINGS_MAX_CONCURRENT_STREAM, 2u}});
+  options.m_default_response = {200u, {}, 1000u};
+  start(options);
+
+  std::vector<std::shared_ptr<mh2c::dispatched_stream>> streams{};
+  for (size_t i = 0; i < REQUESTS; ++i) {
+    streams.push_back(m_dispatcher->submit(make_request("/"),
+                                           mh2c::header_encode_mode::HUFFMAN));
+  }
+  // Sent in the order submitted as the streams before them close
+  for (size_t i = 0; i < REQUESTS; ++i) {
+    const auto result = receive_response(streams[i].get());
+    EXPECT_EQ("200", result.m_status);
+    EXPECT_EQ(1000u, result.m_body_size);
+    EXPECT_EQ(1u + 2u * i, streams[i]->get_stream_id());
+  }
+  EXPECT_EQ(nullptr, m_dispatcher->get_error());
+}
+
+TEST_F(connection_dispatcher_test, fail_streams_left_unprocessed) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {200u, {}, 10u};
+  options.m_max_requests = 1u;
+  start(options);
+
+  std::vector<std::shared_ptr<mh2c::dispatched_stream>> streams{};
+  for (int i = 0; i < 3; ++i) {
+    streams.push_back(m_dispatcher->submit(make_request("/"),
+                                           mh2c::header_encode_mode::HUFFMAN));
+  }
+  EXPECT_EQ(10u, receive_response(streams[0].get()).m_body_size);
+  for (int i = 1; i < 3; ++i) {
+    EXPECT_THROW(receive_response(streams[i].get()),
+                 mh2c::stream_unprocessed);
+    EXPECT_TRUE(streams[i]->is_finished());
+  }
+
+  // The server closes the connection once it has drained.
+  const auto deadline = std::chrono::steady_clock::now() + POP_TIMEOUT;
+  while (m_dispatcher->get_error() == nullptr &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  }
+  ASSERT_NE(nullptr, m_dispatcher->get_error());
+  const auto late = m_dispatcher->submit(make_request("/"),
+                                         mh2c::header_encode_mode::HUFFMAN);
+  EXPECT_ANY_THROW(late->pop(POP_TIMEOUT));
+}
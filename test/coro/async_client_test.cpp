@@ -0,0 +1,221 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/coro/async_client.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <coroutine>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mh2c/body/body_source.h"
+#include "mh2c/connection_dispatcher.h"
+#include "mh2c/coro/task.h"
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/error_codes.h"
+#include "mh2c/frame/frame_builder.h"
+#include "mh2c/frame/settings_frame.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/http2_client.h"
+#include "mh2c/server/server_options.h"
+#include "mh2c/server/server_session.h"
+#include "mh2c/transport/memory_transport.h"
+
+namespace {
+
+struct response {
+  std::string m_status;
+  size_t m_body_size;
+};
+
+// Requests in flight, and the most there were at a time
+struct concurrency {
+  size_t m_current;
+  size_t m_peak;
+};
+
+mh2c::header_block_t make_request(const std::string& path) {
+  return mh2c::make_header_block(
+      mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+      {{":method", "GET"},
+       {":scheme", "http"},
+       {":authority", "localhost"},
+       {":path", path}});
+}
+
+mh2c::coro::task<response> read_response(mh2c::coro::response_stream stream) {
+  response result{};
+  for (const auto& header : co_await stream.read_headers()) {
+    if (header.first == ":status") {
+      result.m_status = header.second;
+    }
+  }
+  while (true) {
+    const auto chunk = co_await stream.read_body_chunk();
+    if (chunk.empty()) {
+      co_return result;
+    }
+    result.m_body_size += chunk.size();
+  }
+}
+
+mh2c::coro::task<> fetch(mh2c::coro::async_client* client,
+                         const std::string path, concurrency* in_flight,
+                         std::vector<response>* responses) {
+  auto stream = co_await client->request(make_request(path),
+                                         mh2c::header_encode_mode::HUFFMAN);
+  in_flight->m_peak = std::max(in_flight->m_peak, ++in_flight->m_current);
+  responses->push_back(co_await read_response(std::move(stream)));
+  --in_flight->m_current;
+}
+
+mh2c::coro::task<> fetch_unprocessed(mh2c::coro::async_client* client,
+                                     std::vector<std::string>* results) {
+  auto stream = co_await client->request(make_request("/"),
+                                         mh2c::header_encode_mode::HUFFMAN);
+  try {
+    co_await read_response(std::move(stream));
+    results->push_back("processed");
+  } catch (const mh2c::stream_unprocessed&) {
+    results->push_back("unprocessed");
+  }
+}
+
+mh2c::coro::task<> fail_after_response(mh2c::coro::async_client* client) {
+  co_await read_response(co_await client->request(
+      make_request("/"), mh2c::header_encode_mode::HUFFMAN));
+  throw std::logic_error("failed");
+}
+
+// Records the error that ended the connection, then waits for something that
+// never comes
+mh2c::coro::task<> wait_after_failure(mh2c::coro::async_client* client,
+                                      std::vector<std::string>* results) {
+  try {
+    co_await read_response(co_await client->request(
+        make_request("/"), mh2c::header_encode_mode::HUFFMAN));
+  } catch (const mh2c::connection_error&) {
+    results->push_back("failed");
+  }
+  co_await std::suspend_always{};
+}
+
+class async_client_test : public ::testing::Test {
+ protected:
+  void start(const mh2c::server::server_options& options) {
+    auto [client_transport, server_transport] =
+        mh2c::transport::make_memory_transport_pair();
+    m_server_thread = std::thread{
+        [options, transport = std::move(server_transport)]() mutable {
+          mh2c::server::server_session{std::move(transport), options}.run();
+        }};
+
+    auto client =
+        std::make_unique<mh2c::http2_client>(std::move(client_transport));
+    client->exchange_settings({});
+    m_client = std::make_unique<mh2c::coro::async_client>(std::move(client));
+  }
+
+  // Connects to a peer driven by the test instead of a server
+  void start_with_peer() {
+    auto [client_transport, peer_transport] =
+        mh2c::transport::make_memory_transport_pair();
+    m_peer = std::move(peer_transport);
+    send_to_client(mh2c::settings_frame{0u, 0u, {}});
+
+    auto client =
+        std::make_unique<mh2c::http2_client>(std::move(client_transport));
+    client->exchange_settings({});
+    m_client = std::make_unique<mh2c::coro::async_client>(std::move(client));
+  }
+
+  template <typename Frame>
+  void send_to_client(const Frame& frame) {
+    const auto raw_frame = frame.serialize();
+    m_peer->write(raw_frame.data(), raw_frame.size());
+  }
+
+  void TearDown() override {
+    m_client.reset();
+    if (m_server_thread.joinable()) {
+      m_server_thread.join();
+    }
+  }
+
+  std::unique_ptr<mh2c::coro::async_client> m_client;
+  std::thread m_server_thread;
+  std::unique_ptr<mh2c::transport::i_transport> m_peer;
+};
+
+}  // namespace
+
+TEST_F(async_client_test, run_requests_concurrently) {
+  constexpr size_t REQUESTS{40u};
+  mh2c::server::server_options options{};
+  options.m_settings = mh2c::make_sf_payload(
+      {{mh2c::sf_parameter::SETTINGS_MAX_CONCURRENT_STREAM, 4u}});
+  options.m_default_response = {200u, {}, 100000u};
+  start(options);
+
+  concurrency in_flight{};
+  std::vector<response> responses{};
+  for (size_t i = 0; i < REQUESTS; ++i) {
+    m_client->spawn(
+        fetch(m_client.get(), "/" + std::to_string(i), &in_flight, &responses));
+  }
+  m_client->run();
+
+  ASSERT_EQ(REQUESTS, responses.size());
+  for (const auto& result : responses) {
+    EXPECT_EQ("200", result.m_status);
+    EXPECT_EQ(100000u, result.m_body_size);
+  }
+  EXPECT_EQ(0u, in_flight.m_current);
+  EXPECT_EQ(4u, in_flight.m_peak);
+}
+
+TEST_F(async_client_test, fail_streams_left_unprocessed) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {200u, {}, 10u};
+  options.m_max_requests = 1u;
+  start(options);
+
+  std::vector<std::string> results{};
+  for (int i = 0; i < 3; ++i) {
+    m_client->spawn(fetch_unprocessed(m_client.get(), &results));
+  }
+  m_client->run();
+
+  std::sort(results.begin(), results.end());
+  EXPECT_EQ((std::vector<std::string>{"processed", "unprocessed",
+                                      "unprocessed"}),
+            results);
+}
+
+TEST_F(async_client_test, rethrow_exception_of_coroutine) {
+  mh2c::server::server_options options{};
+  start(options);
+
+  m_client->spawn(fail_after_response(m_client.get()));
+  EXPECT_THROW(m_client->run(), std::logic_error);
+}
+
+TEST_F(async_client_test, stop_once_connection_failed) {
+  start_with_peer();
+  // Pad Length past the end of the frame
+  send_to_client(mh2c::data_frame{
+      mh2c::make_frame_header_flags(mh2c::df_flag::PADDED), 1u,
+      mh2c::byte_array_t{0x05, 'x'}});
+
+  std::vector<std::string> results{};
+  m_client->spawn(wait_after_failure(m_client.get(), &results));
+  m_client->spawn(wait_after_failure(m_client.get(), &results));
+  EXPECT_THROW(m_client->run(), mh2c::connection_error);
+  EXPECT_EQ((std::vector<std::string>{"failed", "failed"}), results);
+}
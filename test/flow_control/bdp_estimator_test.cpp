@@ -0,0 +1,87 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/flow_control/bdp_estimator.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+namespace {
+
+using clock_type = mh2c::flow_control::bdp_estimator::clock_type;
+constexpr std::chrono::milliseconds SAMPLE_INTERVAL{100};
+
+}  // namespace
+
+TEST(bdp_estimator_test, request_ping_only_when_no_sample_in_flight) {
+  mh2c::flow_control::bdp_estimator estimator{65535u, 1u << 24,
+                                              SAMPLE_INTERVAL};
+  const auto now = clock_type::now();
+
+  EXPECT_TRUE(estimator.on_data_received(1000u, now));
+  estimator.on_ping_sent(now);
+  EXPECT_TRUE(estimator.is_ping_in_flight());
+  EXPECT_FALSE(estimator.on_data_received(1000u, now));
+}
+
+TEST(bdp_estimator_test, measure_rtt_and_bdp) {
+  mh2c::flow_control::bdp_estimator estimator{65535u, 1u << 24,
+                                              SAMPLE_INTERVAL};
+  const auto begin = clock_type::now();
+
+  estimator.on_ping_sent(begin);
+  estimator.on_data_received(5000u, begin + std::chrono::milliseconds{5});
+  estimator.on_ping_ack(begin + std::chrono::milliseconds{10});
+
+  EXPECT_EQ(std::chrono::milliseconds{10}, estimator.get_smoothed_rtt());
+  EXPECT_EQ(5000u, estimator.get_bdp());
+  EXPECT_DOUBLE_EQ(500000.0, estimator.get_bandwidth());
+  EXPECT_FALSE(estimator.is_ping_in_flight());
+}
+
+TEST(bdp_estimator_test, grow_window_when_sample_fills_window) {
+  mh2c::flow_control::bdp_estimator estimator{65535u, 1u << 24,
+                                              SAMPLE_INTERVAL};
+  const auto begin = clock_type::now();
+
+  estimator.on_ping_sent(begin);
+  estimator.on_data_received(60000u, begin);
+  EXPECT_TRUE(estimator.on_ping_ack(begin + std::chrono::milliseconds{10}));
+  EXPECT_EQ(120000u, estimator.get_window());
+}
+
+TEST(bdp_estimator_test, keep_window_for_small_bdp) {
+  mh2c::flow_control::bdp_estimator estimator{65535u, 1u << 24,
+                                              SAMPLE_INTERVAL};
+  const auto begin = clock_type::now();
+
+  estimator.on_ping_sent(begin);
+  estimator.on_data_received(1000u, begin);
+  EXPECT_FALSE(estimator.on_ping_ack(begin + std::chrono::milliseconds{10}));
+  EXPECT_EQ(65535u, estimator.get_window());
+}
+
+TEST(bdp_estimator_test, cap_window_at_max_window) {
+  mh2c::flow_control::bdp_estimator estimator{65535u, 100000u,
+                                              SAMPLE_INTERVAL};
+  const auto begin = clock_type::now();
+
+  estimator.on_ping_sent(begin);
+  estimator.on_data_received(65535u, begin);
+  EXPECT_TRUE(estimator.on_ping_ack(begin + std::chrono::milliseconds{10}));
+  EXPECT_EQ(100000u, estimator.get_window());
+}
+
+TEST(bdp_estimator_test, wait_sample_interval_before_next_ping) {
+  mh2c::flow_control::bdp_estimator estimator{65535u, 1u << 24,
+                                              SAMPLE_INTERVAL};
+  const auto begin = clock_type::now();
+  const auto ack_time = begin + std::chrono::milliseconds{10};
+
+  estimator.on_ping_sent(begin);
+  estimator.on_ping_ack(ack_time);
+
+  EXPECT_FALSE(estimator.on_data_received(1000u, ack_time));
+  EXPECT_TRUE(estimator.on_data_received(1000u, ack_time + SAMPLE_INTERVAL));
+}
@@ -0,0 +1,36 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/flow_control/receive_window.h"
+
+#include <gtest/gtest.h>
+
+TEST(receive_window_test, replenish_after_half_window_consumed) {
+  mh2c::flow_control::receive_window window{65535u};
+
+  EXPECT_TRUE(window.consume(1u, 30000u, false).empty());
+
+  const mh2c::flow_control::window_updates_t expected_updates{{0u, 40000u},
+                                                              {1u, 40000u}};
+  EXPECT_EQ(expected_updates, window.consume(1u, 10000u, false));
+  EXPECT_TRUE(window.consume(1u, 10000u, false).empty());
+}
+
+TEST(receive_window_test, skip_stream_update_at_end_of_stream) {
+  mh2c::flow_control::receive_window window{65535u};
+
+  const mh2c::flow_control::window_updates_t expected_updates{{0u, 40000u}};
+  EXPECT_EQ(expected_updates, window.consume(1u, 40000u, true));
+}
+
+TEST(receive_window_test, resize_windows) {
+  mh2c::flow_control::receive_window window{65535u};
+
+  EXPECT_EQ(34465u, window.resize_connection_window(100000u));
+  EXPECT_EQ(0u, window.resize_connection_window(80000u));
+  EXPECT_EQ(100000u, window.get_connection_window());
+
+  EXPECT_EQ(34465u, window.resize_stream_window(100000u));
+  EXPECT_EQ(100000u, window.get_stream_window());
+  EXPECT_TRUE(window.consume(1u, 40000u, false).empty());
+}
@@ -0,0 +1,36 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/flow_control/send_window.h"
+
+#include <gtest/gtest.h>
+
+TEST(send_window_test, limited_by_connection_and_stream) {
+  mh2c::flow_control::send_window window{};
+  EXPECT_EQ(65535u, window.get_available(1u));
+
+  window.consume(1u, 60000u);
+  EXPECT_EQ(5535u, window.get_available(1u));
+  EXPECT_EQ(5535u, window.get_available(3u));
+
+  window.on_window_update(0u, 100000u);
+  EXPECT_EQ(5535u, window.get_available(1u));
+  EXPECT_EQ(65535u, window.get_available(3u));
+
+  window.on_window_update(1u, 10000u);
+  EXPECT_EQ(15535u, window.get_available(1u));
+}
+
+TEST(send_window_test, initial_window_applies_to_open_streams) {
+  mh2c::flow_control::send_window window{};
+  window.consume(1u, 20000u);
+
+  // cf. https://tools.ietf.org/html/rfc7540#section-6.9.2
+  window.set_initial_stream_window(10000u);
+  EXPECT_EQ(-10000, window.get_stream_window(1u));
+  EXPECT_EQ(0u, window.get_available(1u));
+  EXPECT_EQ(10000u, window.get_available(3u));
+
+  window.close_stream(1u);
+  EXPECT_EQ(10000, window.get_stream_window(1u));
+}
@@ -12,6 +12,7 @@
 #include "mh2c/frame/common_type.h"
 #include "mh2c/frame/continuation_frame.h"
 #include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/error_codes.h"
 #include "mh2c/frame/frame_header.h"
 #include "mh2c/frame/goaway_frame.h"
 #include "mh2c/frame/headers_frame.h"
@@ -710,3 +711,16 @@ TEST(frame_builder_test, window_update_with_reserved) {
   EXPECT_EQ(expected_wuf,
             *dynamic_cast<mh2c::window_update_frame*>(frame.get()));
 }
+
+TEST(frame_builder_test, get_pad_length) {
+  EXPECT_EQ(0u, mh2c::get_pad_length({0x00}));
+  EXPECT_EQ(2u, mh2c::get_pad_length({0x02, 'a', 0x00, 0x00}));
+  EXPECT_EQ(3u, mh2c::get_pad_length({0x03, 0x00, 0x00, 0x00}));
+}
+
+// cf. https://tools.ietf.org/html/rfc7540#section-6.1
+TEST(frame_builder_test, reject_padding_longer_than_payload) {
+  EXPECT_THROW(mh2c::get_pad_length({}), mh2c::connection_error);
+  EXPECT_THROW(mh2c::get_pad_length({0x01}), mh2c::connection_error);
+  EXPECT_THROW(mh2c::get_pad_length({0xff, 'a', 'b'}), mh2c::connection_error);
+}
@@ -0,0 +1,187 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/frame/header_block_fragment.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/continuation_frame.h"
+#include "mh2c/frame/error_codes.h"
+#include "mh2c/frame/frame_builder.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_encoder.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/util/bit_operation.h"
+#include "mh2c/util/cast.h"
+
+namespace {
+
+const mh2c::header_block_t HEADER_BLOCK{mh2c::make_header_block(
+    mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+    mh2c::headers_t{{":authority", "example.com"},
+                    {"cookie", std::string(100u, 'c')},
+                    {"x-token", std::string(50u, 't')}})};
+
+}  // namespace
+
+TEST(header_block_fragment_test, fit_in_one_frame) {
+  const mh2c::dynamic_table dynamic_table{};
+  const auto encoded_block = mh2c::encode_header_block(
+      HEADER_BLOCK, mh2c::header_encode_mode::NONE, dynamic_table);
+
+  const auto frames = mh2c::fragment_header_block(
+      mh2c::make_frame_header_flags(mh2c::hf_flag::END_STREAM), 1u,
+      encoded_block, HEADER_BLOCK, 16384u);
+  ASSERT_EQ(1u, frames.size());
+  // The same bytes as encoding the block within the frame
+  EXPECT_EQ(mh2c::headers_frame(
+                mh2c::make_frame_header_flags(mh2c::hf_flag::END_STREAM,
+                                              mh2c::hf_flag::END_HEADERS),
+                1u, HEADER_BLOCK, mh2c::header_encode_mode::NONE,
+                dynamic_table)
+                .serialize(),
+            frames[0]->serialize());
+}
+
+TEST(header_block_fragment_test, split_and_reassemble) {
+  const mh2c::dynamic_table dynamic_table{};
+  const auto encoded_block = mh2c::encode_header_block(
+      HEADER_BLOCK, mh2c::header_encode_mode::NONE, dynamic_table);
+
+  const auto frames = mh2c::fragment_header_block(
+      mh2c::make_frame_header_flags(mh2c::hf_flag::END_STREAM,
+                                    mh2c::hf_flag::END_HEADERS),
+      3u, encoded_block, HEADER_BLOCK, 64u);
+  ASSERT_EQ(3u, frames.size());
+
+  auto fh = frames[0]->get_header();
+  EXPECT_EQ(mh2c::underlying_cast(mh2c::frame_type_registry::HEADERS),
+            fh.m_type);
+  EXPECT_EQ(mh2c::make_frame_header_flags(mh2c::hf_flag::END_STREAM),
+            fh.m_flags);
+  EXPECT_EQ(64u, fh.m_length);
+  EXPECT_EQ(HEADER_BLOCK, mh2c::get_header_block(*frames[0]));
+
+  auto raw_payload = frames[0]->serialize();
+  raw_payload.erase(raw_payload.begin(),
+                    raw_payload.begin() + mh2c::FRAME_HEADER_BYTES);
+  for (size_t i = 1; i < frames.size(); ++i) {
+    const auto continuation_fh = frames[i]->get_header();
+    EXPECT_EQ(
+        mh2c::underlying_cast(mh2c::frame_type_registry::CONTINUATION),
+        continuation_fh.m_type);
+    EXPECT_EQ(i + 1 == frames.size(),
+              mh2c::is_flag_set(continuation_fh.m_flags,
+                                mh2c::cf_flag::END_HEADERS));
+    auto raw_frame = frames[i]->serialize();
+    raw_frame.erase(raw_frame.begin(),
+                    raw_frame.begin() + mh2c::FRAME_HEADER_BYTES);
+    mh2c::append_header_block_fragment(continuation_fh, raw_frame, &fh,
+                                       &raw_payload);
+  }
+
+  EXPECT_EQ(encoded_block.size(), fh.m_length);
+  EXPECT_TRUE(mh2c::is_flag_set(fh.m_flags, mh2c::hf_flag::END_HEADERS));
+  EXPECT_TRUE(mh2c::is_flag_set(fh.m_flags, mh2c::hf_flag::END_STREAM));
+  const mh2c::headers_frame reassembled{fh, raw_payload, dynamic_table};
+  EXPECT_EQ(HEADER_BLOCK, reassembled.get_payload());
+}
+
+TEST(header_block_fragment_test, prioritized_headers) {
+  const mh2c::dynamic_table dynamic_table{};
+  const auto encoded_block = mh2c::encode_header_block(
+      HEADER_BLOCK, mh2c::header_encode_mode::NONE, dynamic_table);
+  const mh2c::hf_priority_option priority_option{1u, 5u, 200u};
+  const auto flags = mh2c::make_frame_header_flags(
+      mh2c::hf_flag::END_HEADERS, mh2c::hf_flag::PRIORITY);
+
+  const auto whole = mh2c::fragment_header_block(
+      flags, 7u, encoded_block, HEADER_BLOCK, 16384u, priority_option);
+  ASSERT_EQ(1u, whole.size());
+  EXPECT_EQ(mh2c::headers_frame(flags, 7u, HEADER_BLOCK,
+                                mh2c::header_encode_mode::NONE, dynamic_table,
+                                {}, priority_option)
+                .serialize(),
+            whole[0]->serialize());
+
+  // The priority fields take room in the first frame only.
+  const auto frames = mh2c::fragment_header_block(
+      flags, 7u, encoded_block, HEADER_BLOCK, 64u, priority_option);
+  ASSERT_LE(2u, frames.size());
+  EXPECT_EQ(64u, frames[0]->get_header().m_length);
+  EXPECT_EQ(64u, frames[1]->get_header().m_length);
+  auto raw_payload = frames[0]->serialize();
+  raw_payload.erase(raw_payload.begin(),
+                    raw_payload.begin() + mh2c::FRAME_HEADER_BYTES);
+  auto fh = frames[0]->get_header();
+  for (size_t i = 1; i < frames.size(); ++i) {
+    auto raw_frame = frames[i]->serialize();
+    raw_frame.erase(raw_frame.begin(),
+                    raw_frame.begin() + mh2c::FRAME_HEADER_BYTES);
+    mh2c::append_header_block_fragment(frames[i]->get_header(), raw_frame,
+                                       &fh, &raw_payload);
+  }
+  EXPECT_EQ(encoded_block.size() + mh2c::PRIORITY_FIELDS_BYTES, fh.m_length);
+  const mh2c::headers_frame reassembled{fh, raw_payload, dynamic_table};
+  EXPECT_EQ(HEADER_BLOCK, reassembled.get_payload());
+  EXPECT_EQ(priority_option, reassembled.get_priority_option());
+}
+
+TEST(header_block_fragment_test, reassemble_padded_headers) {
+  const mh2c::dynamic_table dynamic_table{};
+  const mh2c::headers_frame hf{
+      mh2c::make_frame_header_flags(mh2c::hf_flag::PADDED), 1u,
+      mh2c::header_block_t{HEADER_BLOCK.begin(), HEADER_BLOCK.begin() + 1},
+      mh2c::header_encode_mode::NONE, dynamic_table,
+      mh2c::byte_array_t{0u, 0u, 0u}};
+  auto fh = hf.get_header();
+  auto raw_payload = hf.serialize();
+  raw_payload.erase(raw_payload.begin(),
+                    raw_payload.begin() + mh2c::FRAME_HEADER_BYTES);
+
+  const mh2c::continuation_frame cf{
+      mh2c::make_frame_header_flags(mh2c::cf_flag::END_HEADERS), 1u,
+      mh2c::header_block_t{HEADER_BLOCK.begin() + 1, HEADER_BLOCK.end()},
+      mh2c::header_encode_mode::NONE, dynamic_table};
+  auto cf_payload = cf.serialize();
+  cf_payload.erase(cf_payload.begin(),
+                   cf_payload.begin() + mh2c::FRAME_HEADER_BYTES);
+  mh2c::append_header_block_fragment(cf.get_header(), cf_payload, &fh,
+                                     &raw_payload);
+
+  EXPECT_FALSE(mh2c::is_flag_set(fh.m_flags, mh2c::hf_flag::PADDED));
+  const mh2c::headers_frame reassembled{fh, raw_payload, dynamic_table};
+  EXPECT_EQ(HEADER_BLOCK, reassembled.get_payload());
+}
+
+TEST(header_block_fragment_test, reject_interrupted_header_block) {
+  mh2c::frame_header fh{
+      0u, mh2c::underlying_cast(mh2c::frame_type_registry::HEADERS), 0u, 0u,
+      1u};
+  mh2c::byte_array_t raw_payload{};
+
+  // cf. https://tools.ietf.org/html/rfc7540#section-6.10
+  const mh2c::frame_header data_fh{
+      0u, mh2c::underlying_cast(mh2c::frame_type_registry::DATA), 0u, 0u, 1u};
+  EXPECT_THROW(
+      mh2c::append_header_block_fragment(data_fh, {}, &fh, &raw_payload),
+      mh2c::connection_error);
+  const mh2c::frame_header other_stream_fh{
+      0u, mh2c::underlying_cast(mh2c::frame_type_registry::CONTINUATION), 0u,
+      0u, 3u};
+  EXPECT_THROW(mh2c::append_header_block_fragment(other_stream_fh, {}, &fh,
+                                                  &raw_payload),
+               mh2c::connection_error);
+
+  EXPECT_THROW(mh2c::fragment_header_block(
+                   mh2c::make_frame_header_flags(mh2c::hf_flag::PADDED), 1u,
+                   {}, {}, 16384u),
+               std::invalid_argument);
+}
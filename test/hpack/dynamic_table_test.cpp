@@ -93,3 +93,22 @@ TEST(dynamic_table, update_table_size) {
   EXPECT_EQ(updated_table_size, table.get_table_size());
   EXPECT_EQ(updated_table_size, table.get_max_table_size());
 }
+
+TEST(dynamic_table, bump_revision_on_change) {
+  mh2c::dynamic_table table{};
+  EXPECT_EQ(0u, table.get_revision());
+
+  table.push({":authority", "example.com"});
+  EXPECT_EQ(1u, table.get_revision());
+  table.update_table_size(0u);
+  EXPECT_EQ(2u, table.get_revision());
+}
+
+TEST(dynamic_table, push_header_larger_than_table) {
+  mh2c::dynamic_table table{64u};
+  table.push({"a", "b"});
+  table.push({"user-agent", "Mozilla/5.0 (X11; Linux x86_64)"});
+
+  EXPECT_TRUE(table.get_entries().empty());
+  EXPECT_EQ(0u, table.get_table_size());
+}
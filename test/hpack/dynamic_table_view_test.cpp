@@ -0,0 +1,86 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/hpack/dynamic_table_view.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+
+namespace {
+
+// 32 bytes of overhead take each entry to 40 bytes.
+const mh2c::header_t OLD_HEADER{"old", "12345"};
+const mh2c::header_t NEW_HEADER{"new", "12345"};
+
+// Expects the view to show the entries of table, in the same order
+void expect_same_entries(const mh2c::dynamic_table& table,
+                         const mh2c::dynamic_table_view& view) {
+  ASSERT_EQ(table.get_entries().size(), view.size());
+  for (size_t i = 0; i < view.size(); ++i) {
+    EXPECT_EQ(table.at(i), view.at(i));
+  }
+  EXPECT_THROW(view.at(view.size()), std::out_of_range);
+}
+
+}  // namespace
+
+TEST(dynamic_table_view, add_entries_in_front_of_table) {
+  mh2c::dynamic_table table{200u};
+  table.push(OLD_HEADER);
+  const mh2c::header_block_t header_block{
+      mh2c::header_block_entry{NEW_HEADER}};
+
+  mh2c::dynamic_table_view view{table, &header_block};
+  view.push(0u);
+
+  auto expected = table;
+  expected.push(NEW_HEADER);
+  expect_same_entries(expected, view);
+  EXPECT_EQ(0u, view.find(NEW_HEADER));
+  EXPECT_EQ(1u, view.find(OLD_HEADER));
+  EXPECT_EQ(2u, view.find({"none", ""}));
+  // The table itself is left as it is.
+  EXPECT_EQ(1u, table.get_entries().size());
+}
+
+TEST(dynamic_table_view, evict_table_entries_first) {
+  mh2c::dynamic_table table{80u};
+  table.push(OLD_HEADER);
+  table.push({"old", "67890"});
+  mh2c::header_block_t header_block{};
+  mh2c::dynamic_table_view view{table, &header_block};
+  auto expected = table;
+
+  // The block grows while the view is in use.
+  for (int i = 0; i < 3; ++i) {
+    header_block.emplace_back(
+        mh2c::header_t{"new", "1234" + std::to_string(i)});
+    view.push(header_block.size() - 1u);
+    expected.push(header_block.back().get_header());
+    expect_same_entries(expected, view);
+  }
+
+  view.update_table_size(40u);
+  expected.update_table_size(40u);
+  expect_same_entries(expected, view);
+}
+
+TEST(dynamic_table_view, empty_for_entry_larger_than_table) {
+  mh2c::dynamic_table table{60u};
+  table.push(OLD_HEADER);
+  const mh2c::header_block_t header_block{
+      mh2c::header_block_entry{NEW_HEADER},
+      mh2c::header_block_entry{{"large", std::string(60u, 'x')}}};
+
+  mh2c::dynamic_table_view view{table, &header_block};
+  view.push(0u);
+  view.push(1u);
+  EXPECT_EQ(0u, view.size());
+  view.push(0u);
+  EXPECT_EQ(NEW_HEADER, view.at(0));
+}
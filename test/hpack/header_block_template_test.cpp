@@ -0,0 +1,164 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/hpack/header_block_template.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/frame_builder.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_decoder.h"
+#include "mh2c/hpack/header_encoder.h"
+#include "mh2c/hpack/header_type.h"
+
+namespace {
+
+mh2c::header_block_t make_request_block() {
+  auto header_block = mh2c::make_header_block(
+      mh2c::header_prefix_pattern::INCREMENTAL_INDEXING,
+      {{":method", "GET"},
+       {":scheme", "https"},
+       {":authority", "example.com"},
+       {"user-agent", "mh2c"},
+       {"authorization", "Bearer 0123456789abcdef"}});
+  header_block.emplace(header_block.begin() + 3,
+                       mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+                       mh2c::header_t{":path", ""});
+  header_block.emplace_back(mh2c::header_prefix_pattern::NEVER_INDEXED,
+                            mh2c::header_t{"x-request-id", ""});
+  return header_block;
+}
+
+mh2c::headers_t to_headers(const mh2c::header_block_t& header_block) {
+  mh2c::headers_t headers{};
+  for (const auto& entry : header_block) {
+    headers.push_back(entry.get_header());
+  }
+  return headers;
+}
+
+// Sends the block as the client does, and checks that the peer, decoding it
+// with a table of its own, reads the values given.
+void send(mh2c::header_block_template* header_template,
+          const std::vector<mh2c::header_value_t>& values,
+          mh2c::dynamic_table* encoder_table,
+          mh2c::dynamic_table* decoder_table,
+          mh2c::byte_array_t* encoded_block = nullptr) {
+  mh2c::header_block_t emitted_block{};
+  const auto encoded =
+      header_template->encode(values, *encoder_table, &emitted_block);
+  EXPECT_EQ(mh2c::encode_header_block(
+                header_template->make_header_block(values),
+                header_template->get_mode(), *encoder_table),
+            encoded);
+
+  const auto decoded_block = mh2c::decode_header_block(encoded, *decoder_table);
+  EXPECT_EQ(to_headers(header_template->make_header_block(values)),
+            to_headers(decoded_block));
+  mh2c::update_dynamic_table(emitted_block, encoder_table);
+  mh2c::update_dynamic_table(decoded_block, decoder_table);
+  EXPECT_EQ(decoder_table->get_entries(), encoder_table->get_entries());
+  if (encoded_block != nullptr) {
+    *encoded_block = encoded;
+  }
+  return;
+}
+
+}  // namespace
+
+TEST(header_block_template, make_header_block) {
+  const mh2c::header_block_template header_template{
+      make_request_block(), {":path", "x-request-id"},
+      mh2c::header_encode_mode::HUFFMAN};
+
+  const auto header_block = header_template.make_header_block({"/a", "1"});
+  ASSERT_EQ(make_request_block().size(), header_block.size());
+  EXPECT_EQ((mh2c::header_t{":path", "/a"}), header_block[3].get_header());
+  EXPECT_EQ((mh2c::header_t{"x-request-id", "1"}),
+            header_block.back().get_header());
+  EXPECT_THROW(header_template.make_header_block({"/a"}),
+               std::invalid_argument);
+}
+
+TEST(header_block_template, reject_indexed_variable_field) {
+  EXPECT_THROW((mh2c::header_block_template{
+                   make_request_block(),
+                   {"user-agent"},
+                   mh2c::header_encode_mode::HUFFMAN}),
+               std::invalid_argument);
+}
+
+TEST(header_block_template, copy_indexed_fields_after_first_send) {
+  mh2c::header_block_template header_template{
+      make_request_block(), {":path", "x-request-id"},
+      mh2c::header_encode_mode::HUFFMAN};
+  mh2c::dynamic_table encoder_table{};
+  mh2c::dynamic_table decoder_table{};
+
+  send(&header_template, {"/", "0"}, &encoder_table, &decoder_table);
+  const auto entry_count = encoder_table.get_entries().size();
+  for (int i = 1; i < 10; ++i) {
+    const auto path = "/" + std::to_string(i);
+    mh2c::byte_array_t encoded_block{};
+    send(&header_template, {path, std::to_string(i)}, &encoder_table,
+         &decoder_table, &encoded_block);
+
+    // A byte for each constant field, and literals for the variable ones
+    const auto variable_block = mh2c::encode_header_block(
+        mh2c::header_block_t{
+            {mh2c::header_prefix_pattern::WITHOUT_INDEXING, {":path", path}},
+            {mh2c::header_prefix_pattern::NEVER_INDEXED,
+             {"x-request-id", std::to_string(i)}}},
+        mh2c::header_encode_mode::HUFFMAN, encoder_table);
+    EXPECT_EQ(5u + variable_block.size(), encoded_block.size());
+  }
+  EXPECT_EQ(entry_count, encoder_table.get_entries().size());
+}
+
+TEST(header_block_template, follow_evictions) {
+  mh2c::header_block_template header_template{
+      make_request_block(), {":path", "x-request-id"},
+      mh2c::header_encode_mode::NONE};
+  // Room for a few of the fields of the block only
+  mh2c::dynamic_table encoder_table{160u};
+  mh2c::dynamic_table decoder_table{160u};
+
+  for (int i = 0; i < 10; ++i) {
+    send(&header_template, {"/" + std::to_string(i), std::to_string(i)},
+         &encoder_table, &decoder_table);
+    if (i % 3 == 0) {
+      // Another request evicts the entries the template refers to.
+      const auto other_block = mh2c::make_header_block(
+          mh2c::header_prefix_pattern::INCREMENTAL_INDEXING,
+          {{"cookie", "session=" + std::to_string(i)}});
+      mh2c::header_block_t emitted_block{};
+      const auto encoded = mh2c::encode_header_block(
+          other_block, mh2c::header_encode_mode::NONE, encoder_table,
+          &emitted_block);
+      mh2c::update_dynamic_table(emitted_block, &encoder_table);
+      mh2c::update_dynamic_table(
+          mh2c::decode_header_block(encoded, decoder_table), &decoder_table);
+    }
+  }
+}
+
+TEST(header_block_template, encode_against_another_table) {
+  mh2c::header_block_template header_template{
+      make_request_block(), {":path", "x-request-id"},
+      mh2c::header_encode_mode::HUFFMAN};
+  mh2c::dynamic_table encoder_table{};
+  mh2c::dynamic_table decoder_table{};
+  send(&header_template, {"/", "0"}, &encoder_table, &decoder_table);
+  send(&header_template, {"/", "0"}, &encoder_table, &decoder_table);
+
+  mh2c::dynamic_table other_encoder_table{};
+  mh2c::dynamic_table other_decoder_table{};
+  send(&header_template, {"/", "0"}, &other_encoder_table,
+       &other_decoder_table);
+  send(&header_template, {"/", "1"}, &encoder_table, &decoder_table);
+}
@@ -156,3 +156,26 @@ TEST(header_decoder, decode_huffman_encoded_header) {
   EXPECT_EQ(expected_header_entry, decoded_header.first);
   EXPECT_EQ(encoded_header.size(), decoded_header.second);
 }
+
+// Test for a block referring to a header an entry before it added
+// cf. https://tools.ietf.org/html/rfc7541#section-3.2
+TEST(header_decoder, decode_block_against_entries_added_before) {
+  const mh2c::byte_array_t encoded_block{
+      0x40,                    // index
+      0x04,                    // header name length
+      0x68, 0x6f, 0x67, 0x65,  // header name
+      0x04,                    // header value length
+      0x66, 0x75, 0x67, 0x61,  // header value
+      0xbe,                    // index
+  };
+  const mh2c::header_block_t expected_header_block{
+      {mh2c::header_prefix_pattern::INCREMENTAL_INDEXING, {"hoge", "fuga"}},
+      {mh2c::header_prefix_pattern::INDEXED, {"hoge", "fuga"}},
+  };
+  const mh2c::dynamic_table dynamic_table{};
+
+  const auto header_block =
+      mh2c::decode_header_block(encoded_block, dynamic_table);
+  EXPECT_EQ(expected_header_block, header_block);
+  EXPECT_TRUE(dynamic_table.get_entries().empty());
+}
@@ -5,6 +5,9 @@
 
 #include <gtest/gtest.h>
 
+#include <cstddef>
+#include <vector>
+
 #include "mh2c/common/byte_array.h"
 #include "mh2c/hpack/dynamic_table.h"
 #include "mh2c/hpack/header_type.h"
@@ -178,3 +181,34 @@ TEST(header_encoder, encode_with_huffman_encode) {
       mh2c::encode_header(header_entry, mode, dynamic_table);
   EXPECT_EQ(expected_encoded_header, encoded_header);
 }
+
+// Test for a block indexing a header an entry before it added
+// cf. https://tools.ietf.org/html/rfc7541#section-3.2
+TEST(header_encoder, encode_block_against_entries_added_before) {
+  const auto header_block = mh2c::make_header_block(
+      mh2c::header_prefix_pattern::INCREMENTAL_INDEXING,
+      mh2c::headers_t{{"hoge", "fuga"}, {"hoge", "fuga"}});
+  const auto mode = mh2c::header_encode_mode::NONE;
+  const mh2c::byte_array_t expected_encoded_block{
+      0x40,                    // index
+      0x04,                    // header name length
+      0x68, 0x6f, 0x67, 0x65,  // header name
+      0x04,                    // header value length
+      0x66, 0x75, 0x67, 0x61,  // header value
+      0xbe,                    // index
+  };
+  const mh2c::header_block_t expected_emitted_block{
+      {mh2c::header_prefix_pattern::INCREMENTAL_INDEXING, {"hoge", "fuga"}},
+      {mh2c::header_prefix_pattern::INDEXED, {"hoge", "fuga"}},
+  };
+  const mh2c::dynamic_table dynamic_table{};
+
+  mh2c::header_block_t emitted_block{};
+  std::vector<size_t> entry_ends{};
+  const auto encoded_block = mh2c::encode_header_block(
+      header_block, mode, dynamic_table, &emitted_block, &entry_ends);
+  EXPECT_EQ(expected_encoded_block, encoded_block);
+  EXPECT_EQ(expected_emitted_block, emitted_block);
+  EXPECT_EQ((std::vector<size_t>{11u, 12u}), entry_ends);
+  EXPECT_TRUE(dynamic_table.get_entries().empty());
+}
@@ -0,0 +1,146 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/hpack/indexing_policy.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "mh2c/frame/frame_builder.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_encoder.h"
+#include "mh2c/hpack/header_type.h"
+
+namespace {
+
+constexpr auto INCREMENTAL_INDEXING =
+    mh2c::header_prefix_pattern::INCREMENTAL_INDEXING;
+constexpr auto WITHOUT_INDEXING = mh2c::header_prefix_pattern::WITHOUT_INDEXING;
+
+mh2c::headers_t make_request(const int i) {
+  return {{":method", "GET"},
+          {":scheme", "https"},
+          {":authority", "example.com"},
+          {":path", "/item/" + std::to_string(i)},
+          {"user-agent", "mh2c/1.0"},
+          {"x-request-id", "3f2a9c" + std::to_string(i * 7919)}};
+}
+
+// Bytes of the requests encoded one after another on a connection
+size_t encode_requests(mh2c::indexing_policy* policy,
+                       const size_t table_size) {
+  mh2c::dynamic_table table{table_size};
+  size_t encoded_bytes{};
+  for (int i = 0; i < 100; ++i) {
+    const auto headers = make_request(i);
+    const auto header_block =
+        policy != nullptr
+            ? policy->make_header_block(headers, table)
+            : mh2c::make_header_block(INCREMENTAL_INDEXING, headers);
+    mh2c::header_block_t emitted_block{};
+    encoded_bytes += mh2c::encode_header_block(
+                         header_block, mh2c::header_encode_mode::HUFFMAN,
+                         table, &emitted_block)
+                         .size();
+    mh2c::update_dynamic_table(emitted_block, &table);
+  }
+  return encoded_bytes;
+}
+
+}  // namespace
+
+TEST(indexing_policy, index_recurring_values) {
+  mh2c::indexing_policy policy{};
+  const mh2c::dynamic_table table{};
+
+  auto decision = policy.decide({"user-agent", "mh2c"}, table);
+  EXPECT_EQ(INCREMENTAL_INDEXING, decision.m_prefix);
+  EXPECT_EQ(mh2c::indexing_reason::RECURRING_NAME, decision.m_reason);
+  decision = policy.decide({"user-agent", "mh2c"}, table);
+  EXPECT_EQ(INCREMENTAL_INDEXING, decision.m_prefix);
+  EXPECT_EQ(mh2c::indexing_reason::RECURRING_VALUE, decision.m_reason);
+}
+
+TEST(indexing_policy, skip_names_with_unique_values) {
+  mh2c::indexing_policy policy{};
+  const mh2c::dynamic_table table{};
+
+  EXPECT_EQ(INCREMENTAL_INDEXING,
+            policy.decide({":path", "/a"}, table).m_prefix);
+  EXPECT_EQ(INCREMENTAL_INDEXING,
+            policy.decide({":path", "/b"}, table).m_prefix);
+  const auto decision = policy.decide({":path", "/c"}, table);
+  EXPECT_EQ(WITHOUT_INDEXING, decision.m_prefix);
+  EXPECT_EQ(mh2c::indexing_reason::UNIQUE_VALUES, decision.m_reason);
+
+  // A value that comes back is still indexed.
+  EXPECT_EQ(INCREMENTAL_INDEXING,
+            policy.decide({":path", "/c"}, table).m_prefix);
+}
+
+TEST(indexing_policy, never_index_sensitive_headers) {
+  mh2c::indexing_policy policy{};
+  const mh2c::dynamic_table table{};
+
+  for (int i = 0; i < 3; ++i) {
+    const auto decision = policy.decide({"authorization", "Bearer x"}, table);
+    EXPECT_EQ(mh2c::header_prefix_pattern::NEVER_INDEXED, decision.m_prefix);
+    EXPECT_EQ(mh2c::indexing_reason::SENSITIVE, decision.m_reason);
+  }
+}
+
+TEST(indexing_policy, skip_values_too_large_for_table) {
+  mh2c::indexing_policy policy{};
+  const mh2c::dynamic_table table{256u};
+
+  // 32 bytes of overhead take the entry past a quarter of the table.
+  auto decision = policy.decide({"x-token", std::string(40u, 'a')}, table);
+  EXPECT_EQ(WITHOUT_INDEXING, decision.m_prefix);
+  EXPECT_EQ(mh2c::indexing_reason::TOO_LARGE, decision.m_reason);
+  decision = policy.decide({"x-token", std::string(20u, 'a')}, table);
+  EXPECT_EQ(INCREMENTAL_INDEXING, decision.m_prefix);
+
+  // Nothing fits a table of zero bytes.
+  decision = policy.decide({"x-token", "a"}, mh2c::dynamic_table{0u});
+  EXPECT_EQ(mh2c::indexing_reason::TOO_LARGE, decision.m_reason);
+}
+
+TEST(indexing_policy, bound_tracked_values) {
+  mh2c::indexing_policy_options options{};
+  options.m_max_tracked_values = 2u;
+  mh2c::indexing_policy policy{options};
+  const mh2c::dynamic_table table{};
+
+  policy.decide({"a", "1"}, table);
+  policy.decide({"b", "1"}, table);
+  // Past the limit the counts start over.
+  policy.decide({"c", "1"}, table);
+  EXPECT_EQ(mh2c::indexing_reason::RECURRING_NAME,
+            policy.decide({"a", "1"}, table).m_reason);
+}
+
+TEST(indexing_policy, report_decisions) {
+  mh2c::indexing_policy policy{};
+  const mh2c::dynamic_table table{};
+
+  policy.make_header_block({{"cookie", "a=1"},
+                            {"user-agent", "mh2c"},
+                            {"user-agent", "mh2c"},
+                            {"x-id", "1"},
+                            {"x-id", "2"},
+                            {"x-id", "3"},
+                            {"x-blob", std::string(2048u, 'a')}},
+                           table);
+  const auto status = policy.get_status();
+  EXPECT_EQ(1u, status.m_sensitive);
+  EXPECT_EQ(1u, status.m_too_large);
+  EXPECT_EQ(1u, status.m_recurring_values);
+  EXPECT_EQ(3u, status.m_recurring_names);
+  EXPECT_EQ(1u, status.m_unique_values);
+}
+
+TEST(indexing_policy, compress_better_than_indexing_everything) {
+  mh2c::indexing_policy policy{};
+  EXPECT_LT(encode_requests(&policy, 256u), encode_requests(nullptr, 256u));
+}
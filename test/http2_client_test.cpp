@@ -0,0 +1,394 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/http2_client.h"
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <zlib.h>
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "mh2c/body/content_decoder.h"
+#include "mh2c/common/byte_array.h"
+#include "mh2c/flow_control/window_autotuning.h"
+#include "mh2c/frame/continuation_frame.h"
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/error_codes.h"
+#include "mh2c/frame/frame_builder.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/ping_frame.h"
+#include "mh2c/frame/settings_frame.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/metrics/connection_metrics.h"
+#include "mh2c/net/connect_options.h"
+#include "mh2c/net/socket_fd.h"
+#include "mh2c/ssl/ssl_ktls_mode.h"
+#include "mh2c/ssl/ssl_verify_mode.h"
+#include "mh2c/stream/stream_state.h"
+#include "mh2c/transport/i_transport.h"
+#include "mh2c/transport/memory_transport.h"
+#include "mh2c/util/bit_operation.h"
+#include "mh2c/util/cast.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds READ_TIMEOUT{5000};
+const mh2c::byte_array_t OPAQUE_DATA{1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u};
+
+// Counts the writes the client makes, whatever their size
+class counting_transport : public mh2c::transport::i_transport {
+ public:
+  counting_transport(std::unique_ptr<mh2c::transport::i_transport> transport,
+                     size_t* write_count)
+      : m_transport{std::move(transport)}, m_write_count{write_count} {}
+
+  void write(const uint8_t* data, const size_t length) override {
+    ++*m_write_count;
+    m_transport->write(data, length);
+  }
+  void writev(const iovec* vectors, const size_t count) override {
+    ++*m_write_count;
+    m_transport->writev(vectors, count);
+  }
+  void read(uint8_t* data, const size_t length) override {
+    m_transport->read(data, length);
+  }
+  void sendfile(const int fd, const off_t offset,
+                const size_t length) override {
+    ++*m_write_count;
+    m_transport->sendfile(fd, offset, length);
+  }
+  bool wait_readable(const std::chrono::milliseconds timeout) override {
+    return m_transport->wait_readable(timeout);
+  }
+  bool wait_readable(const std::chrono::milliseconds timeout,
+                     const int wake_fd) override {
+    return m_transport->wait_readable(timeout, wake_fd);
+  }
+
+ private:
+  std::unique_ptr<mh2c::transport::i_transport> m_transport;
+  size_t* m_write_count;
+};
+
+// Listening socket on 127.0.0.1 which never calls accept(), so that a TLS
+// handshake with it waits for the whole deadline.
+mh2c::net::socket_fd make_listener(uint16_t* port) {
+  mh2c::net::socket_fd fd{socket(AF_INET, SOCK_STREAM, 0)};
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bind(fd.get(), reinterpret_cast<sockaddr*>(&address), sizeof(address));
+  listen(fd.get(), 8);
+
+  socklen_t length = sizeof(address);
+  getsockname(fd.get(), reinterpret_cast<sockaddr*>(&address), &length);
+  *port = ntohs(address.sin_port);
+
+  return fd;
+}
+
+class http2_client_test : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    auto [client_transport, peer_transport] =
+        mh2c::transport::make_memory_transport_pair();
+    m_peer = std::move(peer_transport);
+    m_client = std::make_unique<mh2c::http2_client>(
+        std::make_unique<counting_transport>(std::move(client_transport),
+                                             &m_write_count));
+
+    send_to_client(mh2c::settings_frame{0u, 0u, {}});
+    m_client->exchange_settings({});
+    mh2c::byte_array_t preface(24u);
+    m_peer->read(preface.data(), preface.size());
+    ASSERT_EQ(mh2c::frame_type_registry::SETTINGS, receive_from_client());
+  }
+
+  template <typename Frame>
+  void send_to_client(const Frame& frame) {
+    const auto raw_frame = frame.serialize();
+    m_peer->write(raw_frame.data(), raw_frame.size());
+  }
+
+  // Type of the next frame the client has written, with its flags and
+  // payload
+  mh2c::frame_type_registry receive_from_client(
+      mh2c::fh_flags_t* flags = nullptr,
+      mh2c::byte_array_t* payload = nullptr) {
+    if (m_peer->wait_readable(READ_TIMEOUT) == false) {
+      throw std::runtime_error("no frame from the client");
+    }
+    mh2c::byte_array_t raw_fh(mh2c::FRAME_HEADER_BYTES);
+    m_peer->read(raw_fh.data(), raw_fh.size());
+    const auto fh = mh2c::build_frame_header(raw_fh);
+    mh2c::byte_array_t raw_payload(fh.m_length);
+    if (fh.m_length > 0) {
+      m_peer->read(raw_payload.data(), raw_payload.size());
+    }
+    if (flags != nullptr) {
+      *flags = fh.m_flags;
+    }
+    if (payload != nullptr) {
+      *payload = raw_payload;
+    }
+    return mh2c::cast_to_frame_type_registry(fh.m_type);
+  }
+
+  // Sends a request without a body on the stream, read by the peer
+  void open_stream(const mh2c::fh_stream_id_t stream_id) {
+    m_client->send_headers(
+        mh2c::make_frame_header_flags(mh2c::hf_flag::END_STREAM), stream_id,
+        mh2c::make_header_block(
+            mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+            mh2c::headers_t{{":method", "GET"},
+                            {":scheme", "http"},
+                            {":authority", "localhost"},
+                            {":path", "/"}}),
+        mh2c::header_encode_mode::NONE);
+    // After the SETTINGS ACK still held back
+    while (receive_from_client() != mh2c::frame_type_registry::HEADERS) {
+    }
+  }
+
+  mh2c::headers_frame make_response_headers(
+      const mh2c::fh_stream_id_t stream_id,
+      const std::string& content_encoding) {
+    return mh2c::headers_frame{
+        mh2c::make_frame_header_flags(mh2c::hf_flag::END_HEADERS), stream_id,
+        mh2c::make_header_block(
+            mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+            mh2c::headers_t{{":status", "200"},
+                            {"content-encoding", content_encoding}}),
+        mh2c::header_encode_mode::NONE, mh2c::dynamic_table{}};
+  }
+
+  size_t m_write_count{};
+  std::unique_ptr<mh2c::transport::i_transport> m_peer;
+  std::unique_ptr<mh2c::http2_client> m_client;
+};
+
+}  // namespace
+
+TEST_F(http2_client_test, answer_settings_and_ping_in_one_write) {
+  const auto write_count = m_write_count;
+  send_to_client(mh2c::ping_frame{0u, OPAQUE_DATA});
+  const auto frame = m_client->receive_frame();
+  EXPECT_EQ(mh2c::frame_type_registry::PING,
+            mh2c::cast_to_frame_type_registry(frame->get_header().m_type));
+  EXPECT_EQ(write_count, m_write_count);
+
+  // Nothing more to read
+  EXPECT_FALSE(m_client->wait_readable(std::chrono::milliseconds{0}));
+  EXPECT_EQ(write_count + 1u, m_write_count);
+
+  mh2c::fh_flags_t flags{};
+  mh2c::byte_array_t payload{};
+  EXPECT_EQ(mh2c::frame_type_registry::SETTINGS, receive_from_client(&flags));
+  EXPECT_TRUE(mh2c::is_flag_set(flags, mh2c::sf_flag::ACK));
+  EXPECT_EQ(mh2c::frame_type_registry::PING,
+            receive_from_client(&flags, &payload));
+  EXPECT_TRUE(mh2c::is_flag_set(flags, mh2c::pf_flag::ACK));
+  EXPECT_EQ(OPAQUE_DATA, payload);
+}
+
+TEST_F(http2_client_test, coalesce_answers_into_next_frame) {
+  send_to_client(mh2c::settings_frame{
+      0u, 0u,
+      mh2c::make_sf_payload(
+          {{mh2c::sf_parameter::SETTINGS_MAX_FRAME_SIZE, 32768u}})});
+  send_to_client(mh2c::ping_frame{0u, OPAQUE_DATA});
+  m_client->receive_frame();
+  m_client->receive_frame();
+
+  const auto write_count = m_write_count;
+  m_client->send_frame(mh2c::ping_frame{0u, OPAQUE_DATA});
+  EXPECT_EQ(write_count + 1u, m_write_count);
+
+  mh2c::fh_flags_t flags{};
+  EXPECT_EQ(mh2c::frame_type_registry::SETTINGS, receive_from_client(&flags));
+  EXPECT_TRUE(mh2c::is_flag_set(flags, mh2c::sf_flag::ACK));
+  EXPECT_EQ(mh2c::frame_type_registry::SETTINGS, receive_from_client(&flags));
+  EXPECT_TRUE(mh2c::is_flag_set(flags, mh2c::sf_flag::ACK));
+  EXPECT_EQ(mh2c::frame_type_registry::PING, receive_from_client(&flags));
+  EXPECT_TRUE(mh2c::is_flag_set(flags, mh2c::pf_flag::ACK));
+  EXPECT_EQ(mh2c::frame_type_registry::PING, receive_from_client(&flags));
+  EXPECT_FALSE(mh2c::is_flag_set(flags, mh2c::pf_flag::ACK));
+}
+
+TEST_F(http2_client_test, flush_answers_before_waiting_in_receive) {
+  send_to_client(mh2c::ping_frame{0u, OPAQUE_DATA});
+  m_client->receive_frame();
+
+  // Blocks until the peer has read the answers and sent another PING.
+  std::thread receiver{[this]() { m_client->receive_frame(); }};
+  mh2c::fh_flags_t flags{};
+  EXPECT_EQ(mh2c::frame_type_registry::SETTINGS, receive_from_client(&flags));
+  EXPECT_EQ(mh2c::frame_type_registry::PING, receive_from_client(&flags));
+  EXPECT_TRUE(mh2c::is_flag_set(flags, mh2c::pf_flag::ACK));
+  send_to_client(mh2c::ping_frame{0u, OPAQUE_DATA});
+  receiver.join();
+}
+
+TEST_F(http2_client_test, record_answers_once_written) {
+  const auto ping_slot =
+      mh2c::underlying_cast(mh2c::frame_type_registry::PING);
+  send_to_client(mh2c::ping_frame{0u, OPAQUE_DATA});
+  m_client->receive_frame();
+  EXPECT_EQ(0u, m_client->get_metrics().snapshot().m_frames_sent[ping_slot]);
+
+  m_client->flush_control_frames();
+  EXPECT_EQ(1u, m_client->get_metrics().snapshot().m_frames_sent[ping_slot]);
+}
+
+TEST_F(http2_client_test, flush_window_update_while_peer_keeps_sending) {
+  mh2c::flow_control::autotuning_options options{};
+  options.m_initial_stream_window = 64u;
+  m_client->enable_window_autotuning(options);
+  open_stream(1u);
+  send_to_client(make_response_headers(1u, "identity"));
+  send_to_client(mh2c::data_frame{0u, 1u, mh2c::byte_array_t(40u, 0x61u)});
+  send_to_client(mh2c::ping_frame{0u, OPAQUE_DATA});
+  m_client->receive_frame();
+  m_client->receive_frame();
+
+  // Written before the PING is read, though it was already waiting
+  m_client->receive_frame();
+  mh2c::byte_array_t payload{};
+  EXPECT_EQ(mh2c::frame_type_registry::WINDOW_UPDATE,
+            receive_from_client(nullptr, &payload));
+  EXPECT_EQ((mh2c::byte_array_t{0x00, 0x00, 0x00, 0x28}), payload);
+}
+
+TEST_F(http2_client_test, measure_rtt_from_bdp_ping_written) {
+  m_client->enable_window_autotuning({});
+  open_stream(1u);
+  send_to_client(make_response_headers(1u, "identity"));
+  send_to_client(mh2c::data_frame{0u, 1u, mh2c::byte_array_t(10u, 0x61u)});
+  m_client->receive_frame();
+  m_client->receive_frame();
+
+  // The PING waits in the queue longer than it takes the peer to answer.
+  constexpr std::chrono::milliseconds HOLD{200};
+  std::this_thread::sleep_for(HOLD);
+  m_client->flush_control_frames();
+  mh2c::fh_flags_t flags{};
+  mh2c::byte_array_t payload{};
+  EXPECT_EQ(mh2c::frame_type_registry::PING,
+            receive_from_client(&flags, &payload));
+  EXPECT_FALSE(mh2c::is_flag_set(flags, mh2c::pf_flag::ACK));
+  send_to_client(mh2c::ping_frame{
+      mh2c::make_frame_header_flags(mh2c::pf_flag::ACK), payload});
+  m_client->receive_frame();
+
+  const auto rtt = m_client->get_window_autotuning_status().m_smoothed_rtt;
+  EXPECT_GT(rtt.count(), 0);
+  EXPECT_LT(rtt, HOLD);
+}
+
+TEST_F(http2_client_test, reset_stream_whose_body_cannot_be_decoded) {
+  const auto sink = std::make_shared<mh2c::body::buffer_body_sink>();
+  m_client->decode_response_body(1u, sink);
+  open_stream(1u);
+  send_to_client(make_response_headers(1u, "gzip"));
+  send_to_client(mh2c::data_frame{0u, 1u, std::string{"not gzip"}});
+  m_client->receive_frame();
+
+  // The frame is accounted for and returned, and the connection goes on.
+  const auto frame = m_client->receive_frame();
+  EXPECT_EQ(mh2c::frame_type_registry::DATA,
+            mh2c::cast_to_frame_type_registry(frame->get_header().m_type));
+  EXPECT_FALSE(sink->get_error().empty());
+  EXPECT_FALSE(sink->is_complete());
+  EXPECT_EQ(mh2c::stream::stream_state::CLOSED,
+            m_client->get_stream_state(1u));
+
+  m_client->flush_control_frames();
+  mh2c::byte_array_t payload{};
+  EXPECT_EQ(mh2c::frame_type_registry::RST_STREAM,
+            receive_from_client(nullptr, &payload));
+  EXPECT_EQ((mh2c::byte_array_t{0x00, 0x00, 0x00, 0x08}), payload);
+}
+
+TEST_F(http2_client_test, decode_body_coded_in_continuation) {
+  const std::string text{"a body compressed with deflate"};
+  mh2c::byte_array_t compressed(compressBound(text.size()));
+  auto compressed_length = static_cast<uLongf>(compressed.size());
+  ASSERT_EQ(Z_OK, compress(compressed.data(), &compressed_length,
+                           reinterpret_cast<const Bytef*>(text.data()),
+                           text.size()));
+  compressed.resize(compressed_length);
+
+  const auto sink = std::make_shared<mh2c::body::buffer_body_sink>();
+  m_client->decode_response_body(1u, sink);
+  open_stream(1u);
+  send_to_client(mh2c::headers_frame{
+      0u, 1u,
+      mh2c::make_header_block(mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+                              mh2c::headers_t{{":status", "200"}}),
+      mh2c::header_encode_mode::NONE, mh2c::dynamic_table{}});
+  send_to_client(mh2c::continuation_frame{
+      mh2c::make_frame_header_flags(mh2c::cf_flag::END_HEADERS), 1u,
+      mh2c::make_header_block(mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+                              mh2c::headers_t{{"content-encoding", "deflate"}}),
+      mh2c::header_encode_mode::NONE, mh2c::dynamic_table{}});
+  send_to_client(mh2c::data_frame{
+      mh2c::make_frame_header_flags(mh2c::df_flag::END_STREAM), 1u,
+      compressed});
+  for (int i = 0; i < 3; ++i) {
+    m_client->receive_frame();
+  }
+
+  EXPECT_TRUE(sink->get_error().empty());
+  EXPECT_TRUE(sink->is_complete());
+  EXPECT_EQ(mh2c::byte_array_t(text.begin(), text.end()), sink->get_buffer());
+}
+
+// cf. https://tools.ietf.org/html/rfc7540#section-6.1
+TEST_F(http2_client_test, reject_padding_longer_than_data) {
+  m_client->decode_response_body(
+      1u, std::make_shared<mh2c::body::buffer_body_sink>());
+  open_stream(1u);
+  send_to_client(make_response_headers(1u, "gzip"));
+  send_to_client(mh2c::data_frame{
+      mh2c::make_frame_header_flags(mh2c::df_flag::PADDED), 1u,
+      mh2c::byte_array_t{0xff, 0x00}});
+  m_client->receive_frame();
+  EXPECT_THROW(m_client->receive_frame(), mh2c::connection_error);
+}
+
+TEST(http2_client_async_test, drop_future_without_waiting) {
+  uint16_t port{};
+  const auto listener = make_listener(&port);
+  mh2c::net::connect_options options{};
+  options.m_handshake_timeout = std::chrono::milliseconds{1000};
+
+  const auto start = std::chrono::steady_clock::now();
+  mh2c::http2_client::async_connect("127.0.0.1", port,
+                                    mh2c::ssl::verify_mode::VERIFY_NONE, {},
+                                    mh2c::ssl::ktls_mode::DISABLED, options);
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+            options.m_handshake_timeout / 2);
+
+  // A kept future still gets the failure of the worker, which by then has
+  // also ended the first connection.
+  auto future = mh2c::http2_client::async_connect(
+      "127.0.0.1", port, mh2c::ssl::verify_mode::VERIFY_NONE, {},
+      mh2c::ssl::ktls_mode::DISABLED, options);
+  EXPECT_ANY_THROW(future.get());
+}
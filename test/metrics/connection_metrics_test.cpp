@@ -0,0 +1,68 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/metrics/connection_metrics.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/util/cast.h"
+
+TEST(connection_metrics_test, count_frames_and_bytes_by_type) {
+  mh2c::metrics::connection_metrics metrics{};
+  const auto data_slot = mh2c::underlying_cast(mh2c::frame_type_registry::DATA);
+
+  metrics.on_frame_sent({100u, 0x00u, 0u, 0u, 1u});
+  metrics.on_frame_received({10u, 0x00u, 0u, 0u, 1u});
+  metrics.on_frame_received({20u, 0x00u, 0u, 0u, 1u});
+  // Unknown frame types share the last slot.
+  metrics.on_frame_received({0u, 0xffu, 0u, 0u, 0u});
+
+  const auto snapshot = metrics.snapshot();
+  EXPECT_EQ(1u, snapshot.m_frames_sent[data_slot]);
+  EXPECT_EQ(109u, snapshot.m_bytes_sent[data_slot]);
+  EXPECT_EQ(2u, snapshot.m_frames_received[data_slot]);
+  EXPECT_EQ(48u, snapshot.m_bytes_received[data_slot]);
+  EXPECT_EQ(1u,
+            snapshot.m_frames_received[mh2c::metrics::FRAME_TYPE_SLOTS - 1u]);
+}
+
+TEST(connection_metrics_test, aggregate_snapshots) {
+  mh2c::metrics::connection_metrics first{};
+  mh2c::metrics::connection_metrics second{};
+  first.on_hpack_block(2u, 1u, 1u, 5u);
+  second.on_hpack_block(0u, 0u, 4u, 3u);
+  second.on_hpack_evictions(2u);
+  second.on_flow_control_stalls(1u);
+
+  auto total = first.snapshot();
+  total += second.snapshot();
+  EXPECT_EQ(2u, total.m_hpack_static_hits);
+  EXPECT_EQ(1u, total.m_hpack_dynamic_hits);
+  EXPECT_EQ(5u, total.m_hpack_literals);
+  EXPECT_EQ(8u, total.m_huffman_bytes_saved);
+  EXPECT_EQ(2u, total.m_hpack_evictions);
+  EXPECT_EQ(1u, total.m_flow_control_stalls);
+  EXPECT_DOUBLE_EQ(0.375, total.get_hpack_hit_rate());
+}
+
+TEST(connection_metrics_test, decode_time_histogram) {
+  mh2c::metrics::connection_metrics metrics{};
+  for (int i = 0; i < 99; ++i) {
+    metrics.on_frame_decoded(std::chrono::nanoseconds{100});
+  }
+  metrics.on_frame_decoded(std::chrono::microseconds{50});
+
+  const auto histogram = metrics.snapshot().m_decode_time;
+  EXPECT_EQ(100u, histogram.get_count());
+  EXPECT_EQ(std::chrono::nanoseconds{100}, histogram.get_min());
+  EXPECT_EQ(std::chrono::microseconds{50}, histogram.get_max());
+  EXPECT_EQ(std::chrono::nanoseconds{(99 * 100 + 50000) / 100},
+            histogram.get_mean());
+  // 100ns lies in [96, 104); the top percentile is capped at the maximum.
+  EXPECT_EQ(std::chrono::nanoseconds{103}, histogram.get_percentile(0.5));
+  EXPECT_EQ(std::chrono::microseconds{50}, histogram.get_percentile(1.0));
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/metrics/header_block_inspector.h"
+
+#include <gtest/gtest.h>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/util/bit_operation.h"
+
+namespace {
+
+mh2c::metrics::header_block_stats inspect(const mh2c::headers_frame& hf) {
+  const auto raw_frame = hf.serialize();
+  return mh2c::metrics::inspect_header_block(
+      hf.get_header(), raw_frame.data() + mh2c::FRAME_HEADER_BYTES,
+      hf.get_payload());
+}
+
+}  // namespace
+
+TEST(header_block_inspector_test, classify_representations) {
+  mh2c::dynamic_table dynamic_table{};
+  dynamic_table.push({"x-request-id", "abc"});
+
+  const auto flags =
+      mh2c::make_frame_header_flags(mh2c::hf_flag::END_HEADERS,
+                                    mh2c::hf_flag::PADDED);
+  const mh2c::headers_frame hf{
+      flags,
+      1u,
+      mh2c::make_header_block(
+          mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+          mh2c::headers_t{{":method", "GET"},
+                          {"x-request-id", "abc"},
+                          {":path", "/style.css"},
+                          {"user-agent", "mh2c"}}),
+      mh2c::header_encode_mode::NONE,
+      dynamic_table,
+      {0u, 0u, 0u}};
+
+  const auto stats = inspect(hf);
+  EXPECT_EQ(1u, stats.m_static_hits);
+  EXPECT_EQ(1u, stats.m_dynamic_hits);
+  EXPECT_EQ(2u, stats.m_literals);
+  EXPECT_EQ(0u, stats.m_huffman_bytes_saved);
+}
+
+TEST(header_block_inspector_test, count_huffman_savings) {
+  const mh2c::headers_frame hf{
+      mh2c::make_frame_header_flags(mh2c::hf_flag::END_HEADERS),
+      1u,
+      mh2c::make_header_block(
+          mh2c::header_prefix_pattern::INCREMENTAL_INDEXING,
+          mh2c::header_t{"custom-key", "custom-value"}),
+      mh2c::header_encode_mode::HUFFMAN,
+      mh2c::dynamic_table{}};
+
+  // cf. https://tools.ietf.org/html/rfc7541#appendix-C.4.3
+  // "custom-key" and "custom-value" shrink from 10 to 8 and 12 to 9 bytes.
+  const auto stats = inspect(hf);
+  EXPECT_EQ(1u, stats.m_literals);
+  EXPECT_EQ(5u, stats.m_huffman_bytes_saved);
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/metrics/latency_histogram.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+
+using std::chrono::nanoseconds;
+
+TEST(latency_histogram, empty) {
+  const mh2c::metrics::latency_histogram histogram{};
+
+  EXPECT_EQ(0u, histogram.get_count());
+  EXPECT_EQ(nanoseconds{0}, histogram.get_min());
+  EXPECT_EQ(nanoseconds{0}, histogram.get_mean());
+  EXPECT_EQ(nanoseconds{0}, histogram.get_percentile(0.99));
+}
+
+TEST(latency_histogram, small_values_are_exact) {
+  mh2c::metrics::latency_histogram histogram{};
+  for (int64_t value = 0; value < 8; ++value) {
+    histogram.record(nanoseconds{value});
+  }
+
+  EXPECT_EQ(8u, histogram.get_count());
+  EXPECT_EQ(nanoseconds{0}, histogram.get_min());
+  EXPECT_EQ(nanoseconds{7}, histogram.get_max());
+  EXPECT_EQ(nanoseconds{3}, histogram.get_percentile(0.5));
+  EXPECT_EQ(nanoseconds{7}, histogram.get_percentile(1.0));
+}
+
+TEST(latency_histogram, percentile_within_relative_error) {
+  mh2c::metrics::latency_histogram histogram{};
+  for (int64_t value = 1; value <= 100000; ++value) {
+    histogram.record(std::chrono::microseconds{value});
+  }
+
+  const auto p50 = histogram.get_percentile(0.5).count();
+  const auto p99 = histogram.get_percentile(0.99).count();
+  EXPECT_GE(p50, 50000000);
+  EXPECT_LE(p50, 50000000 * 1.125);
+  EXPECT_GE(p99, 99000000);
+  EXPECT_LE(p99, 100000000);
+  EXPECT_EQ(nanoseconds{std::chrono::milliseconds{100}},
+            histogram.get_percentile(1.0));
+  EXPECT_EQ(nanoseconds{std::chrono::microseconds{50000} + nanoseconds{500}},
+            histogram.get_mean());
+}
+
+TEST(latency_histogram, merge) {
+  const nanoseconds out_of_range{int64_t{1} << 45u};
+  mh2c::metrics::latency_histogram lhs{};
+  mh2c::metrics::latency_histogram rhs{};
+  lhs.record(nanoseconds{100});
+  rhs.record(nanoseconds{1000000});
+  rhs.record(out_of_range);
+
+  lhs += rhs;
+
+  EXPECT_EQ(3u, lhs.get_count());
+  EXPECT_EQ(nanoseconds{100}, lhs.get_min());
+  EXPECT_EQ(out_of_range, lhs.get_max());
+  // Values beyond the range share the last bucket.
+  EXPECT_EQ(out_of_range, lhs.get_percentile(1.0));
+}
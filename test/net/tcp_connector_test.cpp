@@ -0,0 +1,92 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/net/tcp_connector.h"
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "mh2c/net/connect_options.h"
+#include "mh2c/net/socket_fd.h"
+
+namespace {
+
+// Listening socket on 127.0.0.1 which never calls accept().
+mh2c::net::socket_fd make_listener(const int backlog, uint16_t* port) {
+  mh2c::net::socket_fd fd{socket(AF_INET, SOCK_STREAM, 0)};
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bind(fd.get(), reinterpret_cast<sockaddr*>(&address), sizeof(address));
+  listen(fd.get(), backlog);
+
+  socklen_t length = sizeof(address);
+  getsockname(fd.get(), reinterpret_cast<sockaddr*>(&address), &length);
+  *port = ntohs(address.sin_port);
+
+  return fd;
+}
+
+mh2c::net::connect_options make_short_options() {
+  mh2c::net::connect_options options{};
+  options.m_connect_timeout = std::chrono::milliseconds{300};
+  options.m_attempt_delay = std::chrono::milliseconds{50};
+  return options;
+}
+
+}  // namespace
+
+TEST(tcp_connector_test, connect_to_listener) {
+  uint16_t port{};
+  const auto listener = make_listener(8, &port);
+
+  const auto fd =
+      mh2c::net::connect_tcp("127.0.0.1", port, make_short_options());
+  EXPECT_GE(fd.get(), 0);
+}
+
+TEST(tcp_connector_test, connect_to_listener_by_hostname) {
+  // "localhost" may resolve to ::1 first, which has no listener.
+  uint16_t port{};
+  const auto listener = make_listener(8, &port);
+
+  const auto fd =
+      mh2c::net::connect_tcp("localhost", port, make_short_options());
+  EXPECT_GE(fd.get(), 0);
+}
+
+TEST(tcp_connector_test, throw_if_connection_refused) {
+  uint16_t port{};
+  {
+    const auto listener = make_listener(8, &port);
+  }
+
+  EXPECT_ANY_THROW(
+      mh2c::net::connect_tcp("127.0.0.1", port, make_short_options()));
+}
+
+TEST(tcp_connector_test, throw_if_listener_never_accepts) {
+  // Once the accept queue is full, the kernel drops further SYNs.
+  uint16_t port{};
+  const auto listener = make_listener(0, &port);
+  std::vector<mh2c::net::socket_fd> fillers{};
+  for (auto i = 0; i < 4; ++i) {
+    try {
+      fillers.push_back(
+          mh2c::net::connect_tcp("127.0.0.1", port, make_short_options()));
+    } catch (std::exception&) {
+      break;
+    }
+  }
+
+  const auto begin = std::chrono::steady_clock::now();
+  EXPECT_ANY_THROW(
+      mh2c::net::connect_tcp("127.0.0.1", port, make_short_options()));
+  EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds{2});
+}
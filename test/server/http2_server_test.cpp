@@ -0,0 +1,153 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/server/http2_server.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/settings_frame.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/http2_client.h"
+#include "mh2c/net/connect_options.h"
+#include "mh2c/server/server_options.h"
+#include "mh2c/ssl/ssl_ktls_mode.h"
+#include "mh2c/ssl/ssl_session_cache.h"
+#include "mh2c/ssl/ssl_verify_mode.h"
+#include "mh2c/transport/tcp_transport.h"
+#include "mh2c/util/bit_operation.h"
+#include "mh2c/util/cast.h"
+#include "support/self_signed_certificate.h"
+
+namespace {
+
+mh2c::headers_frame make_request(const mh2c::fh_stream_id_t stream_id,
+                                 const std::string& method,
+                                 const mh2c::dynamic_table& table) {
+  return {mh2c::make_frame_header_flags(mh2c::hf_flag::END_STREAM,
+                                        mh2c::hf_flag::END_HEADERS),
+          stream_id,
+          mh2c::make_header_block(
+              mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+              mh2c::headers_t{{":method", method},
+                              {":scheme", "https"},
+                              {":authority", "localhost"},
+                              {":path", "/"}}),
+          mh2c::header_encode_mode::NONE,
+          table};
+}
+
+}  // namespace
+
+TEST(http2_server_test, serve_cleartext_connection) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {200u, {}, 10u};
+  mh2c::server::http2_server server{options};
+  const auto port = server.listen("127.0.0.1", 0u,
+                                  mh2c::server::server_transport::CLEARTEXT);
+
+  mh2c::http2_client client{
+      mh2c::transport::connect_cleartext("127.0.0.1", port)};
+  const auto settings = client.exchange_settings({});
+  EXPECT_EQ(mh2c::frame_type_registry::SETTINGS,
+            mh2c::cast_to_frame_type_registry(settings->get_header().m_type));
+
+  const mh2c::headers_frame hf{
+      mh2c::make_frame_header_flags(mh2c::hf_flag::END_STREAM,
+                                    mh2c::hf_flag::END_HEADERS),
+      1u,
+      mh2c::make_header_block(mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+                              mh2c::headers_t{{":method", "GET"},
+                                              {":scheme", "http"},
+                                              {":authority", "localhost"},
+                                              {":path", "/"}}),
+      mh2c::header_encode_mode::NONE, client.get_request_dynamic_table()};
+  client.send_frame(hf);
+
+  size_t body_size{};
+  while (true) {
+    const auto fh = client.receive_frame()->get_header();
+    if (mh2c::cast_to_frame_type_registry(fh.m_type) ==
+        mh2c::frame_type_registry::DATA) {
+      body_size += fh.m_length;
+    }
+    if (fh.m_stream_id == 1u &&
+        mh2c::is_flag_set(fh.m_flags, mh2c::hf_flag::END_STREAM)) {
+      break;
+    }
+  }
+  EXPECT_EQ(10u, body_size);
+}
+
+TEST(http2_server_test, stop_closes_open_connections) {
+  mh2c::server::http2_server server{{}};
+  const auto port = server.listen("127.0.0.1", 0u,
+                                  mh2c::server::server_transport::CLEARTEXT);
+
+  mh2c::http2_client client{
+      mh2c::transport::connect_cleartext("127.0.0.1", port)};
+  client.exchange_settings({});
+  server.stop();
+
+  // The server's SETTINGS ACK may still be buffered.
+  EXPECT_ANY_THROW({
+    while (true) {
+      client.receive_frame();
+    }
+  });
+}
+
+TEST(http2_server_test, send_get_as_tls_early_data) {
+  const test_support::self_signed_certificate certificate{"http2_server"};
+  mh2c::server::server_options options{};
+  options.m_certificate_file = certificate.get_certificate_file();
+  options.m_private_key_file = certificate.get_private_key_file();
+  options.m_max_early_data = 16384u;
+  mh2c::server::http2_server server{options};
+  const auto port =
+      server.listen("127.0.0.1", 0u, mh2c::server::server_transport::TLS);
+
+  mh2c::net::connect_options connect_options{};
+  connect_options.m_session_cache =
+      std::make_shared<mh2c::ssl::session_cache>();
+  connect_options.m_early_data = true;
+  {
+    mh2c::http2_client client{"127.0.0.1", port,
+                              mh2c::ssl::verify_mode::VERIFY_NONE,
+                              mh2c::ssl::ktls_mode::DISABLED, connect_options};
+    client.exchange_settings({});
+  }
+
+  // The preface, SETTINGS and the GET request go out with ClientHello.
+  mh2c::http2_client client{"127.0.0.1", port,
+                            mh2c::ssl::verify_mode::VERIFY_NONE,
+                            mh2c::ssl::ktls_mode::DISABLED, connect_options};
+  client.send_connection_preface();
+  client.send_frame(mh2c::settings_frame{0u, 0u, {}});
+  client.send_frame(
+      make_request(1u, "GET", client.get_request_dynamic_table()));
+  EXPECT_EQ(mh2c::ssl::early_data_status::PENDING,
+            client.get_early_data_status());
+
+  // POST may not be replayed, so it waits for the handshake.
+  client.send_frame(
+      make_request(3u, "POST", client.get_request_dynamic_table()));
+  EXPECT_EQ(mh2c::ssl::early_data_status::ACCEPTED,
+            client.get_early_data_status());
+
+  size_t completed{};
+  while (completed < 2u) {
+    const auto fh = client.receive_frame()->get_header();
+    if (fh.m_stream_id != 0 &&
+        mh2c::is_flag_set(fh.m_flags, mh2c::hf_flag::END_STREAM)) {
+      ++completed;
+    }
+  }
+}
@@ -0,0 +1,620 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/server/server_session.h"
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mh2c/body/body_source.h"
+#include "mh2c/body/content_decoder.h"
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/frame_builder.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/priority_frame.h"
+#include "mh2c/frame/settings_frame.h"
+#include "mh2c/hpack/header_block_template.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/http2_client.h"
+#include "mh2c/server/server_options.h"
+#include "mh2c/stream/latency_breakdown.h"
+#include "mh2c/stream/stream_state.h"
+#include "mh2c/trace/frame_capture.h"
+#include "mh2c/trace/ring_buffer_recorder.h"
+#include "mh2c/trace/trace_observer.h"
+#include "mh2c/transport/memory_transport.h"
+#include "mh2c/util/bit_operation.h"
+#include "mh2c/util/cast.h"
+
+namespace {
+
+struct response {
+  mh2c::headers_t m_headers;
+  size_t m_body_size;
+};
+
+void send_request(mh2c::http2_client* client,
+                  const mh2c::fh_stream_id_t stream_id,
+                  const std::string& path,
+                  const mh2c::headers_t& extra_headers = {},
+                  const bool end_stream = true) {
+  mh2c::headers_t headers{
+      {":method", "GET"},
+      {":scheme", "http"},
+      {":authority", "localhost"},
+      {":path", path},
+  };
+  headers.insert(headers.end(), extra_headers.begin(), extra_headers.end());
+  client->send_headers(
+      end_stream ? mh2c::make_frame_header_flags(mh2c::hf_flag::END_STREAM)
+                 : mh2c::fh_flags_t{0u},
+      stream_id,
+      mh2c::make_header_block(
+          mh2c::header_prefix_pattern::INCREMENTAL_INDEXING, headers),
+      mh2c::header_encode_mode::HUFFMAN);
+}
+
+// Receives frames until the stream ends.
+response receive_response(mh2c::http2_client* client,
+                          const mh2c::fh_stream_id_t stream_id) {
+  response result{};
+
+  while (true) {
+    const auto frame = client->receive_frame();
+    const auto fh = frame->get_header();
+    const auto type = mh2c::cast_to_frame_type_registry(fh.m_type);
+    if (fh.m_stream_id != stream_id) {
+      continue;
+    }
+
+    if (type == mh2c::frame_type_registry::HEADERS) {
+      for (const auto& entry :
+           dynamic_cast<const mh2c::headers_frame*>(frame.get())
+               ->get_payload()) {
+        result.m_headers.push_back(entry.get_header());
+      }
+    } else if (type == mh2c::frame_type_registry::DATA) {
+      result.m_body_size += fh.m_length;
+    }
+    if (mh2c::is_flag_set(fh.m_flags, mh2c::hf_flag::END_STREAM)) {
+      return result;
+    }
+  }
+}
+
+class server_session_test : public ::testing::Test {
+ protected:
+  void start(const mh2c::server::server_options& options,
+             const std::string& capture_path = "") {
+    auto [client_transport, server_transport] =
+        mh2c::transport::make_memory_transport_pair();
+    m_server_thread = std::thread{
+        [options, transport = std::move(server_transport)]() mutable {
+          mh2c::server::server_session{std::move(transport), options}.run();
+        }};
+
+    m_client = std::make_unique<mh2c::http2_client>(
+        std::move(client_transport));
+    if (capture_path.empty() == false) {
+      m_client->start_capture(capture_path);
+    }
+    m_client->exchange_settings({});
+  }
+
+  void TearDown() override {
+    m_client.reset();
+    m_server_thread.join();
+  }
+
+  std::unique_ptr<mh2c::http2_client> m_client;
+  std::thread m_server_thread;
+};
+
+}  // namespace
+
+TEST_F(server_session_test, serve_default_response) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {204u, {{"server", "mh2c"}}, 0u};
+  start(options);
+
+  send_request(m_client.get(), 1u, "/");
+  const auto result = receive_response(m_client.get(), 1u);
+
+  const mh2c::headers_t expected_headers{
+      {":status", "204"}, {"content-length", "0"}, {"server", "mh2c"}};
+  EXPECT_EQ(expected_headers, result.m_headers);
+  EXPECT_EQ(0u, result.m_body_size);
+}
+
+TEST_F(server_session_test, serve_response_by_path) {
+  mh2c::server::server_options options{};
+  options.m_responses["/small"] = {200u, {}, 100u};
+  options.m_responses["/missing"] = {404u, {}, 0u};
+  start(options);
+
+  send_request(m_client.get(), 1u, "/small");
+  EXPECT_EQ(100u, receive_response(m_client.get(), 1u).m_body_size);
+
+  // The second request reuses the dynamic table entries of the first one.
+  send_request(m_client.get(), 3u, "/missing");
+  const auto result = receive_response(m_client.get(), 3u);
+  ASSERT_FALSE(result.m_headers.empty());
+  EXPECT_EQ(mh2c::header_t(":status", "404"), result.m_headers[0]);
+}
+
+TEST_F(server_session_test, keep_dynamic_tables_in_step) {
+  mh2c::server::server_options options{};
+  options.m_responses["/small"] = {200u, {{"server", "mh2c"}}, 10u};
+  options.m_responses["/missing"] = {404u, {{"server", "mh2c"}}, 0u};
+  start(options);
+
+  // Each block indexes what the block before it added, and its second
+  // x-trace refers to the entry its first one adds.
+  for (mh2c::fh_stream_id_t stream_id = 1u; stream_id < 20u; stream_id += 2u) {
+    const auto is_missing = stream_id % 4u == 3u;
+    send_request(m_client.get(), stream_id, is_missing ? "/missing" : "/small",
+                 {{"x-trace", "abc"}, {"x-trace", "abc"}});
+    const auto result = receive_response(m_client.get(), stream_id);
+    ASSERT_FALSE(result.m_headers.empty());
+    EXPECT_EQ(mh2c::header_t(":status", is_missing ? "404" : "200"),
+              result.m_headers[0]);
+  }
+}
+
+TEST_F(server_session_test, send_requests_from_template) {
+  mh2c::server::server_options options{};
+  options.m_responses["/small"] = {200u, {}, 100u};
+  options.m_responses["/missing"] = {404u, {}, 0u};
+  start(options);
+
+  auto header_block = mh2c::make_header_block(
+      mh2c::header_prefix_pattern::INCREMENTAL_INDEXING,
+      mh2c::headers_t{{":method", "GET"},
+                      {":scheme", "http"},
+                      {":authority", "localhost"},
+                      {"user-agent", "mh2c"}});
+  header_block.emplace_back(mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+                            mh2c::header_t{":path", ""});
+  mh2c::header_block_template header_template{
+      header_block, {":path"}, mh2c::header_encode_mode::HUFFMAN};
+
+  size_t entry_count{};
+  for (mh2c::fh_stream_id_t stream_id = 1u; stream_id < 10u; stream_id += 2u) {
+    const auto is_missing = stream_id % 4u == 3u;
+    m_client->send_headers(
+        mh2c::make_frame_header_flags(mh2c::hf_flag::END_STREAM), stream_id,
+        &header_template, {is_missing ? "/missing" : "/small"});
+    const auto result = receive_response(m_client.get(), stream_id);
+    ASSERT_FALSE(result.m_headers.empty());
+    EXPECT_EQ(mh2c::header_t(":status", is_missing ? "404" : "200"),
+              result.m_headers[0]);
+
+    // Only the first request adds entries.
+    const auto& entries = m_client->get_request_dynamic_table().get_entries();
+    if (stream_id == 1u) {
+      entry_count = entries.size();
+    }
+    EXPECT_EQ(entry_count, entries.size());
+  }
+  EXPECT_EQ(2u, entry_count);
+}
+
+TEST_F(server_session_test, client_metrics_count_exchange) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {200u, {}, 10u};
+  start(options);
+
+  send_request(m_client.get(), 1u, "/");
+  receive_response(m_client.get(), 1u);
+  send_request(m_client.get(), 3u, "/");
+  receive_response(m_client.get(), 3u);
+
+  const auto snapshot = m_client->get_metrics().snapshot();
+  const auto headers_slot =
+      mh2c::underlying_cast(mh2c::frame_type_registry::HEADERS);
+  const auto data_slot =
+      mh2c::underlying_cast(mh2c::frame_type_registry::DATA);
+  EXPECT_EQ(2u, snapshot.m_frames_sent[headers_slot]);
+  EXPECT_EQ(2u, snapshot.m_frames_received[headers_slot]);
+  EXPECT_EQ(2u, snapshot.m_frames_received[data_slot]);
+  EXPECT_EQ(2u * (mh2c::FRAME_HEADER_BYTES + 10u),
+            snapshot.m_bytes_received[data_slot]);
+  // The second request and response are indexed by the dynamic tables.
+  EXPECT_GT(snapshot.m_hpack_dynamic_hits, 0u);
+  EXPECT_GT(snapshot.m_huffman_bytes_saved, 0u);
+  EXPECT_GT(snapshot.m_decode_time.get_count(), 0u);
+}
+
+TEST_F(server_session_test, client_traces_exchange) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {200u, {}, 10u};
+  start(options);
+  // The SETTINGS ACK held back since the exchange is traced once written.
+  m_client->flush_control_frames();
+  const auto recorder =
+      std::make_shared<mh2c::trace::ring_buffer_recorder>(64u);
+  m_client->set_trace_observer(recorder);
+
+  send_request(m_client.get(), 1u, "/");
+  EXPECT_EQ(mh2c::stream::stream_state::HALF_CLOSED_LOCAL,
+            m_client->get_stream_state(1u));
+  receive_response(m_client.get(), 1u);
+  EXPECT_EQ(mh2c::stream::stream_state::CLOSED,
+            m_client->get_stream_state(1u));
+
+  const auto events = recorder->get_events();
+  if (mh2c::trace::TRACING_ENABLED == false) {
+    EXPECT_TRUE(events.empty());
+    return;
+  }
+
+  ASSERT_GE(events.size(), 4u);
+  EXPECT_EQ(mh2c::trace::event_type::FRAME_SENT, events[0].m_type);
+  EXPECT_EQ(mh2c::underlying_cast(mh2c::frame_type_registry::HEADERS),
+            events[0].m_frame_header.m_type);
+  EXPECT_EQ(mh2c::trace::event_type::STREAM_STATE_CHANGED, events[1].m_type);
+  EXPECT_EQ(mh2c::trace::event_type::STREAM_STATE_CHANGED, events[2].m_type);
+  EXPECT_EQ(mh2c::trace::event_type::TABLE_CHANGED, events[3].m_type);
+  EXPECT_EQ(mh2c::trace::table_kind::REQUEST, events[3].m_table);
+  EXPECT_EQ(mh2c::trace::event_type::STREAM_STATE_CHANGED,
+            events.back().m_type);
+  EXPECT_EQ(mh2c::stream::stream_state::CLOSED,
+            events.back().m_transition.m_to);
+  for (size_t i = 1; i < events.size(); ++i) {
+    EXPECT_LE(events[i - 1].m_timestamp, events[i].m_timestamp);
+  }
+}
+
+TEST_F(server_session_test, client_captures_frames) {
+  const auto path = ::testing::TempDir() + "server_session_test.bin";
+  mh2c::server::server_options options{};
+  options.m_default_response = {200u, {}, 10u};
+  start(options, path);
+
+  send_request(m_client.get(), 1u, "/first");
+  receive_response(m_client.get(), 1u);
+  send_request(m_client.get(), 3u, "/second");
+  receive_response(m_client.get(), 3u);
+  m_client->stop_capture();
+
+  const auto frames = mh2c::trace::read_frame_capture(path);
+  std::remove(path.c_str());
+  ASSERT_FALSE(frames.empty());
+  EXPECT_EQ(mh2c::trace::capture_direction::SENT, frames[0].m_direction);
+
+  // Both header blocks of the second exchange decode with the tables the
+  // first one left behind.
+  mh2c::trace::capture_replayer replayer{};
+  std::vector<mh2c::headers_t> requests{};
+  std::vector<mh2c::headers_t> responses{};
+  for (const auto& frame : frames) {
+    const auto frame_ptr = replayer.replay(frame);
+    if (mh2c::cast_to_frame_type_registry(frame_ptr->get_header().m_type) !=
+        mh2c::frame_type_registry::HEADERS) {
+      continue;
+    }
+    mh2c::headers_t headers{};
+    for (const auto& entry : mh2c::get_header_block(*frame_ptr)) {
+      headers.push_back(entry.get_header());
+    }
+    (frame.m_direction == mh2c::trace::capture_direction::SENT ? requests
+                                                                 : responses)
+        .push_back(headers);
+  }
+  ASSERT_EQ(2u, requests.size());
+  ASSERT_EQ(2u, responses.size());
+  EXPECT_EQ(mh2c::header_t(":path", "/second"), requests[1].back());
+  EXPECT_EQ(responses[0], responses[1]);
+}
+
+TEST_F(server_session_test, client_times_stream_phases) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {200u, {}, 10u};
+  start(options);
+
+  m_client->mark_stream_queued(1u);
+  send_request(m_client.get(), 1u, "/");
+  receive_response(m_client.get(), 1u);
+  send_request(m_client.get(), 3u, "/");
+  receive_response(m_client.get(), 3u);
+
+  const auto& breakdown = m_client->get_latency_breakdown();
+  EXPECT_EQ(2u, breakdown.m_completed_streams);
+  EXPECT_EQ(1u, breakdown.m_queued.get_count());
+  EXPECT_EQ(2u, breakdown.m_response_headers.get_count());
+  EXPECT_EQ(2u, breakdown.m_first_data.get_count());
+  EXPECT_EQ(2u, breakdown.m_end_stream.get_count());
+  EXPECT_LE(breakdown.m_response_headers.get_min(),
+            breakdown.m_end_stream.get_max());
+}
+
+TEST_F(server_session_test, serve_body_larger_than_initial_window) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {200u, {}, 300000u};
+  start(options);
+  m_client->enable_window_autotuning();
+
+  send_request(m_client.get(), 1u, "/");
+  EXPECT_EQ(300000u, receive_response(m_client.get(), 1u).m_body_size);
+}
+
+TEST_F(server_session_test, client_applies_negotiated_settings) {
+  mh2c::server::server_options options{};
+  options.m_settings = mh2c::make_sf_payload(
+      {{mh2c::sf_parameter::SETTINGS_MAX_CONCURRENT_STREAM, 1u},
+       {mh2c::sf_parameter::SETTINGS_MAX_FRAME_SIZE, 32768u}});
+  start(options);
+  EXPECT_EQ(1u, m_client->get_settings().get_unacknowledged_count());
+
+  send_request(m_client.get(), 1u, "/");
+  // The SETTINGS of the server comes first after its connection preface.
+  const auto frame = m_client->receive_frame();
+  ASSERT_EQ(mh2c::frame_type_registry::SETTINGS,
+            mh2c::cast_to_frame_type_registry(frame->get_header().m_type));
+  const auto& remote = m_client->get_settings().get_remote();
+  EXPECT_EQ(1u, remote.get(mh2c::sf_parameter::SETTINGS_MAX_CONCURRENT_STREAM));
+  EXPECT_EQ(32768u, remote.get(mh2c::sf_parameter::SETTINGS_MAX_FRAME_SIZE));
+
+  EXPECT_THROW(send_request(m_client.get(), 3u, "/"), std::invalid_argument);
+  receive_response(m_client.get(), 1u);
+  EXPECT_EQ(0u, m_client->get_settings().get_unacknowledged_count());
+
+  send_request(m_client.get(), 3u, "/");
+  receive_response(m_client.get(), 3u);
+}
+
+TEST_F(server_session_test, send_header_block_larger_than_max_frame_size) {
+  mh2c::server::server_options options{};
+  options.m_responses["/large"] = {200u, {}, 10u};
+  start(options);
+
+  // Over two frames of the default SETTINGS_MAX_FRAME_SIZE even with Huffman
+  // coding, so the block is split in the middle of the cookie value.
+  const std::string cookie(60000u, 'a');
+  send_request(m_client.get(), 1u, "/large", {{"cookie", cookie}});
+  EXPECT_EQ(10u, receive_response(m_client.get(), 1u).m_body_size);
+  // The request table stays in step with the server's.
+  send_request(m_client.get(), 3u, "/large", {{"cookie", cookie}});
+  EXPECT_EQ(10u, receive_response(m_client.get(), 3u).m_body_size);
+
+  const auto snapshot = m_client->get_metrics().snapshot();
+  EXPECT_EQ(2u, snapshot.m_frames_sent[mh2c::underlying_cast(
+                    mh2c::frame_type_registry::HEADERS)]);
+  EXPECT_EQ(4u, snapshot.m_frames_sent[mh2c::underlying_cast(
+                    mh2c::frame_type_registry::CONTINUATION)]);
+}
+
+TEST_F(server_session_test, upload_body_larger_than_initial_window) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {201u, {}, 0u};
+  start(options);
+
+  send_request(m_client.get(), 1u, "/", {}, false);
+  m_client->send_body(1u, std::make_unique<mh2c::body::buffer_body_source>(
+                              mh2c::byte_array_t(300000u, 'b')));
+  // Only the initial windows are sent before the server opens them.
+  EXPECT_EQ(1u, m_client->get_pending_body_count());
+  EXPECT_EQ(0u, m_client->get_send_window(1u));
+
+  const auto result = receive_response(m_client.get(), 1u);
+  EXPECT_EQ("201", result.m_headers.at(0).second);
+  EXPECT_EQ(0u, m_client->get_pending_body_count());
+
+  const auto snapshot = m_client->get_metrics().snapshot();
+  const auto data_slot =
+      mh2c::underlying_cast(mh2c::frame_type_registry::DATA);
+  EXPECT_EQ(300000u + snapshot.m_frames_sent[data_slot] *
+                          mh2c::FRAME_HEADER_BYTES,
+            snapshot.m_bytes_sent[data_slot]);
+}
+
+TEST_F(server_session_test, interleave_bodies_by_priority) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {201u, {}, 0u};
+  const auto path = ::testing::TempDir() + "server_session_priority.bin";
+  start(options, path);
+
+  // A bulk upload with the lowest weight, reprioritized by a PRIORITY frame,
+  // and a small one with the highest weight carried by its HEADERS
+  send_request(m_client.get(), 1u, "/bulk", {}, false);
+  m_client->send_frame(mh2c::priority_frame{1u, {0u, 0u, 0u}});
+  m_client->send_headers(
+      mh2c::make_frame_header_flags(mh2c::hf_flag::PRIORITY), 3u,
+      mh2c::make_header_block(mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+                              {{":method", "POST"},
+                               {":scheme", "http"},
+                               {":authority", "localhost"},
+                               {":path", "/small"}}),
+      mh2c::header_encode_mode::HUFFMAN, {0u, 0u, 255u});
+
+  m_client->send_body(1u, std::make_unique<mh2c::body::buffer_body_source>(
+                              mh2c::byte_array_t(300000u, 'b')));
+  m_client->send_body(3u, std::make_unique<mh2c::body::buffer_body_source>(
+                              mh2c::byte_array_t(40000u, 's')));
+  EXPECT_EQ("201", receive_response(m_client.get(), 3u).m_headers.at(0).second);
+  EXPECT_EQ("201", receive_response(m_client.get(), 1u).m_headers.at(0).second);
+  m_client->stop_capture();
+
+  std::vector<mh2c::fh_stream_id_t> data_stream_ids{};
+  for (const auto& frame : mh2c::trace::read_frame_capture(path)) {
+    const auto fh = mh2c::build_frame_header(frame.m_raw_header);
+    if (frame.m_direction == mh2c::trace::capture_direction::SENT &&
+        fh.m_type == mh2c::underlying_cast(mh2c::frame_type_registry::DATA)) {
+      data_stream_ids.push_back(fh.m_stream_id);
+    }
+  }
+  std::remove(path.c_str());
+
+  // Stream 1 takes the whole connection window before stream 3 has a body;
+  // once the window opens, stream 3 goes first as a whole.
+  const std::vector<mh2c::fh_stream_id_t> expected_head{1u, 1u, 1u, 1u,
+                                                        3u, 3u, 3u, 1u};
+  ASSERT_LT(expected_head.size(), data_stream_ids.size());
+  EXPECT_EQ(expected_head,
+            std::vector<mh2c::fh_stream_id_t>(
+                data_stream_ids.begin(),
+                data_stream_ids.begin() + expected_head.size()));
+}
+
+TEST_F(server_session_test, decode_gzip_response_body) {
+  std::string text{};
+  for (int i = 0; i < 5000; ++i) {
+    text += "compressible line " + std::to_string(i) + "\n";
+  }
+  z_stream stream{};
+  ASSERT_EQ(Z_OK, deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                               MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY));
+  mh2c::byte_array_t coded(deflateBound(&stream, text.size()));
+  stream.next_in = reinterpret_cast<Bytef*>(text.data());
+  stream.avail_in = static_cast<uInt>(text.size());
+  stream.next_out = coded.data();
+  stream.avail_out = static_cast<uInt>(coded.size());
+  ASSERT_EQ(Z_STREAM_END, deflate(&stream, Z_FINISH));
+  coded.resize(stream.total_out);
+  deflateEnd(&stream);
+
+  mh2c::server::server_options options{};
+  options.m_responses["/gzip"] = {200u, {{"content-encoding", "gzip"}}, 0u,
+                                  coded};
+  start(options);
+
+  const auto sink = std::make_shared<mh2c::body::buffer_body_sink>();
+  m_client->decode_response_body(1u, sink);
+  send_request(m_client.get(), 1u, "/gzip");
+  const auto result = receive_response(m_client.get(), 1u);
+  EXPECT_EQ(coded.size(), result.m_body_size);
+  EXPECT_TRUE(sink->is_complete());
+  EXPECT_EQ(text, std::string(sink->get_buffer().begin(),
+                              sink->get_buffer().end()));
+
+  // accept-encoding is added to the request without touching the dynamic
+  // tables, so that a second request still decodes on both ends.
+  const auto second_sink = std::make_shared<mh2c::body::buffer_body_sink>();
+  m_client->decode_response_body(3u, second_sink);
+  send_request(m_client.get(), 3u, "/gzip");
+  receive_response(m_client.get(), 3u);
+  EXPECT_EQ(sink->get_buffer(), second_sink->get_buffer());
+}
+
+TEST_F(server_session_test, answer_from_push_cache) {
+  mh2c::server::server_options options{};
+  options.m_responses["/index.html"] = {200u, {}, 100u};
+  options.m_responses["/style.css"] = {200u, {}, 3000u};
+  options.m_responses["/script.js"] = {200u, {}, 50000u};
+  options.m_pushes["/index.html"] = {"/style.css", "/script.js"};
+  start(options);
+
+  mh2c::stream::push_cache_options cache_options{};
+  cache_options.m_max_body_size = 10000u;
+  m_client->enable_push_cache(cache_options);
+  send_request(m_client.get(), 1u, "/index.html");
+  EXPECT_EQ(100u, receive_response(m_client.get(), 1u).m_body_size);
+
+  // Promised before the response to /index.html
+  const mh2c::headers_t style_request{
+      {":method", "GET"},
+      {":scheme", "http"},
+      {":authority", "localhost"},
+      {":path", "/style.css"},
+  };
+  EXPECT_EQ(2u, m_client->get_promised_stream(style_request));
+  while (m_client->get_promised_stream(style_request) != 0) {
+    m_client->receive_frame();
+  }
+
+  const auto response = m_client->find_pushed_response(style_request);
+  ASSERT_NE(nullptr, response);
+  EXPECT_EQ(3000u, response->m_body.size());
+  // /script.js is larger than the cache takes.
+  auto script_request = style_request;
+  script_request.back().second = "/script.js";
+  EXPECT_EQ(nullptr, m_client->find_pushed_response(script_request));
+  EXPECT_EQ(mh2c::stream::stream_state::CLOSED,
+            m_client->get_stream_state(4u));
+
+  const auto status = m_client->get_push_cache_status();
+  EXPECT_EQ(2u, status.m_promised);
+  EXPECT_EQ(1u, status.m_cancelled);
+  EXPECT_EQ(1u, status.m_stored);
+
+  // The server has dropped the cancelled push.
+  send_request(m_client.get(), 3u, "/style.css");
+  EXPECT_EQ(3000u, receive_response(m_client.get(), 3u).m_body_size);
+}
+
+TEST_F(server_session_test, drain_after_goaway) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {200u, {}, 1000u};
+  options.m_max_requests = 2u;
+  start(options);
+
+  for (const mh2c::fh_stream_id_t stream_id : {1u, 3u, 5u}) {
+    send_request(m_client.get(), stream_id, "/");
+  }
+  // The streams up to the last one of GOAWAY still complete.
+  EXPECT_EQ(1000u, receive_response(m_client.get(), 1u).m_body_size);
+  EXPECT_EQ(1000u, receive_response(m_client.get(), 3u).m_body_size);
+
+  EXPECT_TRUE(m_client->is_draining());
+  EXPECT_EQ(std::vector<mh2c::fh_stream_id_t>{5u},
+            m_client->take_unprocessed_streams());
+  EXPECT_TRUE(m_client->take_unprocessed_streams().empty());
+  EXPECT_EQ(mh2c::stream::stream_state::CLOSED,
+            m_client->get_stream_state(5u));
+  EXPECT_THROW(send_request(m_client.get(), 7u, "/"), std::invalid_argument);
+
+  // The server closes the drained connection.
+  EXPECT_THROW(
+      while (true) { m_client->receive_frame(); },
+      mh2c::transport::transport_closed);
+}
+
+TEST_F(server_session_test, upload_file_and_produced_bodies) {
+  mh2c::server::server_options options{};
+  options.m_default_response = {201u, {}, 0u};
+  start(options);
+
+  const auto path = ::testing::TempDir() + "server_session_upload.bin";
+  {
+    std::ofstream file{path, std::ios::binary};
+    file << std::string(100000u, 'f');
+  }
+  send_request(m_client.get(), 1u, "/", {}, false);
+  m_client->send_body(1u,
+                      std::make_unique<mh2c::body::file_body_source>(path));
+  EXPECT_EQ("201", receive_response(m_client.get(), 1u).m_headers.at(0).second);
+
+  // DATA payloads handed to the transport as file ranges
+  send_request(m_client.get(), 3u, "/", {}, false);
+  m_client->send_body(3u, std::make_unique<mh2c::body::file_body_source>(
+                              path, mh2c::body::file_transfer_mode::SENDFILE));
+  EXPECT_EQ("201", receive_response(m_client.get(), 3u).m_headers.at(0).second);
+  std::remove(path.c_str());
+
+  size_t produced_length{};
+  send_request(m_client.get(), 5u, "/", {}, false);
+  m_client->send_body(
+      5u, std::make_unique<mh2c::body::producer_body_source>(
+              [&produced_length](uint8_t* buffer, const size_t max_length) {
+                const auto length =
+                    std::min<size_t>(max_length, 70000u - produced_length);
+                std::fill(buffer, buffer + length, 'p');
+                produced_length += length;
+                return length;
+              }));
+  EXPECT_EQ("201", receive_response(m_client.get(), 5u).m_headers.at(0).second);
+  EXPECT_EQ(70000u, produced_length);
+}
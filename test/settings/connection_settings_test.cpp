@@ -0,0 +1,82 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/settings/connection_settings.h"
+
+#include <gtest/gtest.h>
+
+#include "mh2c/frame/error_codes.h"
+#include "mh2c/frame/settings_frame.h"
+
+using mh2c::sf_parameter;
+
+TEST(connection_settings_test, defaults) {
+  const mh2c::settings::connection_settings settings{};
+
+  for (const auto* values : {&settings.get_local(), &settings.get_remote()}) {
+    EXPECT_EQ(4096u, values->get(sf_parameter::SETTINGS_HEADER_TABLE_SIZE));
+    EXPECT_EQ(1u, values->get(sf_parameter::SETTINGS_ENABLE_PUSH));
+    EXPECT_EQ(mh2c::settings::UNLIMITED,
+              values->get(sf_parameter::SETTINGS_MAX_CONCURRENT_STREAM));
+    EXPECT_EQ(65535u, values->get(sf_parameter::SETTINGS_INITIAL_WINDOW_SIZE));
+    EXPECT_EQ(16384u, values->get(sf_parameter::SETTINGS_MAX_FRAME_SIZE));
+    EXPECT_EQ(mh2c::settings::UNLIMITED,
+              values->get(sf_parameter::SETTINGS_MAX_HEADER_LIST_SIZE));
+  }
+}
+
+TEST(connection_settings_test, local_settings_apply_on_ack) {
+  mh2c::settings::connection_settings settings{};
+  settings.on_local_settings(mh2c::make_sf_payload(
+      {{sf_parameter::SETTINGS_MAX_FRAME_SIZE, 65536u}}));
+  settings.on_local_settings(mh2c::make_sf_payload(
+      {{sf_parameter::SETTINGS_MAX_FRAME_SIZE, 32768u}}));
+  EXPECT_EQ(2u, settings.get_unacknowledged_count());
+  EXPECT_EQ(16384u,
+            settings.get_local().get(sf_parameter::SETTINGS_MAX_FRAME_SIZE));
+
+  EXPECT_TRUE(settings.on_local_ack());
+  EXPECT_EQ(65536u,
+            settings.get_local().get(sf_parameter::SETTINGS_MAX_FRAME_SIZE));
+  EXPECT_TRUE(settings.on_local_ack());
+  EXPECT_EQ(32768u,
+            settings.get_local().get(sf_parameter::SETTINGS_MAX_FRAME_SIZE));
+  EXPECT_FALSE(settings.on_local_ack());
+  EXPECT_EQ(0u, settings.get_unacknowledged_count());
+}
+
+TEST(connection_settings_test, remote_settings_ignore_unknown_parameters) {
+  mh2c::settings::connection_settings settings{};
+  auto payload = mh2c::make_sf_payload(
+      {{sf_parameter::SETTINGS_MAX_CONCURRENT_STREAM, 100u}});
+  payload.emplace(0xf0u, 1u);
+  settings.on_remote_settings(payload);
+
+  EXPECT_EQ(100u, settings.get_remote().get(
+                      sf_parameter::SETTINGS_MAX_CONCURRENT_STREAM));
+}
+
+TEST(connection_settings_test, reject_invalid_values) {
+  mh2c::settings::connection_settings settings{};
+
+  // cf. https://tools.ietf.org/html/rfc7540#section-6.5.2
+  try {
+    settings.on_remote_settings(mh2c::make_sf_payload(
+        {{sf_parameter::SETTINGS_MAX_CONCURRENT_STREAM, 10u},
+         {sf_parameter::SETTINGS_INITIAL_WINDOW_SIZE, 0x80000000u}}));
+    FAIL();
+  } catch (const mh2c::connection_error& e) {
+    EXPECT_EQ(mh2c::error_codes::FLOW_CONTROL_ERROR, e.get_error_code());
+  }
+  // Nothing of a rejected frame is applied.
+  EXPECT_EQ(mh2c::settings::UNLIMITED,
+            settings.get_remote().get(
+                sf_parameter::SETTINGS_MAX_CONCURRENT_STREAM));
+
+  EXPECT_THROW(settings.on_remote_settings(mh2c::make_sf_payload(
+                   {{sf_parameter::SETTINGS_MAX_FRAME_SIZE, 16383u}})),
+               mh2c::connection_error);
+  EXPECT_THROW(settings.on_remote_settings(mh2c::make_sf_payload(
+                   {{sf_parameter::SETTINGS_ENABLE_PUSH, 2u}})),
+               mh2c::connection_error);
+}
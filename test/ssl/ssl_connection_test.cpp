@@ -0,0 +1,248 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/ssl/ssl_connection.h"
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/net/connect_options.h"
+#include "mh2c/net/socket_fd.h"
+#include "mh2c/net/tcp_listener.h"
+#include "mh2c/server/tls_acceptor.h"
+#include "mh2c/ssl/ssl_ktls_mode.h"
+#include "mh2c/ssl/ssl_session_cache.h"
+#include "mh2c/ssl/ssl_verify_mode.h"
+#include "support/self_signed_certificate.h"
+
+namespace {
+
+constexpr size_t ECHO_LENGTH{5u};
+constexpr std::chrono::milliseconds TIMEOUT{std::chrono::seconds{2}};
+
+// Accepts TLS connections on 127.0.0.1 one by one and echoes the first
+// echo_length bytes of each.
+class echo_server {
+ public:
+  echo_server(const test_support::self_signed_certificate& certificate,
+              const uint32_t max_early_data, const size_t connections,
+              const size_t echo_length = ECHO_LENGTH)
+      : m_acceptor{certificate.get_certificate_file(),
+                   certificate.get_private_key_file(), max_early_data},
+        m_listener{mh2c::net::listen_tcp("127.0.0.1", 0u)},
+        m_echo_length{echo_length},
+        m_thread{[this, connections]() { run(connections); }} {}
+  ~echo_server() { m_thread.join(); }
+
+  uint16_t get_port() const {
+    return mh2c::net::get_local_port(m_listener.get());
+  }
+
+ private:
+  void run(const size_t connections) {
+    for (size_t i = 0; i < connections; ++i) {
+      if (mh2c::net::wait_for_events(m_listener.get(), POLLIN, TIMEOUT) ==
+          false) {
+        return;
+      }
+      try {
+        const auto transport = m_acceptor.accept(
+            mh2c::net::socket_fd{accept(m_listener.get(), nullptr, nullptr)},
+            TIMEOUT);
+        mh2c::byte_array_t data(m_echo_length);
+        transport->read(data.data(), data.size());
+        transport->write(data.data(), data.size());
+        // Until the client closes
+        transport->wait_readable(TIMEOUT);
+      } catch (const std::exception& e) {
+        ADD_FAILURE() << e.what();
+      }
+    }
+    return;
+  }
+
+  mh2c::server::tls_acceptor m_acceptor;
+  mh2c::net::socket_fd m_listener;
+  size_t m_echo_length;
+  std::thread m_thread;
+};
+
+std::string echo(mh2c::ssl::ssl_connection* connection,
+                 const std::string& text) {
+  connection->write(reinterpret_cast<const uint8_t*>(text.data()),
+                    text.size());
+  std::string echoed(text.size(), '\0');
+  connection->read(reinterpret_cast<uint8_t*>(&echoed[0]), echoed.size());
+  return echoed;
+}
+
+mh2c::net::connect_options make_early_data_options(
+    std::shared_ptr<mh2c::ssl::session_cache> cache) {
+  mh2c::net::connect_options options{};
+  options.m_session_cache = std::move(cache);
+  options.m_early_data = true;
+  return options;
+}
+
+}  // namespace
+
+TEST(ssl_connection_test, throw_if_handshake_times_out) {
+  // The kernel completes the TCP handshake, but nobody speaks TLS.
+  mh2c::net::socket_fd listener{socket(AF_INET, SOCK_STREAM, 0)};
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bind(listener.get(), reinterpret_cast<sockaddr*>(&address), sizeof(address));
+  listen(listener.get(), 8);
+  socklen_t length = sizeof(address);
+  getsockname(listener.get(), reinterpret_cast<sockaddr*>(&address), &length);
+
+  mh2c::net::connect_options options{};
+  options.m_handshake_timeout = std::chrono::milliseconds{200};
+
+  const auto begin = std::chrono::steady_clock::now();
+  EXPECT_ANY_THROW(mh2c::ssl::ssl_connection(
+      "127.0.0.1", ntohs(address.sin_port),
+      mh2c::ssl::verify_mode::VERIFY_NONE, mh2c::ssl::ktls_mode::DISABLED,
+      options));
+  EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds{2});
+}
+
+TEST(ssl_connection_test, resume_and_send_early_data) {
+  const test_support::self_signed_certificate certificate{"early_data"};
+  echo_server server{certificate, 16384u, 2u};
+  const auto cache = std::make_shared<mh2c::ssl::session_cache>();
+  const auto options = make_early_data_options(cache);
+
+  {
+    mh2c::ssl::ssl_connection first{"127.0.0.1", server.get_port(),
+                                    mh2c::ssl::verify_mode::VERIFY_NONE,
+                                    mh2c::ssl::ktls_mode::DISABLED, options};
+    EXPECT_EQ("hello", echo(&first, "hello"));
+    EXPECT_EQ(mh2c::ssl::early_data_status::NOT_SENT,
+              first.get_early_data_status());
+  }
+  // The tickets were read along with the echo.
+  ASSERT_EQ(1u, cache->get_size());
+
+  mh2c::ssl::ssl_connection resumed{"127.0.0.1", server.get_port(),
+                                    mh2c::ssl::verify_mode::VERIFY_NONE,
+                                    mh2c::ssl::ktls_mode::DISABLED, options};
+  EXPECT_EQ(mh2c::ssl::early_data_status::PENDING,
+            resumed.get_early_data_status());
+  const std::string text{"early"};
+  resumed.write(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+  EXPECT_EQ(mh2c::ssl::early_data_status::PENDING,
+            resumed.get_early_data_status());
+
+  std::string echoed(ECHO_LENGTH, '\0');
+  resumed.read(reinterpret_cast<uint8_t*>(&echoed[0]), echoed.size());
+  EXPECT_EQ(text, echoed);
+  EXPECT_EQ(mh2c::ssl::early_data_status::ACCEPTED,
+            resumed.get_early_data_status());
+}
+
+TEST(ssl_connection_test, replay_rejected_early_data) {
+  const test_support::self_signed_certificate certificate{"rejected"};
+  echo_server issuer{certificate, 16384u, 1u};
+  const auto cache = std::make_shared<mh2c::ssl::session_cache>();
+  const auto options = make_early_data_options(cache);
+  {
+    mh2c::ssl::ssl_connection first{"127.0.0.1", issuer.get_port(),
+                                    mh2c::ssl::verify_mode::VERIFY_NONE,
+                                    mh2c::ssl::ktls_mode::DISABLED, options};
+    EXPECT_EQ("hello", echo(&first, "hello"));
+  }
+
+  // Another server cannot decrypt the ticket, so it does a full handshake
+  // and skips the early data.
+  echo_server other{certificate, 0u, 1u};
+  cache->store("127.0.0.1:" + std::to_string(other.get_port()),
+               cache->take("127.0.0.1:" + std::to_string(issuer.get_port())));
+  mh2c::ssl::ssl_connection resumed{"127.0.0.1", other.get_port(),
+                                    mh2c::ssl::verify_mode::VERIFY_NONE,
+                                    mh2c::ssl::ktls_mode::DISABLED, options};
+  EXPECT_EQ(mh2c::ssl::early_data_status::PENDING,
+            resumed.get_early_data_status());
+  EXPECT_EQ("again", echo(&resumed, "again"));
+  EXPECT_EQ(mh2c::ssl::early_data_status::REJECTED,
+            resumed.get_early_data_status());
+}
+
+TEST(ssl_connection_test, report_ktls_disabled) {
+  const test_support::self_signed_certificate certificate{"ktls_disabled"};
+  echo_server server{certificate, 0u, 1u};
+  mh2c::ssl::ssl_connection connection{"127.0.0.1", server.get_port(),
+                                       mh2c::ssl::verify_mode::VERIFY_NONE};
+  const auto status = connection.get_ktls_status();
+  EXPECT_FALSE(status.m_send);
+  EXPECT_FALSE(status.m_receive);
+  EXPECT_EQ("plain", echo(&connection, "plain"));
+}
+
+TEST(ssl_connection_test, send_file_with_or_without_ktls) {
+  const test_support::self_signed_certificate certificate{"ktls_sendfile"};
+  echo_server server{certificate, 0u, 1u};
+  const auto path = ::testing::TempDir() + "ssl_connection_sendfile.bin";
+  {
+    std::ofstream file{path, std::ios::binary};
+    file << "--file--";
+  }
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  ASSERT_NE(-1, fd);
+
+  // Whether the kernel takes the keys or not, the range reaches the peer:
+  // by SSL_sendfile, or copied through user space.
+  mh2c::ssl::ssl_connection connection{"127.0.0.1", server.get_port(),
+                                       mh2c::ssl::verify_mode::VERIFY_NONE,
+                                       mh2c::ssl::ktls_mode::ENABLED};
+  connection.sendfile(fd, 2, ECHO_LENGTH);
+  std::string echoed(ECHO_LENGTH, '\0');
+  connection.read(reinterpret_cast<uint8_t*>(&echoed[0]), echoed.size());
+  EXPECT_EQ("file-", echoed);
+  close(fd);
+  std::remove(path.c_str());
+}
+
+TEST(ssl_connection_test, write_buffers_across_records) {
+  // A frame header, a payload larger than a record, and a small frame
+  const mh2c::byte_array_t header(9u, 'h');
+  const mh2c::byte_array_t payload(20000u, 'p');
+  const mh2c::byte_array_t ping(17u, 'q');
+  const auto total_length = header.size() + payload.size() + ping.size();
+  const test_support::self_signed_certificate certificate{"writev"};
+  echo_server server{certificate, 0u, 1u, total_length};
+  mh2c::ssl::ssl_connection connection{"127.0.0.1", server.get_port(),
+                                       mh2c::ssl::verify_mode::VERIFY_NONE};
+
+  const iovec vectors[]{
+      {const_cast<uint8_t*>(header.data()), header.size()},
+      {const_cast<uint8_t*>(payload.data()), payload.size()},
+      {const_cast<uint8_t*>(ping.data()), ping.size()},
+  };
+  connection.writev(vectors, sizeof(vectors) / sizeof(vectors[0]));
+
+  mh2c::byte_array_t expected{header};
+  expected.insert(expected.end(), payload.begin(), payload.end());
+  expected.insert(expected.end(), ping.begin(), ping.end());
+  mh2c::byte_array_t echoed(total_length);
+  connection.read(echoed.data(), echoed.size());
+  EXPECT_EQ(expected, echoed);
+}
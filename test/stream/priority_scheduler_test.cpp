@@ -0,0 +1,132 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/stream/priority_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <stdexcept>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/priority_frame.h"
+
+namespace {
+
+constexpr size_t CHUNK_BYTES{1000u};
+
+// Sends a chunk for each of rounds selections
+std::map<mh2c::fh_stream_id_t, int> run(
+    mh2c::stream::priority_scheduler* scheduler, const int rounds) {
+  std::map<mh2c::fh_stream_id_t, int> counts{};
+  for (int i = 0; i < rounds; ++i) {
+    const auto stream_id = scheduler->select();
+    ++counts[stream_id];
+    scheduler->on_sent(stream_id, CHUNK_BYTES);
+  }
+  return counts;
+}
+
+}  // namespace
+
+TEST(priority_scheduler, share_by_weight) {
+  mh2c::stream::priority_scheduler scheduler{};
+  EXPECT_EQ(0u, scheduler.select());
+
+  // Weights 64 and 192 on the wire plus one
+  scheduler.set_priority(1u, {0u, 0u, 63u});
+  scheduler.set_priority(3u, {0u, 0u, 191u});
+  scheduler.set_ready(1u, true);
+  scheduler.set_ready(3u, true);
+
+  const auto counts = run(&scheduler, 400);
+  EXPECT_NEAR(100, counts.at(1u), 1);
+  EXPECT_NEAR(300, counts.at(3u), 1);
+}
+
+TEST(priority_scheduler, idle_stream_does_not_catch_up) {
+  mh2c::stream::priority_scheduler scheduler{};
+  scheduler.set_ready(1u, true);
+  scheduler.set_ready(3u, false);
+  run(&scheduler, 100);
+
+  // Stream 3 has the same weight and gets half from now on, not everything
+  // until it has sent as much as stream 1.
+  scheduler.set_ready(3u, true);
+  const auto counts = run(&scheduler, 10);
+  EXPECT_EQ(5, counts.at(1u));
+  EXPECT_EQ(5, counts.at(3u));
+}
+
+TEST(priority_scheduler, parent_before_children) {
+  mh2c::stream::priority_scheduler scheduler{};
+  scheduler.set_priority(1u, {0u, 0u, 15u});
+  scheduler.set_priority(3u, {0u, 1u, 255u});
+  scheduler.set_priority(5u, {0u, 1u, 255u});
+  for (const mh2c::fh_stream_id_t stream_id : {1u, 3u, 5u}) {
+    scheduler.set_ready(stream_id, true);
+  }
+
+  EXPECT_EQ(10, run(&scheduler, 10).at(1u));
+
+  scheduler.set_ready(1u, false);
+  const auto counts = run(&scheduler, 10);
+  EXPECT_EQ(5, counts.at(3u));
+  EXPECT_EQ(5, counts.at(5u));
+}
+
+TEST(priority_scheduler, exclusive_dependency) {
+  mh2c::stream::priority_scheduler scheduler{};
+  scheduler.set_priority(1u, {0u, 0u, 15u});
+  scheduler.set_priority(3u, {0u, 0u, 15u});
+  scheduler.set_priority(5u, {1u, 0u, 15u});
+
+  // cf. https://tools.ietf.org/html/rfc7540#section-5.3.3
+  EXPECT_EQ(0u, scheduler.get_parent(5u));
+  EXPECT_EQ(5u, scheduler.get_parent(1u));
+  EXPECT_EQ(5u, scheduler.get_parent(3u));
+}
+
+TEST(priority_scheduler, depend_on_descendant) {
+  mh2c::stream::priority_scheduler scheduler{};
+  scheduler.set_priority(1u, {0u, 0u, 15u});
+  scheduler.set_priority(3u, {0u, 1u, 15u});
+  scheduler.set_priority(5u, {0u, 3u, 15u});
+
+  // Stream 3 is moved up to the former parent of stream 1 first.
+  scheduler.set_priority(1u, {0u, 3u, 31u});
+  EXPECT_EQ(0u, scheduler.get_parent(3u));
+  EXPECT_EQ(3u, scheduler.get_parent(1u));
+  EXPECT_EQ(3u, scheduler.get_parent(5u));
+  EXPECT_EQ(32u, scheduler.get_weight(1u));
+
+  EXPECT_THROW(scheduler.set_priority(1u, {0u, 1u, 15u}),
+               std::invalid_argument);
+}
+
+TEST(priority_scheduler, unknown_dependency) {
+  mh2c::stream::priority_scheduler scheduler{};
+  scheduler.set_priority(3u, {1u, 7u, 255u});
+
+  // cf. https://tools.ietf.org/html/rfc7540#section-5.3.1
+  EXPECT_EQ(0u, scheduler.get_parent(3u));
+  EXPECT_EQ(16u, scheduler.get_weight(3u));
+}
+
+TEST(priority_scheduler, remove_stream) {
+  mh2c::stream::priority_scheduler scheduler{};
+  scheduler.set_priority(1u, {0u, 0u, 63u});
+  scheduler.set_priority(3u, {0u, 1u, 63u});
+  scheduler.set_priority(5u, {0u, 1u, 191u});
+
+  // cf. https://tools.ietf.org/html/rfc7540#section-5.3.4
+  scheduler.remove_stream(1u);
+  EXPECT_FALSE(scheduler.contains(1u));
+  EXPECT_EQ(0u, scheduler.get_parent(3u));
+  EXPECT_EQ(16u, scheduler.get_weight(3u));
+  EXPECT_EQ(0u, scheduler.get_parent(5u));
+  EXPECT_EQ(48u, scheduler.get_weight(5u));
+
+  scheduler.set_ready(1u, false);
+  EXPECT_FALSE(scheduler.contains(1u));
+}
@@ -0,0 +1,282 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/stream/push_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/continuation_frame.h"
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/error_codes.h"
+#include "mh2c/frame/goaway_frame.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/push_promise_frame.h"
+#include "mh2c/frame/rst_stream_frame.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/util/bit_operation.h"
+
+namespace {
+
+const mh2c::dynamic_table TABLE{};
+
+mh2c::headers_t make_request(const std::string& path,
+                             const std::string& method = "GET") {
+  return {
+      {":method", method},
+      {":scheme", "https"},
+      {":authority", "example.com"},
+      {":path", path},
+  };
+}
+
+mh2c::header_block_t make_block(const mh2c::headers_t& headers) {
+  return mh2c::make_header_block(
+      mh2c::header_prefix_pattern::WITHOUT_INDEXING, headers);
+}
+
+mh2c::fh_stream_id_t promise(mh2c::stream::push_cache* cache,
+                             const mh2c::fh_stream_id_t promised_stream_id,
+                             const mh2c::headers_t& request) {
+  const mh2c::push_promise_frame frame{
+      mh2c::make_frame_header_flags(mh2c::ppf_flag::END_HEADERS),
+      1u,
+      {0u, promised_stream_id, make_block(request), {}},
+      mh2c::header_encode_mode::NONE,
+      TABLE};
+  return cache->on_frame(frame, {});
+}
+
+mh2c::fh_stream_id_t respond(mh2c::stream::push_cache* cache,
+                             const mh2c::fh_stream_id_t stream_id,
+                             const mh2c::headers_t& headers) {
+  const mh2c::headers_frame frame{
+      mh2c::make_frame_header_flags(mh2c::hf_flag::END_HEADERS), stream_id,
+      make_block(headers), mh2c::header_encode_mode::NONE, TABLE};
+  return cache->on_frame(frame, {});
+}
+
+mh2c::fh_stream_id_t send_data(mh2c::stream::push_cache* cache,
+                               const mh2c::fh_stream_id_t stream_id,
+                               const mh2c::byte_array_t& data,
+                               const bool end_stream) {
+  const mh2c::data_frame frame{
+      end_stream ? mh2c::make_frame_header_flags(mh2c::df_flag::END_STREAM)
+                 : mh2c::fh_flags_t{0u},
+      stream_id, data};
+  return cache->on_frame(frame, data);
+}
+
+// Pushes body for path on stream_id
+void push(mh2c::stream::push_cache* cache,
+          const mh2c::fh_stream_id_t stream_id, const std::string& path,
+          const mh2c::byte_array_t& body) {
+  ASSERT_EQ(0u, promise(cache, stream_id, make_request(path)));
+  ASSERT_EQ(0u, respond(cache, stream_id, {{":status", "200"}}));
+  ASSERT_EQ(0u, send_data(cache, stream_id, body, true));
+}
+
+}  // namespace
+
+TEST(push_cache, store_and_find) {
+  mh2c::stream::push_cache cache{};
+  EXPECT_EQ(0u, promise(&cache, 2u, make_request("/style.css")));
+  EXPECT_EQ(2u, cache.get_promised_stream(make_request("/style.css")));
+  EXPECT_EQ(0u, respond(&cache, 2u,
+                        {{":status", "200"}, {"content-length", "6"}}));
+  EXPECT_EQ(0u, send_data(&cache, 2u, {'b', 'o', 'd'}, false));
+  EXPECT_EQ(nullptr, cache.find(make_request("/style.css")));
+  EXPECT_EQ(0u, send_data(&cache, 2u, {'y', '!', '!'}, true));
+
+  EXPECT_EQ(0u, cache.get_promised_stream(make_request("/style.css")));
+  const auto response = cache.find(make_request("/style.css"));
+  ASSERT_NE(nullptr, response);
+  EXPECT_EQ("200", response->m_headers.at(0).second);
+  EXPECT_EQ((mh2c::byte_array_t{'b', 'o', 'd', 'y', '!', '!'}),
+            response->m_body);
+  EXPECT_EQ(6u, cache.get_size());
+
+  // Another method, scheme, authority or path is another resource.
+  EXPECT_EQ(nullptr, cache.find(make_request("/style.css", "HEAD")));
+  EXPECT_EQ(nullptr, cache.find(make_request("/other.css")));
+
+  const auto status = cache.get_status();
+  EXPECT_EQ(1u, status.m_promised);
+  EXPECT_EQ(1u, status.m_stored);
+  EXPECT_EQ(1u, status.m_hits);
+  EXPECT_EQ(0u, status.m_cancelled);
+}
+
+TEST(push_cache, cancel_unwanted_pushes) {
+  mh2c::stream::push_cache_options options{};
+  options.m_max_body_size = 4u;
+  options.m_filter = [](const mh2c::headers_t& request) {
+    return request.at(3).second != "/ads.js";
+  };
+  mh2c::stream::push_cache cache{options};
+
+  // cf. https://tools.ietf.org/html/rfc7540#section-8.2
+  EXPECT_EQ(2u, promise(&cache, 2u, make_request("/form", "POST")));
+  EXPECT_EQ(4u, promise(&cache, 4u, make_request("/ads.js")));
+
+  push(&cache, 6u, "/a.css", {'a'});
+  EXPECT_EQ(8u, promise(&cache, 8u, make_request("/a.css")));
+  EXPECT_EQ(0u, promise(&cache, 10u, make_request("/b.css")));
+  EXPECT_EQ(12u, promise(&cache, 12u, make_request("/b.css")));
+
+  // By content-length, or by the bytes once there are too many
+  EXPECT_EQ(10u, respond(&cache, 10u,
+                         {{":status", "200"}, {"content-length", "5"}}));
+  EXPECT_EQ(0u, promise(&cache, 14u, make_request("/c.css")));
+  EXPECT_EQ(0u, respond(&cache, 14u, {{":status", "200"}}));
+  EXPECT_EQ(0u, send_data(&cache, 14u, {'c', 'c', 'c'}, false));
+  EXPECT_EQ(14u, send_data(&cache, 14u, {'c', 'c'}, false));
+  EXPECT_EQ(1u, cache.get_size());
+
+  // A cancelled push can be promised again.
+  EXPECT_EQ(0u, cache.get_promised_stream(make_request("/c.css")));
+  EXPECT_EQ(6u, cache.get_status().m_cancelled);
+}
+
+TEST(push_cache, evict_least_recently_used) {
+  mh2c::stream::push_cache_options options{};
+  options.m_max_entries = 2u;
+  options.m_max_size = 4u;
+  mh2c::stream::push_cache cache{options};
+
+  push(&cache, 2u, "/a", {'a'});
+  push(&cache, 4u, "/b", {'b'});
+  EXPECT_NE(nullptr, cache.find(make_request("/a")));
+  push(&cache, 6u, "/c", {'c'});
+  EXPECT_EQ(nullptr, cache.find(make_request("/b")));
+  EXPECT_NE(nullptr, cache.find(make_request("/a")));
+
+  // Making room for the body of a push
+  push(&cache, 8u, "/d", {'d', 'd', 'd'});
+  EXPECT_EQ(nullptr, cache.find(make_request("/c")));
+  EXPECT_NE(nullptr, cache.find(make_request("/a")));
+  EXPECT_NE(nullptr, cache.find(make_request("/d")));
+  EXPECT_EQ(4u, cache.get_size());
+}
+
+TEST(push_cache, header_blocks_in_continuation) {
+  mh2c::stream::push_cache cache{};
+  const auto request = make_request("/split.js");
+  const mh2c::push_promise_frame promise_frame{
+      0u,
+      1u,
+      {0u, 2u, make_block({request.begin(), request.begin() + 2}), {}},
+      mh2c::header_encode_mode::NONE,
+      TABLE};
+  EXPECT_EQ(0u, cache.on_frame(promise_frame, {}));
+  const mh2c::continuation_frame continuation{
+      mh2c::make_frame_header_flags(mh2c::hf_flag::END_HEADERS), 1u,
+      make_block({request.begin() + 2, request.end()}),
+      mh2c::header_encode_mode::NONE, TABLE};
+  EXPECT_EQ(0u, cache.on_frame(continuation, {}));
+  EXPECT_EQ(2u, cache.get_promised_stream(request));
+
+  // A response without a body
+  const mh2c::headers_frame headers{
+      mh2c::make_frame_header_flags(mh2c::hf_flag::END_STREAM), 2u,
+      make_block({{":status", "204"}}), mh2c::header_encode_mode::NONE,
+      TABLE};
+  EXPECT_EQ(0u, cache.on_frame(headers, {}));
+  EXPECT_EQ(nullptr, cache.find(request));
+  EXPECT_EQ(0u, cache.on_frame(
+                    mh2c::continuation_frame{
+                        mh2c::make_frame_header_flags(
+                            mh2c::hf_flag::END_HEADERS),
+                        2u, make_block({{"cache-control", "max-age=60"}}),
+                        mh2c::header_encode_mode::NONE, TABLE},
+                    {}));
+
+  const auto response = cache.find(request);
+  ASSERT_NE(nullptr, response);
+  EXPECT_EQ(2u, response->m_headers.size());
+  EXPECT_TRUE(response->m_body.empty());
+}
+
+TEST(push_cache, reset_by_server) {
+  mh2c::stream::push_cache cache{};
+  EXPECT_EQ(0u, promise(&cache, 2u, make_request("/gone")));
+  EXPECT_EQ(0u, respond(&cache, 2u, {{":status", "200"}}));
+  EXPECT_EQ(0u, send_data(&cache, 2u, {'x'}, false));
+  EXPECT_EQ(0u, cache.on_frame(
+                    mh2c::rst_stream_frame{2u, mh2c::error_codes::CANCEL},
+                    {}));
+
+  EXPECT_EQ(0u, cache.get_promised_stream(make_request("/gone")));
+  EXPECT_EQ(0u, cache.get_size());
+  EXPECT_EQ(0u, cache.get_status().m_cancelled);
+}
+
+// cf. https://tools.ietf.org/html/rfc7234#section-4.2
+TEST(push_cache, refresh_stale_response) {
+  mh2c::stream::push_cache cache{};
+  const auto request = make_request("/app.js");
+  EXPECT_EQ(0u, promise(&cache, 2u, request));
+  EXPECT_EQ(0u, respond(&cache, 2u,
+                        {{":status", "200"}, {"cache-control", "max-age=0"}}));
+  EXPECT_EQ(0u, send_data(&cache, 2u, {'o', 'l', 'd'}, true));
+  EXPECT_EQ(1u, cache.get_status().m_stored);
+
+  // A stale response is neither served nor kept from being pushed again.
+  EXPECT_EQ(0u, promise(&cache, 4u, request));
+  EXPECT_EQ(0u, respond(&cache, 4u,
+                        {{":status", "200"}, {"cache-control", "max-age=60"}}));
+  EXPECT_EQ(0u, send_data(&cache, 4u, {'n', 'e', 'w'}, true));
+  const auto response = cache.find(request);
+  ASSERT_NE(nullptr, response);
+  EXPECT_EQ((mh2c::byte_array_t{'n', 'e', 'w'}), response->m_body);
+  EXPECT_EQ(3u, cache.get_size());
+
+  // While it is fresh, the next push is not wanted.
+  EXPECT_EQ(6u, promise(&cache, 6u, request));
+  EXPECT_EQ(1u, cache.get_status().m_cancelled);
+}
+
+TEST(push_cache, forget_pushes_after_goaway) {
+  mh2c::stream::push_cache cache{};
+  EXPECT_EQ(0u, promise(&cache, 2u, make_request("/kept.css")));
+  EXPECT_EQ(0u, respond(&cache, 2u, {{":status", "200"}}));
+  EXPECT_EQ(0u, send_data(&cache, 2u, {'k'}, false));
+  EXPECT_EQ(0u, promise(&cache, 4u, make_request("/dropped.css")));
+  EXPECT_EQ(0u, respond(&cache, 4u, {{":status", "200"}}));
+  EXPECT_EQ(0u, send_data(&cache, 4u, {'d', 'd'}, false));
+
+  const mh2c::goaway_frame goaway{{0u, 2u, mh2c::error_codes::NO_ERROR, {}}};
+  EXPECT_EQ(0u, cache.on_frame(goaway, {}));
+  EXPECT_EQ(2u, cache.get_promised_stream(make_request("/kept.css")));
+  EXPECT_EQ(0u, cache.get_promised_stream(make_request("/dropped.css")));
+  EXPECT_EQ(1u, cache.get_size());
+  EXPECT_EQ(0u, send_data(&cache, 4u, {'d'}, true));
+  EXPECT_EQ(nullptr, cache.find(make_request("/dropped.css")));
+}
+
+// cf. https://tools.ietf.org/html/rfc7540#section-6.1
+TEST(push_cache, padded_data) {
+  mh2c::stream::push_cache cache{};
+  EXPECT_EQ(0u, promise(&cache, 2u, make_request("/padded")));
+  EXPECT_EQ(0u, respond(&cache, 2u, {{":status", "200"}}));
+  const auto flags = mh2c::make_frame_header_flags(mh2c::df_flag::PADDED,
+                                                   mh2c::df_flag::END_STREAM);
+  const mh2c::byte_array_t payload{0x02, 'o', 'k', 0x00, 0x00};
+  EXPECT_EQ(0u, cache.on_frame(mh2c::data_frame{flags, 2u, payload}, payload));
+  const auto response = cache.find(make_request("/padded"));
+  ASSERT_NE(nullptr, response);
+  EXPECT_EQ((mh2c::byte_array_t{'o', 'k'}), response->m_body);
+
+  // The padding must be shorter than the payload.
+  EXPECT_EQ(0u, promise(&cache, 4u, make_request("/broken")));
+  EXPECT_EQ(0u, respond(&cache, 4u, {{":status", "200"}}));
+  for (const auto& broken_payload :
+       {mh2c::byte_array_t{}, mh2c::byte_array_t{0x05, 'x'}}) {
+    EXPECT_THROW(cache.on_frame(mh2c::data_frame{flags, 4u, broken_payload},
+                                broken_payload),
+                 mh2c::connection_error);
+  }
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/stream/stream_latency_tracker.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <sstream>
+
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/stream/latency_breakdown.h"
+#include "mh2c/stream/stream_tracker.h"
+#include "mh2c/util/cast.h"
+
+namespace {
+
+using mh2c::stream::frame_origin;
+using std::chrono::microseconds;
+using time_point = mh2c::stream::stream_latency_tracker::clock_type::time_point;
+
+mh2c::frame_header make_frame_header(const mh2c::frame_type_registry type,
+                                     const mh2c::fh_flags_t flags,
+                                     const mh2c::fh_stream_id_t stream_id) {
+  return {0u, mh2c::underlying_cast(type), flags, 0u, stream_id};
+}
+
+time_point at(const int64_t us) { return time_point{microseconds{us}}; }
+
+}  // namespace
+
+TEST(stream_latency_tracker, record_phases) {
+  mh2c::stream::stream_latency_tracker tracker{};
+  tracker.on_queued(1u, at(0));
+  tracker.on_frame(
+      make_frame_header(mh2c::frame_type_registry::HEADERS, 0x5u, 1u),
+      frame_origin::LOCAL, at(10));
+  tracker.on_frame(
+      make_frame_header(mh2c::frame_type_registry::HEADERS, 0x4u, 1u),
+      frame_origin::REMOTE, at(110));
+  tracker.on_frame(make_frame_header(mh2c::frame_type_registry::DATA, 0u, 1u),
+                   frame_origin::REMOTE, at(210));
+  tracker.on_frame(
+      make_frame_header(mh2c::frame_type_registry::DATA, 0x1u, 1u),
+      frame_origin::REMOTE, at(1010));
+
+  const auto& breakdown = tracker.get_breakdown();
+  EXPECT_EQ(1u, breakdown.m_completed_streams);
+  EXPECT_EQ(microseconds{10}, breakdown.m_queued.get_max());
+  EXPECT_EQ(microseconds{100}, breakdown.m_response_headers.get_max());
+  EXPECT_EQ(microseconds{200}, breakdown.m_first_data.get_max());
+  EXPECT_EQ(microseconds{1000}, breakdown.m_end_stream.get_max());
+}
+
+TEST(stream_latency_tracker, response_without_body) {
+  mh2c::stream::stream_latency_tracker tracker{};
+  tracker.on_frame(
+      make_frame_header(mh2c::frame_type_registry::HEADERS, 0x5u, 3u),
+      frame_origin::LOCAL, at(0));
+  tracker.on_frame(
+      make_frame_header(mh2c::frame_type_registry::HEADERS, 0x5u, 3u),
+      frame_origin::REMOTE, at(50));
+
+  const auto& breakdown = tracker.get_breakdown();
+  EXPECT_EQ(1u, breakdown.m_completed_streams);
+  EXPECT_EQ(0u, breakdown.m_queued.get_count());
+  EXPECT_EQ(0u, breakdown.m_first_data.get_count());
+  EXPECT_EQ(microseconds{50}, breakdown.m_end_stream.get_max());
+}
+
+TEST(stream_latency_tracker, ignore_reset_and_unknown_streams) {
+  mh2c::stream::stream_latency_tracker tracker{};
+  tracker.on_frame(
+      make_frame_header(mh2c::frame_type_registry::HEADERS, 0x5u, 1u),
+      frame_origin::LOCAL, at(0));
+  tracker.on_frame(
+      make_frame_header(mh2c::frame_type_registry::RST_STREAM, 0u, 1u),
+      frame_origin::REMOTE, at(10));
+  // A pushed response was never requested here.
+  tracker.on_frame(
+      make_frame_header(mh2c::frame_type_registry::HEADERS, 0x5u, 2u),
+      frame_origin::REMOTE, at(20));
+
+  const auto& breakdown = tracker.get_breakdown();
+  EXPECT_EQ(0u, breakdown.m_completed_streams);
+  EXPECT_EQ(1u, breakdown.m_reset_streams);
+  EXPECT_EQ(0u, breakdown.m_end_stream.get_count());
+}
+
+TEST(stream_latency_tracker, merge_and_print_breakdown) {
+  mh2c::stream::stream_latency_tracker tracker{};
+  tracker.on_frame(
+      make_frame_header(mh2c::frame_type_registry::HEADERS, 0x5u, 1u),
+      frame_origin::LOCAL, at(0));
+  tracker.on_frame(
+      make_frame_header(mh2c::frame_type_registry::HEADERS, 0x5u, 1u),
+      frame_origin::REMOTE, at(7));
+
+  mh2c::stream::latency_breakdown total{};
+  total += tracker.get_breakdown();
+  total += tracker.get_breakdown();
+  EXPECT_EQ(2u, total.m_completed_streams);
+  EXPECT_EQ(2u, total.m_end_stream.get_count());
+
+  std::ostringstream out_stream{};
+  out_stream << total;
+  EXPECT_NE(std::string::npos,
+            out_stream.str().find("streams: 2 completed, 0 reset\n"));
+  EXPECT_NE(std::string::npos, out_stream.str().find("end stream"));
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/stream/stream_tracker.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/error_codes.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/push_promise_frame.h"
+#include "mh2c/frame/rst_stream_frame.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/stream/stream_state.h"
+
+namespace {
+
+using mh2c::stream::frame_origin;
+using mh2c::stream::stream_state;
+using transitions_t = std::vector<mh2c::stream::stream_transition>;
+
+mh2c::headers_frame make_headers(const mh2c::fh_stream_id_t stream_id,
+                                 const bool end_stream) {
+  const auto flags =
+      end_stream ? mh2c::make_frame_header_flags(mh2c::hf_flag::END_STREAM,
+                                                 mh2c::hf_flag::END_HEADERS)
+                 : mh2c::make_frame_header_flags(mh2c::hf_flag::END_HEADERS);
+  return {flags, stream_id,
+          mh2c::make_header_block(mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+                                  {{":status", "200"}}),
+          mh2c::header_encode_mode::NONE, mh2c::dynamic_table{}};
+}
+
+}  // namespace
+
+TEST(stream_tracker, request_and_response) {
+  mh2c::stream::stream_tracker tracker{};
+  EXPECT_EQ(stream_state::IDLE, tracker.get_state(1u));
+
+  EXPECT_EQ((transitions_t{{1u, stream_state::IDLE, stream_state::OPEN},
+                           {1u, stream_state::OPEN,
+                            stream_state::HALF_CLOSED_LOCAL}}),
+            tracker.on_frame(make_headers(1u, true), frame_origin::LOCAL));
+  EXPECT_EQ(transitions_t{},
+            tracker.on_frame(make_headers(1u, false), frame_origin::REMOTE));
+  EXPECT_EQ(1u, tracker.get_active_stream_count());
+
+  const mh2c::data_frame df{
+      mh2c::make_frame_header_flags(mh2c::df_flag::END_STREAM), 1u, "body"};
+  EXPECT_EQ((transitions_t{{1u, stream_state::HALF_CLOSED_LOCAL,
+                            stream_state::CLOSED}}),
+            tracker.on_frame(df, frame_origin::REMOTE));
+  EXPECT_EQ(stream_state::CLOSED, tracker.get_state(1u));
+  EXPECT_EQ(0u, tracker.get_active_stream_count());
+}
+
+TEST(stream_tracker, opening_stream_closes_lower_idle_streams) {
+  mh2c::stream::stream_tracker tracker{};
+  tracker.on_frame(make_headers(5u, false), frame_origin::LOCAL);
+
+  // cf. https://tools.ietf.org/html/rfc7540#section-5.1.1
+  EXPECT_EQ(stream_state::CLOSED, tracker.get_state(3u));
+  EXPECT_EQ(stream_state::OPEN, tracker.get_state(5u));
+  EXPECT_EQ(stream_state::IDLE, tracker.get_state(7u));
+  EXPECT_EQ(stream_state::IDLE, tracker.get_state(2u));
+}
+
+TEST(stream_tracker, push_promise_reserves_stream) {
+  mh2c::stream::stream_tracker tracker{};
+  tracker.on_frame(make_headers(1u, true), frame_origin::LOCAL);
+
+  const mh2c::push_promise_frame ppf{
+      mh2c::make_frame_header_flags(mh2c::ppf_flag::END_HEADERS),
+      1u,
+      {0u, 2u, {}, {}},
+      mh2c::header_encode_mode::NONE,
+      mh2c::dynamic_table{}};
+  EXPECT_EQ((transitions_t{{2u, stream_state::IDLE,
+                            stream_state::RESERVED_REMOTE}}),
+            tracker.on_frame(ppf, frame_origin::REMOTE));
+
+  EXPECT_EQ((transitions_t{{2u, stream_state::RESERVED_REMOTE,
+                            stream_state::HALF_CLOSED_LOCAL}}),
+            tracker.on_frame(make_headers(2u, false), frame_origin::REMOTE));
+}
+
+TEST(stream_tracker, rst_stream_closes_stream) {
+  mh2c::stream::stream_tracker tracker{};
+  tracker.on_frame(make_headers(1u, false), frame_origin::LOCAL);
+
+  EXPECT_EQ((transitions_t{{1u, stream_state::OPEN, stream_state::CLOSED}}),
+            tracker.on_frame(
+                mh2c::rst_stream_frame{1u, mh2c::error_codes::CANCEL},
+                frame_origin::REMOTE));
+  // Frames racing with RST_STREAM change nothing.
+  EXPECT_EQ(transitions_t{},
+            tracker.on_frame(make_headers(1u, true), frame_origin::REMOTE));
+}
+
+TEST(stream_tracker, goaway_closes_unprocessed_streams) {
+  mh2c::stream::stream_tracker tracker{};
+  for (const mh2c::fh_stream_id_t stream_id : {1u, 3u, 5u, 7u}) {
+    tracker.on_frame(make_headers(stream_id, true), frame_origin::LOCAL);
+  }
+  const mh2c::push_promise_frame ppf{
+      mh2c::make_frame_header_flags(mh2c::ppf_flag::END_HEADERS),
+      1u,
+      {0u, 4u, {}, {}},
+      mh2c::header_encode_mode::NONE,
+      mh2c::dynamic_table{}};
+  tracker.on_frame(ppf, frame_origin::REMOTE);
+
+  // The stream pushed by the sender of GOAWAY goes on.
+  EXPECT_EQ((transitions_t{{5u, stream_state::HALF_CLOSED_LOCAL,
+                            stream_state::CLOSED},
+                           {7u, stream_state::HALF_CLOSED_LOCAL,
+                            stream_state::CLOSED}}),
+            tracker.on_goaway(3u, true));
+  EXPECT_EQ(stream_state::HALF_CLOSED_LOCAL, tracker.get_state(3u));
+  EXPECT_EQ(stream_state::RESERVED_REMOTE, tracker.get_state(4u));
+  EXPECT_EQ(transitions_t{}, tracker.on_goaway(3u, true));
+}
@@ -0,0 +1,270 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include <gtest/gtest.h>
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mh2c/body/body_source.h"
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/frame/ping_frame.h"
+#include "mh2c/frame/window_update_frame.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_block_template.h"
+#include "mh2c/hpack/header_decoder.h"
+#include "mh2c/hpack/header_encoder.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/hpack/huffman_decoder.h"
+#include "mh2c/hpack/huffman_encoder.h"
+#include "mh2c/http2_client.h"
+#include "mh2c/transport/i_transport.h"
+#include "mh2c/util/bit_operation.h"
+#include "support/allocation_counter.h"
+
+// Allocation budgets of the steady-state hot paths, in allocations per call.
+// They are the counts of the current implementation: lower them as
+// allocations are removed, and treat a failure as a regression rather than
+// a reason to raise a budget.
+
+namespace {
+
+constexpr double RECEIVE_DATA_BUDGET{4.0};
+constexpr double RECEIVE_HEADERS_BUDGET{60.0};
+constexpr double SEND_CONTROL_BUDGET{5.0};
+constexpr double SEND_DATA_BUDGET{16.0};
+constexpr double SEND_HEADERS_BUDGET{7.0};
+constexpr double SEND_BODY_BUDGET{7.0};
+constexpr double ENCODE_HEADER_BUDGET{20.0};
+constexpr double DECODE_HEADER_BUDGET{18.0};
+constexpr double ENCODE_INDEXED_BLOCK_BUDGET{36.0};
+constexpr double DECODE_INDEXED_BLOCK_BUDGET{35.0};
+constexpr double ENCODE_TEMPLATE_BUDGET{49.0};
+constexpr double HUFFMAN_ENCODE_BUDGET{4.0};
+constexpr double HUFFMAN_DECODE_BUDGET{6.0};
+
+// Repeats the same bytes forever and discards everything written, so that
+// the transport itself never allocates.
+class replay_transport : public mh2c::transport::i_transport {
+ public:
+  explicit replay_transport(const mh2c::byte_array_t& data)
+      : m_data{data}, m_position{0} {}
+
+  void write(const uint8_t*, const size_t) override {}
+
+  void read(uint8_t* data, const size_t length) override {
+    for (size_t copied = 0; copied < length;) {
+      const auto chunk = std::min(length - copied, m_data.size() - m_position);
+      std::memcpy(data + copied, m_data.data() + m_position, chunk);
+      copied += chunk;
+      m_position = (m_position + chunk) % m_data.size();
+    }
+    return;
+  }
+
+  void sendfile(const int, const off_t, const size_t) override {}
+
+  bool wait_readable(const std::chrono::milliseconds) override {
+    return true;
+  }
+
+  bool wait_readable(const std::chrono::milliseconds, const int) override {
+    return true;
+  }
+
+ private:
+  mh2c::byte_array_t m_data;
+  size_t m_position;
+};
+
+const mh2c::headers_t RESPONSE_HEADERS{
+    {":status", "200"},
+    {"content-type", "text/html; charset=utf-8"},
+    {"cache-control", "max-age=3600"},
+    {"server", "mh2c"},
+};
+
+const mh2c::headers_t REQUEST_HEADERS{
+    {":method", "GET"},
+    {":scheme", "https"},
+    {":authority", "example.com"},
+    {":path", "/index.html"},
+    {"user-agent", "mh2c"},
+};
+
+const mh2c::ping_frame IDLE_FRAME{0u, {0, 0, 0, 0, 0, 0, 0, 0}};
+
+std::unique_ptr<mh2c::http2_client> make_client(
+    const mh2c::i_frame<mh2c::frame_header>& frame) {
+  return std::make_unique<mh2c::http2_client>(
+      std::make_unique<replay_transport>(frame.serialize()));
+}
+
+// Allocations per call, averaged after a warm-up call
+template <typename Operation>
+double count_allocations(Operation operation) {
+  constexpr uint64_t iterations{16u};
+  operation();
+
+  test_support::allocation_counter counter{};
+  for (uint64_t i = 0; i < iterations; ++i) {
+    operation();
+  }
+  return static_cast<double>(counter.get_count()) / iterations;
+}
+
+}  // namespace
+
+TEST(allocation_counter, count_allocations_in_scope) {
+  test_support::allocation_counter counter{};
+  EXPECT_EQ(0u, counter.get_count());
+
+  auto value = std::make_unique<uint64_t>(0u);
+  EXPECT_EQ(1u, counter.get_count());
+  EXPECT_EQ(sizeof(uint64_t), counter.get_bytes());
+
+  counter.reset();
+  value.reset();
+  EXPECT_EQ(0u, counter.get_count());
+}
+
+TEST(allocation_budget, receive_data_frame) {
+  const auto client = make_client(
+      mh2c::data_frame{0u, 1u, mh2c::byte_array_t(16384u, 'x')});
+  EXPECT_LE(count_allocations([&client]() { client->receive_frame(); }),
+            RECEIVE_DATA_BUDGET);
+}
+
+TEST(allocation_budget, receive_headers_frame) {
+  const auto client = make_client(mh2c::headers_frame{
+      mh2c::make_frame_header_flags(mh2c::hf_flag::END_HEADERS), 1u,
+      mh2c::make_header_block(mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+                              RESPONSE_HEADERS),
+      mh2c::header_encode_mode::HUFFMAN, mh2c::dynamic_table{}});
+  EXPECT_LE(count_allocations([&client]() { client->receive_frame(); }),
+            RECEIVE_HEADERS_BUDGET);
+}
+
+TEST(allocation_budget, send_control_frames) {
+  const auto client = make_client(IDLE_FRAME);
+  const mh2c::window_update_frame wuf{0u, 65535u};
+  EXPECT_LE(count_allocations([&client, &wuf]() { client->send_frame(wuf); }),
+            SEND_CONTROL_BUDGET);
+}
+
+TEST(allocation_budget, send_data_frame) {
+  const auto client = make_client(IDLE_FRAME);
+  // Small enough for all the calls to fit in the initial window
+  const mh2c::data_frame df{0u, 1u, mh2c::byte_array_t(1024u, 'x')};
+  EXPECT_LE(count_allocations([&client, &df]() { client->send_frame(df); }),
+            SEND_DATA_BUDGET);
+}
+
+TEST(allocation_budget, send_headers_frame) {
+  const auto client = make_client(IDLE_FRAME);
+  const mh2c::headers_frame hf{
+      mh2c::make_frame_header_flags(mh2c::hf_flag::END_STREAM,
+                                    mh2c::hf_flag::END_HEADERS),
+      1u,
+      mh2c::make_header_block(mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+                              REQUEST_HEADERS),
+      mh2c::header_encode_mode::HUFFMAN, mh2c::dynamic_table{}};
+  EXPECT_LE(count_allocations([&client, &hf]() { client->send_frame(hf); }),
+            SEND_HEADERS_BUDGET);
+}
+
+TEST(allocation_budget, send_body) {
+  const auto client = make_client(IDLE_FRAME);
+  // Small enough for all the calls to fit in the initial window
+  const mh2c::byte_array_t body(1024u, 'x');
+  EXPECT_LE(count_allocations([&client, &body]() {
+              client->send_body(
+                  1u, std::make_unique<mh2c::body::buffer_body_source>(
+                          body.data(), body.size()));
+            }),
+            SEND_BODY_BUDGET);
+}
+
+TEST(allocation_budget, hpack_encode_header) {
+  const mh2c::dynamic_table table{};
+  const mh2c::header_block_entry entry{
+      mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+      {"user-agent", "Mozilla/5.0 (X11; Linux x86_64)"}};
+  EXPECT_LE(count_allocations([&table, &entry]() {
+              mh2c::encode_header(entry, mh2c::header_encode_mode::HUFFMAN,
+                                  table);
+            }),
+            ENCODE_HEADER_BUDGET);
+}
+
+TEST(allocation_budget, hpack_decode_header) {
+  const mh2c::dynamic_table table{};
+  const auto encoded = mh2c::encode_header(
+      {mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+       {"user-agent", "Mozilla/5.0 (X11; Linux x86_64)"}},
+      mh2c::header_encode_mode::HUFFMAN, table);
+  EXPECT_LE(count_allocations(
+                [&table, &encoded]() { mh2c::decode_header(encoded, table); }),
+            DECODE_HEADER_BUDGET);
+}
+
+// Blocks adding entries are coded against the table as they change it,
+// which must cost the same whatever the number of entries in the table.
+TEST(allocation_budget, hpack_indexed_header_block) {
+  mh2c::dynamic_table table{};
+  // Names and values too long to be stored inline in std::string
+  for (int i = 0; i < 48; ++i) {
+    table.push({"x-correlation-id", "3f2a9c7e-" + std::to_string(1000000 + i)});
+  }
+  const auto header_block = mh2c::make_header_block(
+      mh2c::header_prefix_pattern::INCREMENTAL_INDEXING, REQUEST_HEADERS);
+  EXPECT_LE(count_allocations([&table, &header_block]() {
+              mh2c::encode_header_block(header_block,
+                                        mh2c::header_encode_mode::HUFFMAN,
+                                        table);
+            }),
+            ENCODE_INDEXED_BLOCK_BUDGET);
+
+  const auto encoded = mh2c::encode_header_block(
+      header_block, mh2c::header_encode_mode::HUFFMAN, table);
+  EXPECT_LE(count_allocations([&table, &encoded]() {
+              mh2c::decode_header_block(encoded, table);
+            }),
+            DECODE_INDEXED_BLOCK_BUDGET);
+}
+
+// The block is reserved once, however long the names of the variable fields.
+TEST(allocation_budget, hpack_encode_template) {
+  auto header_block = mh2c::make_header_block(
+      mh2c::header_prefix_pattern::WITHOUT_INDEXING, REQUEST_HEADERS);
+  header_block.emplace_back(
+      mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+      mh2c::header_t{"x-request-correlation-identifier-of-the-client", ""});
+  mh2c::header_block_template header_template{
+      header_block, {":path", "x-request-correlation-identifier-of-the-client"},
+      mh2c::header_encode_mode::NONE};
+  const mh2c::dynamic_table table{};
+  const std::vector<mh2c::header_value_t> values{"/style.css", "3f2a9c"};
+  EXPECT_LE(count_allocations([&header_template, &table, &values]() {
+              header_template.encode(values, table);
+            }),
+            ENCODE_TEMPLATE_BUDGET);
+}
+
+TEST(allocation_budget, huffman_round_trip) {
+  const mh2c::byte_array_t raw{'t', 'e', 'x', 't', '/', 'h', 't', 'm', 'l'};
+  const auto encoded = mh2c::huffman::encode(raw);
+  EXPECT_LE(count_allocations([&raw]() { mh2c::huffman::encode(raw); }),
+            HUFFMAN_ENCODE_BUDGET);
+  EXPECT_LE(
+      count_allocations([&encoded]() { mh2c::huffman::decode(encoded); }),
+      HUFFMAN_DECODE_BUDGET);
+}
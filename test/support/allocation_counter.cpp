@@ -0,0 +1,100 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "support/allocation_counter.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Per thread so that allocations of other threads, e.g. a server thread of
+// the same test, do not leak into the measured scope.
+thread_local uint64_t allocation_count{0};
+thread_local uint64_t allocated_bytes{0};
+
+void* allocate(const size_t size) {
+  ++allocation_count;
+  allocated_bytes += size;
+  return std::malloc(size == 0 ? 1u : size);
+}
+
+void* allocate_aligned(const size_t size, const std::align_val_t alignment) {
+  ++allocation_count;
+  allocated_bytes += size;
+
+  const auto align = static_cast<size_t>(alignment);
+  void* ptr{};
+  return posix_memalign(&ptr, align < sizeof(void*) ? sizeof(void*) : align,
+                        size == 0 ? 1u : size) == 0
+             ? ptr
+             : nullptr;
+}
+
+}  // namespace
+
+void* operator new(const size_t size) {
+  if (auto* ptr = allocate(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void* operator new[](const size_t size) { return operator new(size); }
+
+void* operator new(const size_t size, const std::nothrow_t&) noexcept {
+  return allocate(size);
+}
+
+void* operator new[](const size_t size, const std::nothrow_t&) noexcept {
+  return allocate(size);
+}
+
+void* operator new(const size_t size, const std::align_val_t alignment) {
+  if (auto* ptr = allocate_aligned(size, alignment)) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void* operator new[](const size_t size, const std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+namespace test_support {
+
+allocation_counter::allocation_counter()
+    : m_start_count{allocation_count}, m_start_bytes{allocated_bytes} {}
+
+void allocation_counter::reset() {
+  m_start_count = allocation_count;
+  m_start_bytes = allocated_bytes;
+  return;
+}
+
+uint64_t allocation_counter::get_count() const {
+  return allocation_count - m_start_count;
+}
+
+uint64_t allocation_counter::get_bytes() const {
+  return allocated_bytes - m_start_bytes;
+}
+
+}  // namespace test_support
@@ -0,0 +1,29 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#ifndef TEST_SUPPORT_ALLOCATION_COUNTER_H_
+#define TEST_SUPPORT_ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+namespace test_support {
+
+// Counts the calls of the global operator new made by the current thread
+// since construction or the last reset(). Linking allocation_counter.cpp
+// replaces operator new and delete of the whole program, libmh2c included.
+class allocation_counter {
+ public:
+  allocation_counter();
+
+  void reset();
+  uint64_t get_count() const;
+  uint64_t get_bytes() const;
+
+ private:
+  uint64_t m_start_count;
+  uint64_t m_start_bytes;
+};
+
+}  // namespace test_support
+
+#endif  // TEST_SUPPORT_ALLOCATION_COUNTER_H_
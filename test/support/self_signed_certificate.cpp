@@ -0,0 +1,94 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "support/self_signed_certificate.h"
+
+#include <gtest/gtest.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace test_support {
+
+namespace {
+
+using pkey_ptr = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
+using x509_ptr = std::unique_ptr<X509, decltype(&X509_free)>;
+
+pkey_ptr generate_key() {
+  std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> ctx{
+      EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr), EVP_PKEY_CTX_free};
+  EVP_PKEY* key{};
+  if (ctx == nullptr || EVP_PKEY_keygen_init(ctx.get()) != 1 ||
+      EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx.get(),
+                                             NID_X9_62_prime256v1) != 1 ||
+      EVP_PKEY_keygen(ctx.get(), &key) != 1) {
+    throw std::runtime_error("EVP_PKEY_keygen failed");
+  }
+  return {key, EVP_PKEY_free};
+}
+
+x509_ptr sign_certificate(EVP_PKEY* key) {
+  x509_ptr x509{X509_new(), X509_free};
+  X509_set_version(x509.get(), 2);
+  ASN1_INTEGER_set(X509_get_serialNumber(x509.get()), 1);
+  X509_gmtime_adj(X509_getm_notBefore(x509.get()), 0);
+  X509_gmtime_adj(X509_getm_notAfter(x509.get()), 24 * 60 * 60);
+  X509_set_pubkey(x509.get(), key);
+
+  auto name = X509_get_subject_name(x509.get());
+  X509_NAME_add_entry_by_txt(
+      name, "CN", MBSTRING_ASC,
+      reinterpret_cast<const unsigned char*>("127.0.0.1"), -1, -1, 0);
+  X509_set_issuer_name(x509.get(), name);
+  if (X509_sign(x509.get(), key, EVP_sha256()) == 0) {
+    throw std::runtime_error("X509_sign failed");
+  }
+  return x509;
+}
+
+template <typename Writer>
+void write_pem(const std::string& path, Writer writer) {
+  std::unique_ptr<FILE, decltype(&std::fclose)> file{
+      std::fopen(path.c_str(), "w"), std::fclose};
+  if (file == nullptr || writer(file.get()) != 1) {
+    throw std::runtime_error("cannot write " + path);
+  }
+  return;
+}
+
+}  // namespace
+
+self_signed_certificate::self_signed_certificate(const std::string& name)
+    : m_certificate_file{::testing::TempDir() + name + "_cert.pem"},
+      m_private_key_file{::testing::TempDir() + name + "_key.pem"} {
+  const auto key = generate_key();
+  const auto x509 = sign_certificate(key.get());
+  write_pem(m_certificate_file,
+            [&x509](FILE* file) { return PEM_write_X509(file, x509.get()); });
+  write_pem(m_private_key_file, [&key](FILE* file) {
+    return PEM_write_PrivateKey(file, key.get(), nullptr, nullptr, 0,
+                                nullptr, nullptr);
+  });
+}
+
+self_signed_certificate::~self_signed_certificate() {
+  std::remove(m_certificate_file.c_str());
+  std::remove(m_private_key_file.c_str());
+}
+
+const std::string& self_signed_certificate::get_certificate_file() const {
+  return m_certificate_file;
+}
+
+const std::string& self_signed_certificate::get_private_key_file() const {
+  return m_private_key_file;
+}
+
+}  // namespace test_support
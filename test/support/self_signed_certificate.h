@@ -0,0 +1,31 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#ifndef TEST_SUPPORT_SELF_SIGNED_CERTIFICATE_H_
+#define TEST_SUPPORT_SELF_SIGNED_CERTIFICATE_H_
+
+#include <string>
+
+namespace test_support {
+
+// PEM files of a fresh P-256 key and a certificate for 127.0.0.1 signed with
+// it, for TLS servers of the tests. The files are removed on destruction.
+class self_signed_certificate {
+ public:
+  explicit self_signed_certificate(const std::string& name);
+  ~self_signed_certificate();
+
+  self_signed_certificate(const self_signed_certificate&) = delete;
+  self_signed_certificate& operator=(const self_signed_certificate&) = delete;
+
+  const std::string& get_certificate_file() const;
+  const std::string& get_private_key_file() const;
+
+ private:
+  std::string m_certificate_file;
+  std::string m_private_key_file;
+};
+
+}  // namespace test_support
+
+#endif  // TEST_SUPPORT_SELF_SIGNED_CERTIFICATE_H_
@@ -0,0 +1,144 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/trace/frame_capture.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mh2c/common/byte_array.h"
+#include "mh2c/frame/data_frame.h"
+#include "mh2c/frame/frame_builder.h"
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/headers_frame.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/trace/trace_observer.h"
+#include "mh2c/util/bit_operation.h"
+
+namespace {
+
+const mh2c::headers_t RESPONSE_HEADERS{{":status", "200"},
+                                       {"server", "mh2c"}};
+
+class frame_capture_test : public ::testing::Test {
+ protected:
+  void TearDown() override { std::remove(m_path.c_str()); }
+
+  void write(mh2c::trace::frame_capture_writer* writer,
+             const mh2c::trace::timestamp_t timestamp,
+             const mh2c::trace::capture_direction direction,
+             const mh2c::byte_array_t& raw_frame) {
+    writer->write(timestamp, direction, raw_frame.data(),
+                  raw_frame.data() + mh2c::FRAME_HEADER_BYTES,
+                  raw_frame.size() - mh2c::FRAME_HEADER_BYTES);
+  }
+
+  const std::string m_path{::testing::TempDir() + "frame_capture_test.bin"};
+};
+
+// Two responses on one connection: the second one is only decodable with
+// the dynamic table left by the first one.
+std::vector<mh2c::byte_array_t> make_responses() {
+  mh2c::dynamic_table table{};
+  std::vector<mh2c::byte_array_t> raw_frames{};
+  for (const mh2c::fh_stream_id_t stream_id : {1u, 3u}) {
+    const auto header_block = mh2c::make_header_block(
+        mh2c::header_prefix_pattern::INCREMENTAL_INDEXING, RESPONSE_HEADERS);
+    raw_frames.push_back(
+        mh2c::headers_frame{
+            mh2c::make_frame_header_flags(mh2c::hf_flag::END_HEADERS),
+            stream_id, header_block, mh2c::header_encode_mode::HUFFMAN, table}
+            .serialize());
+    mh2c::update_dynamic_table(header_block, &table);
+  }
+  return raw_frames;
+}
+
+}  // namespace
+
+TEST_F(frame_capture_test, write_and_read) {
+  const auto raw_data =
+      mh2c::data_frame{mh2c::make_frame_header_flags(mh2c::df_flag::END_STREAM),
+                       1u, mh2c::byte_array_t{'b', 'o', 'd', 'y'}}
+          .serialize();
+  const auto raw_empty =
+      mh2c::data_frame{0u, 3u, mh2c::byte_array_t{}}.serialize();
+  {
+    mh2c::trace::frame_capture_writer writer{m_path};
+    write(&writer, mh2c::trace::timestamp_t{0x123456789a},
+          mh2c::trace::capture_direction::SENT, raw_data);
+    write(&writer, mh2c::trace::timestamp_t{42},
+          mh2c::trace::capture_direction::RECEIVED, raw_empty);
+  }
+
+  const auto frames = mh2c::trace::read_frame_capture(m_path);
+  ASSERT_EQ(2u, frames.size());
+  EXPECT_EQ(mh2c::trace::timestamp_t{0x123456789a}, frames[0].m_timestamp);
+  EXPECT_EQ(mh2c::trace::capture_direction::SENT, frames[0].m_direction);
+  EXPECT_EQ(mh2c::byte_array_t(raw_data.begin(),
+                               raw_data.begin() + mh2c::FRAME_HEADER_BYTES),
+            frames[0].m_raw_header);
+  EXPECT_EQ((mh2c::byte_array_t{'b', 'o', 'd', 'y'}), frames[0].m_raw_payload);
+  EXPECT_EQ(mh2c::trace::timestamp_t{42}, frames[1].m_timestamp);
+  EXPECT_EQ(mh2c::trace::capture_direction::RECEIVED, frames[1].m_direction);
+  EXPECT_TRUE(frames[1].m_raw_payload.empty());
+}
+
+TEST_F(frame_capture_test, reject_truncated_capture) {
+  const auto raw_data =
+      mh2c::data_frame{0u, 1u, mh2c::byte_array_t{'x', 'y'}}.serialize();
+  {
+    mh2c::trace::frame_capture_writer writer{m_path};
+    writer.write(mh2c::trace::timestamp_t{1},
+                 mh2c::trace::capture_direction::RECEIVED, raw_data.data(),
+                 raw_data.data() + mh2c::FRAME_HEADER_BYTES, 1u);
+  }
+
+  EXPECT_THROW(mh2c::trace::read_frame_capture(m_path), std::runtime_error);
+}
+
+TEST_F(frame_capture_test, reject_other_files) {
+  {
+    std::ofstream file{m_path};
+    file << "PRI * HTTP/2.0\r\n";
+  }
+
+  EXPECT_THROW(mh2c::trace::read_frame_capture(m_path), std::runtime_error);
+  EXPECT_THROW(mh2c::trace::read_frame_capture(m_path + ".missing"),
+               std::runtime_error);
+}
+
+TEST_F(frame_capture_test, replay_with_dynamic_table) {
+  {
+    mh2c::trace::frame_capture_writer writer{m_path};
+    for (const auto& raw_frame : make_responses()) {
+      write(&writer, mh2c::trace::timestamp_t{0},
+            mh2c::trace::capture_direction::RECEIVED, raw_frame);
+    }
+  }
+  const auto frames = mh2c::trace::read_frame_capture(m_path);
+  ASSERT_EQ(2u, frames.size());
+
+  mh2c::trace::capture_replayer replayer{};
+  for (int pass = 0; pass < 2; ++pass) {
+    for (const auto& frame : frames) {
+      const auto frame_ptr = replayer.replay(frame);
+      mh2c::headers_t headers{};
+      for (const auto& entry : mh2c::get_header_block(*frame_ptr)) {
+        headers.push_back(entry.get_header());
+      }
+      EXPECT_EQ(RESPONSE_HEADERS, headers);
+    }
+    replayer.reset();
+  }
+
+  // The second response refers to entries the first one added.
+  EXPECT_LT(frames[1].m_raw_payload.size(), frames[0].m_raw_payload.size());
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/trace/ring_buffer_recorder.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <stdexcept>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/frame/frame_type_registry.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/stream/stream_state.h"
+#include "mh2c/trace/trace_observer.h"
+#include "mh2c/util/cast.h"
+
+namespace {
+
+mh2c::frame_header make_frame_header(const mh2c::fh_stream_id_t stream_id) {
+  return {5u, mh2c::underlying_cast(mh2c::frame_type_registry::HEADERS), 0x5u,
+          0u, stream_id};
+}
+
+}  // namespace
+
+TEST(ring_buffer_recorder, record_events_in_order) {
+  mh2c::trace::ring_buffer_recorder recorder{8u};
+  const mh2c::stream::stream_transition transition{
+      1u, mh2c::stream::stream_state::IDLE, mh2c::stream::stream_state::OPEN};
+  mh2c::dynamic_table table{};
+  table.push({"server", "mh2c"});
+
+  recorder.on_frame_sent(mh2c::trace::timestamp_t{1}, make_frame_header(1u));
+  recorder.on_stream_state_changed(mh2c::trace::timestamp_t{2}, transition);
+  recorder.on_table_changed(mh2c::trace::timestamp_t{3},
+                            mh2c::trace::table_kind::RESPONSE, table);
+  recorder.on_frame_received(mh2c::trace::timestamp_t{4},
+                             make_frame_header(1u));
+
+  const auto events = recorder.get_events();
+  ASSERT_EQ(4u, events.size());
+  EXPECT_EQ(mh2c::trace::event_type::FRAME_SENT, events[0].m_type);
+  EXPECT_EQ(make_frame_header(1u), events[0].m_frame_header);
+  EXPECT_EQ(mh2c::trace::event_type::STREAM_STATE_CHANGED, events[1].m_type);
+  EXPECT_EQ(transition, events[1].m_transition);
+  EXPECT_EQ(mh2c::trace::event_type::TABLE_CHANGED, events[2].m_type);
+  EXPECT_EQ(1u, events[2].m_table_entries);
+  EXPECT_EQ(table.get_table_size(), events[2].m_table_size);
+  EXPECT_EQ(mh2c::trace::event_type::FRAME_RECEIVED, events[3].m_type);
+  EXPECT_EQ(mh2c::trace::timestamp_t{4}, events[3].m_timestamp);
+  EXPECT_EQ(0u, recorder.get_dropped_count());
+}
+
+TEST(ring_buffer_recorder, overwrite_oldest_events) {
+  mh2c::trace::ring_buffer_recorder recorder{3u};
+  for (mh2c::fh_stream_id_t stream_id = 1u; stream_id <= 5u; ++stream_id) {
+    recorder.on_frame_sent(mh2c::trace::timestamp_t{stream_id},
+                           make_frame_header(stream_id));
+  }
+
+  const auto events = recorder.get_events();
+  ASSERT_EQ(3u, events.size());
+  EXPECT_EQ(3u, events[0].m_frame_header.m_stream_id);
+  EXPECT_EQ(4u, events[1].m_frame_header.m_stream_id);
+  EXPECT_EQ(5u, events[2].m_frame_header.m_stream_id);
+  EXPECT_EQ(2u, recorder.get_dropped_count());
+
+  recorder.clear();
+  EXPECT_TRUE(recorder.get_events().empty());
+  EXPECT_EQ(0u, recorder.get_dropped_count());
+}
+
+TEST(ring_buffer_recorder, format_event) {
+  mh2c::trace::ring_buffer_recorder recorder{1u};
+  recorder.on_frame_received(mh2c::trace::timestamp_t{42},
+                             make_frame_header(3u));
+
+  std::ostringstream out_stream{};
+  out_stream << recorder.get_events().front();
+  EXPECT_EQ("42 recv HEADERS len=5 flags=0x5 stream=3", out_stream.str());
+}
+
+TEST(ring_buffer_recorder, reject_zero_capacity) {
+  EXPECT_THROW(mh2c::trace::ring_buffer_recorder{0u}, std::invalid_argument);
+}
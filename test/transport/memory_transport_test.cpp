@@ -0,0 +1,59 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/transport/memory_transport.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "mh2c/transport/i_transport.h"
+
+TEST(memory_transport_test, write_and_read_both_directions) {
+  auto [client, server] = mh2c::transport::make_memory_transport_pair();
+
+  const std::vector<uint8_t> request{1, 2, 3};
+  client->write(request.data(), request.size());
+  std::vector<uint8_t> received(request.size());
+  server->read(received.data(), received.size());
+  EXPECT_EQ(request, received);
+
+  const std::vector<uint8_t> response{4, 5};
+  server->write(response.data(), response.size());
+  received.resize(response.size());
+  client->read(received.data(), received.size());
+  EXPECT_EQ(response, received);
+}
+
+TEST(memory_transport_test, read_waits_for_writer) {
+  auto [client, server] = mh2c::transport::make_memory_transport_pair();
+  EXPECT_FALSE(server->wait_readable(std::chrono::milliseconds{10}));
+
+  std::thread writer{[&client = client]() {
+    for (uint8_t i = 0; i < 4; ++i) {
+      client->write(&i, 1u);
+    }
+  }};
+
+  std::vector<uint8_t> received(4u);
+  server->read(received.data(), received.size());
+  writer.join();
+  EXPECT_EQ((std::vector<uint8_t>{0, 1, 2, 3}), received);
+}
+
+TEST(memory_transport_test, read_throws_after_peer_closed) {
+  auto [client, server] = mh2c::transport::make_memory_transport_pair();
+
+  const uint8_t data{1u};
+  client->write(&data, 1u);
+  client.reset();
+
+  uint8_t received{};
+  server->read(&received, 1u);
+  EXPECT_EQ(data, received);
+  EXPECT_THROW(server->read(&received, 1u),
+               mh2c::transport::transport_closed);
+}
@@ -61,6 +61,16 @@ TEST(byte_order_test, bytes2integral_uint32_t) {
   EXPECT_EQ(expected_result, result);
 }
 
+TEST(byte_order_test, bytes2integral_uint64_t) {
+  constexpr uint64_t expected_result = 0x123456789abcdef0;
+  const auto bytes =
+      mh2c::byte_array_t{0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0};
+  const auto result =
+      mh2c::bytes2integral<std::decay_t<decltype(expected_result)>>(
+          bytes.begin());
+  EXPECT_EQ(expected_result, result);
+}
+
 TEST(byte_order_test, integral2bytes_uint8_t) {
   constexpr uint8_t integer = 0x12;
   const auto expected_result = mh2c::byte_array_t{0x12};
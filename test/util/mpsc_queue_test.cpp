@@ -0,0 +1,64 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/util/mpsc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST(mpsc_queue, push_and_pop_in_order) {
+  mh2c::mpsc_queue<std::unique_ptr<int>> queue{};
+  EXPECT_TRUE(queue.is_empty());
+
+  for (int i = 0; i < 3; ++i) {
+    queue.push(std::make_unique<int>(i));
+  }
+  EXPECT_FALSE(queue.is_empty());
+
+  std::unique_ptr<int> value{};
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(queue.try_pop(&value));
+    EXPECT_EQ(i, *value);
+  }
+  EXPECT_FALSE(queue.try_pop(&value));
+  EXPECT_TRUE(queue.is_empty());
+
+  // Values left in the queue are destroyed with it.
+  queue.push(std::make_unique<int>(3));
+}
+
+TEST(mpsc_queue, keep_order_of_each_producer) {
+  constexpr uint32_t PRODUCERS{4u};
+  constexpr uint32_t COUNT{20000u};
+  mh2c::mpsc_queue<uint64_t> queue{};
+
+  std::vector<std::thread> producers{};
+  for (uint32_t producer = 0; producer < PRODUCERS; ++producer) {
+    producers.emplace_back([&queue, producer]() {
+      for (uint32_t i = 0; i < COUNT; ++i) {
+        queue.push((static_cast<uint64_t>(producer) << 32u) | i);
+      }
+    });
+  }
+
+  std::vector<uint32_t> next(PRODUCERS, 0u);
+  uint64_t value{};
+  for (uint32_t popped = 0; popped < PRODUCERS * COUNT;) {
+    if (queue.try_pop(&value)) {
+      const auto producer = static_cast<uint32_t>(value >> 32u);
+      ASSERT_EQ(next[producer], static_cast<uint32_t>(value));
+      ++next[producer];
+      ++popped;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  EXPECT_TRUE(queue.is_empty());
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "mh2c/util/spsc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+TEST(spsc_queue, push_and_pop_in_order) {
+  mh2c::spsc_queue<std::unique_ptr<int>> queue{3u};
+  EXPECT_EQ(4u, queue.get_capacity());
+  EXPECT_TRUE(queue.is_empty());
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.try_push(std::make_unique<int>(i)));
+  }
+  auto rejected = std::make_unique<int>(4);
+  EXPECT_FALSE(queue.try_push(std::move(rejected)));
+  // Left to the caller when the queue is full
+  ASSERT_NE(nullptr, rejected);
+
+  std::unique_ptr<int> value{};
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.try_pop(&value));
+    EXPECT_EQ(i, *value);
+  }
+  EXPECT_FALSE(queue.try_pop(&value));
+  EXPECT_TRUE(queue.try_push(std::move(rejected)));
+  EXPECT_FALSE(queue.is_empty());
+}
+
+TEST(spsc_queue, hand_over_between_threads) {
+  constexpr uint64_t COUNT{10000u};
+  mh2c::spsc_queue<uint64_t> queue{4u};
+
+  std::thread producer{[&queue]() {
+    for (uint64_t i = 0; i < COUNT;) {
+      auto value = i;
+      if (queue.try_push(std::move(value))) {
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }};
+
+  uint64_t expected{0u};
+  uint64_t value{};
+  while (expected < COUNT) {
+    if (queue.try_pop(&value)) {
+      ASSERT_EQ(expected, value);
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  EXPECT_TRUE(queue.is_empty());
+}
@@ -0,0 +1,176 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include <getopt.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mh2c/frame/frame_header.h"
+#include "mh2c/http2_client.h"
+#include "mh2c/trace/frame_capture.h"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct replay_options {
+  std::string m_path{};
+  uint64_t m_passes{100u};
+  bool m_dump{false};
+};
+
+struct type_stats {
+  uint64_t m_frames{};
+  uint64_t m_bytes{};
+};
+
+constexpr std::array<const char*, 10> FRAME_TYPE_NAMES{
+    "DATA",         "HEADERS", "PRIORITY", "RST_STREAM",    "SETTINGS",
+    "PUSH_PROMISE", "PING",    "GOAWAY",   "WINDOW_UPDATE", "CONTINUATION"};
+
+void usage(const char* program) {
+  std::cerr << "Usage: " << program << " [options] file\n"
+            << "  file  frame capture, e.g. written by h2_load -w\n"
+            << "  -n N  number of passes over the capture (default 100)\n"
+            << "  -d    print every frame once before replaying\n";
+}
+
+bool parse_options(int argc, char* argv[], replay_options* options) {
+  int opt{};
+  while ((opt = getopt(argc, argv, "n:d")) != -1) {
+    switch (opt) {
+      case 'n':
+        options->m_passes = std::stoull(optarg);
+        break;
+      case 'd':
+        options->m_dump = true;
+        break;
+      default:
+        return false;
+    }
+  }
+
+  if (argc - optind != 1 || options->m_passes == 0) {
+    return false;
+  }
+  options->m_path = argv[optind];
+
+  return true;
+}
+
+uint64_t get_frame_bytes(const mh2c::trace::captured_frame& frame) {
+  return frame.m_raw_header.size() + frame.m_raw_payload.size();
+}
+
+void print_frames(const std::vector<mh2c::trace::captured_frame>& frames) {
+  mh2c::trace::capture_replayer replayer{};
+  for (const auto& frame : frames) {
+    const auto elapsed = frame.m_timestamp - frames.front().m_timestamp;
+    std::cout << '+'
+              << std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+                     .count()
+              << "us "
+              << (frame.m_direction == mh2c::trace::capture_direction::SENT
+                      ? "sent"
+                      : "recv")
+              << '\n'
+              << replayer.replay(frame) << '\n';
+  }
+  return;
+}
+
+void print_composition(const std::vector<mh2c::trace::captured_frame>& frames) {
+  std::array<type_stats, FRAME_TYPE_NAMES.size() + 1> stats{};
+  for (const auto& frame : frames) {
+    const auto type = mh2c::build_frame_header(frame.m_raw_header).m_type;
+    auto& type_stat =
+        stats[type < FRAME_TYPE_NAMES.size() ? type : FRAME_TYPE_NAMES.size()];
+    ++type_stat.m_frames;
+    type_stat.m_bytes += get_frame_bytes(frame);
+  }
+
+  std::cout << std::left << std::setw(16) << "type" << std::right
+            << std::setw(10) << "frames" << std::setw(14) << "bytes" << '\n';
+  for (size_t i = 0; i < stats.size(); ++i) {
+    if (stats[i].m_frames == 0) {
+      continue;
+    }
+    std::cout << std::left << std::setw(16)
+              << (i < FRAME_TYPE_NAMES.size() ? FRAME_TYPE_NAMES[i] : "UNKNOWN")
+              << std::right << std::setw(10) << stats[i].m_frames
+              << std::setw(14) << stats[i].m_bytes << '\n';
+  }
+  return;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  replay_options options{};
+  if (parse_options(argc, argv, &options) == false) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<mh2c::trace::captured_frame> frames{};
+  try {
+    frames = mh2c::trace::read_frame_capture(options.m_path);
+  } catch (std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  uint64_t capture_bytes{};
+  for (const auto& frame : frames) {
+    capture_bytes += get_frame_bytes(frame);
+  }
+  std::cout << frames.size() << " frames, " << capture_bytes << " bytes from "
+            << options.m_path << '\n';
+  if (frames.empty()) {
+    return EXIT_SUCCESS;
+  }
+
+  try {
+    if (options.m_dump) {
+      print_frames(frames);
+    }
+    print_composition(frames);
+
+    // Every pass decodes the whole capture from empty HPACK tables, so the
+    // passes are identical; the file has been read into memory beforehand.
+    mh2c::trace::capture_replayer replayer{};
+    const auto begin = clock_type::now();
+    for (uint64_t pass = 0; pass < options.m_passes; ++pass) {
+      replayer.reset();
+      for (const auto& frame : frames) {
+        replayer.replay(frame);
+      }
+    }
+    const std::chrono::duration<double> elapsed = clock_type::now() - begin;
+
+    const auto total_frames = static_cast<double>(frames.size()) *
+                              static_cast<double>(options.m_passes);
+    const auto total_bytes = static_cast<double>(capture_bytes) *
+                             static_cast<double>(options.m_passes);
+    std::cout << std::fixed << std::setprecision(1) << '\n'
+              << options.m_passes << " passes in " << elapsed.count() * 1000.0
+              << " ms\n"
+              << "  " << elapsed.count() * 1e9 / total_frames
+              << " ns/frame, " << total_frames / elapsed.count()
+              << " frames/s, " << total_bytes / elapsed.count() / 1e6
+              << " MB/s\n";
+  } catch (std::exception& e) {
+    std::cerr << "replay failed: " << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
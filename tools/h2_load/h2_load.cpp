@@ -0,0 +1,598 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include <getopt.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mh2c/mh2c.h"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct load_options {
+  std::string m_host{"127.0.0.1"};
+  uint16_t m_port{443u};
+  uint32_t m_connections{1u};
+  uint32_t m_streams{1u};
+  uint64_t m_requests{0u};  // 0 means unlimited
+  std::chrono::seconds m_duration{0};
+  bool m_cleartext{false};
+  bool m_decode{false};
+  std::string m_capture_path{};
+  std::string m_body_path{};
+  std::vector<std::string> m_paths{};
+  mh2c::headers_t m_extra_headers{};
+  // Shared by the workers when resuming TLS sessions with early data
+  std::shared_ptr<mh2c::ssl::session_cache> m_session_cache{};
+};
+
+struct load_result {
+  uint64_t m_succeeded{};
+  uint64_t m_failed{};
+  uint64_t m_bytes{};
+  uint64_t m_uploaded_bytes{};
+  uint64_t m_decoded_bytes{};
+  // Connections drained by GOAWAY, and requests they left unprocessed that
+  // were sent again on a new connection
+  uint64_t m_drained_connections{};
+  uint64_t m_retried{};
+  // Connections whose first requests went out as TLS 1.3 early data
+  uint64_t m_early_data_accepted{};
+  uint64_t m_early_data_rejected{};
+  std::vector<clock_type::duration> m_ttfb{};
+  std::vector<clock_type::duration> m_latency{};
+  mh2c::metrics::metrics_snapshot m_metrics{};
+  mh2c::stream::latency_breakdown m_latency_breakdown{};
+};
+
+// Counts the decoded bytes of a response, and records its stream when the
+// body cannot be decoded
+class counting_sink : public mh2c::body::i_body_sink {
+ public:
+  counting_sink(uint64_t* bytes, const mh2c::fh_stream_id_t stream_id,
+                std::vector<mh2c::fh_stream_id_t>* failed_streams)
+      : m_bytes{bytes},
+        m_stream_id{stream_id},
+        m_failed_streams{failed_streams} {}
+
+  void on_data(const uint8_t*, const size_t length) override {
+    *m_bytes += length;
+  }
+  void on_end() override {}
+  void on_error(const std::string&) override {
+    m_failed_streams->push_back(m_stream_id);
+  }
+
+ private:
+  uint64_t* m_bytes;
+  mh2c::fh_stream_id_t m_stream_id;
+  std::vector<mh2c::fh_stream_id_t>* m_failed_streams;
+};
+
+struct in_flight_request {
+  clock_type::time_point m_start;
+  bool m_first_byte_received;
+  size_t m_path;
+};
+
+void usage(const char* program) {
+  std::cerr
+      << "Usage: " << program << " [options] host port\n"
+      << "  -c N       number of connections (default 1)\n"
+      << "  -m N       concurrent streams per connection (default 1)\n"
+      << "  -n N       total number of requests\n"
+      << "  -D SEC     duration of the run in seconds\n"
+      << "  -p PATH    request path, repeat for a request mix (default /)\n"
+      << "  -H HEADER  extra request header \"name: value\", repeatable\n"
+      << "  -C         use cleartext HTTP/2 with prior knowledge (h2c)\n"
+      << "  -d FILE    POST the content of FILE as the request body\n"
+      << "  -z         accept gzip and deflate and decode the responses\n"
+      << "  -0         resume TLS sessions and send the first requests of a\n"
+      << "             connection as TLS 1.3 early data\n"
+      << "  -w FILE    capture the frames of the first connection to FILE,\n"
+      << "             see tools/frame_replay\n";
+}
+
+bool parse_options(int argc, char* argv[], load_options* options) {
+  int opt{};
+  while ((opt = getopt(argc, argv, "c:m:n:D:p:H:Cd:z0w:")) != -1) {
+    switch (opt) {
+      case 'c':
+        options->m_connections = std::stoul(optarg);
+        break;
+      case 'm':
+        options->m_streams = std::stoul(optarg);
+        break;
+      case 'n':
+        options->m_requests = std::stoull(optarg);
+        break;
+      case 'D':
+        options->m_duration = std::chrono::seconds{std::stoul(optarg)};
+        break;
+      case 'p':
+        options->m_paths.emplace_back(optarg);
+        break;
+      case 'H': {
+        const std::string header{optarg};
+        const auto colon = header.find(':', 1);
+        if (colon == std::string::npos) {
+          return false;
+        }
+        const auto value_begin = header.find_first_not_of(' ', colon + 1);
+        options->m_extra_headers.emplace_back(
+            header.substr(0, colon),
+            value_begin == std::string::npos ? "" : header.substr(value_begin));
+        break;
+      }
+      case 'C':
+        options->m_cleartext = true;
+        break;
+      case 'd':
+        options->m_body_path = optarg;
+        break;
+      case 'z':
+        options->m_decode = true;
+        break;
+      case '0':
+        options->m_session_cache =
+            std::make_shared<mh2c::ssl::session_cache>();
+        break;
+      case 'w':
+        options->m_capture_path = optarg;
+        break;
+      default:
+        return false;
+    }
+  }
+
+  if (argc - optind != 2 || options->m_connections == 0 ||
+      options->m_streams == 0) {
+    return false;
+  }
+  options->m_host = argv[optind];
+  options->m_port = std::stoul(argv[optind + 1]);
+  if (options->m_paths.empty()) {
+    options->m_paths.emplace_back("/");
+  }
+  if (options->m_requests == 0 && options->m_duration.count() == 0) {
+    options->m_requests = options->m_connections * options->m_streams;
+  }
+
+  return true;
+}
+
+class load_worker {
+ public:
+  load_worker(const load_options& options, std::atomic<uint64_t>* issued,
+              const clock_type::time_point deadline,
+              const std::string& capture_path)
+      : m_options{options},
+        m_capture_path{capture_path},
+        m_issued{issued},
+        m_deadline{deadline},
+        m_next_stream_id{1u},
+        m_next_path{0u},
+        m_result{} {}
+
+  load_result run() {
+    auto client = connect(m_capture_path);
+    while (true) {
+      while (m_in_flight.size() < m_options.m_streams &&
+             issue(client.get())) {
+      }
+
+      while (m_in_flight.empty() == false) {
+        const auto frame = client->receive_frame();
+        // Reset by the client, a stream whose body cannot be decoded gets
+        // no more frames.
+        for (const auto stream_id : std::exchange(m_undecodable_streams, {})) {
+          complete(client.get(), stream_id, false);
+        }
+        if (handle_frame(client.get(), frame) == false) {
+          break;
+        }
+      }
+
+      // Once a connection going away has completed the streams it took,
+      // the others and the rest of the run move to a new one.
+      if (client->is_draining() == false || m_in_flight.empty() == false ||
+          (m_retries.empty() && has_more() == false)) {
+        break;
+      }
+      ++m_result.m_drained_connections;
+      add_client_metrics(*client);
+      client = connect("");
+    }
+    m_result.m_failed += m_in_flight.size() + m_retries.size();
+    add_client_metrics(*client);
+
+    return m_result;
+  }
+
+ private:
+  std::unique_ptr<mh2c::http2_client> connect(
+      const std::string& capture_path) {
+    mh2c::net::connect_options connect_options{};
+    connect_options.m_session_cache = m_options.m_session_cache;
+    connect_options.m_early_data = m_options.m_session_cache != nullptr;
+    auto client =
+        m_options.m_cleartext
+            ? std::make_unique<mh2c::http2_client>(
+                  mh2c::transport::connect_cleartext(m_options.m_host,
+                                                     m_options.m_port))
+            : std::make_unique<mh2c::http2_client>(
+                  m_options.m_host, m_options.m_port,
+                  mh2c::ssl::verify_mode::VERIFY_NONE,
+                  mh2c::ssl::ktls_mode::DISABLED, connect_options);
+    if (capture_path.empty() == false) {
+      client->start_capture(capture_path);
+    }
+    const auto settings = mh2c::make_sf_payload(
+        {{mh2c::sf_parameter::SETTINGS_ENABLE_PUSH, 0u},
+         {mh2c::sf_parameter::SETTINGS_MAX_CONCURRENT_STREAM, 100u}});
+    // The requests follow the preface without waiting for the SETTINGS of
+    // the server, which receive_frame() applies when it comes.
+    // cf. https://tools.ietf.org/html/rfc7540#section-3.5
+    if (client->get_early_data_status() ==
+        mh2c::ssl::early_data_status::PENDING) {
+      client->send_connection_preface();
+      client->send_frame(mh2c::settings_frame{0u, 0u, settings});
+    } else {
+      client->exchange_settings(settings);
+    }
+    client->enable_window_autotuning();
+    m_next_stream_id = 1u;
+    // The constant fields are encoded against the table of this connection,
+    // and the policy follows the fields sent on it.
+    m_indexing_policy.emplace();
+    m_request_template.emplace(
+        make_request_block(client->get_request_dynamic_table()),
+        std::vector<mh2c::header_name_t>{":path"},
+        mh2c::header_encode_mode::HUFFMAN);
+
+    return client;
+  }
+
+  // Only :path changes from one request to the next; it is left out of the
+  // table, which keeps the other fields indexed, but for credentials and
+  // values too large for the table.
+  mh2c::header_block_t make_request_block(
+      const mh2c::dynamic_table& dynamic_table) {
+    const auto has_body = m_options.m_body_path.empty() == false;
+    mh2c::headers_t headers{
+        {":method", has_body ? "POST" : "GET"},
+        {":scheme", m_options.m_cleartext ? "http" : "https"},
+        {":authority", m_options.m_host},
+    };
+    headers.insert(headers.end(), m_options.m_extra_headers.begin(),
+                   m_options.m_extra_headers.end());
+    auto header_block =
+        m_indexing_policy->make_header_block(headers, dynamic_table);
+    header_block.emplace_back(mh2c::header_prefix_pattern::WITHOUT_INDEXING,
+                              mh2c::header_t{":path", ""});
+    return header_block;
+  }
+
+  void add_client_metrics(const mh2c::http2_client& client) {
+    m_result.m_metrics += client.get_metrics().snapshot();
+    m_result.m_latency_breakdown += client.get_latency_breakdown();
+    switch (client.get_early_data_status()) {
+      case mh2c::ssl::early_data_status::ACCEPTED:
+        ++m_result.m_early_data_accepted;
+        break;
+      case mh2c::ssl::early_data_status::REJECTED:
+        ++m_result.m_early_data_rejected;
+        break;
+      default:
+        break;
+    }
+    return;
+  }
+
+  bool has_more() const {
+    if (m_deadline != clock_type::time_point{} &&
+        clock_type::now() >= m_deadline) {
+      return false;
+    }
+    return m_options.m_requests == 0 ||
+           m_issued->load() < m_options.m_requests;
+  }
+
+  bool can_issue() {
+    if (m_deadline != clock_type::time_point{} &&
+        clock_type::now() >= m_deadline) {
+      return false;
+    }
+    if (m_options.m_requests == 0) {
+      return true;
+    }
+    return m_issued->fetch_add(1u) < m_options.m_requests;
+  }
+
+  bool issue(mh2c::http2_client* client) {
+    // A retried request keeps its start time, so that its latency shows the
+    // cost of the retry.
+    in_flight_request request{clock_type::now(), false, 0u};
+    if (m_retries.empty() == false) {
+      request = m_retries.front();
+      m_retries.pop_front();
+    } else if (can_issue()) {
+      request.m_path = m_next_path++ % m_options.m_paths.size();
+    } else {
+      return false;
+    }
+
+    const auto has_body = m_options.m_body_path.empty() == false;
+    const auto stream_id = m_next_stream_id;
+    m_next_stream_id += 2u;
+    m_in_flight[stream_id] = request;
+    if (m_options.m_decode) {
+      client->decode_response_body(
+          stream_id,
+          std::make_shared<counting_sink>(&m_result.m_decoded_bytes,
+                                          stream_id, &m_undecodable_streams));
+    }
+    // Large -H headers go out as HEADERS and CONTINUATION frames.
+    client->send_headers(
+        has_body ? mh2c::fh_flags_t{0u}
+                 : mh2c::make_frame_header_flags(mh2c::hf_flag::END_STREAM),
+        stream_id, &*m_request_template, {m_options.m_paths[request.m_path]});
+    if (has_body) {
+      // Mapped, not read; the rest goes out as the server opens the windows.
+      auto body =
+          std::make_unique<mh2c::body::file_body_source>(m_options.m_body_path);
+      m_result.m_uploaded_bytes += body->get_length();
+      client->send_body(stream_id, std::move(body));
+    }
+
+    return true;
+  }
+
+  void complete(mh2c::http2_client* client,
+                const mh2c::fh_stream_id_t stream_id, const bool succeeded) {
+    const auto ite = m_in_flight.find(stream_id);
+    if (ite == m_in_flight.end()) {
+      return;
+    }
+
+    if (succeeded) {
+      ++m_result.m_succeeded;
+      m_result.m_latency.push_back(clock_type::now() - ite->second.m_start);
+    } else {
+      ++m_result.m_failed;
+    }
+    m_in_flight.erase(ite);
+    if (client->is_draining() == false) {
+      issue(client);
+    }
+
+    return;
+  }
+
+  void record_first_byte(const mh2c::fh_stream_id_t stream_id) {
+    const auto ite = m_in_flight.find(stream_id);
+    if (ite == m_in_flight.end() || ite->second.m_first_byte_received) {
+      return;
+    }
+
+    ite->second.m_first_byte_received = true;
+    m_result.m_ttfb.push_back(clock_type::now() - ite->second.m_start);
+    return;
+  }
+
+  bool handle_frame(mh2c::http2_client* client,
+                    const mh2c::h2_frame_ptr& frame) {
+    const auto fh = frame->get_header();
+    switch (mh2c::cast_to_frame_type_registry(fh.m_type)) {
+      case mh2c::frame_type_registry::HEADERS:
+        record_first_byte(fh.m_stream_id);
+        if (mh2c::is_flag_set(fh.m_flags, mh2c::hf_flag::END_STREAM)) {
+          complete(client, fh.m_stream_id, true);
+        }
+        break;
+      case mh2c::frame_type_registry::DATA:
+        record_first_byte(fh.m_stream_id);
+        m_result.m_bytes += fh.m_length;
+        if (mh2c::is_flag_set(fh.m_flags, mh2c::df_flag::END_STREAM)) {
+          complete(client, fh.m_stream_id, true);
+        }
+        break;
+      case mh2c::frame_type_registry::RST_STREAM:
+        complete(client, fh.m_stream_id, false);
+        break;
+      case mh2c::frame_type_registry::PING:
+        if (mh2c::is_flag_set(fh.m_flags, mh2c::pf_flag::ACK) == false) {
+          const auto pf = dynamic_cast<const mh2c::ping_frame*>(frame.get());
+          client->send_frame(mh2c::ping_frame{
+              mh2c::make_frame_header_flags(mh2c::pf_flag::ACK),
+              pf->get_payload()});
+        }
+        break;
+      case mh2c::frame_type_registry::GOAWAY:
+        // The streams the server did not take are retried on the next
+        // connection.
+        for (const auto stream_id : client->take_unprocessed_streams()) {
+          const auto ite = m_in_flight.find(stream_id);
+          if (ite != m_in_flight.end()) {
+            m_retries.push_back(ite->second);
+            m_in_flight.erase(ite);
+            ++m_result.m_retried;
+          }
+        }
+        break;
+      default:
+        break;
+    }
+
+    return true;
+  }
+
+  const load_options& m_options;
+  const std::string m_capture_path;
+  std::atomic<uint64_t>* m_issued;
+  clock_type::time_point m_deadline;
+  mh2c::fh_stream_id_t m_next_stream_id;
+  size_t m_next_path;
+  std::unordered_map<mh2c::fh_stream_id_t, in_flight_request> m_in_flight;
+  std::deque<in_flight_request> m_retries;
+  load_result m_result;
+  std::vector<mh2c::fh_stream_id_t> m_undecodable_streams;
+  std::optional<mh2c::indexing_policy> m_indexing_policy;
+  std::optional<mh2c::header_block_template> m_request_template;
+};
+
+double to_ms(const clock_type::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void print_distribution(const std::string& title,
+                        std::vector<clock_type::duration> samples) {
+  std::cout << title << ':';
+  if (samples.empty()) {
+    std::cout << " no samples\n";
+    return;
+  }
+
+  std::sort(samples.begin(), samples.end());
+  clock_type::duration total{};
+  for (const auto sample : samples) {
+    total += sample;
+  }
+  const auto percentile = [&samples](const double p) {
+    const auto index = static_cast<size_t>(p * (samples.size() - 1));
+    return to_ms(samples[index]);
+  };
+
+  std::cout << std::fixed << std::setprecision(3)
+            << " min " << to_ms(samples.front()) << "ms, mean "
+            << to_ms(total / samples.size()) << "ms, p50 " << percentile(0.5)
+            << "ms, p90 " << percentile(0.9) << "ms, p99 " << percentile(0.99)
+            << "ms, p99.9 " << percentile(0.999) << "ms, max "
+            << to_ms(samples.back()) << "ms\n";
+  return;
+}
+
+void print_metrics(const mh2c::metrics::metrics_snapshot& metrics) {
+  uint64_t frames_sent{};
+  uint64_t frames_received{};
+  for (size_t i = 0; i < mh2c::metrics::FRAME_TYPE_SLOTS; ++i) {
+    frames_sent += metrics.m_frames_sent[i];
+    frames_received += metrics.m_frames_received[i];
+  }
+
+  std::cout << std::fixed << std::setprecision(2) << "frames: " << frames_sent
+            << " sent, " << frames_received << " received, "
+            << metrics.m_flow_control_stalls << " flow control stalls\n"
+            << "hpack: " << metrics.get_hpack_hit_rate() * 100.0
+            << "% indexed (" << metrics.m_hpack_static_hits << " static, "
+            << metrics.m_hpack_dynamic_hits << " dynamic, "
+            << metrics.m_hpack_literals << " literal), "
+            << metrics.m_hpack_evictions << " evictions, "
+            << metrics.m_huffman_bytes_saved << " bytes saved by Huffman\n"
+            << "frame decode: p50 <= "
+            << metrics.m_decode_time.get_percentile(0.5).count()
+            << "ns, p99 <= "
+            << metrics.m_decode_time.get_percentile(0.99).count() << "ns\n";
+  return;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  load_options options{};
+  if (parse_options(argc, argv, &options) == false) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const auto begin = clock_type::now();
+  const auto deadline = options.m_duration.count() > 0
+                            ? begin + options.m_duration
+                            : clock_type::time_point{};
+  std::atomic<uint64_t> issued{0u};
+  std::mutex result_mutex{};
+  load_result total{};
+
+  std::vector<std::thread> workers{};
+  for (uint32_t i = 0; i < options.m_connections; ++i) {
+    const auto capture_path = i == 0 ? options.m_capture_path : "";
+    workers.emplace_back([&options, &issued, deadline, capture_path,
+                          &result_mutex, &total]() {
+      load_result result{};
+      try {
+        result = load_worker{options, &issued, deadline, capture_path}.run();
+      } catch (std::exception& e) {
+        std::cerr << "connection failed: " << e.what() << '\n';
+      }
+
+      std::lock_guard<std::mutex> lock{result_mutex};
+      total.m_succeeded += result.m_succeeded;
+      total.m_failed += result.m_failed;
+      total.m_bytes += result.m_bytes;
+      total.m_uploaded_bytes += result.m_uploaded_bytes;
+      total.m_decoded_bytes += result.m_decoded_bytes;
+      total.m_drained_connections += result.m_drained_connections;
+      total.m_retried += result.m_retried;
+      total.m_early_data_accepted += result.m_early_data_accepted;
+      total.m_early_data_rejected += result.m_early_data_rejected;
+      total.m_ttfb.insert(total.m_ttfb.end(), result.m_ttfb.begin(),
+                          result.m_ttfb.end());
+      total.m_latency.insert(total.m_latency.end(), result.m_latency.begin(),
+                             result.m_latency.end());
+      total.m_metrics += result.m_metrics;
+      total.m_latency_breakdown += result.m_latency_breakdown;
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  const auto elapsed =
+      std::chrono::duration<double>(clock_type::now() - begin).count();
+  std::cout << std::fixed << std::setprecision(2) << "finished in " << elapsed
+            << "s, " << total.m_succeeded / elapsed << " req/s, "
+            << total.m_bytes / elapsed / (1024.0 * 1024.0) << "MB/s\n"
+            << "requests: " << total.m_succeeded + total.m_failed
+            << " total, " << total.m_succeeded << " succeeded, "
+            << total.m_failed << " failed\n"
+            << "traffic: " << total.m_bytes << " bytes of DATA payload, "
+            << total.m_uploaded_bytes << " bytes of request body\n";
+  if (options.m_decode) {
+    std::cout << "decoded: " << total.m_decoded_bytes
+              << " bytes of response body\n";
+  }
+  if (total.m_drained_connections > 0) {
+    std::cout << "goaway: " << total.m_drained_connections
+              << " connections drained, " << total.m_retried
+              << " requests retried\n";
+  }
+  if (options.m_session_cache) {
+    std::cout << "early data: " << total.m_early_data_accepted
+              << " connections accepted, " << total.m_early_data_rejected
+              << " rejected\n";
+  }
+  print_distribution("time to first byte", total.m_ttfb);
+  print_distribution("request latency", total.m_latency);
+  print_metrics(total.m_metrics);
+  std::cout << total.m_latency_breakdown;
+
+  return total.m_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
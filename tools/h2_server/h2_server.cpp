@@ -0,0 +1,149 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include <getopt.h>
+#include <signal.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "mh2c/mh2c.h"
+
+namespace {
+
+void usage(const char* program) {
+  std::cerr
+      << "Usage: " << program << " [options] port\n"
+      << "  -a ADDRESS    address to bind (default 127.0.0.1)\n"
+      << "  -s SIZE       body size of the default response (default 0)\n"
+      << "  -r PATH=SIZE  body size for a path, repeatable\n"
+      << "  -p PATH=PUSHED  push PUSHED along with the response to PATH,\n"
+      << "                  repeatable\n"
+      << "  -H HEADER     extra response header \"name: value\", repeatable\n"
+      << "  -g N          drain each connection with GOAWAY after N requests\n"
+      << "  -c CERT -k KEY  serve TLS with the PEM certificate and key,\n"
+      << "                  cleartext h2c otherwise\n"
+      << "  -e BYTES      accept TLS 1.3 early data of resumed sessions\n";
+}
+
+bool parse_header(const std::string& header, mh2c::header_t* parsed) {
+  const auto colon = header.find(':', 1);
+  if (colon == std::string::npos) {
+    return false;
+  }
+
+  const auto value_begin = header.find_first_not_of(' ', colon + 1);
+  *parsed = {header.substr(0, colon), value_begin == std::string::npos
+                                          ? ""
+                                          : header.substr(value_begin)};
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string address{"127.0.0.1"};
+  mh2c::server::server_options options{};
+  mh2c::headers_t extra_headers{};
+
+  int opt{};
+  while ((opt = getopt(argc, argv, "a:s:r:p:H:g:c:k:e:")) != -1) {
+    switch (opt) {
+      case 'a':
+        address = optarg;
+        break;
+      case 's':
+        options.m_default_response.m_body_size = std::stoull(optarg);
+        break;
+      case 'r': {
+        const std::string response{optarg};
+        const auto equal = response.rfind('=');
+        if (equal == std::string::npos) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        options.m_responses[response.substr(0, equal)].m_body_size =
+            std::stoull(response.substr(equal + 1));
+        break;
+      }
+      case 'p': {
+        const std::string push{optarg};
+        const auto equal = push.find('=');
+        if (equal == std::string::npos) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        options.m_pushes[push.substr(0, equal)].push_back(
+            push.substr(equal + 1));
+        break;
+      }
+      case 'H': {
+        mh2c::header_t header{};
+        if (parse_header(optarg, &header) == false) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        extra_headers.push_back(header);
+        break;
+      }
+      case 'g':
+        options.m_max_requests = std::stoull(optarg);
+        break;
+      case 'c':
+        options.m_certificate_file = optarg;
+        break;
+      case 'k':
+        options.m_private_key_file = optarg;
+        break;
+      case 'e':
+        options.m_max_early_data =
+            static_cast<uint32_t>(std::stoul(optarg));
+        break;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  const auto tls_enabled = options.m_certificate_file.empty() == false;
+  if (argc - optind != 1 ||
+      tls_enabled == options.m_private_key_file.empty()) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  options.m_default_response.m_headers = extra_headers;
+  for (auto& [path, response] : options.m_responses) {
+    response.m_headers = extra_headers;
+  }
+  const auto transport = tls_enabled
+                             ? mh2c::server::server_transport::TLS
+                             : mh2c::server::server_transport::CLEARTEXT;
+
+  // Serve until SIGINT or SIGTERM. A client closing a TLS connection must not
+  // kill the process with SIGPIPE.
+  sigset_t signals{};
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  try {
+    mh2c::server::http2_server server{options};
+    const auto port =
+        server.listen(address, std::stoul(argv[optind]), transport);
+    std::cout << "listening on " << address << ':' << port << std::endl;
+
+    int received_signal{};
+    sigwait(&signals, &received_signal);
+    server.stop();
+  } catch (std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
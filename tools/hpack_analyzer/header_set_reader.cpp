@@ -0,0 +1,361 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include "header_set_reader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mh2c/hpack/header_type.h"
+
+namespace hpack_analyzer {
+
+namespace {
+
+// cf. https://tools.ietf.org/html/rfc7540#section-8.1.2.2
+const std::set<std::string> CONNECTION_SPECIFIC_FIELDS{
+    "connection", "host",    "keep-alive",       "proxy-connection",
+    "te",         "upgrade", "transfer-encoding"};
+
+std::string to_lower(std::string text) {
+  std::transform(text.begin(), text.end(), text.begin(),
+                 [](const unsigned char c) { return std::tolower(c); });
+  return text;
+}
+
+// Just enough of JSON to walk a HAR file
+struct json_value {
+  enum class kind { NONE, STRING, ARRAY, OBJECT, OTHER };
+
+  const json_value* find(const std::string& key) const {
+    const auto it = std::find(m_keys.begin(), m_keys.end(), key);
+    return it == m_keys.end() ? nullptr : &m_values[it - m_keys.begin()];
+  }
+  std::string get_string(const std::string& key) const {
+    const auto value = find(key);
+    return value != nullptr && value->m_kind == kind::STRING
+               ? value->m_string
+               : std::string{};
+  }
+
+  kind m_kind{kind::NONE};
+  std::string m_string{};
+  // Elements of an array, or values of an object paired with m_keys
+  std::vector<json_value> m_values{};
+  std::vector<std::string> m_keys{};
+};
+
+class json_parser {
+ public:
+  explicit json_parser(const std::string& text) : m_text{text}, m_pos{0} {}
+
+  json_value parse() {
+    auto value = parse_value();
+    skip_spaces();
+    if (m_pos != m_text.size()) {
+      fail();
+    }
+    return value;
+  }
+
+ private:
+  [[noreturn]] void fail() const {
+    throw std::runtime_error("invalid JSON at offset " +
+                             std::to_string(m_pos));
+  }
+
+  void skip_spaces() {
+    while (m_pos < m_text.size() &&
+           std::isspace(static_cast<unsigned char>(m_text[m_pos]))) {
+      ++m_pos;
+    }
+    return;
+  }
+
+  char peek() {
+    skip_spaces();
+    if (m_pos >= m_text.size()) {
+      fail();
+    }
+    return m_text[m_pos];
+  }
+
+  void expect(const char c) {
+    if (peek() != c) {
+      fail();
+    }
+    ++m_pos;
+    return;
+  }
+
+  json_value parse_value() {
+    json_value value{};
+    switch (peek()) {
+      case '{':
+        value.m_kind = json_value::kind::OBJECT;
+        ++m_pos;
+        if (peek() == '}') {
+          ++m_pos;
+          break;
+        }
+        do {
+          value.m_keys.push_back(parse_string());
+          expect(':');
+          value.m_values.push_back(parse_value());
+        } while (consume(','));
+        expect('}');
+        break;
+      case '[':
+        value.m_kind = json_value::kind::ARRAY;
+        ++m_pos;
+        if (peek() == ']') {
+          ++m_pos;
+          break;
+        }
+        do {
+          value.m_values.push_back(parse_value());
+        } while (consume(','));
+        expect(']');
+        break;
+      case '"':
+        value.m_kind = json_value::kind::STRING;
+        value.m_string = parse_string();
+        break;
+      default:
+        // Numbers, true, false and null are not needed, only skipped.
+        value.m_kind = json_value::kind::OTHER;
+        while (m_pos < m_text.size() &&
+               std::string{",]} \t\r\n"}.find(m_text[m_pos]) ==
+                   std::string::npos) {
+          ++m_pos;
+        }
+        break;
+    }
+    return value;
+  }
+
+  bool consume(const char c) {
+    if (peek() != c) {
+      return false;
+    }
+    ++m_pos;
+    return true;
+  }
+
+  uint32_t parse_hex4() {
+    if (m_pos + 4 > m_text.size()) {
+      fail();
+    }
+    const auto digits = m_text.substr(m_pos, 4);
+    if (digits.find_first_not_of("0123456789abcdefABCDEF") !=
+        std::string::npos) {
+      fail();
+    }
+    m_pos += 4;
+    return std::stoul(digits, nullptr, 16);
+  }
+
+  void append_utf8(uint32_t code_point, std::string* out) {
+    if (code_point < 0x80) {
+      out->push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800) {
+      out->push_back(static_cast<char>(0xc0 | (code_point >> 6)));
+      out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+    } else if (code_point < 0x10000) {
+      out->push_back(static_cast<char>(0xe0 | (code_point >> 12)));
+      out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+    } else {
+      out->push_back(static_cast<char>(0xf0 | (code_point >> 18)));
+      out->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+    }
+    return;
+  }
+
+  std::string parse_string() {
+    expect('"');
+    std::string result{};
+    while (true) {
+      if (m_pos >= m_text.size()) {
+        fail();
+      }
+      const auto c = m_text[m_pos++];
+      if (c == '"') {
+        return result;
+      }
+      if (c != '\\') {
+        result.push_back(c);
+        continue;
+      }
+
+      if (m_pos >= m_text.size()) {
+        fail();
+      }
+      switch (const auto escaped = m_text[m_pos++]) {
+        case 'b':
+          result.push_back('\b');
+          break;
+        case 'f':
+          result.push_back('\f');
+          break;
+        case 'n':
+          result.push_back('\n');
+          break;
+        case 'r':
+          result.push_back('\r');
+          break;
+        case 't':
+          result.push_back('\t');
+          break;
+        case 'u': {
+          auto code_point = parse_hex4();
+          // Surrogate pair
+          if (code_point >= 0xd800 && code_point < 0xdc00 &&
+              m_text.compare(m_pos, 2, "\\u") == 0) {
+            m_pos += 2;
+            const auto low = parse_hex4();
+            code_point = 0x10000 + ((code_point - 0xd800) << 10) +
+                         (low - 0xdc00);
+          }
+          append_utf8(code_point, &result);
+          break;
+        }
+        default:
+          result.push_back(escaped);
+          break;
+      }
+    }
+  }
+
+  const std::string& m_text;
+  size_t m_pos;
+};
+
+// Splits "scheme://authority/path?query" into the request pseudo-header
+// fields.
+// cf. https://tools.ietf.org/html/rfc7540#section-8.1.2.3
+mh2c::headers_t make_pseudo_header_fields(const std::string& method,
+                                          const std::string& url) {
+  const auto scheme_end = url.find("://");
+  if (scheme_end == std::string::npos) {
+    throw std::runtime_error("unsupported request URL: " + url);
+  }
+  const auto authority_begin = scheme_end + 3;
+  const auto path_begin = url.find('/', authority_begin);
+  const auto authority =
+      url.substr(authority_begin, path_begin - authority_begin);
+  const auto path = path_begin == std::string::npos
+                        ? std::string{"/"}
+                        : url.substr(path_begin);
+
+  return {{":method", method},
+          {":scheme", to_lower(url.substr(0, scheme_end))},
+          {":authority", authority},
+          {":path", path}};
+}
+
+}  // namespace
+
+header_sets_t read_text(std::istream& in_stream) {
+  header_sets_t header_sets{};
+  mh2c::headers_t headers{};
+
+  std::string line{};
+  while (std::getline(in_stream, line)) {
+    if (line.empty() == false && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty()) {
+      if (headers.empty() == false) {
+        header_sets.push_back(std::move(headers));
+        headers.clear();
+      }
+      continue;
+    }
+    if (line[0] == '#') {
+      continue;
+    }
+
+    // The name of a pseudo-header field starts with a colon itself.
+    const auto colon = line.find(':', 1);
+    if (colon == std::string::npos) {
+      throw std::runtime_error("header line without a colon: " + line);
+    }
+    const auto value_begin = line.find_first_not_of(' ', colon + 1);
+    headers.emplace_back(
+        to_lower(line.substr(0, colon)),
+        value_begin == std::string::npos ? "" : line.substr(value_begin));
+  }
+  if (headers.empty() == false) {
+    header_sets.push_back(std::move(headers));
+  }
+
+  return header_sets;
+}
+
+header_sets_t read_har(std::istream& in_stream) {
+  const std::string text{std::istreambuf_iterator<char>{in_stream},
+                         std::istreambuf_iterator<char>{}};
+  const auto root = json_parser{text}.parse();
+  const auto log = root.find("log");
+  const auto entries = log != nullptr ? log->find("entries") : nullptr;
+  if (entries == nullptr || entries->m_kind != json_value::kind::ARRAY) {
+    throw std::runtime_error("HAR without log.entries");
+  }
+
+  header_sets_t header_sets{};
+  for (const auto& entry : entries->m_values) {
+    const auto request = entry.find("request");
+    const auto fields = request != nullptr ? request->find("headers") : nullptr;
+    if (fields == nullptr) {
+      continue;
+    }
+
+    mh2c::headers_t headers{};
+    for (const auto& field : fields->m_values) {
+      const auto name = to_lower(field.get_string("name"));
+      if (name.empty() || CONNECTION_SPECIFIC_FIELDS.count(name) > 0) {
+        continue;
+      }
+      headers.emplace_back(name, field.get_string("value"));
+    }
+
+    const auto has_pseudo_header_fields =
+        std::any_of(headers.begin(), headers.end(),
+                    [](const auto& header) { return header.first[0] == ':'; });
+    if (has_pseudo_header_fields == false) {
+      auto pseudo_headers = make_pseudo_header_fields(
+          request->get_string("method"), request->get_string("url"));
+      headers.insert(headers.begin(), pseudo_headers.begin(),
+                     pseudo_headers.end());
+    }
+    header_sets.push_back(std::move(headers));
+  }
+
+  return header_sets;
+}
+
+header_sets_t read_header_sets(const std::string& path) {
+  std::ifstream in_stream{path};
+  if (in_stream.is_open() == false) {
+    throw std::runtime_error("cannot open " + path);
+  }
+
+  const auto is_har =
+      (path.size() >= 4 && to_lower(path.substr(path.size() - 4)) == ".har") ||
+      (in_stream >> std::ws).peek() == '{';
+  return is_har ? read_har(in_stream) : read_text(in_stream);
+}
+
+}  // namespace hpack_analyzer
@@ -0,0 +1,33 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#ifndef TOOLS_HPACK_ANALYZER_HEADER_SET_READER_H_
+#define TOOLS_HPACK_ANALYZER_HEADER_SET_READER_H_
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "mh2c/hpack/header_type.h"
+
+namespace hpack_analyzer {
+
+// Header lists in the order they would be sent on one connection
+using header_sets_t = std::vector<mh2c::headers_t>;
+
+// Text format: one "name: value" per line, header sets separated by blank
+// lines, '#' starts a comment line. Pseudo-header fields are written as
+// ":path: /index.html".
+header_sets_t read_text(std::istream& in_stream);
+
+// HTTP Archive: the request headers of log.entries. Pseudo-header fields are
+// derived from the method and URL when the capture has none (HTTP/1.1), and
+// connection-specific fields are dropped as HTTP/2 requires.
+header_sets_t read_har(std::istream& in_stream);
+
+// Picks the format by the ".har" extension or a leading '{'.
+header_sets_t read_header_sets(const std::string& path);
+
+}  // namespace hpack_analyzer
+
+#endif  // TOOLS_HPACK_ANALYZER_HEADER_SET_READER_H_
@@ -0,0 +1,307 @@
+// Copyright (c) 2021, yknoya
+// Distributed under the BSD 3-Clause License.
+// See accompanying file LICENSE
+#include <getopt.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "header_set_reader.h"
+#include "mh2c/common/byte_array.h"
+#include "mh2c/hpack/dynamic_table.h"
+#include "mh2c/hpack/header_encoder.h"
+#include "mh2c/hpack/header_type.h"
+#include "mh2c/hpack/indexing_policy.h"
+#include "mh2c/hpack/integer_representation.h"
+
+namespace {
+
+// Literal representation of every field, or the one indexing_policy
+// chooses for each when empty
+using policy_t = std::optional<mh2c::header_prefix_pattern>;
+
+struct analyzer_options {
+  std::string m_path{};
+  std::vector<policy_t> m_policies{};
+  std::vector<size_t> m_table_sizes{};
+  mh2c::header_encode_mode m_encode_mode{mh2c::header_encode_mode::HUFFMAN};
+  size_t m_top_fields{20u};
+};
+
+struct representation_counts {
+  uint64_t m_static_hits{};
+  uint64_t m_dynamic_hits{};
+  uint64_t m_literals{};
+};
+
+struct field_cost {
+  representation_counts m_representations{};
+  uint64_t m_count{};
+  uint64_t m_encoded_bytes{};
+  uint64_t m_plain_bytes{};
+};
+
+struct analysis {
+  representation_counts m_representations{};
+  uint64_t m_fields{};
+  uint64_t m_encoded_bytes{};
+  uint64_t m_plain_bytes{};
+  uint64_t m_evictions{};
+  std::optional<mh2c::indexing_policy_status> m_decisions{};
+  size_t m_final_entries{};
+  size_t m_final_table_size{};
+  std::unordered_map<mh2c::header_name_t, field_cost> m_costs{};
+};
+
+const std::vector<std::pair<std::string, policy_t>> POLICY_NAMES{
+    {"incremental", mh2c::header_prefix_pattern::INCREMENTAL_INDEXING},
+    {"without", mh2c::header_prefix_pattern::WITHOUT_INDEXING},
+    {"never", mh2c::header_prefix_pattern::NEVER_INDEXED},
+    {"adaptive", std::nullopt},
+};
+
+constexpr uint8_t INDEXED_FLAG{0x80u};
+
+void usage(const char* program) {
+  std::cerr
+      << "Usage: " << program << " [options] file\n"
+      << "  file       header sets as text (\"name: value\" lines, a blank\n"
+      << "             line between sets) or an HTTP Archive (.har)\n"
+      << "  -i POLICY  literal representation: incremental, without,\n"
+      << "             never or adaptive, chosen per field by how often it\n"
+      << "             recurs; repeat to compare (default incremental)\n"
+      << "  -t SIZE    SETTINGS_HEADER_TABLE_SIZE of the peer, repeat to\n"
+      << "             compare (default 4096)\n"
+      << "  -N         encode string literals without Huffman coding\n"
+      << "  -k N       number of header names in the cost table (default 20)\n";
+}
+
+bool parse_options(int argc, char* argv[], analyzer_options* options) {
+  int opt{};
+  while ((opt = getopt(argc, argv, "i:t:Nk:")) != -1) {
+    switch (opt) {
+      case 'i': {
+        const std::string name{optarg};
+        const auto it = std::find_if(
+            POLICY_NAMES.begin(), POLICY_NAMES.end(),
+            [&name](const auto& policy) { return policy.first == name; });
+        if (it == POLICY_NAMES.end()) {
+          return false;
+        }
+        options->m_policies.push_back(it->second);
+        break;
+      }
+      case 't':
+        options->m_table_sizes.push_back(std::stoul(optarg));
+        break;
+      case 'N':
+        options->m_encode_mode = mh2c::header_encode_mode::NONE;
+        break;
+      case 'k':
+        options->m_top_fields = std::stoul(optarg);
+        break;
+      default:
+        return false;
+    }
+  }
+
+  if (argc - optind != 1) {
+    return false;
+  }
+  options->m_path = argv[optind];
+  if (options->m_policies.empty()) {
+    options->m_policies.push_back(
+        mh2c::header_prefix_pattern::INCREMENTAL_INDEXING);
+  }
+  if (options->m_table_sizes.empty()) {
+    options->m_table_sizes.push_back(mh2c::dynamic_table::DEFAULT_TABLE_SIZE);
+  }
+
+  return true;
+}
+
+// Size of the field as an HTTP/1.1 header line, "name: value\r\n"
+uint64_t get_plain_size(const mh2c::header_t& header) {
+  return header.first.length() + header.second.length() + 4u;
+}
+
+// Encodes the header sets one field at a time, as a single connection would,
+// keeping the dynamic table in step with what a decoder would hold.
+analysis analyze(const hpack_analyzer::header_sets_t& header_sets,
+                 const policy_t& policy,
+                 const size_t table_size,
+                 const mh2c::header_encode_mode mode) {
+  analysis result{};
+  mh2c::dynamic_table table{};
+  mh2c::indexing_policy adaptive_policy{};
+
+  // cf. https://tools.ietf.org/html/rfc7541#section-4.2
+  if (table_size != table.get_max_table_size()) {
+    result.m_encoded_bytes +=
+        mh2c::encode_header(
+            {mh2c::header_prefix_pattern::SIZE_UPDATE, table_size}, mode,
+            table)
+            .size();
+    table.update_table_size(table_size);
+  }
+
+  for (const auto& headers : header_sets) {
+    for (const auto& header : headers) {
+      const auto prefix = policy.has_value()
+                              ? *policy
+                              : adaptive_policy.decide(header, table).m_prefix;
+      const auto encoded = mh2c::encode_header({prefix, header}, mode, table);
+      auto& cost = result.m_costs[header.first];
+      representation_counts counts{};
+
+      if ((encoded[0] & INDEXED_FLAG) != 0) {
+        const auto index = mh2c::decode_integer_value<7>(encoded);
+        if (index < mh2c::dynamic_table::FIRST_INDEX) {
+          counts.m_static_hits = 1u;
+        } else {
+          counts.m_dynamic_hits = 1u;
+        }
+      } else {
+        counts.m_literals = 1u;
+        if (prefix == mh2c::header_prefix_pattern::INCREMENTAL_INDEXING) {
+          const auto entries = table.get_entries().size();
+          table.push(header);
+          result.m_evictions += entries + 1u - table.get_entries().size();
+        }
+      }
+
+      for (auto* target :
+           {&result.m_representations, &cost.m_representations}) {
+        target->m_static_hits += counts.m_static_hits;
+        target->m_dynamic_hits += counts.m_dynamic_hits;
+        target->m_literals += counts.m_literals;
+      }
+      ++result.m_fields;
+      ++cost.m_count;
+      result.m_encoded_bytes += encoded.size();
+      cost.m_encoded_bytes += encoded.size();
+      result.m_plain_bytes += get_plain_size(header);
+      cost.m_plain_bytes += get_plain_size(header);
+    }
+  }
+
+  if (policy.has_value() == false) {
+    result.m_decisions = adaptive_policy.get_status();
+  }
+  result.m_final_entries = table.get_entries().size();
+  result.m_final_table_size = table.get_table_size();
+  return result;
+}
+
+double to_percent(const uint64_t part, const uint64_t total) {
+  return total == 0 ? 0.0 : part * 100.0 / total;
+}
+
+void print_analysis(const analysis& result, const size_t top_fields) {
+  const auto& counts = result.m_representations;
+  std::cout << std::fixed << std::setprecision(2)
+            << "  header fields : " << result.m_fields << '\n'
+            << "  encoded bytes : " << result.m_encoded_bytes << " of "
+            << result.m_plain_bytes << " plain ("
+            << to_percent(result.m_encoded_bytes, result.m_plain_bytes)
+            << "%)\n"
+            << "  static hits   : " << counts.m_static_hits << " ("
+            << to_percent(counts.m_static_hits, result.m_fields) << "%)\n"
+            << "  dynamic hits  : " << counts.m_dynamic_hits << " ("
+            << to_percent(counts.m_dynamic_hits, result.m_fields) << "%)\n"
+            << "  literals      : " << counts.m_literals << " ("
+            << to_percent(counts.m_literals, result.m_fields) << "%)\n"
+            << "  evictions     : " << result.m_evictions << '\n'
+            << "  final table   : " << result.m_final_entries
+            << " entries, " << result.m_final_table_size << " bytes\n";
+  if (result.m_decisions.has_value()) {
+    const auto& decisions = *result.m_decisions;
+    std::cout << "  decisions     : " << decisions.m_recurring_values
+              << " recurring values, " << decisions.m_recurring_names
+              << " recurring names, " << decisions.m_unique_values
+              << " unique values, " << decisions.m_too_large
+              << " too large, " << decisions.m_sensitive << " sensitive\n";
+  }
+  if (top_fields == 0) {
+    return;
+  }
+
+  std::vector<std::pair<mh2c::header_name_t, field_cost>> costs{
+      result.m_costs.begin(), result.m_costs.end()};
+  std::sort(costs.begin(), costs.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.second.m_encoded_bytes > rhs.second.m_encoded_bytes;
+  });
+  costs.resize(std::min(costs.size(), top_fields));
+
+  std::cout << "  " << std::left << std::setw(28) << "name" << std::right
+            << std::setw(8) << "count" << std::setw(10) << "encoded"
+            << std::setw(10) << "plain" << std::setw(9) << "avg"
+            << std::setw(8) << "static" << std::setw(9) << "dynamic"
+            << std::setw(9) << "literal" << '\n';
+  for (const auto& [name, cost] : costs) {
+    const auto& field_counts = cost.m_representations;
+    std::cout << "  " << std::left << std::setw(28) << name << std::right
+              << std::setw(8) << cost.m_count << std::setw(10)
+              << cost.m_encoded_bytes << std::setw(10) << cost.m_plain_bytes
+              << std::setw(9)
+              << static_cast<double>(cost.m_encoded_bytes) / cost.m_count
+              << std::setw(8) << field_counts.m_static_hits << std::setw(9)
+              << field_counts.m_dynamic_hits << std::setw(9)
+              << field_counts.m_literals << '\n';
+  }
+  return;
+}
+
+std::string get_policy_name(const policy_t& policy) {
+  for (const auto& [name, value] : POLICY_NAMES) {
+    if (value == policy) {
+      return name;
+    }
+  }
+  return "unknown";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  analyzer_options options{};
+  if (parse_options(argc, argv, &options) == false) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  hpack_analyzer::header_sets_t header_sets{};
+  try {
+    header_sets = hpack_analyzer::read_header_sets(options.m_path);
+  } catch (std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+  std::cout << header_sets.size() << " header sets from " << options.m_path
+            << '\n';
+
+  for (const auto& policy : options.m_policies) {
+    for (const auto table_size : options.m_table_sizes) {
+      std::cout << "\npolicy " << get_policy_name(policy) << ", table "
+                << table_size << " bytes, "
+                << (options.m_encode_mode == mh2c::header_encode_mode::HUFFMAN
+                        ? "Huffman"
+                        : "no Huffman")
+                << '\n';
+      print_analysis(
+          analyze(header_sets, policy, table_size, options.m_encode_mode),
+          options.m_top_fields);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}